@@ -2,6 +2,9 @@
 #include "pal_controller.hpp"
 #include <siege/content/bmp/bitmap.hpp>
 #include <siege/content/bmp/tim.hpp>
+#include <siege/content/pal/palette_registry.hpp>
+#include <siege/content/pal/palette_detection.hpp>
+#include <siege/platform/stream.hpp>
 #include <siege/platform/image.hpp>
 #include <deque>
 #include <fstream>
@@ -37,86 +40,49 @@ namespace siege::views
     return temp;
   }
 
+  // Shared by every bitmap which is opened, so that only the first one has to look for palettes on disk.
+  static content::pal::palette_registry& get_palette_registry()
+  {
+    static content::pal::palette_registry registry(content::pal::get_default_palette_index_folder() / "palette-index.bin");
+    return registry;
+  }
+
+  // Palettes which were assigned ahead of time, by batch detection or by hand.
+  static content::pal::palette_mapping& get_palette_mapping()
+  {
+    static content::pal::palette_mapping mapping(content::pal::get_default_palette_index_folder() / "palette-mapping.bin");
+    return mapping;
+  }
+
   std::future<const std::deque<palette_info>&> bmp_controller::load_palettes_async(std::optional<std::filesystem::path> folder_hint,
     std::move_only_function<get_embedded_pal_filenames> get_palettes,
     std::move_only_function<resolve_embedded_pal> resolve_data)
   {
     namespace fs = std::filesystem;
 
+    palette_folder = folder_hint.value_or(fs::current_path());
+
     return std::async(std::launch::async, 
         [this, get_palettes = std::move(get_palettes), resolve_data = std::move(resolve_data)]() mutable -> const std::deque<palette_info>& {
-      std::deque<fs::path> pal_paths;
-      std::deque<fs::path> embedded_pal_paths;
-
-      for (auto entry = fs::recursive_directory_iterator(fs::current_path());
-           entry != fs::recursive_directory_iterator();
-           ++entry)
+      auto& registry = get_palette_registry();
+      if (registry.scan(palette_folder, pal_controller::formats, std::move(get_palettes), std::move(resolve_data)))
       {
-        if (entry.depth() > 3)
-        {
-          entry.disable_recursion_pending();
-          continue;
-        }
-
-        if (!fs::is_directory(entry->path()))
-        {
-          auto is_pal = std::any_of(pal_controller::formats.begin(), pal_controller::formats.end(), [&](auto& ext) { return entry->path().extension() == ext; });
-
-          if (is_pal)
-          {
-            pal_paths.emplace_back(entry->path());
-          }
-          else
-          {
-            auto palettes = get_palettes(entry->path());
-            embedded_pal_paths.insert(embedded_pal_paths.end(), palettes.cbegin(), palettes.cend());
-          }
-        }
+        registry.save();
       }
 
-      palettes.resize(pal_paths.size() + embedded_pal_paths.size());
+      palettes.clear();
 
-      auto load_palette = [&](std::filesystem::path&& path, std::istream& temp) -> palette_info {
-        std::vector<content::pal::palette> results;
-        if (siege::platform::palette::is_microsoft_pal(temp))
-        {
-          results.emplace_back().colours = siege::platform::palette::get_pal_data(temp);
-        }
-        else if (siege::content::pal::is_earthsiege_pal(temp))
-        {
-          results.emplace_back().colours = siege::content::pal::get_earthsiege_pal(temp);
-        }
-        else if (siege::content::pal::is_phoenix_pal(temp))
-        {
-          return { path, siege::content::pal::get_ppl_data(temp) };
-        }
-
-        if (results.empty())
+      for (auto& entry : registry.get_palettes(palette_folder))
+      {
+        if (palettes.empty() || palettes.back().path != entry.path)
         {
-          results.emplace_back(get_default_palette());
+          palettes.emplace_back(palette_info{ entry.path });
         }
 
-        return { path, results };
-      };
-
-      auto task_a = std::async(std::launch::async, [&]() {
-        std::transform(embedded_pal_paths.begin(),
-          embedded_pal_paths.end(),
-          palettes.begin() + pal_paths.size(),
-          [&resolve_data, &load_palette](auto& path) mutable {
-            auto data = resolve_data(path);
-            std::spanstream span_data(data);
-            return load_palette(std::move(path), span_data);
-          });  
-      });
-
-      std::transform(std::execution::par_unseq, pal_paths.begin(), pal_paths.end(), palettes.begin(), [&load_palette](auto& path) mutable {
-        std::fstream file_data(path);
-        return load_palette(std::move(path), file_data);
-      });
-
-      
-      task_a.wait();
+        auto& palette = palettes.back().children.emplace_back();
+        palette.colours = std::move(entry.colours);
+        palette.index = entry.index;
+      }
 
       selected_palette_file = palettes.begin();
       selected_palette = 0;
@@ -141,7 +107,7 @@ namespace siege::views
 
         platform::bitmap::windows_bmp_data dest{};
 
-        dest.info.bit_depth = 32;
+        dest.info.bit_depth = 8;
         dest.info.width = image.bmp_header.width;
         dest.info.height = image.bmp_header.height;
 
@@ -149,20 +115,35 @@ namespace siege::views
         if (!palettes.empty())
         {
           selected_palette = 0;
-          selected_palette_file = std::find_if(palettes.begin(), palettes.end(), [&](palette_info& group) {
-            return std::any_of(group.children.begin(), group.children.end(), [&](pal::palette& pal) {
-              return pal.index == image.palette_index;
+          selected_palette_file = palettes.end();
+
+          auto bitmap_path = platform::get_stream_path(image_stream);
+          auto assigned = bitmap_path ? get_palette_mapping().find(*bitmap_path) : std::nullopt;
+
+          auto select = [&](const std::filesystem::path& path, std::size_t position) {
+            selected_palette_file = std::find_if(palettes.begin(), palettes.end(), [&](palette_info& group) {
+              return group.path == path && position < group.children.size();
             });
-          });
 
-          if (selected_palette_file != palettes.end())
+            selected_palette = position;
+          };
+
+          if (assigned)
+          {
+            select(assigned->palette_path, assigned->position);
+          }
+
+          if (selected_palette_file == palettes.end())
           {
-            auto expected_pal = std::find_if(selected_palette_file->children.begin(), selected_palette_file->children.end(), [&](pal::palette& pal) {
-              return pal.index == image.palette_index;
+            get_palette_registry().find_by_index(image.palette_index, palette_folder, [&](const content::pal::palette_entry& entry) {
+              select(entry.path, entry.position);
+              return false;
             });
+          }
 
-            selected_palette = std::distance(selected_palette_file->children.begin(), expected_pal);
-            dest.colours = expected_pal->colours;
+          if (selected_palette_file != palettes.end())
+          {
+            dest.colours = selected_palette_file->children[selected_palette].colours;
           }
           else
           {
@@ -175,10 +156,7 @@ namespace siege::views
           dest.colours = get_default_palette().colours;
         }
 
-        dest.indexes.reserve(image.pixels.size());
-        std::transform(image.pixels.begin(), image.pixels.end(), std::back_inserter(dest.indexes), [](auto& value) {
-          return std::int32_t(value);
-        });
+        dest.pixels = platform::bitmap::pixel_buffer(platform::bitmap::pixel_format::indexed_8, image.bmp_header.width, image.bmp_header.height, std::move(image.pixels));
 
         original_image.emplace(std::move(dest));
       }
@@ -67,6 +67,7 @@ namespace siege::views
 
   private:
     std::optional<platform::bitmap::platform_image> original_image;
+    std::filesystem::path palette_folder;
     std::deque<palette_info> palettes;
     std::deque<palette_info>::iterator selected_palette_file;
     std::size_t selected_palette;
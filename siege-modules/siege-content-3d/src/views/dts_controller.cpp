@@ -1,40 +1,13 @@
-#include <any>
 #include <siege/content/dts/darkstar.hpp>
 #include <siege/content/dts/3space.hpp>
+#include <siege/content/dts/mdl.hpp>
+#include <siege/content/dts/tmd.hpp>
+#include <siege/content/dts/bnd.hpp>
+#include <siege/content/dts/bwd.hpp>
 #include <siege/content/dts/renderable_shape_factory.hpp>
 #include <siege/content/dts/null_renderable_shape.hpp>
 #include "dts_controller.hpp"
 
-namespace siege::content::tmd
-{
-  bool is_tmd(std::istream& stream);
-  std::vector<std::any> load_tmd(std::istream& stream);
-}// namespace siege::content::tmd
-
-namespace siege::content::bnd
-{
-  bool is_bnd(std::istream& stream);
-  std::vector<std::any> load_bnd(std::istream& stream);
-}// namespace siege::content::bnd
-
-namespace siege::content::mdl
-{
-  bool is_mdl(std::istream& stream);
-  std::any load_mdl(std::istream& stream);
-
-  bool is_md2(std::istream& stream);
-  std::any load_md2(std::istream& stream);
-
-  bool is_mdx(std::istream& stream);
-  std::any load_mdx(std::istream& stream);
-}// namespace siege::content::mdl
-
-namespace siege::content::bwd
-{
-  bool is_bwd(std::istream& stream);
-  std::any load_bwd(std::istream& stream);
-}
-
 namespace siege::views
 {
   bool dts_controller::is_shape(std::istream& stream)
@@ -46,41 +19,12 @@ namespace siege::views
            || siege::content::mdl::is_mdl(stream)
            || siege::content::mdl::is_md2(stream)
            || siege::content::mdl::is_mdx(stream)
+           || siege::content::mdl::is_dkm(stream)
            || siege::content::bwd::is_bwd(stream);
   }
 
   std::size_t dts_controller::load_shape(std::istream& stream)
   {
-    if (siege::content::tmd::is_tmd(stream))
-    {
-      siege::content::tmd::load_tmd(stream);
-    }
-
-    if (siege::content::bnd::is_bnd(stream))
-    {
-      siege::content::bnd::load_bnd(stream);
-    }
-
-    if (siege::content::mdl::is_mdl(stream))
-    {
-      siege::content::mdl::load_mdl(stream);
-    }
-
-    if (siege::content::mdl::is_md2(stream))
-    {
-      siege::content::mdl::load_md2(stream);
-    }
-
-    if (siege::content::mdl::is_mdx(stream))
-    {
-      siege::content::mdl::load_mdx(stream);
-    }
-
-    if (siege::content::bwd::is_bwd(stream))
-    {
-      siege::content::bwd::load_bwd(stream);
-    }
-
     auto shape = content::dts::make_shape(stream);
 
     if (dynamic_cast<content::dts::null_renderable_shape*>(shape.get()) != nullptr)
@@ -115,4 +59,16 @@ namespace siege::views
     auto& context = shapes[index];
     context.shape->render_shape(renderer, context.selected_detail_levels, context.sequences);
   }
+
+  const std::vector<content::mesh_batch>& dts_controller::get_mesh_batches(std::size_t index)
+  {
+    auto& context = shapes[index];
+
+    if (!context.mesh_batches)
+    {
+      context.mesh_batches = context.shape->get_mesh_batches(context.selected_detail_levels, context.sequences);
+    }
+
+    return *context.mesh_batches;
+  }
 }// namespace siege::views
\ No newline at end of file
@@ -4,6 +4,7 @@
 #include <string>
 #include <vector>
 #include <any>
+#include <optional>
 #include <siege/platform/shared.hpp>
 #include <siege/content/renderable_shape.hpp>
 
@@ -22,6 +23,9 @@ namespace siege::views
     std::size_t load_shape(std::istream& image_stream);
 
     void render_shape(std::size_t index, content::shape_renderer& renderer);
+
+    // Built the first time they are asked for, and kept until the shape changes.
+    const std::vector<content::mesh_batch>& get_mesh_batches(std::size_t index);
   private:
       std::vector<shape_context> shapes;
   };
@@ -33,6 +37,7 @@ namespace siege::views
     std::vector<content::material> materials;
     std::vector<std::size_t> selected_detail_levels;
     std::vector<content::sequence_info> sequences;
+    std::optional<std::vector<content::mesh_batch>> mesh_batches;
   };
 
 }// namespace siege::views
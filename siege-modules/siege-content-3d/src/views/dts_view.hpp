@@ -240,9 +240,35 @@ namespace siege::views
         glRotatef(rotation.y, 0.f, 1.f, 0.f);
         glRotatef(rotation.z, 0.f, 0.f, 1.f);
 
-        glBegin(GL_TRIANGLES);
-        controller.render_shape(0, *renderer);
-        glEnd();
+        std::uint8_t batch_number = 0;
+
+        for (const auto& batch : controller.get_mesh_batches(0))
+        {
+          auto visible = true;
+
+          if (batch.node_name)
+          {
+            for (auto& [parent_node, nodes] : visible_nodes)
+            {
+              if (auto node = nodes.find(*batch.node_name); node != nodes.end())
+              {
+                visible = node->second;
+              }
+            }
+
+            auto [object_iterator, object_added] = visible_objects.emplace(*batch.node_name, std::map<std::string, bool>{});
+            visible = visible && object_iterator->second.emplace(batch.object_name, true).first->second;
+          }
+
+          if (visible)
+          {
+            const auto [red, green, blue] = renderer->max_colour;
+            draw_mesh_batch(batch, { std::uint8_t(red - batch_number), std::uint8_t(green - batch_number), std::uint8_t(batch.object_name.size()) });
+          }
+
+          batch_number += 255 / 15;
+        }
+
         glFlush();
       }
 
@@ -85,6 +85,35 @@ namespace siege::views
     }
   };
 
+  // Draws a whole batch with one call, instead of one call per vertex.
+  inline void draw_mesh_batch(const content::mesh_batch& batch, std::array<std::uint8_t, 3> colour)
+  {
+    if (batch.vertices.empty())
+    {
+      return;
+    }
+
+    glColor4ub(colour[0], colour[1], colour[2], 255);
+
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_NORMAL_ARRAY);
+    glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+
+    glVertexPointer(3, GL_FLOAT, sizeof(content::mesh_vertex), &batch.vertices[0].position);
+    glNormalPointer(GL_FLOAT, sizeof(content::mesh_vertex), &batch.vertices[0].normal);
+    glTexCoordPointer(2, GL_FLOAT, sizeof(content::mesh_vertex), &batch.vertices[0].texture_coordinate);
+
+    std::visit([](const auto& indexes) {
+      using index_type = typename std::decay_t<decltype(indexes)>::value_type;
+      glDrawElements(GL_TRIANGLES, GLsizei(indexes.size()), sizeof(index_type) == sizeof(std::uint16_t) ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT, indexes.data());
+    },
+      batch.indexes);
+
+    glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+    glDisableClientState(GL_NORMAL_ARRAY);
+    glDisableClientState(GL_VERTEX_ARRAY);
+  }
+
   inline void perspectiveGL(GLdouble fovY, GLdouble aspect, GLdouble zNear, GLdouble zFar)
   {
     constexpr GLdouble pi = 3.1415926535897932384626433832795;
@@ -116,18 +116,17 @@ namespace siege::views
           resource->extract_file_contents(cache, *memory, *file, temp_output);
         }
 
-        pixels.erase(pixels.begin(), pixels.begin() + settings->offset);
+        namespace bitmap = siege::platform::bitmap;
+        auto format = bitmap::get_bmp_pixel_format(std::uint16_t(settings->bit_depth));
+        auto stride = bitmap::get_row_size(format, settings->width);
 
-        results.resize(pixels.size() + (settings->colours.size() * 4) + 64, char{});
+        // The pixels are written straight from the extracted file, after the offset.
+        bitmap::const_pixel_view view{ format, std::size_t(settings->width), std::size_t(settings->height), stride, std::span(pixels).subspan(std::min(settings->offset, pixels.size())) };
+
+        results.resize((stride + 3) / 4 * 4 * view.height + (settings->colours.size() * 4) + 64, char{});
         std::ospanstream output(results);
 
-        siege::platform::bitmap::write_bmp_data(output,
-          settings->colours,
-          std::move(pixels),
-          settings->width,
-          settings->height,
-          settings->bit_depth,
-          settings->auto_flip);
+        bitmap::write_bmp_data(output, settings->colours, view, settings->auto_flip);
 
         return results;
       }
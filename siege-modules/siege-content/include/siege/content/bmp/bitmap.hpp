@@ -5,7 +5,9 @@
 #include <array>
 #include <fstream>
 #include <optional>
+#include <span>
 #include <siege/content/pal/palette.hpp>
+#include <siege/platform/pixel_buffer.hpp>
 #include <siege/platform/endian_arithmetic.hpp>
 
 namespace siege::content::bmp
@@ -29,6 +31,17 @@ namespace siege::content::bmp
     std::vector<std::byte> pixels;
   };
 
+  // Where the pixels of one PBMP image are, so that they can be decoded when they are needed rather than up front.
+  struct pbmp_frame_layout
+  {
+    pbmp_header bmp_header;
+    std::uint32_t detail_levels;
+    std::uint32_t palette_index;
+    // The position of the pixel data in the stream, and its size including every detail level.
+    std::size_t data_offset;
+    std::size_t data_size;
+  };
+
   struct dba_header
   {
     std::array<std::byte, 4> tag;
@@ -77,6 +90,19 @@ namespace siege::content::bmp
 
   std::vector<pbmp_data> get_pba_data(std::istream& raw_data);
 
+  // Reads the chunk headers of a PBMP file, or of every image of a PBA file, while skipping over the pixels.
+  std::vector<pbmp_frame_layout> get_pbmp_layout(std::istream& raw_data);
+
+  // Each detail level is half the size of the one before it, down to one pixel.
+  std::size_t get_pbmp_detail_count(const pbmp_frame_layout& layout);
+  std::pair<std::size_t, std::size_t> get_pbmp_detail_size(const pbmp_frame_layout& layout, std::size_t detail_level);
+
+  // Decodes a single detail level of one image, from the stream that the layout was read from.
+  platform::bitmap::pixel_buffer read_pbmp_pixels(std::istream& raw_data, const pbmp_frame_layout& layout, std::size_t detail_level = 0);
+
+  // Decodes a single detail level of one image straight from the bytes of the file, such as a mapped archive entry.
+  platform::bitmap::pixel_buffer read_pbmp_pixels(std::span<const std::byte> raw_data, const pbmp_frame_layout& layout, std::size_t detail_level = 0);
+
   std::vector<std::byte> remap_bitmap(const std::vector<std::byte>& pixels,
                                          const std::vector<pal::colour>& original_colours,
                                          const std::vector<pal::colour>& other_colours,
@@ -0,0 +1,118 @@
+#ifndef SIEGE_CONTENT_BITMAP_FRAMES_HPP
+#define SIEGE_CONTENT_BITMAP_FRAMES_HPP
+
+#include <array>
+#include <cstddef>
+#include <filesystem>
+#include <functional>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <siege/content/pal/palette_resolver.hpp>
+#include <siege/platform/pixel_buffer.hpp>
+#include <siege/platform/resource.hpp>
+
+namespace siege::content::bmp
+{
+  struct decoded_frame
+  {
+    std::vector<pal::colour> colours;
+    platform::bitmap::pixel_buffer pixels;
+  };
+
+  // index and count are positions among every image of the file, including the ones which are not decoded.
+  using frame_callback = std::function<void(std::size_t index, std::size_t count, decoded_frame frame)>;
+
+  // Decodes each image of a Phoenix, Earthsiege, TIM or Windows bitmap, with the palettes of indexed images picked by palettes.
+  // Phoenix images are decoded one at a time straight from contents, so that a large PBA is never fully in memory,
+  // and their detail levels are left out. No more than max_frames images are passed to on_frame.
+  void decode_bitmap_frames(std::span<const char> contents,
+    const std::filesystem::path& path,
+    const pal::palette_resolver& palettes,
+    const frame_callback& on_frame,
+    std::size_t max_frames = std::numeric_limits<std::size_t>::max());
+
+  // The bitmaps which shapes use as textures.
+  constexpr auto texture_extensions = std::array<std::string_view, 2>{ { ".bmp", ".pba" } };
+
+  // Textures are found by file name anywhere in the files given to it, decoded once into a T with convert,
+  // and then shared by every shape which uses them. Only the first frame at full size is used as the texture.
+  // Reads go through read, which must be safe to call from several threads at once.
+  template<typename T>
+  class texture_cache
+  {
+  public:
+    using read_file = std::function<std::vector<char>(const platform::file_info&)>;
+    using convert_frame = std::function<T(decoded_frame)>;
+
+    texture_cache(read_file read, const pal::palette_resolver& palettes, convert_frame convert)
+      : read(std::move(read)), palettes(palettes), convert(std::move(convert))
+    {
+    }
+
+    void add_files(std::vector<platform::file_info> files)
+    {
+      for (auto& info : files)
+      {
+        textures.emplace(platform::to_lower(info.filename.string()), std::move(info));
+      }
+    }
+
+    std::shared_ptr<const T> get(std::string_view filename) const
+    {
+      auto key = platform::to_lower(filename);
+
+      {
+        std::lock_guard<std::mutex> guard(mutex);
+
+        if (auto existing = decoded.find(key); existing != decoded.end())
+        {
+          return existing->second;
+        }
+      }
+
+      auto result = decode(key);
+
+      std::lock_guard<std::mutex> guard(mutex);
+      return decoded.emplace(std::move(key), std::move(result)).first->second;
+    }
+
+  private:
+    std::shared_ptr<const T> decode(const std::string& key) const
+    {
+      auto texture = textures.find(key);
+
+      if (texture == textures.end())
+      {
+        return nullptr;
+      }
+
+      auto contents = read(texture->second);
+      std::shared_ptr<const T> result;
+
+      decode_bitmap_frames(contents, texture->second.folder_path / texture->second.filename, palettes, [&](std::size_t, std::size_t, decoded_frame frame) {
+        if (!frame.pixels.empty())
+        {
+          result = std::make_shared<const T>(convert(std::move(frame)));
+        }
+      },
+        1);
+
+      return result;
+    }
+
+    read_file read;
+    const pal::palette_resolver& palettes;
+    convert_frame convert;
+    std::map<std::string, platform::file_info> textures;
+    mutable std::mutex mutex;
+    mutable std::map<std::string, std::shared_ptr<const T>> decoded;
+  };
+}// namespace siege::content::bmp
+
+#endif// SIEGE_CONTENT_BITMAP_FRAMES_HPP
@@ -0,0 +1,39 @@
+#ifndef SIEGE_CONTENT_PNG_HPP
+#define SIEGE_CONTENT_PNG_HPP
+
+#include <cstddef>
+#include <filesystem>
+#include <vector>
+#include <span>
+#include <istream>
+#include <ostream>
+#include <siege/content/pal/palette.hpp>
+#include <siege/platform/pixel_buffer.hpp>
+
+namespace siege::content::bmp
+{
+  struct png_data
+  {
+    // Only filled in for palette based images, with any transparency in the flags of each colour.
+    std::vector<pal::colour> colours;
+    // Palette based images are always indexed_8, and everything else is rgba_8888, with the top row first.
+    platform::bitmap::pixel_buffer pixels;
+  };
+
+  // Reads non-interlaced PNG files of any colour type. 16-bit channels are reduced to 8 bits.
+  png_data get_png_data(std::istream& raw_data);
+
+  // Indexed pixels are written with their palette, and every other format as RGB or RGBA.
+  // The rows of pixels are expected to be top row first.
+  void write_png_data(std::ostream& raw_data,
+    std::span<const pal::colour> colours,
+    platform::bitmap::const_pixel_view pixels,
+    int compression_level = 6);
+
+  // The name of the PNG made from one frame of a bitmap, such as by siege-texconv.
+  // The first frame keeps the stem of the bitmap, so that materials can refer to it without knowing how many frames there are,
+  // and every other frame gets its index added as _<index>.
+  std::filesystem::path get_png_filename(const std::filesystem::path& bitmap, std::size_t frame_index = 0);
+}// namespace siege::content::bmp
+
+#endif// SIEGE_CONTENT_PNG_HPP
@@ -1,12 +1,50 @@
 #ifndef SIEGE_TIM_HPP
 #define SIEGE_TIM_HPP
 
+#include <cstdint>
+#include <span>
+#include <vector>
 #include <siege/platform/bitmap.hpp>
 
 namespace siege::content::tim
 {
+  enum class tim_format
+  {
+    four_bit,
+    eight_bit,
+    sixteen_bit,
+    twenty_four_bit
+  };
+
+  struct tim_image
+  {
+    tim_format format{};
+    // Every colour table of the file. The rows of 4-bit tables are split into groups of 16 colours.
+    std::vector<std::vector<platform::palette::colour>> cluts;
+    // indexed_4, indexed_8, rgb_1555 or rgb_888, with the top row first.
+    platform::bitmap::pixel_buffer pixels;
+    // Where the pixels and the colour tables are loaded into VRAM, in 16-bit units.
+    // Models refer to textures by these positions rather than by file.
+    std::uint16_t vram_x = 0;
+    std::uint16_t vram_y = 0;
+    std::uint16_t clut_x = 0;
+    std::uint16_t clut_y = 0;
+    // How many colours each row of colour tables has in VRAM, which can be more than one table.
+    std::uint16_t clut_row_size = 0;
+  };
+
   bool is_tim(std::istream& raw_data);
 
-  platform::bitmap::windows_bmp_data get_tim_data_as_bitmap(std::istream& raw_data);
+  tim_image get_tim_image(std::istream& raw_data);
+
+  // PlayStation colours are A1B5G5R5, where black is transparent unless its top bit is set.
+  void decode_colours(std::span<const std::byte> raw_colours, std::span<platform::palette::colour> destination);
+
+  // Indexed images use the colours of clut_index, for files which have more than one colour table.
+  platform::bitmap::windows_bmp_data to_bitmap(tim_image image, std::size_t clut_index = 0);
+
+  platform::bitmap::windows_bmp_data get_tim_data_as_bitmap(std::istream& raw_data, std::size_t clut_index = 0);
+
+  platform::bitmap::windows_bmp_data get_tim_data_as_bitmap(std::span<const std::byte> raw_data, std::size_t clut_index = 0);
 }// namespace siege::content::tim
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,57 @@
+#ifndef SIEGE_BND_HPP
+#define SIEGE_BND_HPP
+
+#include <istream>
+#include <optional>
+#include <vector>
+#include <siege/content/dts/tmd.hpp>
+#include <siege/content/bmp/tim.hpp>
+
+namespace siege::content::bnd
+{
+  namespace endian = siege::platform;
+
+  // The same packet as a lit, gouraud shaded, textured TMD triangle, without the primitive header in front of it.
+  struct bnd_textured_triangle_primitive
+  {
+    struct
+    {
+      endian::little_uint16_t v_coord;
+      endian::little_uint16_t u_coord;
+    } texture_coordinates[3];
+
+    struct
+    {
+      endian::little_uint16_t v_index;
+      endian::little_uint16_t u_index;
+    } vertex_indices[3];
+  };
+
+  struct bnd_shape
+  {
+    std::vector<tmd::tmd_vertex> vertices;
+    std::vector<tmd::tmd_vertex> normals;
+    std::vector<bnd_textured_triangle_primitive> primitives;
+  };
+
+  struct bnd_collision
+  {
+    std::vector<char> bytes;
+    bnd_shape shape;
+  };
+
+  struct bnd_data
+  {
+    std::vector<bnd_shape> shapes;
+    std::vector<bnd_collision> collision_data;
+    // Kept as they are so that primitives can find them by where they are in VRAM.
+    std::vector<tim::tim_image> textures;
+  };
+
+  bool is_bnd(std::istream& stream);
+  std::optional<bnd_data> load_bnd(std::istream& stream);
+
+  tmd::tmd_object to_tmd_object(const bnd_shape& shape);
+}// namespace siege::content::bnd
+
+#endif// !SIEGE_BND_HPP
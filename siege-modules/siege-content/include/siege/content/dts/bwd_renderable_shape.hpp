@@ -0,0 +1,56 @@
+#ifndef SIEGE_CONTENT_BWD_RENDERABLE_SHAPE_HPP
+#define SIEGE_CONTENT_BWD_RENDERABLE_SHAPE_HPP
+
+#include <functional>
+#include <optional>
+#include <string>
+#include <siege/content/renderable_shape.hpp>
+#include "bwd.hpp"
+#include "wtb.hpp"
+
+namespace siege::content::bwd
+{
+  // Finds the WTB mesh of an object by its PRJ file ID, which only the archive the model came from can know.
+  using mesh_resolver = std::function<std::optional<wtb::wtb_shape>(std::int16_t prj_file_index)>;
+
+  // Finds the file name of a texture by its PRJ file ID, in the same way.
+  using texture_resolver = std::function<std::optional<std::string>(std::uint16_t prj_file_index)>;
+
+  // MechWarrior 2 models, with each object of the BWD file placed at its origin.
+  // The first detail level is the objects of the model itself, and the others are its levels of detail, in order.
+  // There is one material per polygon surface, with the texture the surface resolves to, if any.
+  // Texture coordinates are not known yet, so every vertex has zero for them.
+  class bwd_renderable_shape final : public renderable_shape
+  {
+  public:
+    bwd_renderable_shape(const bwd_model& model, const mesh_resolver& resolve_mesh, const texture_resolver& resolve_texture = {});
+
+    std::vector<sequence_info> get_sequences(const std::vector<std::size_t>& detail_level_indexes) const override;
+    std::vector<std::string> get_detail_levels() const override;
+    std::vector<material> get_materials() const override;
+
+    void render_shape(shape_renderer& renderer, const std::vector<std::size_t>& detail_level_indexes, const std::vector<sequence_info>& sequences) const override;
+    std::vector<mesh_batch> get_mesh_batches(const std::vector<std::size_t>& detail_level_indexes, const std::vector<sequence_info>& sequences) const override;
+
+  private:
+    struct prepared_object
+    {
+      std::string name;
+      std::vector<vector3f> positions;
+      std::vector<std::array<std::uint16_t, 3>> faces;
+      // The material index of each face.
+      std::vector<std::int32_t> face_materials;
+    };
+
+    struct detail_level
+    {
+      std::string name;
+      std::vector<prepared_object> objects;
+    };
+
+    std::vector<detail_level> detail_levels;
+    std::vector<material> materials;
+  };
+}// namespace siege::content::bwd
+
+#endif// SIEGE_CONTENT_BWD_RENDERABLE_SHAPE_HPP
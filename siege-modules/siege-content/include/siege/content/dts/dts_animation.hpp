@@ -0,0 +1,118 @@
+#ifndef SIEGE_CONTENT_DTS_ANIMATION_HPP
+#define SIEGE_CONTENT_DTS_ANIMATION_HPP
+
+#include <cstdint>
+#include <span>
+#include <vector>
+#include <glm/mat4x4.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <siege/content/renderable_shape.hpp>
+#include "darkstar_structures.hpp"
+
+namespace siege::content::dts::darkstar
+{
+  // The local transform of a node. Rotations are kept as they are in the file, which is the inverse of what glm expects.
+  struct node_pose
+  {
+    glm::quat rotation;
+    glm::vec3 translation;
+    glm::vec3 scale;
+  };
+
+  glm::mat4 to_matrix(const node_pose& pose);
+
+  // The keyframes of one sub sequence, with each part of the transform in its own array.
+  struct node_channel
+  {
+    std::int32_t node_index;
+    std::int32_t sequence_index;
+    std::int32_t first_key_frame_index;
+    std::vector<float> positions;
+    std::vector<glm::quat> rotations;
+    std::vector<glm::vec3> translations;
+    std::vector<glm::vec3> scales;
+  };
+
+  // Every frame of one sequence, sampled at evenly spaced positions. Frame i starts at poses[i * node_count].
+  struct pose_cache
+  {
+    std::size_t node_count = 0;
+    std::size_t frame_count = 0;
+    bool cyclic = false;
+    std::vector<node_pose> poses;
+
+    std::span<const node_pose> get_frame(std::size_t frame_index) const
+    {
+      return std::span(poses).subspan(frame_index * node_count, node_count);
+    }
+
+    // The baked frame closest to position, which goes from 0 to 1 over the sequence.
+    std::span<const node_pose> get_frame_at(float position) const;
+  };
+
+  // Turns the keyframes of a shape into channels once, so that a pose for any point in time
+  // only costs one lookup per animated node, rather than a search of every sequence for every node.
+  class animation_engine
+  {
+  public:
+    explicit animation_engine(const shape_variant& shape);
+
+    std::size_t get_node_count() const
+    {
+      return default_pose.size();
+    }
+
+    std::size_t get_sequence_count() const
+    {
+      return sequence_offsets.empty() ? 0 : sequence_offsets.size() - 1;
+    }
+
+    std::span<const node_pose> get_default_pose() const
+    {
+      return default_pose;
+    }
+
+    // The channels which belong to a sequence, one per animated node.
+    std::span<const node_channel> get_channels(std::size_t sequence_index) const;
+
+    bool is_cyclic(std::size_t sequence_index) const
+    {
+      return cyclic[sequence_index];
+    }
+
+    // How long one run of the sequence takes, in seconds.
+    float get_duration(std::size_t sequence_index) const
+    {
+      return durations[sequence_index];
+    }
+
+    // Interpolates between the two keyframes around position, with slerp for rotations and lerp for everything else.
+    // Cyclic sequences wrap around from the last keyframe to the first.
+    static node_pose sample(const node_channel& channel, float position, bool cyclic);
+
+    // Fills in the pose of every node for one sequence at position, with nodes it does not animate left at their default.
+    void sample(std::size_t sequence_index, float position, std::span<node_pose> pose) const;
+
+    // Fills in the pose of every node from the enabled sub sequences, each at its own position.
+    // Later sequences override earlier ones when they animate the same node.
+    void sample(const std::vector<sequence_info>& sequences, std::span<node_pose> pose) const;
+
+    // Samples every frame of a sequence up front, in parallel, so playback becomes a copy of one frame.
+    pose_cache bake(std::size_t sequence_index, std::size_t frame_count) const;
+
+  private:
+    const node_channel* find_channel(std::int32_t node_index, std::int32_t first_key_frame_index) const;
+
+    std::vector<node_pose> default_pose;
+    // Sorted by sequence, with the channels of sequence i starting at sequence_offsets[i].
+    std::vector<node_channel> channels;
+    std::vector<std::uint32_t> sequence_offsets;
+    std::vector<bool> cyclic;
+    std::vector<float> durations;
+    // Channel indexes sorted by node and then by first keyframe, which is how sequence_info refers to them.
+    // Nodes can share the same keyframes, so the first keyframe alone is not enough to find a channel.
+    std::vector<std::uint32_t> channels_by_key_frame;
+  };
+}// namespace siege::content::dts::darkstar
+
+#endif// SIEGE_CONTENT_DTS_ANIMATION_HPP
@@ -9,19 +9,21 @@
 #include <unordered_map>
 #include <set>
 #include <memory_resource>
+#include <span>
 
 #include <siege/content/renderable_shape.hpp>
 #include "darkstar_structures.hpp"
+#include "dts_animation.hpp"
 
 namespace siege::content::dts::darkstar
 {
+  // The materials of a shape, or of a DML file on its own.
+  std::vector<material> get_materials(const material_list_variant& material_list);
+
   class dts_renderable_shape final : public renderable_shape
   {
   public:
-    dts_renderable_shape(shape_variant shape)
-      : shape(std::move(shape))
-    {
-    }
+    dts_renderable_shape(shape_variant shape);
 
     std::vector<sequence_info> get_sequences(const std::vector<std::size_t>& detail_level_indexes) const override;
     std::vector<std::string> get_detail_levels() const override;
@@ -29,8 +31,56 @@ namespace siege::content::dts::darkstar
 
     void render_shape(shape_renderer& renderer, const std::vector<std::size_t>& detail_level_indexes, const std::vector<sequence_info>& sequences) const override;
 
+    std::vector<mesh_batch> get_mesh_batches(const std::vector<std::size_t>& detail_level_indexes, const std::vector<sequence_info>& sequences) const override;
+
+    // The mesh of one object in the space of its own node, for exporters which keep the node transforms.
+    std::vector<mesh_batch> get_object_batches(std::int32_t object_index) const;
+
+    const shape_variant& get_shape() const
+    {
+      return shape;
+    }
+
+    const animation_engine& get_animation() const
+    {
+      return animation;
+    }
+
+    // Which nodes and objects belong to each node, as flat arrays built once when the shape is loaded.
+    // The children of a node are child_nodes[child_offsets[node]] up to child_nodes[child_offsets[node + 1]],
+    // and its objects are found the same way in node_objects.
+    struct node_hierarchy
+    {
+      std::vector<std::int32_t> child_offsets;
+      std::vector<std::int32_t> child_nodes;
+      std::vector<std::int32_t> object_offsets;
+      std::vector<std::int32_t> node_objects;
+
+      std::size_t size() const
+      {
+        return child_offsets.empty() ? 0 : child_offsets.size() - 1;
+      }
+
+      std::span<const std::int32_t> get_children(std::int32_t node_index) const
+      {
+        return std::span(child_nodes).subspan(child_offsets[node_index], child_offsets[node_index + 1] - child_offsets[node_index]);
+      }
+
+      std::span<const std::int32_t> get_objects(std::int32_t node_index) const
+      {
+        return std::span(node_objects).subspan(object_offsets[node_index], object_offsets[node_index + 1] - object_offsets[node_index]);
+      }
+    };
+
+    const node_hierarchy& get_hierarchy() const
+    {
+      return hierarchy;
+    }
+
   private:
     shape_variant shape;
+    node_hierarchy hierarchy;
+    animation_engine animation;
   };
 }
 
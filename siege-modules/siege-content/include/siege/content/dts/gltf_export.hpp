@@ -0,0 +1,24 @@
+#ifndef SIEGE_CONTENT_DTS_GLTF_EXPORT_HPP
+#define SIEGE_CONTENT_DTS_GLTF_EXPORT_HPP
+
+#include <cstddef>
+#include <functional>
+#include <optional>
+#include <string_view>
+#include <vector>
+#include <siege/content/gltf.hpp>
+#include <siege/content/renderable_shape.hpp>
+
+namespace siege::content::dts
+{
+  // Turns the texture file name of a material into PNG data, or nothing when the texture cannot be found.
+  using texture_resolver = std::function<std::optional<std::vector<std::byte>>(std::string_view filename)>;
+
+  // Adds the materials of a shape and then each of its detail levels as a scene of its own.
+  // Darkstar shapes keep their node hierarchy in the default pose, and every sequence becomes an animation.
+  // Other shapes get one node per object, with the vertices already where render_shape puts them.
+  // Batches refer to materials by their index in the shape, so each shape needs a writer of its own.
+  void add_shape(gltf::glb_writer& writer, const renderable_shape& shape, const texture_resolver& resolve_texture = {});
+}// namespace siege::content::dts
+
+#endif// SIEGE_CONTENT_DTS_GLTF_EXPORT_HPP
@@ -0,0 +1,262 @@
+#ifndef SIEGE_CONTENT_MDL_HPP
+#define SIEGE_CONTENT_MDL_HPP
+
+// MDL - Quake 1 model data
+// MD2 version 8 - Quake 2 model data
+// MD2 version 15 - Anachronox model data
+// MDX - Kingpin model data
+// DKM - Daikatana model data
+
+#include <array>
+#include <cstdint>
+#include <istream>
+#include <optional>
+#include <span>
+#include <string>
+#include <variant>
+#include <vector>
+#include <siege/platform/endian_arithmetic.hpp>
+#include <siege/content/3d_structures.hpp>
+
+namespace siege::content::mdl
+{
+  namespace endian = siege::platform;
+
+  struct mdl_header
+  {
+    std::array<std::byte, 4> tag;
+    endian::little_uint32_t version;
+    std::array<float, 3> scale;
+    std::array<float, 3> translation;
+    float other;
+    std::array<endian::little_uint32_t, 3> padding;
+    endian::little_uint32_t texture_count;
+    endian::little_uint32_t texture_width;
+    endian::little_uint32_t texture_height;
+    endian::little_uint32_t vertex_and_uv_count;
+    endian::little_uint32_t face_count;
+    endian::little_uint32_t frame_count;
+    endian::little_uint32_t padding2;
+    endian::little_uint32_t padding3;
+    float other2;
+  };
+
+  struct mdl_uv_coordinate
+  {
+    endian::little_uint32_t on_seam;
+    endian::little_uint32_t u;
+    endian::little_uint32_t v;
+  };
+
+  struct mdl_face
+  {
+    endian::little_uint32_t is_front_face;
+    std::array<endian::little_uint32_t, 3> vertex_indices;
+  };
+
+  // Each component is scaled and then moved by the translation of the model or frame.
+  struct mdl_vertex
+  {
+    std::uint8_t x;
+    std::uint8_t y;
+    std::uint8_t z;
+    std::uint8_t normal;
+  };
+
+  struct mdl_frame
+  {
+    mdl_vertex bounding_min;
+    mdl_vertex bounding_max;
+    std::array<char, 16> name;
+    std::vector<mdl_vertex> vertices;
+  };
+
+  struct animated_texture
+  {
+    float frame_duration;
+    std::vector<std::vector<std::byte>> frame_data;
+  };
+
+  using texture_data = std::variant<std::vector<std::byte>, animated_texture>;
+
+  struct mdl_shape
+  {
+    std::array<float, 3> scale;
+    std::array<float, 3> translation;
+    endian::little_uint32_t texture_width;
+    endian::little_uint32_t texture_height;
+    std::vector<texture_data> textures;
+    std::vector<mdl_uv_coordinate> uv_coordinates;
+    std::vector<mdl_face> faces;
+    // Frames which were in groups are listed one after the other, as if they were on their own.
+    std::vector<mdl_frame> frames;
+  };
+
+  struct md2_header
+  {
+    std::array<std::byte, 4> tag;
+    endian::little_uint32_t version;
+    endian::little_uint32_t texture_width;
+    endian::little_uint32_t texture_height;
+    endian::little_uint32_t frame_byte_count;
+    endian::little_uint32_t texture_count;
+    endian::little_uint32_t vertex_per_frame_count;
+    endian::little_uint32_t uv_count;
+    endian::little_uint32_t face_count;
+    endian::little_uint32_t unknown_count;
+    endian::little_uint32_t frame_count;
+    endian::little_uint32_t texture_offset;
+    endian::little_uint32_t uv_offset;
+    endian::little_uint32_t face_offset;
+    endian::little_uint32_t frame_offset;
+    endian::little_uint32_t unknown_offset;
+    endian::little_uint32_t eof_offset;
+  };
+
+  struct md2_uv_coordinate
+  {
+    endian::little_uint16_t u;
+    endian::little_uint16_t v;
+  };
+
+  struct md2_face
+  {
+    std::array<endian::little_uint16_t, 3> vertex_indices;
+    std::array<endian::little_uint16_t, 3> uv_indices;
+  };
+
+  struct md2_frame
+  {
+    std::array<float, 3> scale;
+    std::array<float, 3> translation;
+    std::array<char, 16> name;
+    std::vector<mdl_vertex> vertices;
+  };
+
+  struct md2_shape
+  {
+    endian::little_uint32_t texture_width;
+    endian::little_uint32_t texture_height;
+    std::vector<std::string> texture_filenames;
+    std::vector<md2_face> faces;
+    std::vector<md2_uv_coordinate> uv_coordinates;
+    std::vector<md2_frame> frames;
+  };
+
+  struct mdx_header
+  {
+    std::array<std::byte, 4> tag;
+    endian::little_uint32_t version;
+    endian::little_uint32_t texture_width;
+    endian::little_uint32_t texture_height;
+    endian::little_uint32_t frame_byte_count;
+    endian::little_uint32_t texture_count;
+    endian::little_uint32_t vertex_per_frame_count;
+    endian::little_uint32_t face_count;
+    endian::little_uint32_t unknown_count;
+    endian::little_uint32_t frame_count;
+    endian::little_uint32_t padding;
+    endian::little_uint32_t padding2;
+    endian::little_uint32_t sub_object_count;
+    endian::little_uint32_t texture_offset;
+    endian::little_uint32_t face_offset;
+    endian::little_uint32_t frame_offset;
+    endian::little_uint32_t unknown_offset;
+    endian::little_uint32_t vertex_group_offset;
+    endian::little_uint32_t padding3;
+    endian::little_uint32_t padding4;
+    endian::little_uint32_t frame_bounding_box_offset;
+  };
+
+  struct mdx_frame : md2_frame
+  {
+    std::array<float, 6> bounding_box;
+  };
+
+  struct mdx_sub_object_grouping
+  {
+    std::vector<endian::little_uint32_t> vertex_groupings;
+  };
+
+  struct mdx_shape
+  {
+    endian::little_uint32_t texture_width;
+    endian::little_uint32_t texture_height;
+    std::vector<std::string> texture_filenames;
+    std::vector<md2_face> faces;
+    std::vector<mdx_frame> frames;
+    std::vector<mdx_sub_object_grouping> sub_object_groupings;
+  };
+
+  struct dkm_face
+  {
+    endian::little_uint32_t padding;
+    std::array<endian::little_uint16_t, 3> vertex_indices;
+    std::array<endian::little_uint16_t, 3> uv_indices;
+  };
+
+  struct dkm_header
+  {
+    std::array<std::byte, 4> tag;
+    endian::little_uint32_t version;
+    endian::little_uint32_t texture_width;
+    endian::little_uint32_t texture_height;
+    endian::little_uint32_t unknown;
+    endian::little_uint32_t frame_byte_count;
+    endian::little_uint32_t texture_count;
+    endian::little_uint32_t vertex_per_frame_count;
+    endian::little_uint32_t uv_count;
+    endian::little_uint32_t face_count;
+    endian::little_uint32_t unknown_count;
+    endian::little_uint32_t frame_count;
+    endian::little_uint32_t unknown_count2;
+    endian::little_uint32_t texture_offset;
+    endian::little_uint32_t uv_offset;
+    endian::little_uint32_t face_offset;
+    endian::little_uint32_t frame_offset;
+    endian::little_uint32_t unknown_offset;
+    endian::little_uint32_t eof_offset;
+    endian::little_uint32_t unknown_count3;
+    endian::little_uint32_t unknown_offset3;
+  };
+
+  // Version 2 of DKM packs x, y and z into 11, 10 and 11 bits, for more precision than MD2 has.
+  struct dkm_packed_vertex
+  {
+    endian::little_uint32_t position;
+    std::uint8_t normal;
+  };
+
+  struct dkm_frame
+  {
+    std::array<float, 3> scale;
+    std::array<float, 3> translation;
+    std::array<char, 16> name;
+    std::variant<std::vector<mdl_vertex>, std::vector<dkm_packed_vertex>> vertices;
+  };
+
+  struct dkm_shape
+  {
+    std::vector<std::string> texture_filenames;
+    std::vector<dkm_face> faces;
+    std::vector<dkm_frame> frames;
+  };
+
+  bool is_mdl(std::istream& stream);
+  std::optional<mdl_shape> load_mdl(std::istream& stream);
+
+  bool is_md2(std::istream& stream);
+  std::optional<md2_shape> load_md2(std::istream& stream);
+
+  bool is_mdx(std::istream& stream);
+  std::optional<mdx_shape> load_mdx(std::istream& stream);
+
+  bool is_dkm(std::istream& stream);
+  std::optional<dkm_shape> load_dkm(std::istream& stream);
+
+  // Each is one multiply and add per component over the whole frame, so that it can be vectorised.
+  void decode_vertices(std::span<const mdl_vertex> vertices, const std::array<float, 3>& scale, const std::array<float, 3>& translation, std::span<vector3f> results);
+  void decode_vertices(std::span<const dkm_packed_vertex> vertices, const std::array<float, 3>& scale, const std::array<float, 3>& translation, std::span<vector3f> results);
+}// namespace siege::content::mdl
+
+#endif// SIEGE_CONTENT_MDL_HPP
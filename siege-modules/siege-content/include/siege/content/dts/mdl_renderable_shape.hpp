@@ -0,0 +1,76 @@
+#ifndef SIEGE_CONTENT_MDL_RENDERABLE_SHAPE_HPP
+#define SIEGE_CONTENT_MDL_RENDERABLE_SHAPE_HPP
+
+#include <array>
+#include <span>
+#include <siege/content/renderable_shape.hpp>
+#include "mdl.hpp"
+
+namespace siege::content::mdl
+{
+  // What MDL, MD2, MDX and DKM models have in common once they are loaded,
+  // with the packed vertices of every frame already turned into positions.
+  struct keyframe_model
+  {
+    struct corner
+    {
+      std::uint32_t vertex_index;
+      std::uint32_t texture_index;
+    };
+
+    // Skins which are inside of the model, as with MDL, have no filename.
+    std::vector<std::string> skins;
+    std::vector<texture_vertex> texture_vertices;
+    std::vector<std::array<corner, 3>> faces;
+    std::vector<std::string> frame_names;
+    std::size_t vertex_count = 0;
+    // vertex_count positions for each frame, one frame after the other.
+    std::vector<vector3f> positions;
+
+    std::span<const vector3f> get_frame(std::size_t frame_index) const
+    {
+      return std::span<const vector3f>(positions).subspan(frame_index * vertex_count, vertex_count);
+    }
+  };
+
+  keyframe_model to_keyframe_model(const mdl_shape& shape);
+  keyframe_model to_keyframe_model(const md2_shape& shape);
+  keyframe_model to_keyframe_model(const mdx_shape& shape);
+  keyframe_model to_keyframe_model(const dkm_shape& shape);
+
+  // Frames are grouped into sequences by their names without the numbers at the end, so that run1 to run6 become run.
+  // The position of a sequence moves through its frames, with positions interpolated between one frame and the next.
+  class mdl_renderable_shape final : public renderable_shape
+  {
+  public:
+    mdl_renderable_shape(keyframe_model model);
+
+    std::vector<sequence_info> get_sequences(const std::vector<std::size_t>& detail_level_indexes) const override;
+    std::vector<std::string> get_detail_levels() const override;
+    std::vector<material> get_materials() const override;
+
+    void render_shape(shape_renderer& renderer, const std::vector<std::size_t>& detail_level_indexes, const std::vector<sequence_info>& sequences) const override;
+    std::vector<mesh_batch> get_mesh_batches(const std::vector<std::size_t>& detail_level_indexes, const std::vector<sequence_info>& sequences) const override;
+
+    // The positions for the first enabled sequence, or the first frame when none are enabled.
+    void sample(const std::vector<sequence_info>& sequences, std::span<vector3f> results) const;
+
+    const keyframe_model& get_model() const
+    {
+      return model;
+    }
+
+  private:
+    struct frame_range
+    {
+      std::string name;
+      std::uint32_t first_frame;
+      std::uint32_t frame_count;
+    };
+
+    keyframe_model model;
+    std::vector<frame_range> ranges;
+  };
+}// namespace siege::content::mdl
+
+#endif// SIEGE_CONTENT_MDL_RENDERABLE_SHAPE_HPP
@@ -1,11 +1,23 @@
 #ifndef RENDERABLE_SHAPE_FACTORY_HPP
 #define RENDERABLE_SHAPE_FACTORY_HPP
 
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string>
+#include <vector>
 #include <siege/content/renderable_shape.hpp>
 
 namespace siege::content::dts
 {
-  std::unique_ptr<content::renderable_shape> make_shape(std::istream& shape_stream);
+  // The other files of the archive a shape came from, by their file ID, for shapes which are split across several files.
+  struct related_files
+  {
+    std::function<std::optional<std::string>(std::uint16_t file_id)> get_filename;
+    std::function<std::vector<char>(std::uint16_t file_id)> read;
+  };
+
+  std::unique_ptr<content::renderable_shape> make_shape(std::istream& shape_stream, const related_files& files = {});
 }
 
 #endif//INC_3SPACESTUDIO_RENDERABLE_SHAPE_FACTORY_HPP
@@ -1,19 +1,67 @@
 #ifndef SIEGE_TMD_HPP
-#define SIEGE_TMP_HPP
+#define SIEGE_TMD_HPP
 
+#include <array>
+#include <cstdint>
+#include <istream>
+#include <optional>
+#include <span>
+#include <vector>
 #include <siege/platform/endian_arithmetic.hpp>
+#include <siege/content/3d_structures.hpp>
 
 namespace siege::content::tmd
 {
   namespace endian = siege::platform;
 
+  // Whole numbers for positions. Normals use the same layout, with 4096 as 1.
   struct tmd_vertex
   {
-    endian::little_uint16_t x;
-    endian::little_uint16_t y;
-    endian::little_uint16_t z;
-    endian::little_uint16_t padding;
+    endian::little_int16_t x;
+    endian::little_int16_t y;
+    endian::little_int16_t z;
+    endian::little_int16_t padding;
   };
+
+  struct tmd_corner
+  {
+    std::uint16_t vertex_index;
+    std::uint16_t normal_index;
+    // In pixels of the texture page, for textured polygons.
+    std::uint8_t u;
+    std::uint8_t v;
+  };
+
+  struct tmd_polygon
+  {
+    // 3 or 4, where the corners of a quad are in the order 0, 1, 2 and 1, 3, 2 for its two triangles.
+    std::uint8_t corner_count;
+    std::array<tmd_corner, 4> corners;
+    bool is_textured;
+    // Which part of VRAM the texture coordinates are in, along with the bit depth of the texture.
+    std::uint16_t texture_page;
+    // Where the colour table of the texture is in VRAM.
+    std::uint16_t clut;
+    // The colour of the first corner, for polygons without textures.
+    rgb_data colour;
+  };
+
+  struct tmd_object
+  {
+    std::vector<tmd_vertex> vertices;
+    std::vector<tmd_vertex> normals;
+    std::vector<tmd_polygon> polygons;
+  };
+
+  bool is_tmd(std::istream& stream);
+  std::vector<tmd_object> load_tmd(std::istream& stream);
+
+  // Reads the packet of one primitive, which comes after its mode and flags.
+  // Lines, sprites and packets which are too small for their mode give nothing.
+  std::optional<tmd_polygon> read_polygon(std::uint8_t mode, std::uint8_t flags, std::span<const std::byte> packet);
+
+  // The Y and Z axes of the PlayStation point down and away, so both are flipped to stand models upright.
+  void decode_vertices(std::span<const tmd_vertex> vertices, std::span<vector3f> results);
 }// namespace siege::content::tmd
 
 #endif// !SIEGE_TMD_HPP
@@ -0,0 +1,67 @@
+#ifndef SIEGE_CONTENT_TMD_RENDERABLE_SHAPE_HPP
+#define SIEGE_CONTENT_TMD_RENDERABLE_SHAPE_HPP
+
+#include <optional>
+#include <unordered_map>
+#include <string_view>
+#include <siege/content/renderable_shape.hpp>
+#include <siege/content/bmp/tim.hpp>
+#include "tmd.hpp"
+
+namespace siege::content::tmd
+{
+  // PlayStation models, from TMD files or from the TMD data inside of Colony Wars BND files.
+  // Textured polygons are bound to the TIM images which were loaded with them, by where each one is in VRAM,
+  // and every image and colour table pair they use becomes a material. Other polygons get a material for their colour.
+  class tmd_renderable_shape final : public renderable_shape
+  {
+  public:
+    tmd_renderable_shape(std::vector<tmd_object> objects, std::vector<tim::tim_image> images = {});
+
+    std::vector<sequence_info> get_sequences(const std::vector<std::size_t>& detail_level_indexes) const override;
+    std::vector<std::string> get_detail_levels() const override;
+    std::vector<material> get_materials() const override;
+
+    void render_shape(shape_renderer& renderer, const std::vector<std::size_t>& detail_level_indexes, const std::vector<sequence_info>& sequences) const override;
+    std::vector<mesh_batch> get_mesh_batches(const std::vector<std::size_t>& detail_level_indexes, const std::vector<sequence_info>& sequences) const override;
+
+    // The pixels of a material which uses one of the images of the shape, found by the file name of the material.
+    std::optional<platform::bitmap::windows_bmp_data> get_texture(std::string_view filename) const;
+
+  private:
+    struct face
+    {
+      std::int32_t material_index;
+      std::array<std::uint16_t, 3> vertex_indexes;
+      std::array<texture_vertex, 3> texture_vertices;
+      // The texture coordinates in pixels, which are what tell corners apart in batches.
+      std::array<std::uint16_t, 3> texture_keys;
+    };
+
+    struct prepared_object
+    {
+      std::string name;
+      std::vector<vector3f> positions;
+      std::vector<face> faces;
+    };
+
+    struct texture_source
+    {
+      std::size_t image_index;
+      std::size_t clut_index;
+    };
+
+    // Keys are the image and colour table for textured polygons, and the colour for the others.
+    using material_keys = std::unordered_map<std::uint64_t, std::int32_t>;
+
+    std::int32_t get_material(const tmd_polygon& polygon, std::array<texture_vertex, 4>& texture_vertices, material_keys& keys);
+
+    std::vector<tim::tim_image> images;
+    std::vector<prepared_object> objects;
+    std::vector<material> materials;
+    // For each material, the image it uses, if it has one.
+    std::vector<std::optional<texture_source>> texture_sources;
+  };
+}// namespace siege::content::tmd
+
+#endif// SIEGE_CONTENT_TMD_RENDERABLE_SHAPE_HPP
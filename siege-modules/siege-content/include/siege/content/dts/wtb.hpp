@@ -0,0 +1,45 @@
+#ifndef SIEGE_WTB_HPP
+#define SIEGE_WTB_HPP
+
+#include <array>
+#include <istream>
+#include <optional>
+#include <span>
+#include <vector>
+#include <siege/platform/endian_arithmetic.hpp>
+#include <siege/content/3d_structures.hpp>
+
+namespace siege::content::wtb
+{
+  namespace endian = siege::platform;
+
+  struct wtb_point
+  {
+    endian::little_int32_t x;
+    endian::little_int32_t y;
+    endian::little_int32_t z;
+    endian::little_int32_t unknown;
+  };
+
+  struct wtb_polygon
+  {
+    // The first value of each polygon. It changes with how the polygon is drawn, and is used as the PRJ file ID of its texture.
+    std::uint16_t surface;
+    // Anywhere from three to seven point indexes.
+    std::vector<std::uint16_t> points;
+  };
+
+  struct wtb_shape
+  {
+    std::vector<wtb_point> points;
+    std::vector<wtb_polygon> polygons;
+  };
+
+  bool is_wtb(std::istream& stream);
+  std::optional<wtb_shape> load_wtb(std::istream& stream);
+
+  // Points are used as they are, since what the scale and translation in the header do is not known yet.
+  void decode_points(std::span<const wtb_point> points, std::span<vector3f> results);
+}// namespace siege::content::wtb
+
+#endif// !SIEGE_WTB_HPP
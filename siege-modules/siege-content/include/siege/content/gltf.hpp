@@ -0,0 +1,178 @@
+#ifndef SIEGE_CONTENT_GLTF_HPP
+#define SIEGE_CONTENT_GLTF_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <ostream>
+#include <span>
+#include <string>
+#include <vector>
+#include <siege/content/mesh_batch.hpp>
+
+namespace siege::content::gltf
+{
+  struct node
+  {
+    std::string name;
+    std::optional<std::size_t> mesh_index;
+    std::vector<std::size_t> children;
+    std::array<float, 3> translation{ 0, 0, 0 };
+    // x, y, z and then w, as glTF expects.
+    std::array<float, 4> rotation{ 0, 0, 0, 1 };
+    std::array<float, 3> scale{ 1, 1, 1 };
+  };
+
+  enum class animation_path
+  {
+    translation,
+    rotation,
+    scale
+  };
+
+  // Keyframes of one part of the transform of one node, interpolated linearly.
+  struct animation_channel
+  {
+    std::size_t node_index;
+    animation_path path;
+    // In seconds, in increasing order.
+    std::vector<float> times;
+    // Three floats per time for translations and scales, and four for rotations.
+    std::vector<float> values;
+  };
+
+  // Builds a binary glTF 2.0 file.
+  // Vertices and indexes are not copied: the writer keeps views of the batches given to add_mesh,
+  // which must outlive the call to write, and streams them into the BIN chunk in one pass.
+  // The JSON chunk is only a description of the views, so it is built as a document and written out whole.
+  class glb_writer
+  {
+  public:
+    std::size_t add_image(std::string name, std::vector<std::byte> png_data);
+
+    std::size_t add_material(std::string name, std::optional<std::size_t> image_index, std::array<float, 4> base_colour = { 1, 1, 1, 1 });
+
+    // One primitive per batch, using the material at the material index of the batch, if there is one.
+    std::size_t add_mesh(std::string name, std::span<const mesh_batch> batches);
+
+    // The same, but the writer keeps the batches alive itself.
+    std::size_t add_mesh(std::string name, std::vector<mesh_batch>&& batches);
+
+    std::size_t add_node(node value);
+
+    node& get_node(std::size_t node_index)
+    {
+      return nodes.at(node_index);
+    }
+
+    std::size_t get_node_count() const
+    {
+      return nodes.size();
+    }
+
+    std::size_t get_material_count() const
+    {
+      return materials.size();
+    }
+
+    // The first scene added is the one which viewers show by default.
+    std::size_t add_scene(std::string name, std::vector<std::size_t> root_nodes);
+
+    void add_animation(std::string name, std::vector<animation_channel> channels);
+
+    void write(std::ostream& output) const;
+
+  private:
+    enum class component_type : std::uint32_t
+    {
+      unsigned_short = 5123,
+      unsigned_int = 5125,
+      float_value = 5126
+    };
+
+    struct buffer_view
+    {
+      std::span<const std::byte> data;
+      std::optional<std::size_t> stride;
+      // 34962 for vertices and 34963 for indexes, or none for anything else.
+      std::optional<std::uint32_t> target;
+    };
+
+    struct accessor
+    {
+      std::size_t view_index;
+      std::size_t byte_offset;
+      component_type type;
+      std::size_t count;
+      std::string_view shape;
+      std::vector<float> min;
+      std::vector<float> max;
+    };
+
+    struct primitive
+    {
+      std::size_t position_accessor;
+      std::size_t normal_accessor;
+      std::size_t texture_accessor;
+      std::size_t index_accessor;
+      std::optional<std::size_t> material_index;
+    };
+
+    struct mesh
+    {
+      std::string name;
+      std::vector<primitive> primitives;
+    };
+
+    struct image
+    {
+      std::string name;
+      std::size_t view_index;
+    };
+
+    struct material
+    {
+      std::string name;
+      std::optional<std::size_t> image_index;
+      std::array<float, 4> base_colour;
+    };
+
+    struct scene
+    {
+      std::string name;
+      std::vector<std::size_t> nodes;
+    };
+
+    struct sampler
+    {
+      std::size_t input_accessor;
+      std::size_t output_accessor;
+    };
+
+    struct animation
+    {
+      std::string name;
+      std::vector<std::pair<std::size_t, animation_path>> targets;
+      std::vector<sampler> samplers;
+    };
+
+    std::size_t add_view(std::span<const std::byte> data, std::optional<std::size_t> stride = std::nullopt, std::optional<std::uint32_t> target = std::nullopt);
+    std::size_t add_floats(std::vector<float> values);
+
+    std::vector<buffer_view> views;
+    std::vector<accessor> accessors;
+    std::vector<mesh> meshes;
+    std::vector<node> nodes;
+    std::vector<image> images;
+    std::vector<material> materials;
+    std::vector<scene> scenes;
+    std::vector<animation> animations;
+    // Data which the writer made itself, such as images and keyframes. A deque never moves what it already holds.
+    std::deque<std::vector<std::byte>> owned_data;
+    std::deque<std::vector<mesh_batch>> owned_batches;
+  };
+}// namespace siege::content::gltf
+
+#endif// SIEGE_CONTENT_GLTF_HPP
@@ -0,0 +1,316 @@
+#ifndef SIEGE_CONTENT_JSON_STREAM_HPP
+#define SIEGE_CONTENT_JSON_STREAM_HPP
+
+#include <array>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <variant>
+#include <vector>
+#include <siege/platform/endian_arithmetic.hpp>
+
+namespace siege::content
+{
+  enum class json_style
+  {
+    // Laid out the same as nlohmann::json with std::setw(4).
+    pretty,
+    // No whitespace, and arrays of structs which only hold numbers are written as one flat array of numbers,
+    // such as [x, y, z, x, y, z] for vertices.
+    compact
+  };
+
+  // Writes JSON as it goes, into a buffer which is handed to the output stream whenever it fills up,
+  // so that nothing the size of the whole document is ever built.
+  class json_stream_writer
+  {
+  public:
+    explicit json_stream_writer(std::ostream& output, json_style style = json_style::pretty);
+    ~json_stream_writer();
+
+    json_stream_writer(const json_stream_writer&) = delete;
+    json_stream_writer& operator=(const json_stream_writer&) = delete;
+
+    json_style get_style() const
+    {
+      return style;
+    }
+
+    void begin_object();
+    void end_object();
+    void begin_array();
+    void end_array();
+    void key(std::string_view name);
+
+    void null();
+    void value(bool item);
+    void value(std::int64_t item);
+    void value(std::uint64_t item);
+    // Written as the shortest text which reads back as the same float, and as null when not finite, the same as nlohmann::json.
+    void value(float item);
+    void value(double item);
+    void value(std::string_view item);
+
+    void flush();
+
+  private:
+    struct level
+    {
+      bool is_object;
+      std::size_t count;
+    };
+
+    void begin_value();
+    void begin_container(char bracket, bool is_object);
+    void end_container(char bracket);
+    void new_line(std::size_t depth);
+    void write_string(std::string_view item);
+    void write_float(double item, bool is_single);
+
+    std::ostream& output;
+    json_style style;
+    std::string buffer;
+    std::vector<level> levels;
+    bool after_key = false;
+  };
+
+  template<typename T>
+  struct is_endian_int : std::false_type
+  {
+  };
+
+  template<std::endian ByteOrder, std::integral IntType, std::size_t Size>
+  struct is_endian_int<platform::endian_int_t<ByteOrder, IntType, Size>> : std::true_type
+  {
+  };
+
+  template<typename T>
+  concept json_keyed_struct = requires { T::keys; };
+
+  template<typename T>
+  concept json_number = std::is_arithmetic_v<T> || std::is_enum_v<T> || is_endian_int<T>::value;
+
+  // Calls func with every member of a struct which has keys, in the same order as its keys.
+  template<json_keyed_struct StructType, typename Func>
+  decltype(auto) apply_members(const StructType& raw, Func&& func)
+  {
+    constexpr auto size = std::tuple_size_v<std::remove_cvref_t<decltype(StructType::keys)>>;
+
+    if constexpr (size == 1)
+    {
+      auto& [item0] = raw;
+      return func(item0);
+    }
+    else if constexpr (size == 2)
+    {
+      auto& [item0, item1] = raw;
+      return func(item0, item1);
+    }
+    else if constexpr (size == 3)
+    {
+      auto& [item0, item1, item2] = raw;
+      return func(item0, item1, item2);
+    }
+    else if constexpr (size == 4)
+    {
+      auto& [item0, item1, item2, item3] = raw;
+      return func(item0, item1, item2, item3);
+    }
+    else if constexpr (size == 5)
+    {
+      auto& [item0, item1, item2, item3, item4] = raw;
+      return func(item0, item1, item2, item3, item4);
+    }
+    else if constexpr (size == 6)
+    {
+      auto& [item0, item1, item2, item3, item4, item5] = raw;
+      return func(item0, item1, item2, item3, item4, item5);
+    }
+    else if constexpr (size == 7)
+    {
+      auto& [item0, item1, item2, item3, item4, item5, item6] = raw;
+      return func(item0, item1, item2, item3, item4, item5, item6);
+    }
+    else if constexpr (size == 8)
+    {
+      auto& [item0, item1, item2, item3, item4, item5, item6, item7] = raw;
+      return func(item0, item1, item2, item3, item4, item5, item6, item7);
+    }
+    else if constexpr (size == 9)
+    {
+      auto& [item0, item1, item2, item3, item4, item5, item6, item7, item8] = raw;
+      return func(item0, item1, item2, item3, item4, item5, item6, item7, item8);
+    }
+    else if constexpr (size == 10)
+    {
+      auto& [item0, item1, item2, item3, item4, item5, item6, item7, item8, item9] = raw;
+      return func(item0, item1, item2, item3, item4, item5, item6, item7, item8, item9);
+    }
+    else if constexpr (size == 11)
+    {
+      auto& [item0, item1, item2, item3, item4, item5, item6, item7, item8, item9, item10] = raw;
+      return func(item0, item1, item2, item3, item4, item5, item6, item7, item8, item9, item10);
+    }
+    else if constexpr (size == 12)
+    {
+      auto& [item0, item1, item2, item3, item4, item5, item6, item7, item8, item9, item10, item11] = raw;
+      return func(item0, item1, item2, item3, item4, item5, item6, item7, item8, item9, item10, item11);
+    }
+    else if constexpr (size == 13)
+    {
+      auto& [item0, item1, item2, item3, item4, item5, item6, item7, item8, item9, item10, item11, item12] = raw;
+      return func(item0, item1, item2, item3, item4, item5, item6, item7, item8, item9, item10, item11, item12);
+    }
+    else if constexpr (size == 14)
+    {
+      auto& [item0, item1, item2, item3, item4, item5, item6, item7, item8, item9, item10, item11, item12, item13] = raw;
+      return func(item0, item1, item2, item3, item4, item5, item6, item7, item8, item9, item10, item11, item12, item13);
+    }
+    else if constexpr (size == 15)
+    {
+      auto& [item0, item1, item2, item3, item4, item5, item6, item7, item8, item9, item10, item11, item12, item13, item14] = raw;
+      return func(item0, item1, item2, item3, item4, item5, item6, item7, item8, item9, item10, item11, item12, item13, item14);
+    }
+    else
+    {
+      static_assert(size <= 15, "Structs with more than 15 keys are not supported");
+    }
+  }
+
+  // Structs such as vertices and keyframes, which compact JSON writes as a run of numbers.
+  template<typename T>
+  constexpr bool is_json_number_struct()
+  {
+    if constexpr (json_keyed_struct<T>)
+    {
+      return decltype(apply_members(std::declval<const T&>(), [](const auto&... items) {
+        return std::bool_constant<(json_number<std::remove_cvref_t<decltype(items)>> && ...)>{};
+      }))::value;
+    }
+    else
+    {
+      return false;
+    }
+  }
+
+  template<typename T>
+  void write_json(json_stream_writer& writer, const T& item);
+
+  template<std::size_t Size>
+  void write_json(json_stream_writer& writer, const std::array<char, Size>& item);
+
+  template<typename... Type>
+  void write_json(json_stream_writer& writer, const std::variant<Type...>& item);
+
+  template<json_keyed_struct StructType>
+  void write_json_members(json_stream_writer& writer, const StructType& raw)
+  {
+    apply_members(raw, [&](const auto&... items) {
+      std::size_t current_key = 0;
+      ((writer.key(StructType::keys[current_key++]), write_json(writer, items)), ...);
+    });
+  }
+
+  template<typename Range>
+  void write_json_array(json_stream_writer& writer, const Range& items)
+  {
+    using item_type = std::remove_cvref_t<decltype(*std::begin(items))>;
+
+    writer.begin_array();
+
+    if constexpr (is_json_number_struct<item_type>())
+    {
+      if (writer.get_style() == json_style::compact)
+      {
+        for (const auto& item : items)
+        {
+          apply_members(item, [&](const auto&... values) { (write_json(writer, values), ...); });
+        }
+
+        writer.end_array();
+        return;
+      }
+    }
+
+    for (const auto& item : items)
+    {
+      write_json(writer, item);
+    }
+
+    writer.end_array();
+  }
+
+  // Follows the same rules as the nlohmann::json serializers in json_boost.hpp and complex_serializer.hpp,
+  // so that both produce the same document: structs with keys become objects, variants also get their version and typeName,
+  // char arrays become strings, and endian integers, enums and std::byte become plain numbers.
+  template<typename T>
+  void write_json(json_stream_writer& writer, const T& item)
+  {
+    if constexpr (std::is_same_v<T, bool>)
+    {
+      writer.value(item);
+    }
+    else if constexpr (is_endian_int<T>::value)
+    {
+      write_json(writer, static_cast<typename T::value_type>(item));
+    }
+    else if constexpr (std::is_enum_v<T>)
+    {
+      write_json(writer, static_cast<std::underlying_type_t<T>>(item));
+    }
+    else if constexpr (std::is_floating_point_v<T>)
+    {
+      writer.value(item);
+    }
+    else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>)
+    {
+      writer.value(std::int64_t(item));
+    }
+    else if constexpr (std::is_integral_v<T>)
+    {
+      writer.value(std::uint64_t(item));
+    }
+    else if constexpr (std::is_convertible_v<const T&, std::string_view>)
+    {
+      writer.value(std::string_view(item));
+    }
+    else if constexpr (json_keyed_struct<T>)
+    {
+      writer.begin_object();
+      write_json_members(writer, item);
+      writer.end_object();
+    }
+    else
+    {
+      write_json_array(writer, item);
+    }
+  }
+
+  template<std::size_t Size>
+  void write_json(json_stream_writer& writer, const std::array<char, Size>& item)
+  {
+    auto text = std::string_view(item.data(), item.size());
+    writer.value(text.substr(0, text.find('\0')));
+  }
+
+  template<typename... Type>
+  void write_json(json_stream_writer& writer, const std::variant<Type...>& item)
+  {
+    std::visit([&](const auto& value) {
+      using value_type = std::remove_cvref_t<decltype(value)>;
+
+      writer.begin_object();
+      writer.key("version");
+      write_json(writer, value_type::version);
+      writer.key("typeName");
+      write_json(writer, std::string_view(value_type::type_name));
+      write_json_members(writer, value);
+      writer.end_object();
+    },
+      item);
+  }
+}// namespace siege::content
+
+#endif// SIEGE_CONTENT_JSON_STREAM_HPP
@@ -0,0 +1,119 @@
+#ifndef SIEGE_CONTENT_MESH_BATCH_HPP
+#define SIEGE_CONTENT_MESH_BATCH_HPP
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <variant>
+#include <vector>
+#include <siege/content/3d_structures.hpp>
+
+namespace siege::content
+{
+  struct mesh_vertex
+  {
+    vector3f position;
+    texture_vertex texture_coordinate;
+    vector3f normal;
+  };
+
+  // The triangles of one object which use one material, with vertices shared between them,
+  // so that they can be uploaded or written out without any more processing.
+  struct mesh_batch
+  {
+    std::optional<std::string> node_name;
+    std::string object_name;
+    // An index into the materials of the shape, or -1 when the shape does not have any.
+    std::int32_t material_index = -1;
+    std::vector<mesh_vertex> vertices;
+    // Three per triangle. 16-bit whenever the batch has few enough vertices.
+    std::variant<std::vector<std::uint16_t>, std::vector<std::uint32_t>> indexes;
+
+    std::size_t get_index_count() const
+    {
+      return std::visit([](const auto& values) { return values.size(); }, indexes);
+    }
+
+    std::uint32_t get_index(std::size_t position) const
+    {
+      return std::visit([&](const auto& values) { return std::uint32_t(values[position]); }, indexes);
+    }
+  };
+
+  // Builds batches for one object at a time, splitting them by material.
+  // Corners are merged by a key chosen by the caller, such as the vertex and texture vertex indexes of the source mesh,
+  // so that no floating point values need to be hashed or compared.
+  class mesh_batch_builder
+  {
+  public:
+    // vertex_key_count is how many different vertex keys the object is expected to use, if known.
+    void begin_object(std::optional<std::string_view> node_name, std::string_view object_name, std::size_t vertex_key_count = 0);
+
+    struct corner
+    {
+      // Corners with the same vertex key and texture key share a vertex.
+      std::uint32_t vertex_key;
+      std::uint32_t texture_key;
+      vector3f position;
+      texture_vertex texture_coordinate;
+    };
+
+    // The position is only read the first time a corner is seen, so get_position is only called for new vertices.
+    template<typename GetPosition>
+    void add_triangle(std::int32_t material_index, const std::array<corner, 3>& corners, GetPosition&& get_position)
+    {
+      auto& pending = get_batch(material_index);
+
+      for (const auto& item : corners)
+      {
+        auto index = find_vertex(pending, item.vertex_key, item.texture_key);
+
+        if (index == no_vertex)
+        {
+          index = add_vertex(pending, item.vertex_key, item.texture_key, get_position(item), item.texture_coordinate);
+        }
+
+        pending.indexes.emplace_back(index);
+      }
+    }
+
+    void add_triangle(std::int32_t material_index, const std::array<corner, 3>& corners)
+    {
+      add_triangle(material_index, corners, [](const corner& item) { return item.position; });
+    }
+
+    // Computes normals for every batch, and switches to 16-bit indexes where they fit.
+    std::vector<mesh_batch> finish();
+
+  private:
+    static constexpr std::uint32_t no_vertex = UINT32_MAX;
+
+    struct pending_batch
+    {
+      mesh_batch batch;
+      std::vector<std::uint32_t> indexes;
+      // The first vertex made for each vertex key, with the others for the same key chained through next_vertex.
+      std::vector<std::uint32_t> first_vertex;
+      std::vector<std::uint32_t> next_vertex;
+      std::vector<std::uint32_t> texture_keys;
+    };
+
+    pending_batch& get_batch(std::int32_t material_index);
+    std::uint32_t find_vertex(const pending_batch& batch, std::uint32_t vertex_key, std::uint32_t texture_key) const;
+    std::uint32_t add_vertex(pending_batch& batch, std::uint32_t vertex_key, std::uint32_t texture_key, const vector3f& position, const texture_vertex& texture_coordinate);
+    void finish_object();
+
+    std::optional<std::string> node_name;
+    std::string object_name;
+    std::size_t vertex_key_count = 0;
+    std::vector<pending_batch> current;
+    std::vector<mesh_batch> results;
+  };
+
+  // Smooth normals from the triangles of the batch, weighted by their area.
+  void compute_normals(mesh_batch& batch);
+}// namespace siege::content
+
+#endif// SIEGE_CONTENT_MESH_BATCH_HPP
@@ -1,24 +1,93 @@
 #ifndef DARKSTARDTSCONVERTER_OBJ_RENDERER_HPP
 #define DARKSTARDTSCONVERTER_OBJ_RENDERER_HPP
 
+#include <array>
+#include <cstdint>
+#include <ostream>
+#include <span>
+#include <string>
 #include <string_view>
-#include <fstream>
-#include <sstream>
-#include <iomanip>
+#include <unordered_map>
+#include <vector>
 #include <siege/content/renderable_shape.hpp>
 
 namespace siege::content
 {
-  struct obj_renderer final : shape_renderer
+  // Writes OBJ text into a large buffer which goes out in big blocks.
+  // Numbers use the shortest text which reads back as the same float,
+  // and positions, texture vertices and normals which are the same are only written once.
+  class obj_writer
   {
-    std::optional<std::string> new_face_str = std::nullopt;
-    std::size_t face_count = 0;
-    std::ofstream& output;
+  public:
+    explicit obj_writer(std::ostream& output, std::size_t buffer_size = 1 << 20);
+    ~obj_writer();
+
+    obj_writer(const obj_writer&) = delete;
+    obj_writer& operator=(const obj_writer&) = delete;
+
+    void write_material_library(std::string_view filename);
+    void write_object(std::string_view name);
+    void use_material(std::string_view name);
 
-    obj_renderer(std::ofstream& output)
-      : output(output)
+    // Each returns the index to use in faces, starting from 1.
+    std::uint32_t add_position(const vector3f& position);
+    std::uint32_t add_texture_vertex(const texture_vertex& vertex);
+    std::uint32_t add_normal(const vector3f& normal);
+
+    struct corner
+    {
+      std::uint32_t position;
+      std::uint32_t texture_vertex;
+      // Zero when there is no normal.
+      std::uint32_t normal = 0;
+    };
+
+    void write_face(std::span<const corner> corners);
+
+    // One object per batch, using the material names given for the material index of each batch.
+    void write_batches(std::span<const mesh_batch> batches, std::span<const std::string> material_names);
+
+    void flush();
+
+  private:
+    // The bits of each float, with negative zero turned into zero so that both weld together.
+    using key = std::array<std::uint32_t, 3>;
+
+    struct key_hash
+    {
+      std::size_t operator()(const key& value) const noexcept;
+    };
+
+    static key to_key(float x, float y, float z);
+
+    void write_floats(std::string_view prefix, std::span<const float> values);
+    void write_index(std::uint32_t value);
+    void reserve(std::size_t size);
+
+    std::ostream& output;
+    std::string buffer;
+    std::size_t buffer_size;
+
+    std::unordered_map<key, std::uint32_t, key_hash> positions;
+    std::unordered_map<key, std::uint32_t, key_hash> texture_vertices;
+    std::unordered_map<key, std::uint32_t, key_hash> normals;
+  };
+
+  // The name each material gets in the MTL file, which is unique even when materials share a texture.
+  std::string get_material_name(std::size_t index, const material& value);
+
+  // One newmtl per material, with its texture as map_Kd or its colour as Kd.
+  // Textures point at the PNG which siege-texconv makes from the first frame of the original bitmap, named by bmp::get_png_filename.
+  void write_mtl(std::ostream& output, std::span<const material> materials);
+
+  // Writes whatever render_shape draws, as it comes, without materials.
+  // dts-to-obj does not need it, since the default get_mesh_batches already goes through render_shape for shapes
+  // which have nothing better, and write_batches keeps the materials. It stays for code which only has a shape_renderer to give.
+  struct obj_renderer final : shape_renderer
+  {
+    explicit obj_renderer(std::ostream& output)
+      : writer(output)
     {
-      output << std::setprecision(32);
     }
 
     void update_node(std::optional<std::string_view>, std::string_view) override
@@ -27,44 +96,39 @@ namespace siege::content
 
     void update_object(std::optional<std::string_view>, std::string_view object_name) override
     {
-      output << "o " << object_name << '\n';
+      writer.write_object(object_name);
     }
 
     void new_face(std::size_t num_vertices) override
     {
-      std::stringstream stream;
-      stream << "\tf";
-
-      for (auto i = 1u; i <= num_vertices; ++i)
-      {
-        stream << " " << face_count + i << "/" << face_count + i;
-      }
-
-      stream << '\n';
-
-      new_face_str = stream.str();
-
-      face_count += num_vertices;
+      corners.clear();
+      corners.reserve(num_vertices);
+      next_texture_vertex = 0;
     }
 
     void end_face() override
     {
-      if (new_face_str.has_value())
-      {
-        output << new_face_str.value();
-      }
+      writer.write_face(corners);
     }
 
     void emit_vertex(const vector3f& vertex) override
     {
-      output << "\tv " << vertex.x << ' ' << vertex.y << ' ' << vertex.z << '\n';
+      corners.emplace_back(obj_writer::corner{ writer.add_position(vertex), 0 });
     }
 
+    // Texture vertices follow the vertices of the face, in the same order.
     void emit_texture_vertex(const texture_vertex& vertex) override
     {
-      output << "\tvt " << vertex.x << ' ' << vertex.y << '\n';
+      if (next_texture_vertex < corners.size())
+      {
+        corners[next_texture_vertex++].texture_vertex = writer.add_texture_vertex(vertex);
+      }
     }
-  };
 
-}
+  private:
+    obj_writer writer;
+    std::vector<obj_writer::corner> corners;
+    std::size_t next_texture_vertex = 0;
+  };
+}// namespace siege::content
 #endif//DARKSTARDTSCONVERTER_OBJ_RENDERER_HPP
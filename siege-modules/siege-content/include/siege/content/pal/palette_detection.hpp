@@ -0,0 +1,65 @@
+#ifndef SIEGE_CONTENT_PALETTE_DETECTION_HPP
+#define SIEGE_CONTENT_PALETTE_DETECTION_HPP
+
+#include <filesystem>
+#include <map>
+#include <optional>
+#include <shared_mutex>
+#include <span>
+#include <vector>
+#include <siege/content/pal/palette_registry.hpp>
+
+namespace siege::content::pal
+{
+  struct palette_assignment
+  {
+    std::filesystem::path bitmap;
+    std::filesystem::path palette_path;
+    // The position of the palette inside of its file.
+    std::uint32_t position;
+    // How well the palette fits the pixels, from 0 to 1, or 1 when no scoring was done.
+    float score;
+  };
+
+  struct palette_detection_settings
+  {
+    // Picks the candidate whose colours change the least between neighbouring pixels,
+    // rather than just the closest one with the right palette index.
+    bool score_by_histogram = false;
+    std::size_t max_candidates = 8;
+  };
+
+  // The palettes in the closest folder to folder which has any, with the ones nearest to it first.
+  std::vector<palette_entry> get_nearby_palettes(const palette_registry& registry, const std::filesystem::path& folder);
+
+  // Assigns a palette to every Phoenix and Earthsiege bitmap in bitmaps, in parallel.
+  // Phoenix bitmaps are matched by palette index and then by folder, while Earthsiege bitmaps only have their folder to go on.
+  // Bitmaps which are not one of those formats, or have no palette anywhere near them, are left out.
+  std::vector<palette_assignment> detect_palettes(const palette_registry& registry,
+    std::span<const std::filesystem::path> bitmaps,
+    palette_detection_settings settings = {});
+
+  // Which palette goes with which bitmap, saved to a file so that viewers and exporters agree.
+  class palette_mapping
+  {
+  public:
+    explicit palette_mapping(std::filesystem::path mapping_path);
+
+    void assign(std::span<const palette_assignment> assignments);
+
+    std::optional<palette_assignment> find(const std::filesystem::path& bitmap) const;
+
+    std::size_t size() const;
+
+    void save() const;
+
+  private:
+    void load();
+
+    std::filesystem::path mapping_path;
+    mutable std::shared_mutex mutex;
+    std::map<std::filesystem::path, palette_assignment> assignments;
+  };
+}// namespace siege::content::pal
+
+#endif// SIEGE_CONTENT_PALETTE_DETECTION_HPP
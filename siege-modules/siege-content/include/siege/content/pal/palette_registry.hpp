@@ -0,0 +1,92 @@
+#ifndef SIEGE_CONTENT_PALETTE_REGISTRY_HPP
+#define SIEGE_CONTENT_PALETTE_REGISTRY_HPP
+
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <map>
+#include <set>
+#include <shared_mutex>
+#include <span>
+#include <vector>
+#include <siege/platform/shared.hpp>
+#include <siege/content/pal/palette.hpp>
+
+namespace siege::content::pal
+{
+  struct palette_entry
+  {
+    // The palette file, which may be inside of an archive.
+    std::filesystem::path path;
+    // The index given to the palette by its file, or its position in the file when there is none.
+    std::uint32_t index;
+    std::uint32_t position;
+    std::uint64_t colour_hash;
+    std::vector<colour> colours;
+  };
+
+  std::uint64_t get_colour_hash(std::span<const colour> colours);
+
+  // Where the palette index and palette mapping are kept, so that every tool shares them.
+  // This is the cache folder of the current user, and not a temporary folder, since the index is slow to build and must not be cleaned up.
+  std::filesystem::path get_default_palette_index_folder();
+
+  // Reads every palette which a PAL, PPL, DPL or Earthsiege palette file contains.
+  std::vector<palette_entry> get_palette_entries(const std::filesystem::path& path, std::istream& raw_data);
+
+  // Keeps track of every palette found under a folder, so that bitmaps can find their palettes without rescanning the disk.
+  // The index is saved to a file, and files whose size and modification time have not changed are not parsed again.
+  class palette_registry
+  {
+  public:
+    using get_embedded_palettes = std::set<std::filesystem::path>(std::filesystem::path);
+    using resolve_embedded_palette = std::vector<char>(std::filesystem::path);
+
+    explicit palette_registry(std::filesystem::path index_path);
+
+    // Finds every palette under root, up to max_depth folders deep.
+    // Archives are asked for the palette files they contain with get_embedded,
+    // and those files are read with resolve_embedded.
+    // Folders which were already scanned are skipped unless force is set, in which case false is returned.
+    bool scan(const std::filesystem::path& root,
+      std::span<const siege::fs_string_view> palette_extensions,
+      std::move_only_function<get_embedded_palettes> get_embedded,
+      std::move_only_function<resolve_embedded_palette> resolve_embedded,
+      int max_depth = 3,
+      bool force = false);
+
+    // Calls visit with each palette which has the given index, the ones closest to folder first, until visit returns false.
+    // The palettes are only lent out for the call, which must not use the registry itself, so nothing is copied or sorted to find them.
+    void find_by_index(std::uint32_t index, const std::filesystem::path& folder, const std::function<bool(const palette_entry&)>& visit) const;
+
+    std::vector<palette_entry> find_by_hash(std::uint64_t colour_hash) const;
+
+    // Every palette found under root, grouped by file and in path order.
+    std::vector<palette_entry> get_palettes(const std::filesystem::path& root) const;
+
+    void save() const;
+
+  private:
+    struct indexed_file
+    {
+      std::uint64_t size;
+      std::int64_t last_write_time;
+      std::vector<palette_entry> palettes;
+    };
+
+    void load();
+    void rebuild_lookups();
+
+    std::filesystem::path index_path;
+    mutable std::shared_mutex mutex;
+    std::map<std::filesystem::path, indexed_file> files;
+    std::set<std::filesystem::path> scanned_roots;
+
+    // Points into files, sorted by palette index and then by folder, for O(log n) lookups.
+    // The palettes under any one folder are next to each other, which is what lets find_by_index go from the closest to the furthest.
+    std::multimap<std::pair<std::uint32_t, std::filesystem::path>, const palette_entry*> by_index;
+    std::multimap<std::uint64_t, const palette_entry*> by_hash;
+  };
+}// namespace siege::content::pal
+
+#endif// SIEGE_CONTENT_PALETTE_REGISTRY_HPP
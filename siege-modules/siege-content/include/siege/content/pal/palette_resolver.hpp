@@ -0,0 +1,49 @@
+#ifndef SIEGE_CONTENT_PALETTE_RESOLVER_HPP
+#define SIEGE_CONTENT_PALETTE_RESOLVER_HPP
+
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <optional>
+#include <set>
+#include <span>
+#include <string_view>
+#include <vector>
+#include <siege/platform/shared.hpp>
+#include <siege/content/pal/palette_detection.hpp>
+#include <siege/content/pal/palette_registry.hpp>
+
+namespace siege::content::pal
+{
+  // The palette files which tools scan for, both as file system paths and as names inside of archives.
+  constexpr auto palette_file_extensions = std::array<siege::fs_string_view, 4>{ { FSL".pal", FSL".ipl", FSL".ppl", FSL".dpl" } };
+  constexpr auto palette_archive_extensions = std::array<std::string_view, 4>{ { ".pal", ".ipl", ".ppl", ".dpl" } };
+
+  // Finds the palettes for each input, from the folder which it is or is in, and saves the index when anything new was found.
+  // Archives are asked for the palette files they contain with get_embedded, and those files are read with resolve_embedded.
+  void scan_input_palettes(palette_registry& registry,
+    std::span<const std::filesystem::path> inputs,
+    const std::function<std::set<std::filesystem::path>(std::filesystem::path)>& get_embedded,
+    const std::function<std::vector<char>(std::filesystem::path)>& resolve_embedded);
+
+  // The same greyscale ramp as the bitmap viewer, so that a bitmap with no palette is at least recognisable.
+  std::vector<colour> get_greyscale_palette();
+
+  // Picks the palette for a bitmap: the one forced by the caller, then the one assigned by palette detection,
+  // then the closest one with a matching palette index, then the closest one of any kind, and finally greyscale.
+  class palette_resolver
+  {
+  public:
+    palette_resolver(const palette_registry& registry, const palette_mapping& mapping, std::optional<palette_entry> forced = std::nullopt);
+
+    std::vector<colour> resolve(const std::filesystem::path& bitmap, std::optional<std::uint32_t> palette_index) const;
+
+  private:
+    const palette_registry& registry;
+    const palette_mapping& mapping;
+    std::optional<palette_entry> forced;
+  };
+}// namespace siege::content::pal
+
+#endif// SIEGE_CONTENT_PALETTE_RESOLVER_HPP
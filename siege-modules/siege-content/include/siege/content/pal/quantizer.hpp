@@ -0,0 +1,76 @@
+#ifndef SIEGE_CONTENT_QUANTIZER_HPP
+#define SIEGE_CONTENT_QUANTIZER_HPP
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <span>
+#include <vector>
+#include <siege/content/pal/palette.hpp>
+#include <siege/platform/pixel_buffer.hpp>
+
+namespace siege::content::pal
+{
+  enum class dither_method
+  {
+    none,
+    // Error diffusion, which gives the smoothest gradients.
+    floyd_steinberg,
+    // An 8x8 Bayer pattern, which keeps flat areas stable between frames of an animation.
+    ordered
+  };
+
+  struct quantize_settings
+  {
+    dither_method dither = dither_method::floyd_steinberg;
+    // How much of the error is spread to the neighbouring pixels, or how strong the ordered pattern is.
+    float strength = 1.0f;
+    // Pixels whose alpha is below the threshold become this index, which is never picked for any other pixel.
+    std::optional<std::uint8_t> transparent_index;
+    std::uint8_t alpha_threshold = 128;
+    // The most threads used for any dithering method. Zero uses every core.
+    std::size_t max_threads = 0;
+  };
+
+  // Finds the closest palette colour using the same redmean metric as colour_distance.
+  // The palette is split into cells which only keep the colours that could be closest to some point in the cell,
+  // and recent answers are remembered in a lock free table, so one instance can be shared by many threads.
+  class nearest_colour_cache
+  {
+  public:
+    explicit nearest_colour_cache(std::span<const colour> colours, std::optional<std::uint8_t> excluded_index = std::nullopt);
+
+    std::uint8_t find(std::uint8_t red, std::uint8_t green, std::uint8_t blue) const;
+
+    std::span<const colour> get_colours() const
+    {
+      return colours;
+    }
+
+  private:
+    static constexpr std::size_t cell_bits = 4;
+    static constexpr std::size_t cells_per_channel = 1 << cell_bits;
+    static constexpr std::size_t answer_count = 1 << 16;
+
+    std::vector<colour> colours;
+    // For each cell, where its candidates start in candidates, with one extra entry at the end.
+    std::array<std::uint32_t, cells_per_channel * cells_per_channel * cells_per_channel + 1> cell_offsets{};
+    std::vector<std::uint8_t> candidates;
+    // The colour in the top 24 bits and the index in the bottom 8, with zero as an empty slot.
+    std::unique_ptr<std::atomic<std::uint32_t>[]> answers;
+  };
+
+  // Maps every pixel of a true colour image to the closest colour of the palette, one index per pixel.
+  // Indexed images are converted to RGBA first.
+  platform::bitmap::pixel_buffer quantize(platform::bitmap::const_pixel_view pixels,
+    std::span<const colour> colours,
+    const quantize_settings& settings = {});
+
+  platform::bitmap::pixel_buffer quantize(platform::bitmap::const_pixel_view pixels,
+    const nearest_colour_cache& cache,
+    const quantize_settings& settings = {});
+}// namespace siege::content::pal
+
+#endif// SIEGE_CONTENT_QUANTIZER_HPP
@@ -7,6 +7,7 @@
 #include <variant>
 #include <unordered_map>
 #include "3d_structures.hpp"
+#include "mesh_batch.hpp"
 
 namespace siege::content
 {
@@ -22,6 +23,10 @@ namespace siege::content
 
     virtual void render_shape(shape_renderer& renderer, const std::vector<std::size_t>& detail_level_indexes, const std::vector<sequence_info>& sequences) const = 0;
 
+    // The same triangles as render_shape, but grouped by object and material with shared vertices.
+    // Shapes which can build the batches directly should override this, since the default goes through render_shape.
+    virtual std::vector<mesh_batch> get_mesh_batches(const std::vector<std::size_t>& detail_level_indexes, const std::vector<sequence_info>& sequences) const;
+
     virtual ~renderable_shape() = default;
   };
 
@@ -50,6 +55,7 @@ namespace siege::content
     std::int32_t num_key_frames;
     float min_position;
     float max_position;
+    // Where the sub sequence is sampled, between min_position and max_position, with keyframes interpolated in between.
     float position;
     bool enabled;
   };
@@ -0,0 +1,91 @@
+#ifndef SIEGE_CONTENT_SOFTWARE_RASTERISER_HPP
+#define SIEGE_CONTENT_SOFTWARE_RASTERISER_HPP
+
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+#include <siege/platform/palette.hpp>
+#include <siege/platform/pixel_buffer.hpp>
+#include <siege/content/mesh_batch.hpp>
+#include <siege/content/renderable_shape.hpp>
+
+namespace siege::content
+{
+  // The pixels of a texture as colours, with the top row first, so that sampling is a single lookup.
+  struct raster_texture
+  {
+    std::size_t width = 0;
+    std::size_t height = 0;
+    std::vector<platform::palette::colour> pixels;
+  };
+
+  // Indexed pixels are looked up in colours, and every other format is expanded as it is.
+  raster_texture to_raster_texture(platform::bitmap::const_pixel_view pixels, std::span<const platform::palette::colour> colours);
+
+  struct raster_material
+  {
+    // Used for triangles without a texture, such as when it could not be found.
+    platform::palette::colour colour{ std::byte{ 200 }, std::byte{ 200 }, std::byte{ 200 }, std::byte{ 0xff } };
+    std::shared_ptr<const raster_texture> texture;
+  };
+
+  // The colour of the material, from its rgbData when it has one.
+  raster_material to_raster_material(const material& source);
+
+  // Where the shape is seen from. The camera circles the centre of everything being drawn,
+  // far enough away that all of it is in view.
+  struct raster_camera
+  {
+    // In degrees, around the up axis and then above the horizon.
+    float yaw = 35;
+    float pitch = 25;
+    float field_of_view = 45;
+    // Darkstar, 3Space and the id Tech formats are Z up. PlayStation models are Y up.
+    vector3f up{ 0, 0, 1 };
+  };
+
+  // Draws depth tested, textured triangles into an RGBA image without needing a GPU.
+  // Triangles are first sorted into the screen tiles they overlap, and then every tile is drawn in parallel,
+  // which needs no locking since each one only writes to its own pixels.
+  class software_rasteriser
+  {
+  public:
+    software_rasteriser(std::size_t width, std::size_t height, std::size_t tile_size = 32);
+
+    void clear(platform::palette::colour background);
+
+    // Batches refer to materials by index, and ones without a matching material are drawn in grey.
+    // Both sides of every triangle are drawn, since which way triangles wind is not the same for every format.
+    void draw(std::span<const mesh_batch> batches, std::span<const raster_material> materials, const raster_camera& camera);
+
+    // RGBA pixels with the top row first, where nothing was drawn keeps the clear colour.
+    platform::bitmap::pixel_buffer get_pixels() const;
+
+    std::size_t get_width() const
+    {
+      return width;
+    }
+
+    std::size_t get_height() const
+    {
+      return height;
+    }
+
+  private:
+    std::size_t width;
+    std::size_t height;
+    std::size_t tile_size;
+    std::vector<platform::palette::colour> colours;
+    // 1 / depth, so that 0 is infinitely far away and the buffer can be cleared with zeroes.
+    std::vector<float> depths;
+  };
+
+  // Draws the first detail level of a shape in its default pose, as a size by size image.
+  platform::bitmap::pixel_buffer render_thumbnail(const renderable_shape& shape,
+    std::span<const raster_material> materials,
+    std::size_t size,
+    const raster_camera& camera = {});
+}// namespace siege::content
+
+#endif// SIEGE_CONTENT_SOFTWARE_RASTERISER_HPP
@@ -1,6 +1,7 @@
 #include <set>
 #include <map>
 #include <cmath>
+#include <cstring>
 #include <siege/content/bmp/bitmap.hpp>
 #include <siege/platform/tagged_data.hpp>
 #include <siege/platform/stream.hpp>
@@ -120,123 +121,266 @@ namespace siege::content::bmp
     return results;
   }
 
-  template<typename AlignmentType, typename PixelType>
-  [[maybe_unused]] std::size_t read_pixel_data(std::istream& raw_data, std::vector<PixelType>& raw_pixels, std::int32_t width, std::int32_t height, std::int32_t bit_depth)
+  bool is_phoenix_bmp(std::istream& raw_data)
   {
-    const auto x_stride = width * bit_depth / 8;
-    const auto padding = platform::get_padding_size(x_stride, sizeof(AlignmentType));
+    std::array<std::byte, 4> header{};
+    platform::read(raw_data, header.data(), sizeof(header));
 
-    if (padding == 0)
+    raw_data.seekg(-int(sizeof(header)), std::ios::cur);
+
+    return header == pbmp_tag;
+  }
+
+  namespace
+  {
+    // Rows of PBMP pixels are padded to four bytes, including the rows of each detail level.
+    std::size_t get_pbmp_stride(std::size_t width, std::size_t bit_depth)
     {
-      platform::read(raw_data, reinterpret_cast<char*>(raw_pixels.data()), raw_pixels.size() * sizeof(PixelType));
-      return raw_pixels.size();
+      const auto row_size = width * bit_depth / 8;
+      return row_size + platform::get_padding_size(row_size, sizeof(std::int32_t));
     }
-    else
+
+    std::size_t get_pbmp_detail_offset(const pbmp_frame_layout& layout, std::size_t detail_level)
     {
-      std::vector<std::byte> padding_bytes(padding);
+      std::size_t offset = 0;
 
-      auto pos = 0u;
+      for (auto level = 0u; level < detail_level; ++level)
+      {
+        auto [width, height] = get_pbmp_detail_size(layout, level);
+        offset += get_pbmp_stride(width, layout.bmp_header.bit_depth) * height;
+      }
+
+      return offset;
+    }
+
+    void read_pbmp_rows(std::istream& raw_data, std::size_t row_size, std::size_t stride, std::size_t height, std::span<std::byte> destination)
+    {
+      if (row_size == stride)
+      {
+        platform::read(raw_data, destination.data(), std::min(destination.size(), row_size * height));
+        return;
+      }
 
-      auto start = raw_data.tellg();
-      for (auto i = 0; i < height; ++i)
+      for (auto y = 0u; y < height && (y + 1) * row_size <= destination.size(); ++y)
       {
-        if (pos > raw_pixels.size())
+        platform::read(raw_data, destination.data() + y * row_size, row_size);
+        raw_data.ignore(stride - row_size);
+      }
+    }
+
+    // Reads the chunks of one PBMP image, leaving the stream at the end of it.
+    pbmp_frame_layout read_pbmp_frame_layout(std::istream& raw_data)
+    {
+      const auto start = std::size_t(raw_data.tellg());
+      std::array<std::byte, 4> header{};
+      endian::little_uint32_t file_size{};
+
+      platform::read(raw_data, header.data(), sizeof(header));
+      platform::read(raw_data, reinterpret_cast<char*>(&file_size), sizeof(file_size));
+
+      if (header != pbmp_tag)
+      {
+        throw std::invalid_argument("File data is not PBMP based. Offset is " + std::to_string(raw_data.tellg()));
+      }
+
+      pbmp_frame_layout layout{};
+
+      auto end = start + file_size + sizeof(header) + sizeof(file_size) + sizeof(std::int32_t) + sizeof(std::array<std::int32_t, 6>);
+
+      while (std::size_t(raw_data.tellg()) < end)
+      {
+        std::array<std::byte, 4> chunk_header{};
+        endian::little_uint32_t chunk_size{};
+
+        platform::read(raw_data, chunk_header.data(), chunk_header.size());
+        platform::read(raw_data, reinterpret_cast<char*>(&chunk_size), sizeof(chunk_size));
+
+        if (chunk_header == header_tag)
+        {
+          platform::read(raw_data, reinterpret_cast<char*>(&layout.bmp_header), sizeof(layout.bmp_header));
+        }
+        else if (chunk_header == data_tag)
+        {
+          // PBMP files contain mip maps of the main image, which are only read when asked for.
+          layout.data_offset = std::size_t(raw_data.tellg());
+          layout.data_size = chunk_size;
+          raw_data.seekg(chunk_size, std::ios::cur);
+        }
+        else if (chunk_header == detail_tag)
         {
+          endian::little_uint32_t detail_levels{};
+          platform::read(raw_data, reinterpret_cast<char*>(&detail_levels), sizeof(detail_levels));
+          layout.detail_levels = detail_levels;
+        }
+        else if (chunk_header == palette_tag)
+        {
+          endian::little_uint32_t palette_index{};
+          platform::read(raw_data, reinterpret_cast<char*>(&palette_index), sizeof(palette_index));
+          layout.palette_index = palette_index;
+        }
+        else if (chunk_header == pbmp_tag)
+        {
+          raw_data.seekg(-int(sizeof(file_size)), std::ios::cur);
+          raw_data.seekg(-int(sizeof(pbmp_tag)), std::ios::cur);
           break;
         }
-
-        platform::read(raw_data, reinterpret_cast<char*>(raw_pixels.data()) + pos, x_stride);
-        platform::read(raw_data, padding_bytes.data(), padding_bytes.size());
-        pos += x_stride;
+        else
+        {
+          if (chunk_size == 0)
+          {
+            break;
+          }
+          raw_data.seekg(chunk_size, std::ios::cur);
+        }
       }
 
-      return raw_data.tellg() - start;
+      return layout;
     }
-  }
 
-  bool is_phoenix_bmp(std::istream& raw_data)
-  {
-    std::array<std::byte, 4> header{};
-    platform::read(raw_data, header.data(), sizeof(header));
+    std::uint32_t read_pba_header(std::istream& raw_data)
+    {
+      std::array<std::byte, 4> header{};
+      endian::little_uint32_t count{};
 
-    raw_data.seekg(-int(sizeof(header)), std::ios::cur);
+      platform::read(raw_data, header.data(), sizeof(header));
+      platform::read(raw_data, reinterpret_cast<char*>(&count), sizeof(count));
 
-    return header == pbmp_tag;
-  }
+      if (header != pba_tag)
+      {
+        throw std::invalid_argument("File data is not PBA based.");
+      }
+
+      platform::read(raw_data, header.data(), sizeof(header));
+
+      platform::read(raw_data, reinterpret_cast<char*>(&count), sizeof(count));
+
+      // Count appears twice in the files. Or it means something else. Haven't seen a file where it is something else.
+      platform::read(raw_data, reinterpret_cast<char*>(&count), sizeof(count));
+      platform::read(raw_data, reinterpret_cast<char*>(&count), sizeof(count));
+
+      return count;
+    }
+  }// namespace
 
   pbmp_data get_pbmp_data(std::istream& raw_data)
   {
-    const auto start = std::size_t(raw_data.tellg());
-    std::array<std::byte, 4> header{};
-    endian::little_uint32_t file_size{};
+    auto layout = read_pbmp_frame_layout(raw_data);
+    auto end = raw_data.tellg();
 
-    platform::read(raw_data, header.data(), sizeof(header));
-    platform::read(raw_data, reinterpret_cast<char*>(&file_size), sizeof(file_size));
+    const auto& bmp_header = layout.bmp_header;
+    const auto num_pixels = bmp_header.width.value() * bmp_header.height * (bmp_header.bit_depth / 8);
+    std::vector<std::byte> pixels(num_pixels, std::byte{});
+
+    if (layout.data_size > 0)
+    {
+      raw_data.seekg(layout.data_offset);
+      read_pbmp_rows(raw_data, bmp_header.width * bmp_header.bit_depth / 8, get_pbmp_stride(bmp_header.width, bmp_header.bit_depth), bmp_header.height, pixels);
+      raw_data.clear();
+      raw_data.seekg(end);
+    }
+
+    return {
+      bmp_header,
+      layout.detail_levels,
+      layout.palette_index,
+      std::move(pixels)
+    };
+  }
 
-    if (header != pbmp_tag)
+  std::vector<pbmp_frame_layout> get_pbmp_layout(std::istream& raw_data)
+  {
+    if (is_phoenix_bmp(raw_data))
     {
-      throw std::invalid_argument("File data is not PBMP based. Offset is " + std::to_string(raw_data.tellg()));
+      return { read_pbmp_frame_layout(raw_data) };
     }
 
-    pbmp_header bmp_header{};
-    endian::little_uint32_t detail_levels{};
-    endian::little_uint32_t palette_index{};
-    std::vector<std::byte> pixels;
+    auto count = read_pba_header(raw_data);
 
-    auto end = start + file_size + sizeof(header) + sizeof(file_size) + sizeof(std::int32_t) + sizeof(std::array<std::int32_t, 6>);
+    std::vector<pbmp_frame_layout> results;
+    results.reserve(count);
 
-    while (std::size_t(raw_data.tellg()) < end)
+    for (auto i = 0u; i < count; ++i)
     {
-      std::array<std::byte, 4> chunk_header{};
-      endian::little_uint32_t chunk_size{};
+      results.emplace_back(read_pbmp_frame_layout(raw_data));
+    }
 
-      platform::read(raw_data, chunk_header.data(), chunk_header.size());
-      platform::read(raw_data, reinterpret_cast<char*>(&chunk_size), sizeof(chunk_size));
+    return results;
+  }
 
-      if (chunk_header == header_tag)
-      {
-        platform::read(raw_data, reinterpret_cast<char*>(&bmp_header), sizeof(bmp_header));
+  std::size_t get_pbmp_detail_count(const pbmp_frame_layout& layout)
+  {
+    auto count = std::max<std::size_t>(1, layout.detail_levels);
 
-        const auto num_pixels = bmp_header.width.value() * bmp_header.height * (bmp_header.bit_depth / 8);
-        pixels = std::vector<std::byte>(num_pixels, std::byte{});
-      }
-      else if (chunk_header == data_tag)
-      {
-        auto bytes_read = read_pixel_data<std::int32_t>(raw_data, pixels, bmp_header.width, bmp_header.height, bmp_header.bit_depth);
-        // PBMP files contain mip maps of the main image.
-        // For now, we won't worry about them.
-        raw_data.seekg(chunk_size - bytes_read, std::ios::cur);
-      }
-      else if (chunk_header == detail_tag)
-      {
-        platform::read(raw_data, reinterpret_cast<char*>(&detail_levels), sizeof(detail_levels));
-      }
-      else if (chunk_header == palette_tag)
-      {
-        platform::read(raw_data, reinterpret_cast<char*>(&palette_index), sizeof(palette_index));
-      }
-      else if (chunk_header == pbmp_tag)
+    // Only the levels which actually fit in the pixel data are counted.
+    while (count > 1)
+    {
+      auto [width, height] = get_pbmp_detail_size(layout, count - 1);
+
+      if (get_pbmp_detail_offset(layout, count - 1) + get_pbmp_stride(width, layout.bmp_header.bit_depth) * height <= layout.data_size)
       {
-        raw_data.seekg(-int(sizeof(file_size)), std::ios::cur);
-        raw_data.seekg(-int(sizeof(pbmp_tag)), std::ios::cur);
         break;
       }
-      else
-      {
-        if (chunk_size == 0)
-        {
-          break;
-        }
-        raw_data.seekg(chunk_size, std::ios::cur);
-      }
+
+      --count;
     }
 
-    return {
-      bmp_header,
-      detail_levels,
-      palette_index,
-      pixels
-    };
+    return count;
+  }
+
+  std::pair<std::size_t, std::size_t> get_pbmp_detail_size(const pbmp_frame_layout& layout, std::size_t detail_level)
+  {
+    auto width = std::size_t(std::abs(layout.bmp_header.width.value()));
+    auto height = std::size_t(std::abs(layout.bmp_header.height.value()));
+
+    return std::make_pair(std::max<std::size_t>(1, width >> detail_level), std::max<std::size_t>(1, height >> detail_level));
+  }
+
+  static platform::bitmap::pixel_buffer create_pbmp_pixels(const pbmp_frame_layout& layout, std::size_t detail_level)
+  {
+    if (layout.bmp_header.bit_depth != 8)
+    {
+      throw std::invalid_argument("Only 8-bit PBMP images can be decoded.");
+    }
+
+    if (detail_level >= get_pbmp_detail_count(layout))
+    {
+      throw std::out_of_range("The PBMP image does not have detail level " + std::to_string(detail_level));
+    }
+
+    auto [width, height] = get_pbmp_detail_size(layout, detail_level);
+    return platform::bitmap::pixel_buffer(platform::bitmap::pixel_format::indexed_8, width, height);
+  }
+
+  platform::bitmap::pixel_buffer read_pbmp_pixels(std::istream& raw_data, const pbmp_frame_layout& layout, std::size_t detail_level)
+  {
+    auto result = create_pbmp_pixels(layout, detail_level);
+
+    // Reading the layout can leave the stream at the end of the file.
+    raw_data.clear();
+    raw_data.seekg(layout.data_offset + get_pbmp_detail_offset(layout, detail_level));
+    read_pbmp_rows(raw_data, result.get_stride(), get_pbmp_stride(result.get_width(), 8), result.get_height(), result.bytes());
+
+    return result;
+  }
+
+  platform::bitmap::pixel_buffer read_pbmp_pixels(std::span<const std::byte> raw_data, const pbmp_frame_layout& layout, std::size_t detail_level)
+  {
+    auto result = create_pbmp_pixels(layout, detail_level);
+
+    const auto source_stride = get_pbmp_stride(result.get_width(), 8);
+    const auto first = layout.data_offset + get_pbmp_detail_offset(layout, detail_level);
+
+    if (first > raw_data.size() || raw_data.size() - first < source_stride * (result.get_height() - 1) + result.get_stride())
+    {
+      throw std::out_of_range("The PBMP pixel data goes past the end of the file.");
+    }
+
+    for (auto y = 0u; y < result.get_height(); ++y)
+    {
+      std::memcpy(result.row(y).data(), raw_data.data() + first + y * source_stride, result.get_stride());
+    }
+
+    return result;
   }
 
   void write_pbmp_data(std::ofstream& raw_data,
@@ -308,25 +452,7 @@ namespace siege::content::bmp
   {
     std::vector<pbmp_data> results;
 
-    std::array<std::byte, 4> header{};
-    endian::little_uint32_t count{};
-
-    platform::read(raw_data, header.data(), sizeof(header));
-    platform::read(raw_data, reinterpret_cast<char*>(&count), sizeof(count));
-
-    if (header != pba_tag)
-    {
-      throw std::invalid_argument("File data is not PBA based.");
-    }
-
-    platform::read(raw_data, header.data(), sizeof(header));
-
-    platform::read(raw_data, reinterpret_cast<char*>(&count), sizeof(count));
-
-    // Count appears twice in the files. Or it means something else. Haven't seen a file where it is something else.
-    platform::read(raw_data, reinterpret_cast<char*>(&count), sizeof(count));
-    platform::read(raw_data, reinterpret_cast<char*>(&count), sizeof(count));
-
+    auto count = read_pba_header(raw_data);
     results.reserve(count);
 
     for (auto i = 0u; i < count; ++i)
@@ -353,64 +479,10 @@ namespace siege::content::bmp
       return pixels;
     }
 
-    std::vector<IndexType> results;
-    results.reserve(pixels.size());
-    std::map<std::size_t, std::size_t> palette_map;
-
-    for (auto x = 0u; x < original_colours.size(); x++)
-    {
-      auto& colour = original_colours[x];
-      auto result = std::find_if(other_colours.begin(), other_colours.end(), [&](auto& other) {
-             return other.red == colour.red && other.green == colour.green && other.blue == colour.blue;
-      });
-
-      if (result != other_colours.end())
-      {
-        auto other_index = std::distance(other_colours.begin(), result);
-        palette_map[x] = other_index;
-      }
-      else
-      {
-        std::map<double, std::size_t> distances;
-        for (auto y = 0u; y < other_colours.size(); y++)
-        {
-          auto& other = other_colours[y];
-          auto distance = pal::colour_distance(colour, other);
-          distances[distance] = y;
-        }
-
-        if (only_unique)
-        {
-          for (auto distance : distances)
-          {
-            auto already_exists = std::find_if(palette_map.begin(), palette_map.end(), [&](auto& elem) {
-                   return elem.second == distance.second;
-            });
-
-            if (already_exists == palette_map.end())
-            {
-              palette_map[x] = distance.second;
-              break;
-            }
-          }
-
-          if (auto inserted = palette_map.find(x); inserted == palette_map.end())
-          {
-            palette_map[x] = distances.begin()->second;
-          }
-        }
-        else
-        {
-          palette_map[x] = distances.begin()->second;
-        }
-      }
-    }
+    auto table = platform::palette::get_remap_table(original_colours, other_colours, only_unique);
 
-    for (auto pixel : pixels)
-    {
-      auto new_index = palette_map[std::size_t(pixel)];
-      results.emplace_back(IndexType(new_index));
-    }
+    std::vector<IndexType> results(pixels.size());
+    platform::palette::apply_remap_table(*table, pixels, results);
 
     return results;
   }
@@ -0,0 +1,69 @@
+#include <spanstream>
+#include <siege/content/bmp/bitmap_frames.hpp>
+#include <siege/content/bmp/bitmap.hpp>
+#include <siege/content/bmp/tim.hpp>
+#include <siege/platform/bitmap.hpp>
+
+namespace siege::content::bmp
+{
+  using namespace siege::platform::bitmap;
+
+  void decode_bitmap_frames(std::span<const char> contents,
+    const std::filesystem::path& path,
+    const pal::palette_resolver& palettes,
+    const frame_callback& on_frame,
+    std::size_t max_frames)
+  {
+    std::ispanstream stream(contents);
+    std::size_t decoded = 0;
+
+    auto add_frame = [&](std::size_t index, std::size_t count, decoded_frame frame) {
+      if (decoded < max_frames)
+      {
+        decoded++;
+        on_frame(index, count, std::move(frame));
+      }
+    };
+
+    auto add_indexed = [&](std::size_t index, std::size_t count, std::size_t width, std::size_t height, std::vector<std::byte> pixels, std::optional<std::uint32_t> palette_index) {
+      add_frame(index, count, decoded_frame{ palettes.resolve(path, palette_index), pixel_buffer(pixel_format::indexed_8, width, height, std::move(pixels)) });
+    };
+
+    if (is_phoenix_bmp(stream) || is_phoenix_bmp_array(stream))
+    {
+      auto frames = get_pbmp_layout(stream);
+
+      for (auto i = 0u; i < frames.size() && decoded < max_frames; ++i)
+      {
+        if (frames[i].bmp_header.bit_depth == 8 && frames[i].data_size > 0)
+        {
+          add_frame(i, frames.size(), decoded_frame{ palettes.resolve(path, frames[i].palette_index), read_pbmp_pixels(std::as_bytes(contents), frames[i]) });
+        }
+      }
+    }
+    else if (is_earthsiege_bmp(stream))
+    {
+      auto image = read_earthsiege_bmp(stream);
+      add_indexed(0, 1, image.header.width, image.header.height, std::move(image.pixels), std::nullopt);
+    }
+    else if (is_earthsiege_bmp_array(stream))
+    {
+      auto images = read_earthsiege_bmp_array(stream);
+
+      for (auto i = 0u; i < images.size(); ++i)
+      {
+        add_indexed(i, images.size(), images[i].header.width, images[i].header.height, std::move(images[i].pixels), std::nullopt);
+      }
+    }
+    else if (tim::is_tim(stream))
+    {
+      auto image = tim::get_tim_data_as_bitmap(stream);
+      add_frame(0, 1, decoded_frame{ std::move(image.colours), std::move(image.pixels) });
+    }
+    else if (is_microsoft_bmp(stream))
+    {
+      auto image = get_bmp_data(stream);
+      add_frame(0, 1, decoded_frame{ std::move(image.colours), std::move(image.pixels) });
+    }
+  }
+}// namespace siege::content::bmp
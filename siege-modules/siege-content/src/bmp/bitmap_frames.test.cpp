@@ -0,0 +1,48 @@
+#include <atomic>
+#include <sstream>
+#include <catch2/catch_test_macros.hpp>
+#include <siege/content/bmp/bitmap_frames.hpp>
+#include <siege/platform/bitmap.hpp>
+#include "test_helpers.hpp"
+
+namespace fs = std::filesystem;
+namespace bmp = siege::content::bmp;
+namespace pal = siege::content::pal;
+
+TEST_CASE("Textures are found by name in any case, and each one is only read and decoded the once", "[bmp.texture_cache]")
+{
+  auto colours = siege::content::test_helpers::make_palette();
+  siege::platform::bitmap::pixel_buffer pixels(siege::platform::bitmap::pixel_format::indexed_8, 3, 2, std::vector<std::byte>(6));
+
+  std::ostringstream output(std::ios::binary);
+  siege::platform::bitmap::write_bmp_data(output, colours, pixels);
+  auto bitmap = std::move(output).str();
+
+  siege::platform::file_info texture{};
+  texture.filename = "Grass.BMP";
+  texture.folder_path = fs::temp_directory_path();
+  texture.size = bitmap.size();
+
+  auto root = fs::temp_directory_path() / "texture_cache_test";
+  pal::palette_registry registry(root / "palettes.idx");
+  pal::palette_mapping mapping(root / "mapping.idx");
+  pal::palette_resolver palettes(registry, mapping);
+
+  std::atomic_size_t reads = 0;
+  bmp::texture_cache<std::size_t> textures([&](const siege::platform::file_info&) {
+    reads++;
+    return std::vector<char>(bitmap.begin(), bitmap.end());
+  },
+    palettes,
+    [](bmp::decoded_frame frame) { return frame.pixels.get_width(); });
+
+  textures.add_files({ texture });
+
+  REQUIRE(textures.get("missing.bmp") == nullptr);
+
+  auto width = textures.get("grass.bmp");
+  REQUIRE(width != nullptr);
+  REQUIRE(*width == 3);
+  REQUIRE(textures.get("GRASS.bmp") == width);
+  REQUIRE(reads == 1);
+}
@@ -0,0 +1,116 @@
+#include <catch2/catch_test_macros.hpp>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <siege/content/bmp/bitmap.hpp>
+
+namespace bmp = siege::content::bmp;
+namespace pal = siege::content::pal;
+namespace fs = std::filesystem;
+
+namespace
+{
+  // Each level is filled with its own pattern, with every row padded to four bytes.
+  std::vector<std::byte> make_detail_levels(std::size_t width, std::size_t height, std::size_t levels)
+  {
+    std::vector<std::byte> pixels;
+
+    for (auto level = 0u; level < levels; ++level)
+    {
+      auto level_width = std::max<std::size_t>(1, width >> level);
+      auto level_height = std::max<std::size_t>(1, height >> level);
+      auto stride = (level_width + 3) & ~std::size_t(3);
+
+      for (auto y = 0u; y < level_height; ++y)
+      {
+        for (auto x = 0u; x < stride; ++x)
+        {
+          pixels.emplace_back(x < level_width ? std::byte(level * 64 + y * 7 + x) : std::byte{ 0xff });
+        }
+      }
+    }
+
+    return pixels;
+  }
+
+  std::string write_pbmp(std::size_t width, std::size_t height, std::size_t levels)
+  {
+    auto path = fs::temp_directory_path() / "open-siege-pbmp-layout.bmp";
+    std::vector<pal::colour> colours(256);
+
+    {
+      std::ofstream output(path, std::ios::binary | std::ios::trunc);
+      bmp::write_pbmp_data(output, std::int32_t(width), std::int32_t(height), colours, make_detail_levels(width, height, levels), 7);
+    }
+
+    std::ifstream input(path, std::ios::binary);
+    std::string result{ std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>() };
+    input.close();
+    fs::remove(path);
+
+    // The writer always says there is one detail level.
+    auto detail = result.find("DETL");
+    REQUIRE(detail != std::string::npos);
+    result[detail + 8] = char(levels);
+
+    return result;
+  }
+}// namespace
+
+TEST_CASE("With a PBMP file, the layout describes the image without reading the pixels", "[bmp.pbmp]")
+{
+  auto file = write_pbmp(13, 7, 3);
+  std::istringstream stream(file, std::ios::binary);
+
+  auto layout = bmp::get_pbmp_layout(stream);
+
+  REQUIRE(layout.size() == 1);
+  REQUIRE(layout[0].bmp_header.width == 13);
+  REQUIRE(layout[0].bmp_header.height == 7);
+  REQUIRE(layout[0].palette_index == 7);
+  REQUIRE(layout[0].detail_levels == 3);
+  REQUIRE(layout[0].data_size == 16 * 7 + 8 * 3 + 4 * 1);
+  REQUIRE(bmp::get_pbmp_detail_count(layout[0]) == 3);
+  REQUIRE(bmp::get_pbmp_detail_size(layout[0], 2) == std::make_pair(std::size_t(3), std::size_t(1)));
+}
+
+TEST_CASE("With a PBMP file, the first detail level matches the eagerly read pixels", "[bmp.pbmp]")
+{
+  auto file = write_pbmp(13, 7, 3);
+  std::istringstream stream(file, std::ios::binary);
+
+  auto eager = bmp::get_pbmp_data(stream);
+  stream.seekg(0);
+  auto layout = bmp::get_pbmp_layout(stream);
+
+  auto from_stream = bmp::read_pbmp_pixels(stream, layout[0]);
+  auto from_span = bmp::read_pbmp_pixels(std::as_bytes(std::span(file)), layout[0]);
+
+  REQUIRE(eager.pixels.size() == 13 * 7);
+  REQUIRE(std::ranges::equal(from_stream.bytes(), eager.pixels));
+  REQUIRE(std::ranges::equal(from_span.bytes(), eager.pixels));
+}
+
+TEST_CASE("With a PBMP file, each detail level is read from its own offset", "[bmp.pbmp]")
+{
+  auto file = write_pbmp(13, 7, 3);
+  std::istringstream stream(file, std::ios::binary);
+  auto layout = bmp::get_pbmp_layout(stream);
+
+  for (auto level = 0u; level < 3; ++level)
+  {
+    auto pixels = bmp::read_pbmp_pixels(std::as_bytes(std::span(file)), layout[0], level);
+    REQUIRE(pixels.get_width() == std::max<std::size_t>(1, 13 >> level));
+    REQUIRE(pixels.get_height() == std::max<std::size_t>(1, 7 >> level));
+
+    for (auto y = 0u; y < pixels.get_height(); ++y)
+    {
+      for (auto x = 0u; x < pixels.get_width(); ++x)
+      {
+        REQUIRE(pixels.row(y)[x] == std::byte(level * 64 + y * 7 + x));
+      }
+    }
+  }
+
+  REQUIRE_THROWS_AS(bmp::read_pbmp_pixels(stream, layout[0], 3), std::out_of_range);
+}
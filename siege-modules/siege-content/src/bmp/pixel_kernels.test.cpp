@@ -0,0 +1,99 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <vector>
+#include <siege/platform/pixel_kernels.hpp>
+#include "test_helpers.hpp"
+
+namespace bitmap = siege::platform::bitmap;
+namespace palette = siege::platform::palette;
+using siege::content::test_helpers::make_palette;
+
+namespace
+{
+  bitmap::pixel_buffer make_pixels(bitmap::pixel_format format, std::size_t width, std::size_t height)
+  {
+    bitmap::pixel_buffer pixels(format, width, height);
+    auto bytes = pixels.bytes();
+
+    for (auto i = 0u; i < bytes.size(); ++i)
+    {
+      bytes[i] = std::byte((i * 2654435761u) >> 13);
+    }
+
+    return pixels;
+  }
+
+  std::vector<std::byte> convert(const bitmap::pixel_buffer& pixels, std::span<const palette::colour> colours, bool flip_rows, bitmap::instruction_set instructions)
+  {
+    std::vector<std::byte> result(pixels.get_width() * pixels.get_height() * sizeof(palette::colour));
+    bitmap::convert_to_rgba(pixels, colours, result, flip_rows, instructions);
+    return result;
+  }
+}// namespace
+
+TEST_CASE("Every instruction set produces the same pixels as the scalar kernels", "[bitmap.convert_to_rgba]")
+{
+  // The palette is smaller than the range of 8-bit indexes, so that missing colours are covered too.
+  auto colours = make_palette(200, std::byte{ 0xff });
+
+  for (auto format : { bitmap::pixel_format::indexed_1, bitmap::pixel_format::indexed_4, bitmap::pixel_format::indexed_8, bitmap::pixel_format::rgb_1555, bitmap::pixel_format::rgb_888, bitmap::pixel_format::rgba_8888 })
+  {
+    // An odd width leaves a tail for the scalar kernels to handle.
+    auto pixels = make_pixels(format, 67, 5);
+
+    for (auto flip_rows : { false, true })
+    {
+      auto expected = convert(pixels, colours, flip_rows, bitmap::instruction_set::scalar);
+
+      REQUIRE(convert(pixels, colours, flip_rows, bitmap::instruction_set::sse2) == expected);
+      REQUIRE(convert(pixels, colours, flip_rows, bitmap::instruction_set::avx2) == expected);
+    }
+  }
+}
+
+TEST_CASE("With a 1555 pixel, expands every channel to 8 bits", "[bitmap.convert_to_rgba]")
+{
+  bitmap::pixel_buffer pixels(bitmap::pixel_format::rgb_1555, 1, 2);
+  // Opaque pure blue, then transparent pure red.
+  pixels.bytes()[0] = std::byte{ 0x1f };
+  pixels.bytes()[1] = std::byte{ 0x80 };
+  pixels.bytes()[2] = std::byte{ 0x00 };
+  pixels.bytes()[3] = std::byte{ 0x7c };
+
+  auto result = convert(pixels, {}, true, bitmap::instruction_set::scalar);
+
+  REQUIRE(result == std::vector<std::byte>{ std::byte{ 0xff }, std::byte{}, std::byte{}, std::byte{}, std::byte{}, std::byte{}, std::byte{ 0xff }, std::byte{ 0xff } });
+}
+
+TEST_CASE("With a destination that is too small, throws", "[bitmap.convert_to_rgba]")
+{
+  auto pixels = make_pixels(bitmap::pixel_format::indexed_8, 4, 4);
+  std::vector<std::byte> destination(4 * 4 * 3);
+
+  REQUIRE_THROWS_AS(bitmap::convert_to_rgba(pixels, make_palette(256, std::byte{ 0xff }), destination, false, bitmap::instruction_set::scalar), std::invalid_argument);
+}
+
+TEST_CASE("Throughput of expanding a 1024x1024 image to RGBA", "[bitmap.convert_to_rgba][!benchmark]")
+{
+  auto colours = make_palette(256, std::byte{ 0xff });
+  std::vector<std::byte> destination(1024 * 1024 * sizeof(palette::colour));
+
+  for (auto [format, name] : { std::pair{ bitmap::pixel_format::indexed_4, "4-bit" }, std::pair{ bitmap::pixel_format::indexed_8, "8-bit" }, std::pair{ bitmap::pixel_format::rgb_1555, "1555" } })
+  {
+    auto pixels = make_pixels(format, 1024, 1024);
+
+    for (auto [instructions, instructions_name] : { std::pair{ bitmap::instruction_set::scalar, "scalar" }, std::pair{ bitmap::instruction_set::sse2, "sse2" }, std::pair{ bitmap::instruction_set::avx2, "avx2" } })
+    {
+      if (instructions > bitmap::get_supported_instruction_set())
+      {
+        continue;
+      }
+
+      BENCHMARK(std::string(name) + " " + instructions_name)
+      {
+        bitmap::convert_to_rgba(pixels, colours, destination, true, instructions);
+        return destination[0];
+      };
+    }
+  }
+}
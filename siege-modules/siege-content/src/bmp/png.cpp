@@ -0,0 +1,597 @@
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <zlib.h>
+#include <siege/content/bmp/png.hpp>
+#include <siege/platform/bitmap.hpp>
+#include <siege/platform/stream.hpp>
+#include <siege/platform/tagged_data.hpp>
+
+namespace siege::content::bmp
+{
+  namespace endian = siege::platform;
+  using namespace siege::platform::bitmap;
+  using chunk_tag = std::array<std::byte, 4>;
+
+  constexpr std::array<std::byte, 8> png_signature = platform::to_tag<8>({ 0x89, 'P', 'N', 'G', 0x0d, 0x0a, 0x1a, 0x0a });
+  constexpr chunk_tag header_tag = platform::to_tag<4>({ 'I', 'H', 'D', 'R' });
+  constexpr chunk_tag palette_tag = platform::to_tag<4>({ 'P', 'L', 'T', 'E' });
+  constexpr chunk_tag transparency_tag = platform::to_tag<4>({ 't', 'R', 'N', 'S' });
+  constexpr chunk_tag data_tag = platform::to_tag<4>({ 'I', 'D', 'A', 'T' });
+  constexpr chunk_tag end_tag = platform::to_tag<4>({ 'I', 'E', 'N', 'D' });
+
+  // Anything bigger than this is not a real image, and is most likely a damaged file.
+  constexpr std::uint32_t max_chunk_size = 0x7fffffff;
+  constexpr std::size_t compressed_chunk_size = 0x10000;
+  // The largest width and height allowed by the PNG specification.
+  constexpr std::uint32_t max_dimension = 0x7fffffff;
+
+  enum colour_type : std::uint8_t
+  {
+    greyscale = 0,
+    truecolour = 2,
+    indexed = 3,
+    greyscale_alpha = 4,
+    truecolour_alpha = 6
+  };
+
+  enum filter_type : std::uint8_t
+  {
+    none = 0,
+    sub = 1,
+    up = 2,
+    average = 3,
+    paeth = 4
+  };
+
+  struct png_header
+  {
+    endian::big_uint32_t width;
+    endian::big_uint32_t height;
+    std::uint8_t bit_depth;
+    std::uint8_t colour_type;
+    std::uint8_t compression_method;
+    std::uint8_t filter_method;
+    std::uint8_t interlace_method;
+  };
+
+  static_assert(sizeof(png_header) == 13);
+
+  static std::size_t get_channel_count(std::uint8_t type)
+  {
+    switch (type)
+    {
+    case greyscale:
+    case indexed:
+      return 1;
+    case greyscale_alpha:
+      return 2;
+    case truecolour:
+      return 3;
+    case truecolour_alpha:
+      return 4;
+    default:
+      return 0;
+    }
+  }
+
+  static bool is_valid_depth(std::uint8_t type, std::uint8_t depth)
+  {
+    switch (type)
+    {
+    case greyscale:
+      return depth == 1 || depth == 2 || depth == 4 || depth == 8 || depth == 16;
+    case indexed:
+      return depth == 1 || depth == 2 || depth == 4 || depth == 8;
+    case truecolour:
+    case greyscale_alpha:
+    case truecolour_alpha:
+      return depth == 8 || depth == 16;
+    default:
+      return false;
+    }
+  }
+
+  static void write_chunk(std::ostream& raw_data, const chunk_tag& tag, std::span<const std::byte> data)
+  {
+    endian::big_uint32_t size = std::uint32_t(data.size());
+    platform::write(raw_data, reinterpret_cast<const std::byte*>(&size), sizeof(size));
+    platform::write(raw_data, tag.data(), tag.size());
+    platform::write(raw_data, data.data(), data.size());
+
+    auto crc = ::crc32(0, reinterpret_cast<const Bytef*>(tag.data()), uInt(tag.size()));
+    crc = ::crc32(crc, reinterpret_cast<const Bytef*>(data.data()), uInt(data.size()));
+
+    endian::big_uint32_t checksum = std::uint32_t(crc);
+    platform::write(raw_data, reinterpret_cast<const std::byte*>(&checksum), sizeof(checksum));
+  }
+
+  static std::uint8_t paeth_predictor(std::uint8_t a, std::uint8_t b, std::uint8_t c)
+  {
+    int p = int(a) + int(b) - int(c);
+    int pa = std::abs(p - int(a));
+    int pb = std::abs(p - int(b));
+    int pc = std::abs(p - int(c));
+
+    if (pa <= pb && pa <= pc)
+    {
+      return a;
+    }
+
+    return pb <= pc ? b : c;
+  }
+
+  // Reverses the filter of one row in place, with previous being all zeros for the first row.
+  static void unfilter_row(std::uint8_t filter, std::span<std::uint8_t> row, std::span<const std::uint8_t> previous, std::size_t pixel_size)
+  {
+    switch (filter)
+    {
+    case none:
+      break;
+    case sub:
+      for (auto x = pixel_size; x < row.size(); ++x)
+      {
+        row[x] += row[x - pixel_size];
+      }
+      break;
+    case up:
+      for (auto x = 0u; x < row.size(); ++x)
+      {
+        row[x] += previous[x];
+      }
+      break;
+    case average:
+      for (auto x = 0u; x < row.size(); ++x)
+      {
+        auto left = x >= pixel_size ? row[x - pixel_size] : 0;
+        row[x] += std::uint8_t((left + previous[x]) / 2);
+      }
+      break;
+    case paeth:
+      for (auto x = 0u; x < row.size(); ++x)
+      {
+        auto left = x >= pixel_size ? row[x - pixel_size] : std::uint8_t(0);
+        auto upper_left = x >= pixel_size ? previous[x - pixel_size] : std::uint8_t(0);
+        row[x] += paeth_predictor(left, previous[x], upper_left);
+      }
+      break;
+    default:
+      throw std::invalid_argument("The PNG file has an unknown row filter.");
+    }
+  }
+
+  png_data get_png_data(std::istream& raw_data)
+  {
+    std::array<std::byte, 8> signature{};
+    platform::read(raw_data, signature.data(), signature.size());
+
+    if (signature != png_signature)
+    {
+      throw std::invalid_argument("The stream does not contain a PNG file.");
+    }
+
+    std::optional<png_header> header;
+    std::vector<pal::colour> colours;
+    std::optional<std::array<std::uint16_t, 3>> transparent_colour;
+
+    std::vector<std::uint8_t> filtered;
+    std::size_t row_size = 0;
+
+    z_stream inflater{};
+
+    if (::inflateInit(&inflater) != Z_OK)
+    {
+      throw std::runtime_error("Could not start decompressing the PNG file.");
+    }
+
+    struct inflate_guard
+    {
+      z_stream& stream;
+      ~inflate_guard()
+      {
+        ::inflateEnd(&stream);
+      }
+    } guard{ inflater };
+
+    std::vector<std::byte> chunk;
+    bool finished_data = false;
+
+    // A chunk can never be longer than what is left of the stream, so a damaged length is caught before anything is allocated.
+    std::optional<std::size_t> stream_size;
+
+    if (raw_data.tellg() != std::istream::pos_type(-1))
+    {
+      stream_size = platform::get_stream_size(raw_data);
+    }
+
+    while (raw_data)
+    {
+      endian::big_uint32_t size{};
+      chunk_tag tag{};
+      platform::read(raw_data, reinterpret_cast<std::byte*>(&size), sizeof(size));
+      platform::read(raw_data, tag.data(), tag.size());
+
+      auto position = raw_data.tellg();
+      auto bytes_left = stream_size && position != std::istream::pos_type(-1) ? *stream_size - std::min<std::size_t>(*stream_size, std::size_t(position)) : std::size_t(max_chunk_size);
+
+      if (!raw_data || size > max_chunk_size || size > bytes_left)
+      {
+        throw std::invalid_argument("The PNG file is truncated or damaged.");
+      }
+
+      chunk.resize(size);
+      platform::read(raw_data, chunk.data(), chunk.size());
+      raw_data.ignore(sizeof(std::uint32_t));
+
+      if (tag == end_tag)
+      {
+        break;
+      }
+
+      if (tag == header_tag)
+      {
+        if (chunk.size() < sizeof(png_header))
+        {
+          throw std::invalid_argument("The PNG header is too small.");
+        }
+
+        header.emplace();
+        std::memcpy(&*header, chunk.data(), sizeof(png_header));
+
+        if (!is_valid_depth(header->colour_type, header->bit_depth) || header->compression_method != 0 || header->filter_method != 0)
+        {
+          throw std::invalid_argument("The PNG file has an unsupported pixel format.");
+        }
+
+        if (header->interlace_method != 0)
+        {
+          throw std::invalid_argument("Interlaced PNG files are not supported.");
+        }
+
+        if (header->width == 0 || header->height == 0 || header->width > max_dimension || header->height > max_dimension)
+        {
+          throw std::invalid_argument("The PNG file has an invalid width or height.");
+        }
+
+        row_size = (std::size_t(header->width) * get_channel_count(header->colour_type) * header->bit_depth + 7) / 8;
+
+        // The pixel data is inflated in one go, so it has to fit in what zlib can write at once.
+        if (header->height > std::numeric_limits<uInt>::max() / (row_size + 1))
+        {
+          throw std::invalid_argument("The PNG file is too big to be read.");
+        }
+
+        filtered.resize((row_size + 1) * header->height);
+        inflater.next_out = filtered.data();
+        inflater.avail_out = uInt(filtered.size());
+      }
+      else if (tag == palette_tag)
+      {
+        colours.resize(chunk.size() / 3);
+
+        for (auto i = 0u; i < colours.size(); ++i)
+        {
+          colours[i] = pal::colour{ chunk[i * 3], chunk[i * 3 + 1], chunk[i * 3 + 2], std::byte{ 0xff } };
+        }
+      }
+      else if (tag == transparency_tag && header)
+      {
+        if (header->colour_type == indexed)
+        {
+          for (auto i = 0u; i < chunk.size() && i < colours.size(); ++i)
+          {
+            colours[i].flags = chunk[i];
+          }
+        }
+        else if (chunk.size() >= 2)
+        {
+          auto sample = [&](std::size_t index) {
+            return index * 2 + 1 < chunk.size() ? std::uint16_t(std::uint16_t(chunk[index * 2]) << 8 | std::uint16_t(chunk[index * 2 + 1])) : std::uint16_t(0);
+          };
+
+          transparent_colour = header->colour_type == truecolour ? std::array<std::uint16_t, 3>{ sample(0), sample(1), sample(2) } : std::array<std::uint16_t, 3>{ sample(0), sample(0), sample(0) };
+        }
+      }
+      else if (tag == data_tag && header && !finished_data)
+      {
+        inflater.next_in = reinterpret_cast<Bytef*>(chunk.data());
+        inflater.avail_in = uInt(chunk.size());
+
+        while (inflater.avail_in > 0 && inflater.avail_out > 0)
+        {
+          auto result = ::inflate(&inflater, Z_NO_FLUSH);
+
+          if (result == Z_STREAM_END)
+          {
+            finished_data = true;
+            break;
+          }
+
+          if (result != Z_OK)
+          {
+            throw std::invalid_argument("The PNG pixel data could not be decompressed.");
+          }
+        }
+      }
+    }
+
+    if (!header)
+    {
+      throw std::invalid_argument("The PNG file has no header.");
+    }
+
+    if (inflater.avail_out != 0)
+    {
+      throw std::invalid_argument("The PNG file does not have enough pixel data.");
+    }
+
+    const auto width = std::size_t(header->width);
+    const auto height = std::size_t(header->height);
+    const auto depth = header->bit_depth;
+    const auto channels = get_channel_count(header->colour_type);
+    const auto pixel_size = std::max<std::size_t>(1, channels * depth / 8);
+
+    std::vector<std::uint8_t> zero_row(row_size);
+
+    for (auto y = 0u; y < height; ++y)
+    {
+      auto line = std::span(filtered).subspan(y * (row_size + 1), row_size + 1);
+      auto previous = y == 0 ? std::span<const std::uint8_t>(zero_row) : std::span<const std::uint8_t>(filtered).subspan((y - 1) * (row_size + 1) + 1, row_size);
+      unfilter_row(line[0], line.subspan(1), previous, pixel_size);
+    }
+
+    // Samples of less than 8 bits are packed with the first pixel in the highest bits.
+    auto get_sample = [depth](std::span<const std::uint8_t> row, std::size_t index) -> std::uint16_t {
+      switch (depth)
+      {
+      case 16:
+        return std::uint16_t(row[index * 2] << 8 | row[index * 2 + 1]);
+      case 8:
+        return row[index];
+      default:
+        auto per_byte = 8 / depth;
+        auto shift = (per_byte - 1 - index % per_byte) * depth;
+        return std::uint16_t((row[index / per_byte] >> shift) & ((1 << depth) - 1));
+      }
+    };
+
+    png_data result;
+
+    if (header->colour_type == indexed)
+    {
+      result.colours = std::move(colours);
+      result.pixels = pixel_buffer(pixel_format::indexed_8, width, height);
+
+      for (auto y = 0u; y < height; ++y)
+      {
+        auto source = std::span<const std::uint8_t>(filtered).subspan(y * (row_size + 1) + 1, row_size);
+        auto destination = result.pixels.row(y);
+
+        if (depth == 8)
+        {
+          std::memcpy(destination.data(), source.data(), width);
+          continue;
+        }
+
+        for (auto x = 0u; x < width; ++x)
+        {
+          destination[x] = std::byte(get_sample(source, x));
+        }
+      }
+
+      return result;
+    }
+
+    // Every sample is scaled to 8 bits, including greyscale samples of less than 8 bits.
+    auto to_byte = [depth](std::uint16_t sample) {
+      switch (depth)
+      {
+      case 16:
+        return std::byte(sample >> 8);
+      case 8:
+        return std::byte(sample);
+      default:
+        return std::byte(sample * 255 / ((1 << depth) - 1));
+      }
+    };
+
+    result.pixels = pixel_buffer(pixel_format::rgba_8888, width, height);
+
+    for (auto y = 0u; y < height; ++y)
+    {
+      auto source = std::span<const std::uint8_t>(filtered).subspan(y * (row_size + 1) + 1, row_size);
+      auto destination = reinterpret_cast<pal::colour*>(result.pixels.row(y).data());
+
+      for (auto x = 0u; x < width; ++x)
+      {
+        std::array<std::uint16_t, 4> samples{};
+
+        for (auto channel = 0u; channel < channels; ++channel)
+        {
+          samples[channel] = get_sample(source, x * channels + channel);
+        }
+
+        auto& output = destination[x];
+
+        switch (header->colour_type)
+        {
+        case greyscale:
+          output = pal::colour{ to_byte(samples[0]), to_byte(samples[0]), to_byte(samples[0]), std::byte{ 0xff } };
+          break;
+        case greyscale_alpha:
+          output = pal::colour{ to_byte(samples[0]), to_byte(samples[0]), to_byte(samples[0]), to_byte(samples[1]) };
+          break;
+        case truecolour:
+          output = pal::colour{ to_byte(samples[0]), to_byte(samples[1]), to_byte(samples[2]), std::byte{ 0xff } };
+          break;
+        default:
+          output = pal::colour{ to_byte(samples[0]), to_byte(samples[1]), to_byte(samples[2]), to_byte(samples[3]) };
+          break;
+        }
+
+        if (transparent_colour && channels < 4 && header->colour_type != greyscale_alpha)
+        {
+          auto& key = *transparent_colour;
+          auto matches = header->colour_type == truecolour ? samples[0] == key[0] && samples[1] == key[1] && samples[2] == key[2] : samples[0] == key[0];
+
+          if (matches)
+          {
+            output.flags = std::byte{};
+          }
+        }
+      }
+    }
+
+    return result;
+  }
+
+  void write_png_data(std::ostream& raw_data,
+    std::span<const pal::colour> colours,
+    const_pixel_view pixels,
+    int compression_level)
+  {
+    if (pixels.format == pixel_format::unknown || pixels.width == 0 || pixels.height == 0)
+    {
+      throw std::invalid_argument("The pixels cannot be written to a PNG file.");
+    }
+
+    const auto is_palette = is_indexed(pixels.format);
+
+    if (is_palette && colours.empty())
+    {
+      throw std::invalid_argument("Indexed pixels need a palette to be written to a PNG file.");
+    }
+
+    png_header header{};
+    header.width = std::uint32_t(pixels.width);
+    header.height = std::uint32_t(pixels.height);
+
+    if (is_palette)
+    {
+      header.bit_depth = std::uint8_t(get_bits_per_pixel(pixels.format));
+      header.colour_type = indexed;
+    }
+    else
+    {
+      header.bit_depth = 8;
+      header.colour_type = pixels.format == pixel_format::rgb_888 ? truecolour : truecolour_alpha;
+    }
+
+    platform::write(raw_data, png_signature.data(), png_signature.size());
+    write_chunk(raw_data, header_tag, std::span(reinterpret_cast<const std::byte*>(&header), sizeof(header)));
+
+    if (is_palette)
+    {
+      // The flags of palette colours are not transparency, so the palette is written as fully opaque.
+      auto count = std::min<std::size_t>(colours.size(), std::size_t(1) << header.bit_depth);
+      std::vector<std::byte> palette(count * 3);
+
+      for (auto i = 0u; i < count; ++i)
+      {
+        palette[i * 3] = colours[i].red;
+        palette[i * 3 + 1] = colours[i].green;
+        palette[i * 3 + 2] = colours[i].blue;
+      }
+
+      write_chunk(raw_data, palette_tag, palette);
+    }
+
+    z_stream deflater{};
+
+    if (::deflateInit(&deflater, compression_level) != Z_OK)
+    {
+      throw std::runtime_error("Could not start compressing the PNG file.");
+    }
+
+    struct deflate_guard
+    {
+      z_stream& stream;
+      ~deflate_guard()
+      {
+        ::deflateEnd(&stream);
+      }
+    } guard{ deflater };
+
+    const auto channels = get_channel_count(header.colour_type);
+    const auto row_size = is_palette ? get_row_size(pixels.format, pixels.width) : pixels.width * channels;
+    const auto pixel_size = is_palette ? 1 : channels;
+
+    // Palette indexes compress best as they are, while colour channels do better as differences from the pixel to the left.
+    const auto filter = is_palette ? none : sub;
+
+    std::vector<std::uint8_t> line(row_size + 1);
+    std::vector<std::byte> expanded(pixels.format == pixel_format::rgb_1555 ? pixels.width * sizeof(pal::colour) : 0);
+    std::vector<std::byte> compressed(compressed_chunk_size);
+
+    deflater.next_out = reinterpret_cast<Bytef*>(compressed.data());
+    deflater.avail_out = uInt(compressed.size());
+
+    auto pump = [&](int flush) {
+      int result = Z_OK;
+
+      do
+      {
+        result = ::deflate(&deflater, flush);
+
+        if (result == Z_STREAM_ERROR)
+        {
+          throw std::runtime_error("The PNG pixel data could not be compressed.");
+        }
+
+        if (deflater.avail_out == 0 || (flush == Z_FINISH && deflater.avail_out != compressed.size()))
+        {
+          write_chunk(raw_data, data_tag, std::span(compressed).first(compressed.size() - deflater.avail_out));
+          deflater.next_out = reinterpret_cast<Bytef*>(compressed.data());
+          deflater.avail_out = uInt(compressed.size());
+        }
+      } while (deflater.avail_in > 0 || (flush == Z_FINISH && result != Z_STREAM_END));
+    };
+
+    for (auto y = 0u; y < pixels.height; ++y)
+    {
+      auto source = pixels.row(y);
+
+      if (pixels.format == pixel_format::rgb_1555)
+      {
+        convert_to_rgba(const_pixel_view{ pixels.format, pixels.width, 1, pixels.stride, source }, colours, expanded);
+        source = expanded;
+      }
+
+      line[0] = filter;
+      std::memcpy(line.data() + 1, source.data(), row_size);
+
+      if (filter == sub)
+      {
+        for (auto x = row_size; x > pixel_size; --x)
+        {
+          line[x] -= line[x - pixel_size];
+        }
+      }
+
+      deflater.next_in = line.data();
+      deflater.avail_in = uInt(line.size());
+      pump(Z_NO_FLUSH);
+    }
+
+    pump(Z_FINISH);
+
+    write_chunk(raw_data, end_tag, {});
+  }
+
+  std::filesystem::path get_png_filename(const std::filesystem::path& bitmap, std::size_t frame_index)
+  {
+    auto stem = bitmap.filename().stem().string();
+
+    if (frame_index == 0)
+    {
+      return stem + ".png";
+    }
+
+    return stem + "_" + std::to_string(frame_index) + ".png";
+  }
+}// namespace siege::content::bmp
@@ -0,0 +1,138 @@
+#include <catch2/catch_test_macros.hpp>
+#include <sstream>
+#include <siege/content/bmp/png.hpp>
+#include <siege/platform/image.hpp>
+#include "test_helpers.hpp"
+
+namespace bmp = siege::content::bmp;
+namespace pal = siege::content::pal;
+using namespace siege::platform::bitmap;
+using siege::content::test_helpers::make_palette;
+
+namespace
+{
+  bmp::png_data round_trip(std::span<const pal::colour> colours, const_pixel_view pixels)
+  {
+    std::stringstream buffer(std::ios::in | std::ios::out | std::ios::binary);
+    bmp::write_png_data(buffer, colours, pixels);
+    REQUIRE(is_png(buffer));
+    return bmp::get_png_data(buffer);
+  }
+}// namespace
+
+TEST_CASE("With an 8-bit image, the PNG keeps the same indexes and palette", "[bmp.png]")
+{
+  auto colours = make_palette(256);
+  pixel_buffer pixels(pixel_format::indexed_8, 37, 11);
+
+  for (auto i = 0u; i < pixels.bytes().size(); ++i)
+  {
+    pixels.bytes()[i] = std::byte(i * 7);
+  }
+
+  auto result = round_trip(colours, pixels);
+
+  REQUIRE(result.pixels.get_format() == pixel_format::indexed_8);
+  REQUIRE(result.pixels.get_width() == 37);
+  REQUIRE(result.pixels.get_height() == 11);
+  REQUIRE(std::ranges::equal(result.pixels.bytes(), pixels.bytes()));
+  REQUIRE(result.colours.size() == 256);
+  REQUIRE(result.colours[10].red == colours[10].red);
+  REQUIRE(result.colours[10].blue == colours[10].blue);
+}
+
+TEST_CASE("With a 4-bit image, the PNG is unpacked into one index per pixel", "[bmp.png]")
+{
+  auto colours = make_palette(16);
+  pixel_buffer pixels(pixel_format::indexed_4, 5, 3);
+
+  for (auto i = 0u; i < pixels.bytes().size(); ++i)
+  {
+    pixels.bytes()[i] = std::byte(0x1f + i * 0x11);
+  }
+
+  auto result = round_trip(colours, pixels);
+
+  REQUIRE(result.pixels.get_format() == pixel_format::indexed_8);
+
+  for (auto y = 0u; y < 3; ++y)
+  {
+    for (auto x = 0u; x < 5; ++x)
+    {
+      REQUIRE(std::size_t(result.pixels.row(y)[x]) == pixels.view().get_index(x, y));
+    }
+  }
+}
+
+TEST_CASE("With 16-bit and 32-bit images, the PNG has the same colours", "[bmp.png]")
+{
+  pixel_buffer pixels(pixel_format::rgb_1555, 19, 7);
+
+  for (auto i = 0u; i < pixels.bytes().size(); ++i)
+  {
+    pixels.bytes()[i] = std::byte(i * 13);
+  }
+
+  std::vector<std::byte> expected(19 * 7 * sizeof(pal::colour));
+  convert_to_rgba(pixels, {}, expected);
+
+  auto result = round_trip({}, pixels);
+  REQUIRE(result.pixels.get_format() == pixel_format::rgba_8888);
+  REQUIRE(std::ranges::equal(result.pixels.bytes(), expected));
+
+  pixel_buffer rgba(pixel_format::rgba_8888, 19, 7, expected);
+  result = round_trip({}, rgba);
+  REQUIRE(std::ranges::equal(result.pixels.bytes(), expected));
+}
+
+TEST_CASE("With a width or height which is too big, the PNG is rejected before anything is allocated", "[bmp.png]")
+{
+  auto make_header = [](std::uint32_t width, std::uint32_t height) {
+    std::string data("\x89PNG\r\n\x1a\n", 8);
+    data.append("\0\0\0\x0dIHDR", 8);
+
+    for (auto value : { width, height })
+    {
+      data.push_back(char(value >> 24));
+      data.push_back(char(value >> 16));
+      data.push_back(char(value >> 8));
+      data.push_back(char(value));
+    }
+
+    // 8 bits per channel RGBA, followed by a CRC which is not checked.
+    data.append("\x08\x06\0\0\0", 5);
+    data.append(4, '\0');
+    return std::stringstream(data, std::ios::in | std::ios::binary);
+  };
+
+  auto too_wide = make_header(0x80000000, 1);
+  REQUIRE_THROWS_AS(bmp::get_png_data(too_wide), std::invalid_argument);
+
+  auto empty = make_header(0, 1);
+  REQUIRE_THROWS_AS(bmp::get_png_data(empty), std::invalid_argument);
+
+  // Both are allowed on their own, but not together.
+  auto too_big = make_header(0x7fffffff, 0x7fffffff);
+  REQUIRE_THROWS_AS(bmp::get_png_data(too_big), std::invalid_argument);
+
+  auto too_big_for_zlib = make_header(0x10000, 0x10000);
+  REQUIRE_THROWS_AS(bmp::get_png_data(too_big_for_zlib), std::invalid_argument);
+}
+
+TEST_CASE("With a chunk longer than the rest of the file, the PNG is rejected before the chunk is read", "[bmp.png]")
+{
+  // Just under the largest chunk size allowed, in a file which ends right after it.
+  std::string data("\x89PNG\r\n\x1a\n", 8);
+  data.append("\x7f\xff\xff\xf0IHDR", 8);
+  data.append(16, '\0');
+
+  std::stringstream stream(data, std::ios::in | std::ios::binary);
+  REQUIRE_THROWS_AS(bmp::get_png_data(stream), std::invalid_argument);
+}
+
+TEST_CASE("The first frame of a bitmap keeps its name as a PNG, and every other frame gets its index", "[bmp.png]")
+{
+  REQUIRE(bmp::get_png_filename("textures/sky.pba") == "sky.png");
+  REQUIRE(bmp::get_png_filename("textures/sky.pba", 0) == "sky.png");
+  REQUIRE(bmp::get_png_filename("textures/sky.pba", 3) == "sky_3.png");
+}
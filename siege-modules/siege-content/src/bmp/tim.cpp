@@ -1,7 +1,17 @@
 #include <siege/platform/tagged_data.hpp>
 #include <siege/platform/stream.hpp>
 #include <siege/platform/bitmap.hpp>
-#include <bitset>
+#include <siege/content/bmp/tim.hpp>
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <spanstream>
+#include <stdexcept>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SIEGE_HAS_SSE2 1
+#include <emmintrin.h>
+#endif
 
 namespace siege::content::tim
 {
@@ -11,6 +21,7 @@ namespace siege::content::tim
   constexpr file_tag four_bit_image = platform::to_tag<8>({ 0x10, 0x00, 0x00, 0x00, 0x08, 0x00, 0x00, 0x00 });
   constexpr file_tag eight_bit_image = platform::to_tag<8>({ 0x10, 0x00, 0x00, 0x00, 0x09, 0x00, 0x00, 0x00 });
   constexpr file_tag sixteen_bit_image = platform::to_tag<8>({ 0x10, 0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00 });
+  constexpr file_tag twenty_four_bit_image = platform::to_tag<8>({ 0x10, 0x00, 0x00, 0x00, 0x03, 0x00, 0x00, 0x00 });
 
   struct palette_header
   {
@@ -26,29 +37,43 @@ namespace siege::content::tim
     endian::little_uint32_t size;
     endian::little_uint16_t offset_x;
     endian::little_uint16_t offset_y;
+    // In 16-bit units of VRAM, rather than pixels.
     endian::little_uint16_t width;
     endian::little_uint16_t height;
   };
 
-  struct tim_data
+  // Each colour is the low byte looked up in one table combined with the high byte looked up in the other.
+  // Green is split across both bytes, but its expanded bits from each byte never overlap, so the halves can simply be or'd together.
+  using colour_table = std::array<std::uint32_t, 256>;
+
+  constexpr std::uint32_t expand_5_bits(std::uint32_t value)
   {
-    enum tim_type
+    return (value << 3) | (value >> 2);
+  }
+
+  constexpr colour_table low_byte_colours = [] {
+    colour_table table{};
+
+    for (auto i = 0u; i < table.size(); ++i)
     {
-      sixteen_bit,
-      eight_bit,
-      four_bit
-    } type{};
-    std::optional<palette_header> palette_header;
+      auto green = i >> 5;
+      table[i] = expand_5_bits(i & 0x1f) | (((green << 3) | (green >> 2)) << 8);
+    }
 
-    struct tim_palette
+    return table;
+  }();
+
+  constexpr colour_table high_byte_colours = [] {
+    colour_table table{};
+
+    for (auto i = 0u; i < table.size(); ++i)
     {
-      std::vector<endian::little_uint16_t> colours;
-    };
-    std::vector<tim_palette> palettes;
+      auto green = i & 0x03;
+      table[i] = (((green << 6) | (green << 1)) << 8) | (expand_5_bits((i >> 2) & 0x1f) << 16);
+    }
 
-    image_header header;
-    std::vector<endian::little_uint16_t> pixels;
-  };
+    return table;
+  }();
 
   bool is_tim(std::istream& raw_data)
   {
@@ -56,162 +81,211 @@ namespace siege::content::tim
     platform::istream_pos_resetter resetter(raw_data);
     platform::read(raw_data, header.data(), sizeof(header));
 
-    return header == four_bit_image || header == eight_bit_image || header == sixteen_bit_image;
+    return header == four_bit_image || header == eight_bit_image || header == sixteen_bit_image || header == twenty_four_bit_image;
   }
 
-  tim_data get_tim_data(std::istream& raw_data)
+  void decode_colours(std::span<const std::byte> raw_colours, std::span<platform::palette::colour> destination)
   {
+    auto count = std::min(raw_colours.size() / 2, destination.size());
+
+    for (auto i = 0u; i < count; ++i)
+    {
+      auto low = std::uint32_t(raw_colours[i * 2]);
+      auto high = std::uint32_t(raw_colours[i * 2 + 1]);
+      auto value = low_byte_colours[low] | high_byte_colours[high] | ((low | high) != 0 ? 0xff000000u : 0u);
+      std::memcpy(&destination[i], &value, sizeof(value));
+    }
+  }
+
+  // Moves red to the top and blue to the bottom, to match rgb_1555, and turns the semi-transparency bit into an opaque flag.
+  static std::uint16_t to_rgb_1555(std::uint16_t value)
+  {
+    return std::uint16_t(((value & 0x1f) << 10) | (value & 0x03e0) | ((value >> 10) & 0x1f) | (value != 0 ? 0x8000 : 0));
+  }
+
+  static void convert_to_rgb_1555(std::span<std::byte> pixels)
+  {
+    std::size_t i = 0;
+
+#if defined(SIEGE_HAS_SSE2)
+    const auto low_mask = _mm_set1_epi16(0x1f);
+    const auto green_mask = _mm_set1_epi16(0x03e0);
+    const auto opaque = _mm_set1_epi16(std::int16_t(0x8000));
+    const auto zero = _mm_setzero_si128();
+
+    for (; i + 16 <= pixels.size(); i += 16)
+    {
+      auto value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pixels.data() + i));
+      auto red = _mm_slli_epi16(_mm_and_si128(value, low_mask), 10);
+      auto green = _mm_and_si128(value, green_mask);
+      auto blue = _mm_and_si128(_mm_srli_epi16(value, 10), low_mask);
+      auto alpha = _mm_andnot_si128(_mm_cmpeq_epi16(value, zero), opaque);
+
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(pixels.data() + i), _mm_or_si128(_mm_or_si128(red, green), _mm_or_si128(blue, alpha)));
+    }
+#endif
+
+    for (; i + 2 <= pixels.size(); i += 2)
+    {
+      auto value = to_rgb_1555(std::uint16_t(std::uint16_t(pixels[i]) | (std::uint16_t(pixels[i + 1]) << 8)));
+      pixels[i] = std::byte(value & 0xff);
+      pixels[i + 1] = std::byte(value >> 8);
+    }
+  }
+
+  tim_image get_tim_image(std::istream& raw_data)
+  {
+    using platform::bitmap::pixel_buffer;
+    using platform::bitmap::pixel_format;
+
     platform::istream_pos_resetter resetter(raw_data);
     std::array<std::byte, 8> header{};
     platform::read(raw_data, header.data(), sizeof(header));
 
-    tim_data result{};
+    tim_image result{};
 
     if (header == four_bit_image || header == eight_bit_image)
     {
-      palette_header temp;
-      raw_data.read((char*)&temp, sizeof(temp));
+      result.format = header == four_bit_image ? tim_format::four_bit : tim_format::eight_bit;
+
+      auto palette_start = raw_data.tellg();
+      palette_header palettes{};
+      platform::read(raw_data, reinterpret_cast<char*>(&palettes), sizeof(palettes));
 
-      if (temp.palette_count > 4096 || (temp.palette_count == 0 || temp.palette_count >= 10))
+      const std::size_t colour_count = palettes.color_count;
+      const std::size_t table_count = palettes.palette_count;
+
+      if (colour_count == 0 || colour_count > 256 || table_count == 0 || palettes.size < sizeof(palettes) + colour_count * table_count * sizeof(std::uint16_t))
       {
         return result;
       }
 
-      result.palette_header = std::move(temp);
+      result.clut_x = palettes.offset_x;
+      result.clut_y = palettes.offset_y;
+      result.clut_row_size = palettes.color_count;
+
+      std::vector<std::byte> raw_colours(colour_count * table_count * sizeof(std::uint16_t));
+      platform::read(raw_data, raw_colours.data(), raw_colours.size());
 
-      for (auto i = 0; i < result.palette_header->palette_count; ++i)
+      std::vector<platform::palette::colour> colours(colour_count * table_count);
+      decode_colours(raw_colours, colours);
+
+      // A 4-bit image can only use 16 colours at a time, so wider rows hold several tables side by side.
+      const std::size_t table_size = result.format == tim_format::four_bit ? std::min<std::size_t>(16, colour_count) : colour_count;
+
+      for (auto first = colours.begin(); first != colours.end();)
       {
-        auto& palette = result.palettes.emplace_back();
-        palette.colours.resize(result.palette_header->color_count);
-        raw_data.read((char*)palette.colours.data(), palette.colours.size() * sizeof(std::uint16_t));
+        auto last = first + std::min<std::size_t>(table_size, std::distance(first, colours.end()));
+        result.cluts.emplace_back(first, last);
+        first = last;
       }
+
+      raw_data.seekg(palette_start + std::streamoff(palettes.size), std::ios::beg);
+    }
+    else if (header == sixteen_bit_image)
+    {
+      result.format = tim_format::sixteen_bit;
+    }
+    else if (header == twenty_four_bit_image)
+    {
+      result.format = tim_format::twenty_four_bit;
+    }
+    else
+    {
+      return result;
     }
 
-    raw_data.read((char*)&result.header, sizeof(result.header));
+    image_header image{};
+    platform::read(raw_data, reinterpret_cast<char*>(&image), sizeof(image));
 
-    auto stride = result.header.width;
+    const std::size_t vram_width = image.width;
+    const std::size_t height = image.height;
+    result.vram_x = image.offset_x;
+    result.vram_y = image.offset_y;
 
-    if (header == four_bit_image)
+    switch (result.format)
+    {
+    case tim_format::four_bit:
     {
-      stride = stride * 2;
-      result.type = result.four_bit;
+      result.pixels = pixel_buffer(pixel_format::indexed_4, vram_width * 4, height);
+      auto pixels = result.pixels.bytes();
+      platform::read(raw_data, pixels.data(), pixels.size());
+
+      // TIM files keep the first pixel in the low nibble, but pixel_buffer expects it in the high one.
+      std::transform(pixels.begin(), pixels.end(), pixels.begin(), [](auto value) {
+        return (value << 4) | (value >> 4);
+      });
+      break;
     }
-    else if (header == eight_bit_image)
+    case tim_format::eight_bit:
     {
-      stride = stride * 2;
-      result.type = result.eight_bit;
+      result.pixels = pixel_buffer(pixel_format::indexed_8, vram_width * 2, height);
+      auto pixels = result.pixels.bytes();
+      platform::read(raw_data, pixels.data(), pixels.size());
+      break;
     }
+    case tim_format::sixteen_bit:
+    {
+      result.pixels = pixel_buffer(pixel_format::rgb_1555, vram_width, height);
+      auto pixels = result.pixels.bytes();
+      platform::read(raw_data, pixels.data(), pixels.size());
+      convert_to_rgb_1555(pixels);
+      break;
+    }
+    case tim_format::twenty_four_bit:
+    {
+      // Two pixels take up three units of VRAM, and rows may end with half a pixel.
+      result.pixels = pixel_buffer(pixel_format::rgb_888, vram_width * 2 / 3, height);
+      const auto row_size = result.pixels.get_stride();
+      const auto padding = vram_width * 2 - row_size;
 
-    result.pixels.resize((int)stride * result.header.height);
-
-    raw_data.read((char*)result.pixels.data(), result.pixels.size() * sizeof(std::uint16_t));
+      for (auto y = 0u; y < height; ++y)
+      {
+        platform::read(raw_data, result.pixels.row(y).data(), row_size);
+        raw_data.ignore(padding);
+      }
+      break;
+    }
+    }
 
     return result;
   }
 
-  siege::platform::palette::colour to_rgba(std::uint16_t raw_colour)
-  {
-    siege::platform::palette::colour colour;
-
-    // A1B5G5R5
-    std::bitset<16> bits(raw_colour);
-    std::bitset<5> b;
-    std::bitset<5> g;
-    std::bitset<5> r;
-    colour.flags = bits[15] ? std::byte(0xff) : std::byte{};
-
-    r[4] = bits[14];
-    r[3] = bits[13];
-    r[2] = bits[12];
-    r[1] = bits[11];
-    r[0] = bits[10];
-    g[4] = bits[9];
-    g[3] = bits[8];
-    g[2] = bits[7];
-    g[1] = bits[6];
-    g[0] = bits[5];
-    b[4] = bits[4];
-    b[3] = bits[3];
-    b[2] = bits[2];
-    b[1] = bits[1];
-    b[0] = bits[0];
-
-    colour.red = std::byte(r.to_ulong());
-    colour.green = std::byte(g.to_ulong());
-    colour.blue = std::byte(b.to_ulong());
-
-    return colour;
-  }
-
-
-  platform::bitmap::windows_bmp_data get_tim_data_as_bitmap(std::istream& raw_data)
+  platform::bitmap::windows_bmp_data to_bitmap(tim_image image, std::size_t clut_index)
   {
-    tim_data temp = get_tim_data(raw_data);
     platform::bitmap::windows_bmp_data result{};
 
-    if (temp.type == temp.eight_bit)
+    if (platform::bitmap::is_indexed(image.pixels.get_format()))
     {
-      result.info.width = temp.header.width * 2;
-      result.info.height = temp.header.height;
-      result.info.bit_depth = 8;
-      if (temp.palettes.size() > 0)
+      if (image.cluts.empty())
       {
-        result.colours.reserve(temp.palettes[0].colours.size());
-
-        for (auto& colour : temp.palettes[0].colours)
-        {
-          result.colours.emplace_back(to_rgba(colour));
-        }
-
-        result.indexes.reserve(temp.pixels.size() * 2);
-
-        for (auto& pixel : temp.pixels)
-        {
-          result.indexes.emplace_back((std::int32_t)pixel.data[0]);
-          result.indexes.emplace_back((std::int32_t)pixel.data[1]);
-        }
-      }
-    }
-    else if (temp.type == temp.four_bit)
-    {
-      result.info.bit_depth = 8;
-      result.info.width = temp.header.width * 4;
-      result.info.height = temp.header.height;
-      if (temp.palettes.size() > 0)
-      {
-        result.colours.reserve(temp.palettes[0].colours.size());
-
-        for (auto& colour : temp.palettes[0].colours)
-        {
-          result.colours.emplace_back(to_rgba(colour));
-        }
-
-        result.indexes.reserve(temp.pixels.size() * 2);
-
-        for (auto& pixel : temp.pixels)
-        {
-          result.indexes.emplace_back((std::uint32_t)pixel.data[0] & 0x0f);
-          result.indexes.emplace_back((std::uint32_t)pixel.data[0] >> 4);
-          result.indexes.emplace_back((std::uint32_t)pixel.data[1] & 0x0f);
-          result.indexes.emplace_back((std::uint32_t)pixel.data[1] >> 4);
-        }
+        return result;
       }
-    }
-    else
-    {
-      result.info.bit_depth = 32;
-      result.info.width = temp.header.width;
-      result.info.height = temp.header.height;
-      result.colours.reserve(temp.pixels.size());
 
-      for (auto value : temp.pixels)
+      if (clut_index >= image.cluts.size())
       {
-        result.colours.emplace_back(to_rgba(value));
+        throw std::out_of_range("The TIM file does not have colour table " + std::to_string(clut_index));
       }
+
+      result.colours = std::move(image.cluts[clut_index]);
     }
 
+    result.info.width = std::int32_t(image.pixels.get_width());
+    result.info.height = std::int32_t(image.pixels.get_height());
+    result.info.bit_depth = std::uint16_t(platform::bitmap::get_bits_per_pixel(image.pixels.get_format()));
+    result.pixels = std::move(image.pixels);
+
     return result;
   }
 
+  platform::bitmap::windows_bmp_data get_tim_data_as_bitmap(std::istream& raw_data, std::size_t clut_index)
+  {
+    return to_bitmap(get_tim_image(raw_data), clut_index);
+  }
 
-}// namespace siege::content::tim
\ No newline at end of file
+  platform::bitmap::windows_bmp_data get_tim_data_as_bitmap(std::span<const std::byte> raw_data, std::size_t clut_index)
+  {
+    std::ispanstream stream(std::span<const char>(reinterpret_cast<const char*>(raw_data.data()), raw_data.size()));
+    return get_tim_data_as_bitmap(stream, clut_index);
+  }
+}// namespace siege::content::tim
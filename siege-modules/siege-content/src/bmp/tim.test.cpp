@@ -0,0 +1,156 @@
+#include <catch2/catch_test_macros.hpp>
+#include <cstring>
+#include <siege/content/bmp/tim.hpp>
+
+namespace tim = siege::content::tim;
+using namespace siege::platform::bitmap;
+using siege::platform::palette::colour;
+
+namespace
+{
+  void add_uint16(std::vector<std::byte>& data, std::uint16_t value)
+  {
+    data.emplace_back(std::byte(value & 0xff));
+    data.emplace_back(std::byte(value >> 8));
+  }
+
+  void add_uint32(std::vector<std::byte>& data, std::uint32_t value)
+  {
+    add_uint16(data, std::uint16_t(value & 0xffff));
+    add_uint16(data, std::uint16_t(value >> 16));
+  }
+
+  std::vector<std::byte> make_tim(std::uint32_t flags, std::uint16_t vram_width, std::uint16_t height, std::span<const std::uint16_t> clut, std::uint16_t clut_width, std::span<const std::byte> pixels)
+  {
+    std::vector<std::byte> data;
+    add_uint32(data, 0x10);
+    add_uint32(data, flags);
+
+    if (!clut.empty())
+    {
+      add_uint32(data, std::uint32_t(12 + clut.size() * 2));
+      add_uint16(data, 0);
+      add_uint16(data, 0);
+      add_uint16(data, clut_width);
+      add_uint16(data, std::uint16_t(clut.size() / clut_width));
+
+      for (auto value : clut)
+      {
+        add_uint16(data, value);
+      }
+    }
+
+    add_uint32(data, std::uint32_t(12 + pixels.size()));
+    add_uint16(data, 0);
+    add_uint16(data, 0);
+    add_uint16(data, vram_width);
+    add_uint16(data, height);
+    data.insert(data.end(), pixels.begin(), pixels.end());
+
+    return data;
+  }
+
+  colour reference_colour(std::uint16_t value)
+  {
+    auto expand = [](std::uint32_t channel) { return std::byte((channel << 3) | (channel >> 2)); };
+    return colour{ expand(value & 0x1f), expand((value >> 5) & 0x1f), expand((value >> 10) & 0x1f), value == 0 ? std::byte{} : std::byte{ 0xff } };
+  }
+}// namespace
+
+TEST_CASE("With every 16-bit value, the decoded colour expands each channel to 8 bits", "[bmp.tim]")
+{
+  std::vector<std::byte> raw;
+
+  for (auto i = 0u; i < 65536; ++i)
+  {
+    add_uint16(raw, std::uint16_t(i));
+  }
+
+  std::vector<colour> colours(65536);
+  tim::decode_colours(raw, colours);
+
+  for (auto i = 0u; i < 65536; ++i)
+  {
+    REQUIRE(colours[i] == reference_colour(std::uint16_t(i)));
+  }
+}
+
+TEST_CASE("With a 4-bit TIM with several colour tables, the selected table is used", "[bmp.tim]")
+{
+  std::vector<std::uint16_t> clut(32);
+
+  for (auto i = 0u; i < clut.size(); ++i)
+  {
+    clut[i] = std::uint16_t(i < 16 ? i : 0x7c00 | i);
+  }
+
+  std::vector<std::byte> pixels{ std::byte{ 0x21 }, std::byte{ 0x43 }, std::byte{ 0x65 }, std::byte{ 0x87 } };
+  auto file = make_tim(0x08, 2, 1, clut, 16, pixels);
+
+  auto first = tim::get_tim_data_as_bitmap(std::span<const std::byte>(file));
+  auto second = tim::get_tim_data_as_bitmap(std::span<const std::byte>(file), 1);
+
+  REQUIRE(first.pixels.get_format() == pixel_format::indexed_4);
+  REQUIRE(first.pixels.get_width() == 8);
+  REQUIRE(first.colours.size() == 16);
+  REQUIRE(first.colours[3] == reference_colour(3));
+  REQUIRE(second.colours[3] == reference_colour(0x7c00 | 19));
+
+  // The first pixel is in the low nibble of a TIM file.
+  const_pixel_view view = first.pixels;
+
+  for (auto x = 0u; x < 8; ++x)
+  {
+    REQUIRE(view.get_index(x, 0) == x + 1);
+  }
+
+  REQUIRE_THROWS_AS(tim::get_tim_data_as_bitmap(std::span<const std::byte>(file), 2), std::out_of_range);
+}
+
+TEST_CASE("With a 16-bit TIM, pixels become rgb_1555 with black as transparent", "[bmp.tim]")
+{
+  std::vector<std::byte> pixels;
+  std::vector<std::uint16_t> values;
+
+  for (auto i = 0u; i < 19 * 3; ++i)
+  {
+    values.emplace_back(std::uint16_t(i * 2731));
+    add_uint16(pixels, values.back());
+  }
+
+  auto file = make_tim(0x02, 19, 3, {}, 0, pixels);
+  auto image = tim::get_tim_data_as_bitmap(std::span<const std::byte>(file));
+
+  REQUIRE(image.pixels.get_format() == pixel_format::rgb_1555);
+  REQUIRE(image.pixels.get_width() == 19);
+  REQUIRE(image.pixels.get_height() == 3);
+
+  std::vector<std::byte> rgba(19 * 3 * 4);
+  convert_to_rgba(image.pixels, {}, rgba);
+
+  for (auto i = 0u; i < values.size(); ++i)
+  {
+    colour converted;
+    std::memcpy(&converted, rgba.data() + i * 4, sizeof(converted));
+    REQUIRE(converted == reference_colour(values[i]));
+  }
+}
+
+TEST_CASE("With a 24-bit TIM, every two pixels take three units of VRAM", "[bmp.tim]")
+{
+  std::vector<std::byte> pixels;
+
+  for (auto i = 0u; i < 12; ++i)
+  {
+    pixels.emplace_back(std::byte(i));
+  }
+
+  auto file = make_tim(0x03, 3, 2, {}, 0, pixels);
+  auto image = tim::get_tim_data_as_bitmap(std::span<const std::byte>(file));
+
+  REQUIRE(image.pixels.get_format() == pixel_format::rgb_888);
+  REQUIRE(image.pixels.get_width() == 2);
+  REQUIRE(image.pixels.get_height() == 2);
+  REQUIRE(image.pixels.row(1)[0] == std::byte{ 6 });
+  REQUIRE(image.pixels.row(1)[5] == std::byte{ 11 });
+}
@@ -2,18 +2,13 @@
 // Contains embedded TMD shape data and TIM texture data.
 
 #include <array>
-#include <any>
 #include <spanstream>
-#include <siege/content/dts/tmd.hpp>
-#include <siege/content/bmp/tim.hpp>
+#include <siege/content/dts/bnd.hpp>
 #include <siege/platform/shared.hpp>
 #include <siege/platform/stream.hpp>
-#include <siege/platform/endian_arithmetic.hpp>
 
 namespace siege::content::bnd
 {
-  namespace endian = siege::platform;
-
   constexpr static auto body_tag = platform::to_tag<4>("BODY");
   constexpr static auto data_tag = platform::to_tag<4>("DATA");
   constexpr static auto tmds_tag = platform::to_tag<4>("TMDS");
@@ -47,41 +42,6 @@ namespace siege::content::bnd
     std::array<endian::little_uint32_t, 4> primitive_end_offsets;
   };
 
-  struct bnd_textured_triangle_primitive
-  {
-    struct
-    {
-      endian::little_uint16_t v_coord;
-      endian::little_uint16_t u_coord;
-    } texture_coordinates[3];
-
-    struct
-    {
-      endian::little_uint16_t v_index;
-      endian::little_uint16_t u_index;
-    } vertex_indices[3];
-  };
-
-  struct bnd_shape
-  {
-    std::vector<tmd::tmd_vertex> vertices;
-    std::vector<tmd::tmd_vertex> normals;
-    std::vector<bnd_textured_triangle_primitive> primitives;
-  };
-
-  struct bnd_collision
-  {
-    std::vector<char> bytes;
-    bnd_shape shape;
-  };
-
-  struct bnd_data
-  {
-    std::vector<bnd_shape> shapes;
-    std::vector<bnd_collision> collision_data;
-    std::vector<platform::bitmap::windows_bmp_data> textures;
-  };
-
   bool is_bnd(std::istream& stream)
   {
     platform::istream_pos_resetter resetter(stream);
@@ -95,9 +55,8 @@ namespace siege::content::bnd
     return body.tag == body_tag && data.tag == data_tag;
   }
 
-  std::vector<std::any> load_bnd(std::istream& stream)
+  std::optional<bnd_data> load_bnd(std::istream& stream)
   {
-    std::vector<std::any> results;
     platform::istream_pos_resetter resetter(stream);
 
     iff_tag body;
@@ -152,7 +111,7 @@ namespace siege::content::bnd
               if (primitive_count != tmd_section.primitive_sizes.end())
               {
                 shape.primitives.resize(*primitive_count);
-                tmd_stream.seekg(tmd_section.primitive_offsets[0], std::ios::beg);
+                tmd_stream.seekg(tmd_section.primitive_offsets[std::distance(tmd_section.primitive_sizes.begin(), primitive_count)], std::ios::beg);
                 tmd_stream.read((char*)shape.primitives.data(), sizeof(bnd_textured_triangle_primitive) * shape.primitives.size());
               }
             };
@@ -213,15 +172,36 @@ namespace siege::content::bnd
             
             buffer.resize(next_item.size);
             stream.read(buffer.data(), buffer.size());
+
             std::ispanstream tim_stream(buffer);
-            result.textures.emplace_back(tim::get_tim_data_as_bitmap(tim_stream));
+            result.textures.emplace_back(tim::get_tim_image(tim_stream));
           }
         }
       }
 
-      results.emplace_back(std::move(result));
+      return result;
+    }
+
+    return std::nullopt;
+  }
+
+  tmd::tmd_object to_tmd_object(const bnd_shape& shape)
+  {
+    constexpr static std::uint8_t gouraud_textured_triangle = 0x34;
+
+    tmd::tmd_object result{ shape.vertices, shape.normals, {} };
+    result.polygons.reserve(shape.primitives.size());
+
+    for (const auto& primitive : shape.primitives)
+    {
+      auto polygon = tmd::read_polygon(gouraud_textured_triangle, 0, std::as_bytes(std::span(&primitive, 1)));
+
+      if (polygon)
+      {
+        result.polygons.emplace_back(*polygon);
+      }
     }
 
-    return results;
+    return result;
   }
 }// namespace siege::content::bnd
\ No newline at end of file
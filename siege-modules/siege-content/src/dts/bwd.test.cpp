@@ -0,0 +1,56 @@
+#include <algorithm>
+#include <catch2/catch_test_macros.hpp>
+#include <siege/content/dts/bwd_renderable_shape.hpp>
+#include "test_helpers.hpp"
+
+using namespace siege::content;
+using namespace siege::content::test_helpers;
+
+TEST_CASE("BWD objects are placed at their origins and their surfaces become materials", "[bwd]")
+{
+  wtb::wtb_shape mesh;
+  mesh.points.emplace_back(wtb::wtb_point{ 0, 0, 0, 0 });
+  mesh.points.emplace_back(wtb::wtb_point{ 1, 0, 0, 0 });
+  mesh.points.emplace_back(wtb::wtb_point{ 1, 1, 0, 0 });
+  mesh.points.emplace_back(wtb::wtb_point{ 0, 1, 0, 0 });
+  // A quad with a texture, a triangle with none and one polygon which points past the end of the mesh.
+  mesh.polygons.emplace_back(wtb::wtb_polygon{ 7, { 0, 1, 2, 3 } });
+  mesh.polygons.emplace_back(wtb::wtb_polygon{ 9, { 0, 2, 3 } });
+  mesh.polygons.emplace_back(wtb::wtb_polygon{ 7, { 0, 1, 4 } });
+
+  bwd::bwd_model model{};
+  auto& object = model.objects.emplace_back();
+  object.origin = bwd::vec_3s{ 10, -20, 30 };
+  object.prf_file_index = 3;
+  // The mesh of this one cannot be found, so it is left empty.
+  model.objects.emplace_back().prf_file_index = 4;
+
+  std::vector<std::int16_t> requested;
+  bwd::bwd_renderable_shape shape(
+    model,
+    [&](std::int16_t file_id) -> std::optional<wtb::wtb_shape> {
+      requested.emplace_back(file_id);
+      return file_id == 3 ? std::make_optional(mesh) : std::nullopt;
+    },
+    [](std::uint16_t file_id) -> std::optional<std::string> {
+      return file_id == 7 ? std::make_optional<std::string>("tex.bmp") : std::nullopt;
+    });
+
+  REQUIRE(requested == std::vector<std::int16_t>{ 3, 4 });
+
+  auto materials = shape.get_materials();
+  REQUIRE(materials.size() == 2);
+  REQUIRE(materials[0].filename == "tex.bmp");
+  REQUIRE(materials[1].filename.empty());
+  REQUIRE(std::get<std::uint16_t>(materials[0].metadata.at("surface")) == 7);
+
+  auto batches = shape.get_mesh_batches({ 0 }, {});
+  REQUIRE(batches.size() == 2);
+
+  auto textured = std::find_if(batches.begin(), batches.end(), [](const auto& batch) { return batch.material_index == 0; });
+  REQUIRE(textured != batches.end());
+  REQUIRE(textured->get_index_count() == 6);
+  REQUIRE(is_near(textured->vertices[0].position.x, 10));
+  REQUIRE(is_near(textured->vertices[0].position.y, -20));
+  REQUIRE(is_near(textured->vertices[0].position.z, 30));
+}
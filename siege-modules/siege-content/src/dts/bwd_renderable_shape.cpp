@@ -0,0 +1,203 @@
+#include <algorithm>
+#include <map>
+#include <siege/content/dts/bwd_renderable_shape.hpp>
+
+namespace siege::content::bwd
+{
+  constexpr std::string_view root_node_name = "root";
+
+  bwd_renderable_shape::bwd_renderable_shape(const bwd_model& model, const mesh_resolver& resolve_mesh, const texture_resolver& resolve_texture)
+  {
+    struct decoded_mesh
+    {
+      std::vector<vector3f> positions;
+      std::vector<std::array<std::uint16_t, 3>> faces;
+      std::vector<std::int32_t> face_materials;
+    };
+
+    // Objects often share meshes, so each one is only resolved and decoded the once.
+    std::map<std::int16_t, std::optional<decoded_mesh>> meshes;
+    std::map<std::uint16_t, std::int32_t> surface_materials;
+
+    auto get_material = [&](std::uint16_t surface) {
+      auto [existing, added] = surface_materials.try_emplace(surface, std::int32_t(materials.size()));
+
+      if (added)
+      {
+        auto& result = materials.emplace_back();
+        result.metadata.emplace("surface", surface);
+
+        if (auto texture = resolve_texture ? resolve_texture(surface) : std::nullopt; texture)
+        {
+          result.filename = std::move(*texture);
+        }
+      }
+
+      return existing->second;
+    };
+
+    auto get_mesh = [&](std::int16_t prj_file_index) -> const auto& {
+      auto [existing, added] = meshes.try_emplace(prj_file_index);
+
+      if (!added)
+      {
+        return existing->second;
+      }
+
+      auto mesh = resolve_mesh(prj_file_index);
+
+      if (!mesh)
+      {
+        return existing->second;
+      }
+
+      auto& [positions, faces, face_materials] = existing->second.emplace();
+      positions.resize(mesh->points.size());
+      wtb::decode_points(mesh->points, positions);
+
+      for (const auto& polygon : mesh->polygons)
+      {
+        const auto& points = polygon.points;
+        auto is_valid = points.size() >= 3 && std::all_of(points.begin(), points.end(), [&](auto index) { return index < positions.size(); });
+
+        if (!is_valid)
+        {
+          continue;
+        }
+
+        auto material_index = get_material(polygon.surface);
+
+        // Polygons are convex, so a fan around the first point covers each of them.
+        for (auto i = 1u; i + 1 < points.size(); ++i)
+        {
+          faces.emplace_back(std::array<std::uint16_t, 3>{ points[0], points[i], points[i + 1] });
+          face_materials.emplace_back(material_index);
+        }
+      }
+
+      return existing->second;
+    };
+
+    auto add_objects = [&](detail_level& level, const std::vector<dtb_object>& objects) {
+      for (const auto& object : objects)
+      {
+        const auto& mesh = get_mesh(object.prf_file_index);
+
+        if (!mesh)
+        {
+          continue;
+        }
+
+        auto& result = level.objects.emplace_back();
+        result.name = "object_" + std::to_string(std::int16_t(object.id));
+        result.faces = mesh->faces;
+        result.face_materials = mesh->face_materials;
+        result.positions.resize(mesh->positions.size());
+
+        const vector3f origin{ float(std::int16_t(object.origin.x)), float(std::int16_t(object.origin.y)), float(std::int16_t(object.origin.z)) };
+
+        std::transform(mesh->positions.begin(), mesh->positions.end(), result.positions.begin(), [&](const vector3f& position) {
+          return vector3f{ position.x + origin.x, position.y + origin.y, position.z + origin.z };
+        });
+      }
+    };
+
+    add_objects(detail_levels.emplace_back(detail_level{ "default" }), model.objects);
+
+    for (const auto& [index, objects] : model.lod_objects)
+    {
+      add_objects(detail_levels.emplace_back(detail_level{ "lod-" + std::to_string(index) }), objects);
+    }
+  }
+
+  std::vector<sequence_info> bwd_renderable_shape::get_sequences(const std::vector<std::size_t>&) const
+  {
+    return {};
+  }
+
+  std::vector<std::string> bwd_renderable_shape::get_detail_levels() const
+  {
+    std::vector<std::string> results;
+    results.reserve(detail_levels.size());
+
+    for (const auto& level : detail_levels)
+    {
+      results.emplace_back(level.name);
+    }
+
+    return results;
+  }
+
+  std::vector<material> bwd_renderable_shape::get_materials() const
+  {
+    return materials;
+  }
+
+  void bwd_renderable_shape::render_shape(shape_renderer& renderer, const std::vector<std::size_t>& detail_level_indexes, const std::vector<sequence_info>&) const
+  {
+    renderer.update_node(std::nullopt, root_node_name);
+
+    for (auto detail_level_index : detail_level_indexes)
+    {
+      if (detail_level_index >= detail_levels.size())
+      {
+        continue;
+      }
+
+      for (const auto& object : detail_levels[detail_level_index].objects)
+      {
+        renderer.update_object(root_node_name, object.name);
+
+        for (const auto& face : object.faces)
+        {
+          renderer.new_face(3);
+
+          for (auto index : face)
+          {
+            renderer.emit_vertex(object.positions[index]);
+          }
+
+          for (auto i = 0u; i < face.size(); ++i)
+          {
+            renderer.emit_texture_vertex(texture_vertex{});
+          }
+
+          renderer.end_face();
+        }
+      }
+    }
+  }
+
+  std::vector<mesh_batch> bwd_renderable_shape::get_mesh_batches(const std::vector<std::size_t>& detail_level_indexes, const std::vector<sequence_info>&) const
+  {
+    mesh_batch_builder builder;
+
+    for (auto detail_level_index : detail_level_indexes)
+    {
+      if (detail_level_index >= detail_levels.size())
+      {
+        continue;
+      }
+
+      for (const auto& object : detail_levels[detail_level_index].objects)
+      {
+        builder.begin_object(root_node_name, object.name, object.positions.size());
+
+        for (auto face_index = 0u; face_index < object.faces.size(); ++face_index)
+        {
+          const auto& face = object.faces[face_index];
+          std::array<mesh_batch_builder::corner, 3> corners;
+
+          for (auto i = 0u; i < corners.size(); ++i)
+          {
+            corners[i] = mesh_batch_builder::corner{ face[i], 0, object.positions[face[i]], texture_vertex{} };
+          }
+
+          builder.add_triangle(object.face_materials[face_index], corners);
+        }
+      }
+    }
+
+    return builder.finish();
+  }
+}// namespace siege::content::bwd
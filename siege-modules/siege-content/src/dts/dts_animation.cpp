@@ -0,0 +1,314 @@
+#include <algorithm>
+#include <cmath>
+#include <execution>
+#include <numeric>
+#include <tuple>
+#include <utility>
+#include <glm/gtx/quaternion.hpp>
+#include <siege/content/dts/dts_animation.hpp>
+
+namespace siege::content::dts::darkstar
+{
+  static node_pose to_pose(const shape::v2::transform& transform)
+  {
+    auto rotation = to_float(transform.rotation);
+    return node_pose{ glm::quat(rotation.w, rotation.x, rotation.y, rotation.z), glm::vec3(transform.translation.x, transform.translation.y, transform.translation.z), glm::vec3(transform.scale.x, transform.scale.y, transform.scale.z) };
+  }
+
+  static node_pose to_pose(const shape::v7::transform& transform)
+  {
+    auto rotation = to_float(transform.rotation);
+    return node_pose{ glm::quat(rotation.w, rotation.x, rotation.y, rotation.z), glm::vec3(transform.translation.x, transform.translation.y, transform.translation.z), glm::vec3(transform.scale.x, transform.scale.y, transform.scale.z) };
+  }
+
+  static node_pose to_pose(const shape::v8::transform& transform)
+  {
+    auto rotation = to_float(transform.rotation);
+    return node_pose{ glm::quat(rotation.w, rotation.x, rotation.y, rotation.z), glm::vec3(transform.translation.x, transform.translation.y, transform.translation.z), glm::vec3(1.0f) };
+  }
+
+  glm::mat4 to_matrix(const node_pose& pose)
+  {
+    auto translation_matrix = glm::translate(glm::mat4(1.0f), pose.translation);
+    auto rotation_matrix = glm::transpose(glm::toMat4(pose.rotation));
+    auto scale_matrix = glm::scale(glm::mat4(1.0f), pose.scale);
+
+    return translation_matrix * rotation_matrix * scale_matrix;
+  }
+
+  std::span<const node_pose> pose_cache::get_frame_at(float position) const
+  {
+    if (frame_count == 0)
+    {
+      return {};
+    }
+
+    if (cyclic)
+    {
+      position -= std::floor(position);
+      return get_frame(std::size_t(std::lround(position * float(frame_count))) % frame_count);
+    }
+
+    position = std::clamp(position, 0.0f, 1.0f);
+    return get_frame(std::size_t(std::lround(position * float(frame_count - 1))));
+  }
+
+  animation_engine::animation_engine(const shape_variant& shape)
+  {
+    std::visit([&](const auto& local_shape) {
+      const auto node_count = local_shape.nodes.size();
+      const auto sequence_count = local_shape.sequences.size();
+
+      default_pose.reserve(node_count);
+
+      for (const auto& node : local_shape.nodes)
+      {
+        auto transform_index = std::size_t(node.default_transform_index);
+        default_pose.emplace_back(transform_index < local_shape.transforms.size() ? to_pose(local_shape.transforms[transform_index]) : node_pose{ glm::quat(1.0f, 0.0f, 0.0f, 0.0f), glm::vec3(0.0f), glm::vec3(1.0f) });
+      }
+
+      cyclic.reserve(sequence_count);
+      durations.reserve(sequence_count);
+
+      for (const auto& sequence : local_shape.sequences)
+      {
+        cyclic.emplace_back(sequence.cyclic != 0);
+        durations.emplace_back(sequence.duration);
+      }
+
+      // Nodes without sub sequences of their own are animated by the first object attached to them, the same as get_sequences.
+      std::vector<std::int32_t> first_object(node_count, -1);
+
+      for (auto i = 0u; i < local_shape.objects.size(); ++i)
+      {
+        auto node_index = std::size_t(local_shape.objects[i].node_index);
+
+        if (node_index < node_count && first_object[node_index] == -1)
+        {
+          first_object[node_index] = std::int32_t(i);
+        }
+      }
+
+      auto add_channels = [&](std::int32_t node_index, std::int32_t first_sub_sequence, std::int32_t sub_sequence_count) {
+        for (auto i = first_sub_sequence; i < first_sub_sequence + sub_sequence_count; ++i)
+        {
+          if (i < 0 || std::size_t(i) >= local_shape.sub_sequences.size())
+          {
+            continue;
+          }
+
+          const auto& sub_sequence = local_shape.sub_sequences[i];
+
+          if (sub_sequence.sequence_index < 0 || std::size_t(sub_sequence.sequence_index) >= sequence_count)
+          {
+            continue;
+          }
+
+          node_channel channel{ node_index, std::int32_t(sub_sequence.sequence_index), std::int32_t(sub_sequence.first_key_frame_index) };
+
+          const auto first_key_frame = std::int32_t(sub_sequence.first_key_frame_index);
+          const auto key_frame_count = std::int32_t(sub_sequence.num_key_frames);
+
+          for (auto k = first_key_frame; k < first_key_frame + key_frame_count; ++k)
+          {
+            if (k < 0 || std::size_t(k) >= local_shape.keyframes.size())
+            {
+              continue;
+            }
+
+            const auto& key_frame = local_shape.keyframes[k];
+
+            // Keyframes which do not point at a transform only change materials or visibility.
+            if (key_frame.transform_index >= local_shape.transforms.size())
+            {
+              continue;
+            }
+
+            auto pose = to_pose(local_shape.transforms[key_frame.transform_index]);
+            channel.positions.emplace_back(key_frame.position);
+            channel.rotations.emplace_back(pose.rotation);
+            channel.translations.emplace_back(pose.translation);
+            channel.scales.emplace_back(pose.scale);
+          }
+
+          if (!channel.positions.empty())
+          {
+            channels.emplace_back(std::move(channel));
+          }
+        }
+      };
+
+      for (auto node_index = 0u; node_index < node_count; ++node_index)
+      {
+        const auto& node = local_shape.nodes[node_index];
+
+        if (node.num_sub_sequences == 0)
+        {
+          if (first_object[node_index] != -1)
+          {
+            const auto& object = local_shape.objects[first_object[node_index]];
+            add_channels(std::int32_t(node_index), object.first_sub_sequence_index, object.num_sub_sequences);
+          }
+        }
+        else
+        {
+          add_channels(std::int32_t(node_index), node.first_sub_sequence_index, node.num_sub_sequences);
+        }
+      }
+
+      std::stable_sort(channels.begin(), channels.end(), [](const auto& left, const auto& right) {
+        return left.sequence_index < right.sequence_index;
+      });
+
+      sequence_offsets.assign(sequence_count + 1, 0);
+
+      for (const auto& channel : channels)
+      {
+        ++sequence_offsets[channel.sequence_index + 1];
+      }
+
+      std::partial_sum(sequence_offsets.begin(), sequence_offsets.end(), sequence_offsets.begin());
+
+      channels_by_key_frame.resize(channels.size());
+      std::iota(channels_by_key_frame.begin(), channels_by_key_frame.end(), 0u);
+      std::stable_sort(channels_by_key_frame.begin(), channels_by_key_frame.end(), [&](auto left, auto right) {
+        return std::tie(channels[left].node_index, channels[left].first_key_frame_index) < std::tie(channels[right].node_index, channels[right].first_key_frame_index);
+      });
+    },
+      shape);
+  }
+
+  std::span<const node_channel> animation_engine::get_channels(std::size_t sequence_index) const
+  {
+    return std::span(channels).subspan(sequence_offsets[sequence_index], sequence_offsets[sequence_index + 1] - sequence_offsets[sequence_index]);
+  }
+
+  node_pose animation_engine::sample(const node_channel& channel, float position, bool cyclic)
+  {
+    const auto count = channel.positions.size();
+    auto key = [&](std::size_t index) { return node_pose{ channel.rotations[index], channel.translations[index], channel.scales[index] }; };
+
+    if (count == 1)
+    {
+      return key(0);
+    }
+
+    if (cyclic)
+    {
+      position -= std::floor(position);
+    }
+
+    const auto& positions = channel.positions;
+    auto next = std::size_t(std::distance(positions.begin(), std::upper_bound(positions.begin(), positions.end(), position)));
+
+    std::size_t previous;
+    float start;
+    float end;
+
+    if (next == 0 || next == count)
+    {
+      if (!cyclic)
+      {
+        return key(next == 0 ? 0 : count - 1);
+      }
+
+      // Between the last keyframe and the first one of the next cycle.
+      previous = count - 1;
+      next = 0;
+      start = positions[previous] - (position < positions[previous] ? 1.0f : 0.0f);
+      end = positions[next] + (position < positions[previous] ? 0.0f : 1.0f);
+    }
+    else
+    {
+      previous = next - 1;
+      start = positions[previous];
+      end = positions[next];
+    }
+
+    const auto amount = end > start ? (position - start) / (end - start) : 0.0f;
+
+    if (amount <= 0.0f)
+    {
+      return key(previous);
+    }
+
+    return node_pose{
+      glm::slerp(channel.rotations[previous], channel.rotations[next], amount),
+      glm::mix(channel.translations[previous], channel.translations[next], amount),
+      glm::mix(channel.scales[previous], channel.scales[next], amount)
+    };
+  }
+
+  void animation_engine::sample(std::size_t sequence_index, float position, std::span<node_pose> pose) const
+  {
+    std::copy_n(default_pose.begin(), std::min(default_pose.size(), pose.size()), pose.begin());
+
+    for (const auto& channel : get_channels(sequence_index))
+    {
+      if (std::size_t(channel.node_index) < pose.size())
+      {
+        pose[channel.node_index] = sample(channel, position, cyclic[sequence_index]);
+      }
+    }
+  }
+
+  const node_channel* animation_engine::find_channel(std::int32_t node_index, std::int32_t first_key_frame_index) const
+  {
+    const auto key = std::make_pair(node_index, first_key_frame_index);
+
+    auto result = std::lower_bound(channels_by_key_frame.begin(), channels_by_key_frame.end(), key, [&](auto index, const auto& value) {
+      return std::make_pair(channels[index].node_index, channels[index].first_key_frame_index) < value;
+    });
+
+    if (result == channels_by_key_frame.end() || std::make_pair(channels[*result].node_index, channels[*result].first_key_frame_index) != key)
+    {
+      return nullptr;
+    }
+
+    return &channels[*result];
+  }
+
+  void animation_engine::sample(const std::vector<sequence_info>& sequences, std::span<node_pose> pose) const
+  {
+    std::copy_n(default_pose.begin(), std::min(default_pose.size(), pose.size()), pose.begin());
+
+    for (const auto& sequence : sequences)
+    {
+      if (!sequence.enabled || sequence.index < 0 || std::size_t(sequence.index) >= cyclic.size())
+      {
+        continue;
+      }
+
+      for (const auto& sub_sequence : sequence.sub_sequences)
+      {
+        if (!sub_sequence.enabled || std::size_t(sub_sequence.node_index) >= pose.size())
+        {
+          continue;
+        }
+
+        if (auto channel = find_channel(sub_sequence.node_index, sub_sequence.first_key_frame_index); channel)
+        {
+          pose[sub_sequence.node_index] = sample(*channel, sub_sequence.position, cyclic[sequence.index]);
+        }
+      }
+    }
+  }
+
+  pose_cache animation_engine::bake(std::size_t sequence_index, std::size_t frame_count) const
+  {
+    pose_cache result{ get_node_count(), frame_count, cyclic[sequence_index] };
+    result.poses.resize(result.node_count * frame_count);
+
+    std::vector<std::size_t> frames(frame_count);
+    std::iota(frames.begin(), frames.end(), std::size_t(0));
+
+    // A cyclic sequence comes back around to its first frame, so the last frame stops one step short of it.
+    const auto steps = float(result.cyclic ? frame_count : std::max<std::size_t>(frame_count, 2) - 1);
+
+    std::for_each(std::execution::par, frames.begin(), frames.end(), [&](std::size_t frame) {
+      sample(sequence_index, float(frame) / steps, std::span(result.poses).subspan(frame * result.node_count, result.node_count));
+    });
+
+    return result;
+  }
+}// namespace siege::content::dts::darkstar
@@ -0,0 +1,150 @@
+#include <catch2/catch_test_macros.hpp>
+#include <siege/content/dts/dts_animation.hpp>
+#include "test_helpers.hpp"
+
+using namespace siege::content;
+using namespace siege::content::dts::darkstar;
+using namespace siege::content::test_helpers;
+
+namespace
+{
+  shape::v2::transform make_transform(float x)
+  {
+    return shape::v2::transform{ quaternion4f{ 0, 0, 0, 1 }, vector3f{ x, 0, 0 }, vector3f{ 1, 1, 1 } };
+  }
+
+  // A root node with one child, which moves from x = 0 to x = 2 and back over one sequence.
+  shape::v2::shape make_shape(bool cyclic)
+  {
+    shape::v2::shape result{};
+    result.transforms = { make_transform(0), make_transform(0), make_transform(2) };
+
+    result.nodes.resize(2);
+    result.nodes[0].parent_node_index = -1;
+    result.nodes[0].default_transform_index = 0;
+    result.nodes[1].parent_node_index = 0;
+    result.nodes[1].default_transform_index = 0;
+    result.nodes[1].num_sub_sequences = 1;
+    result.nodes[1].first_sub_sequence_index = 0;
+
+    result.sequences.resize(1);
+    result.sequences[0].cyclic = cyclic ? 1 : 0;
+
+    result.sub_sequences.resize(1);
+    result.sub_sequences[0].sequence_index = 0;
+    result.sub_sequences[0].num_key_frames = 2;
+    result.sub_sequences[0].first_key_frame_index = 0;
+
+    result.keyframes.resize(2);
+    result.keyframes[0].position = 0;
+    result.keyframes[0].transform_index = 1;
+    result.keyframes[1].position = 0.5f;
+    result.keyframes[1].transform_index = 2;
+
+    return result;
+  }
+}// namespace
+
+TEST_CASE("Keyframes are interpolated between their positions", "[dts.animation]")
+{
+  animation_engine engine(make_shape(false));
+
+  REQUIRE(engine.get_node_count() == 2);
+  REQUIRE(engine.get_sequence_count() == 1);
+  REQUIRE(engine.get_channels(0).size() == 1);
+
+  const auto& channel = engine.get_channels(0).front();
+  REQUIRE(channel.node_index == 1);
+
+  REQUIRE(is_near(animation_engine::sample(channel, 0.0f, false).translation.x, 0));
+  REQUIRE(is_near(animation_engine::sample(channel, 0.25f, false).translation.x, 1));
+  REQUIRE(is_near(animation_engine::sample(channel, 0.5f, false).translation.x, 2));
+
+  SECTION("Sequences which do not repeat hold their last keyframe")
+  {
+    REQUIRE(is_near(animation_engine::sample(channel, 0.75f, false).translation.x, 2));
+  }
+
+  SECTION("Cyclic sequences go from the last keyframe back to the first")
+  {
+    REQUIRE(is_near(animation_engine::sample(channel, 0.75f, true).translation.x, 1));
+    REQUIRE(is_near(animation_engine::sample(channel, 1.25f, true).translation.x, 1));
+  }
+}
+
+TEST_CASE("Enabled sub sequences move their node and leave the rest at the default pose", "[dts.animation]")
+{
+  animation_engine engine(make_shape(false));
+
+  std::vector<sequence_info> sequences(1);
+  sequences[0].index = 0;
+  sequences[0].enabled = true;
+  sequences[0].sub_sequences.resize(1);
+
+  auto& sub_sequence = sequences[0].sub_sequences[0];
+  sub_sequence.node_index = 1;
+  sub_sequence.first_key_frame_index = 0;
+  sub_sequence.num_key_frames = 2;
+  sub_sequence.position = 0.25f;
+  sub_sequence.enabled = true;
+
+  std::vector<node_pose> pose(engine.get_node_count());
+  engine.sample(sequences, pose);
+
+  REQUIRE(is_near(pose[0].translation.x, 0));
+  REQUIRE(is_near(pose[1].translation.x, 1));
+
+  sub_sequence.enabled = false;
+  engine.sample(sequences, pose);
+
+  REQUIRE(is_near(pose[1].translation.x, 0));
+}
+
+TEST_CASE("When nodes share the same keyframes, each node is found by its own channel", "[dts.animation]")
+{
+  auto shared = make_shape(false);
+  shared.nodes.resize(3);
+  shared.nodes[2] = shared.nodes[1];
+
+  animation_engine engine(shared);
+  REQUIRE(engine.get_channels(0).size() == 2);
+
+  std::vector<sequence_info> sequences(1);
+  sequences[0].index = 0;
+  sequences[0].enabled = true;
+  sequences[0].sub_sequences.resize(1);
+
+  // Only the second node is enabled, so a lookup by keyframe alone would find the first node and skip it.
+  auto& sub_sequence = sequences[0].sub_sequences[0];
+  sub_sequence.node_index = 2;
+  sub_sequence.first_key_frame_index = 0;
+  sub_sequence.num_key_frames = 2;
+  sub_sequence.position = 0.25f;
+  sub_sequence.enabled = true;
+
+  std::vector<node_pose> pose(engine.get_node_count());
+  engine.sample(sequences, pose);
+
+  REQUIRE(is_near(pose[1].translation.x, 0));
+  REQUIRE(is_near(pose[2].translation.x, 1));
+}
+
+TEST_CASE("Baked frames match sampling each position", "[dts.animation]")
+{
+  animation_engine engine(make_shape(true));
+  REQUIRE(engine.is_cyclic(0));
+
+  auto cache = engine.bake(0, 4);
+
+  REQUIRE(cache.frame_count == 4);
+  REQUIRE(cache.poses.size() == 8);
+
+  std::array<float, 4> expected{ 0, 1, 2, 1 };
+
+  for (auto i = 0u; i < expected.size(); ++i)
+  {
+    REQUIRE(is_near(cache.get_frame(i)[1].translation.x, expected[i]));
+  }
+
+  REQUIRE(is_near(cache.get_frame_at(1.25f)[1].translation.x, 1));
+}
@@ -4,7 +4,7 @@
 #include <optional>
 #include <memory>
 #include <functional>
-#include <list>
+#include <span>
 #include <glm/gtx/quaternion.hpp>
 
 #include <siege/content/dts/dts_renderable_shape.hpp>
@@ -21,110 +21,162 @@ overloaded(Ts...) -> overloaded<Ts...>;
 
 namespace siege::content::dts::darkstar
 {
-  struct node_instance
+  // Mesh vertices are bytes, which are scaled and then moved by the origin of the mesh.
+  template<typename Mesh>
+  glm::mat4 get_mesh_matrix(const Mesh& mesh)
   {
-    std::set<std::int32_t> object_indexes;
-    std::unordered_map<std::int32_t, std::unique_ptr<node_instance>> node_indexes;
-  };
+    vector3f mesh_scale{ 1, 1, 1 };
+    vector3f mesh_origin{ 0, 0, 0 };
 
-  struct instance_info
-  {
-    using transform = std::tuple<vector3f, quaternion4f, vector3f>;
-    std::pair<std::int32_t, std::unique_ptr<node_instance>> root_node;
-  };
+    if constexpr (Mesh::version < 3)
+    {
+      mesh_scale = mesh.header.scale;
+      mesh_origin = mesh.header.origin;
+    }
+    else
+    {
+      if (!mesh.frames.empty())
+      {
+        mesh_scale = mesh.frames[0].scale;
+        mesh_origin = mesh.frames[0].origin;
+      }
+    }
 
-  std::tuple<vector3f, quaternion4f, vector3f> get_translation(const shape::v2::transform& transform)
-  {
-    return std::make_tuple(transform.translation, to_float(transform.rotation), transform.scale);
+    return glm::translate(glm::mat4(1.0f), glm::vec3(mesh_origin.x, mesh_origin.y, mesh_origin.z)) * glm::scale(glm::mat4(1.0f), glm::vec3(mesh_scale.x, mesh_scale.y, mesh_scale.z));
   }
 
-  std::tuple<vector3f, quaternion4f, vector3f> get_translation(const shape::v7::transform& transform)
+  // Applies one matrix to every vertex of a mesh. The matrix is unpacked into plain floats first,
+  // which leaves a loop of independent multiply-adds that the compiler can vectorise.
+  void transform_vertices(std::span<const mesh::v1::vertex> vertices, const glm::mat4& matrix, std::span<vector3f> destination)
   {
-    return std::make_tuple(transform.translation, to_float(transform.rotation), transform.scale);
+    const float m00 = matrix[0][0], m01 = matrix[0][1], m02 = matrix[0][2];
+    const float m10 = matrix[1][0], m11 = matrix[1][1], m12 = matrix[1][2];
+    const float m20 = matrix[2][0], m21 = matrix[2][1], m22 = matrix[2][2];
+    const float m30 = matrix[3][0], m31 = matrix[3][1], m32 = matrix[3][2];
+
+    const auto count = std::min(vertices.size(), destination.size());
+
+    for (auto i = 0u; i < count; ++i)
+    {
+      const float x = vertices[i].x;
+      const float y = vertices[i].y;
+      const float z = vertices[i].z;
+
+      destination[i] = vector3f{
+        m00 * x + m10 * y + m20 * z + m30,
+        m01 * x + m11 * y + m21 * z + m31,
+        m02 * x + m12 * y + m22 * z + m32
+      };
+    }
   }
 
-  std::tuple<vector3f, quaternion4f, vector3f> get_translation(const shape::v8::transform& transform)
+  bool is_valid_face(const mesh::v1::face& face, std::size_t vertex_count, std::size_t texture_vertex_count)
   {
-    return std::make_tuple(transform.translation, to_float(transform.rotation), vector3f{ 1.0f, 1.0f, 1.0f });
+    auto is_valid = [](std::int32_t index, std::size_t count) { return index >= 0 && std::size_t(index) < count; };
+
+    return is_valid(face.vi1, vertex_count) && is_valid(face.vi2, vertex_count) && is_valid(face.vi3, vertex_count)
+           && is_valid(face.ti1, texture_vertex_count) && is_valid(face.ti2, texture_vertex_count) && is_valid(face.ti3, texture_vertex_count);
   }
 
-  std::int32_t get_transform_index(const shape_variant& shape, std::int32_t node_index, const std::vector<sequence_info>& sequences)
+  // Adds the triangles of one object to builder, with its vertices moved by matrix.
+  template<typename Shape, typename Object>
+  void add_object(mesh_batch_builder& builder, const Shape& shape, const Object& object, std::string_view node_name, const glm::mat4& matrix, std::vector<vector3f>& transformed_vertices)
   {
-    return std::visit([&](const auto& local_shape) {
-      std::int32_t transform_index = local_shape.nodes[node_index].default_transform_index;
+    if (object.mesh_index < 0 || std::size_t(object.mesh_index) >= shape.meshes.size())
+    {
+      return;
+    }
+
+    std::visit([&](const auto& mesh) {
+      transformed_vertices.resize(mesh.vertices.size());
+      transform_vertices(mesh.vertices, matrix * get_mesh_matrix(mesh), transformed_vertices);
+
+      builder.begin_object(node_name, shape.names[object.name_index].data(), mesh.vertices.size());
 
-      for (auto& sequence : sequences)
+      for (const auto& face : mesh.faces)
       {
-        if (sequence.enabled)
+        if (!is_valid_face(face, mesh.vertices.size(), mesh.texture_vertices.size()))
         {
-          for (auto& sub_sequence : sequence.sub_sequences)
-          {
-            if (sub_sequence.enabled && node_index == sub_sequence.node_index)
-            {
-              const auto& key_frame = local_shape.keyframes[sub_sequence.first_key_frame_index + sub_sequence.frame_index];
+          continue;
+        }
 
-              if (local_shape.transforms.size() > key_frame.transform_index)
-              {
-                transform_index = key_frame.transform_index;
-                break;
-              }
-              else
-              {
-                continue;
-              }
-            }
-          }
+        std::array<std::pair<std::int32_t, std::int32_t>, 3> indexes{ { { face.vi3, face.ti3 }, { face.vi2, face.ti2 }, { face.vi1, face.ti1 } } };
+        std::array<mesh_batch_builder::corner, 3> corners;
+
+        for (auto i = 0u; i < corners.size(); ++i)
+        {
+          auto [vertex_index, texture_index] = indexes[i];
+          corners[i] = mesh_batch_builder::corner{ std::uint32_t(vertex_index), std::uint32_t(texture_index), transformed_vertices[vertex_index], mesh.texture_vertices[texture_index] };
         }
-      }
 
-      return transform_index;
+        builder.add_triangle(face.material, corners);
+      }
     },
-      shape);
+      shape.meshes[object.mesh_index]);
   }
 
-  instance_info get_instance(const shape_variant& shape, std::size_t detail_level_index)
+  // Counting sort of items by the node they belong to, which keeps them in their original order within each node.
+  template<typename Items, typename GetNode>
+  void build_adjacency(std::size_t node_count, const Items& items, GetNode get_node, std::vector<std::int32_t>& offsets, std::vector<std::int32_t>& values)
   {
-    return std::visit([&](const auto& local_shape) {
-      const auto& detail_level = local_shape.details[detail_level_index];
-      const std::int32_t root_note_index = detail_level.root_node_index;
+    offsets.assign(node_count + 1, 0);
 
-      instance_info info{
-        std::make_pair(root_note_index, std::make_unique<node_instance>())
-      };
-
-      std::list<std::pair<const std::int32_t, node_instance*>> valid_nodes{ std::make_pair(root_note_index, info.root_node.second.get()) };
+    for (const auto& item : items)
+    {
+      auto node_index = std::int32_t(get_node(item));
 
-      for (const auto& iterator : valid_nodes)
+      if (node_index >= 0 && std::size_t(node_index) < node_count)
       {
-        auto& [parent_index, node_info] = iterator;
-        for (auto other_node = std::begin(local_shape.nodes); other_node != std::end(local_shape.nodes); ++other_node)
-        {
-          if (other_node->parent_node_index == parent_index)
-          {
-            const auto node_index = static_cast<std::int32_t>(std::distance(std::begin(local_shape.nodes), other_node));
+        ++offsets[node_index + 1];
+      }
+    }
 
-            auto [new_node_info, new_added] = node_info->node_indexes.emplace(node_index, std::make_unique<node_instance>());
+    for (auto i = 0u; i < node_count; ++i)
+    {
+      offsets[i + 1] += offsets[i];
+    }
 
-            if (new_added)
-            {
-              valid_nodes.emplace_back(std::make_pair(new_node_info->first, new_node_info->second.get()));
-            }
-          }
-        }
+    values.resize(offsets.back());
+    auto next = std::vector<std::int32_t>(offsets.begin(), offsets.end() - 1);
 
-        for (auto object = std::begin(local_shape.objects); object != std::end(local_shape.objects); ++object)
-        {
-          if (object->node_index == parent_index)
-          {
-            const auto object_index = static_cast<std::int32_t>(std::distance(std::begin(local_shape.objects), object));
-            node_info->object_indexes.emplace(object_index);
-          }
-        }
+    for (auto i = 0u; i < items.size(); ++i)
+    {
+      auto node_index = std::int32_t(get_node(items[i]));
+
+      if (node_index >= 0 && std::size_t(node_index) < node_count)
+      {
+        values[next[node_index]++] = std::int32_t(i);
       }
+    }
+  }
 
-      return info;
+  dts_renderable_shape::dts_renderable_shape(shape_variant shape)
+    : shape(std::move(shape)), animation(this->shape)
+  {
+    std::visit([&](const auto& local_shape) {
+      const auto node_count = local_shape.nodes.size();
+      build_adjacency(node_count, local_shape.nodes, [](const auto& node) { return node.parent_node_index; }, hierarchy.child_offsets, hierarchy.child_nodes);
+      build_adjacency(node_count, local_shape.objects, [](const auto& object) { return object.node_index; }, hierarchy.object_offsets, hierarchy.node_objects);
     },
-      shape);
+      this->shape);
+  }
+
+  // Visits a node and then its children, passing the state returned for a node on to its children.
+  // The depth is limited to the number of nodes, so a file whose parents loop back on themselves cannot recurse forever.
+  template<typename State, typename Visitor>
+  void visit_nodes(const dts_renderable_shape::node_hierarchy& hierarchy, std::int32_t node_index, const State& parent_state, Visitor& visitor, std::size_t depth = 0)
+  {
+    if (node_index < 0 || std::size_t(node_index) >= hierarchy.size() || depth > hierarchy.size())
+    {
+      return;
+    }
+
+    auto state = visitor(node_index, parent_state);
+
+    for (auto child_node_index : hierarchy.get_children(node_index))
+    {
+      visit_nodes(hierarchy, child_node_index, state, visitor, depth + 1);
+    }
   }
 
   std::vector<sequence_info> dts_renderable_shape::get_sequences(const std::vector<std::size_t>& detail_level_indexes) const
@@ -158,14 +210,7 @@ namespace siege::content::dts::darkstar
 
       for (auto detail_level_index : detail_level_indexes)
       {
-        auto instance = get_instance(shape, detail_level_index);
-
-        std::function<void(const std::int32_t&, const node_instance&)> populate_sequences = [&](const auto& node_index, const auto& node_instance) {
-          if (node_index == -1)
-          {
-            return;
-          }
-
+        auto populate_sequences = [&](std::int32_t node_index, bool) {
           const auto& node = local_shape.nodes[node_index];
           std::string node_name = local_shape.names[node.name_index].data();
 
@@ -196,18 +241,17 @@ namespace siege::content::dts::darkstar
 
           if (node.num_sub_sequences == 0)
           {
-            for (auto& object : local_shape.objects)
+            // Nodes without their own animation use the one of their first object.
+            if (auto objects = hierarchy.get_objects(node_index); !objects.empty())
             {
-              if (object.node_index == node_index)
+              const auto& object = local_shape.objects[objects.front()];
+
+              for (auto i = object.first_sub_sequence_index; i < object.first_sub_sequence_index.value() + object.num_sub_sequences; ++i)
               {
-                for (auto i = object.first_sub_sequence_index; i < object.first_sub_sequence_index.value() + object.num_sub_sequences; ++i)
-                {
-                  auto& sub_sequence = local_shape.sub_sequences[i];
-                  auto& sequence = results[sub_sequence.sequence_index];
+                auto& sub_sequence = local_shape.sub_sequences[i];
+                auto& sequence = results[sub_sequence.sequence_index];
 
-                  sequence.sub_sequences.emplace_back(create_sub_info(node_index, sub_sequence));
-                }
-                break;
+                sequence.sub_sequences.emplace_back(create_sub_info(node_index, sub_sequence));
               }
             }
           }
@@ -222,13 +266,10 @@ namespace siege::content::dts::darkstar
             }
           }
 
-          for (const auto& [child_node_index, child_node_instance] : node_instance.node_indexes)
-          {
-            populate_sequences(child_node_index, *child_node_instance);
-          }
+          return true;
         };
 
-        populate_sequences(instance.root_node.first, *instance.root_node.second);
+        visit_nodes(hierarchy, local_shape.details[detail_level_index].root_node_index, true, populate_sequences);
       }
     },
       shape);
@@ -254,168 +295,190 @@ namespace siege::content::dts::darkstar
       shape);
   }
 
-  std::vector<material> dts_renderable_shape::get_materials() const
+  std::vector<material> get_materials(const material_list_variant& material_list)
   {
-    return std::visit([](const auto& instance) {
-      return std::visit([](const auto& list) {
-        std::vector<material> results;
-        results.reserve(list.materials.size());
+    return std::visit([](const auto& list) {
+      std::vector<material> results;
+      results.reserve(list.materials.size());
 
-        for (const auto& raw_material : list.materials)
+      for (const auto& raw_material : list.materials)
+      {
+        auto& temp = results.emplace_back();
+        temp.filename = raw_material.file_name.data();
+
+        temp.metadata.emplace("flags", raw_material.flags.value());
+        temp.metadata.emplace("alpha", raw_material.alpha);
+        temp.metadata.emplace("index", raw_material.index.value());
+        temp.metadata.emplace("rgbData", raw_material.rgb_data);
+
+        using T = std::decay_t<decltype(raw_material)>;
+
+        if constexpr (std::is_same_v<T, material_list::v3::material>)
+        {
+          temp.metadata.emplace("type", raw_material.type.value());
+          temp.metadata.emplace("friction", raw_material.friction);
+          temp.metadata.emplace("elasticity", raw_material.elasticity);
+        }
+        if constexpr (std::is_same_v<T, material_list::v4::material>)
         {
-         auto& temp = results.emplace_back();
-         temp.filename = raw_material.file_name.data();
-
-         temp.metadata.emplace("flags", raw_material.flags.value());
-         temp.metadata.emplace("alpha", raw_material.alpha);
-         temp.metadata.emplace("index", raw_material.index.value());
-         temp.metadata.emplace("rgbData", raw_material.rgb_data);
-
-         using T = std::decay_t<decltype(raw_material)>;
-
-         if constexpr (std::is_same_v<T, material_list::v3::material>)
-         {
-           temp.metadata.emplace("type", raw_material.type.value());
-           temp.metadata.emplace("friction", raw_material.friction);
-           temp.metadata.emplace("elasticity", raw_material.elasticity);
-         }
-         if constexpr (std::is_same_v<T, material_list::v4::material>)
-         {
-           temp.metadata.emplace("type", raw_material.type.value());
-           temp.metadata.emplace("friction", raw_material.friction);
-           temp.metadata.emplace("elasticity", raw_material.elasticity);
-           temp.metadata.emplace("useDefaultProperties", raw_material.use_default_properties.value());
-         }
+          temp.metadata.emplace("type", raw_material.type.value());
+          temp.metadata.emplace("friction", raw_material.friction);
+          temp.metadata.emplace("elasticity", raw_material.elasticity);
+          temp.metadata.emplace("useDefaultProperties", raw_material.use_default_properties.value());
         }
-        return results;
-      },
-        instance.material_list);
-      }, shape);
+      }
+      return results;
+    },
+      material_list);
   }
 
-  void dts_renderable_shape::render_shape(shape_renderer& renderer, const std::vector<std::size_t>& detail_level_indexes, const std::vector<sequence_info>& sequences) const
+  std::vector<material> dts_renderable_shape::get_materials() const
   {
+    return std::visit([](const auto& instance) { return darkstar::get_materials(instance.material_list); }, shape);
+  }
 
+  void dts_renderable_shape::render_shape(shape_renderer& renderer, const std::vector<std::size_t>& detail_level_indexes, const std::vector<sequence_info>& sequences) const
+  {
     std::visit([&](const auto& local_shape) {
       if (local_shape.details.empty())
       {
         return;
       }
 
-      for (auto detail_level_index : detail_level_indexes)
-      {
-        auto instance = get_instance(shape, detail_level_index);
+      // Reused by every mesh, so that a frame of an animation does not allocate for each object.
+      std::vector<vector3f> transformed_vertices;
 
-        std::function<void(const std::pair<std::int32_t, std::reference_wrapper<node_instance>>&, std::optional<glm::mat4>)> render_node =
-          [&](const auto& node_item, const auto parent_node_matrix) {
-            auto& [node_index, node_instance] = node_item;
+      std::vector<node_pose> pose(animation.get_node_count());
+      animation.sample(sequences, pose);
 
-            const auto& node = local_shape.nodes[node_index];
-            const std::string_view node_name = local_shape.names[node.name_index].data();
+      for (auto detail_level_index : detail_level_indexes)
+      {
+        auto render_node = [&](std::int32_t node_index, const glm::mat4& parent_matrix) {
+          const auto& node = local_shape.nodes[node_index];
+          const std::string_view node_name = local_shape.names[node.name_index].data();
+          const auto node_matrix = parent_matrix * to_matrix(pose[node_index]);
 
-            glm::mat4 node_matrix;
+          std::optional<std::string_view> parent_node_name;
 
-            auto transform_index = get_transform_index(shape, node_index, sequences);
-            const auto& [translation, rotation, scale] = get_translation(local_shape.transforms[transform_index]);
+          if (node.parent_node_index != -1)
+          {
+            const auto& parent_node = local_shape.nodes[node.parent_node_index];
+            parent_node_name = local_shape.names[parent_node.name_index].data();
+          }
 
-            auto translation_matrix = glm::translate(glm::mat4(1.0f), glm::vec3(translation.x, translation.y, translation.z));
-            auto rotation_matrix = glm::transpose(glm::toMat4(glm::quat(rotation.w, rotation.x, rotation.y, rotation.z)));
+          renderer.update_node(parent_node_name, node_name);
 
-            auto scale_matrix = glm::scale(glm::mat4(1.0f), glm::vec3(scale.x, scale.y, scale.z));
+          for (const std::int32_t object_index : hierarchy.get_objects(node_index))
+          {
+            const auto& object = local_shape.objects[object_index];
 
-            if (parent_node_matrix.has_value())
-            {
-              node_matrix = parent_node_matrix.value() * (translation_matrix * rotation_matrix * scale_matrix);
-            }
-            else
+            if (object.mesh_index < 0 || std::size_t(object.mesh_index) >= local_shape.meshes.size())
             {
-              node_matrix = translation_matrix * rotation_matrix * scale_matrix;
+              continue;
             }
 
-            std::optional<std::string_view> parent_node_name;
+            const std::string_view object_name = local_shape.names[object.name_index].data();
 
-            if (node.parent_node_index != -1)
-            {
-              const auto& parent_node = local_shape.nodes[node.parent_node_index];
-              parent_node_name = local_shape.names[parent_node.name_index].data();
-            }
+            renderer.update_object(node_name, object_name);
 
-            renderer.update_node(parent_node_name, node_name);
+            std::visit([&](const auto& mesh) {
+              transformed_vertices.resize(mesh.vertices.size());
+              transform_vertices(mesh.vertices, node_matrix * get_mesh_matrix(mesh), transformed_vertices);
 
-            for (const std::int32_t object_index : node_instance.get().object_indexes)
-            {
-              const auto& object = local_shape.objects[object_index];
-              const std::string_view object_name = local_shape.names[object.name_index].data();
+              for (const auto& face : mesh.faces)
+              {
+                if (!is_valid_face(face, mesh.vertices.size(), mesh.texture_vertices.size()))
+                {
+                  continue;
+                }
 
-              renderer.update_object(node_name, object_name);
+                renderer.new_face(3);
 
-              std::visit([&](const auto& mesh) {
-                vector3f mesh_scale;
-                vector3f mesh_origin;
+                renderer.emit_vertex(transformed_vertices[face.vi3]);
+                renderer.emit_vertex(transformed_vertices[face.vi2]);
+                renderer.emit_vertex(transformed_vertices[face.vi1]);
 
-                if constexpr (std::remove_reference_t<decltype(mesh)>::version < 3)
-                {
-                  mesh_scale = mesh.header.scale;
-                  mesh_origin = mesh.header.origin;
-                }
-                else if constexpr (std::remove_reference_t<decltype(mesh)>::version >= 3)
-                {
-                  if (!mesh.frames.empty())
-                  {
-                    mesh_scale = mesh.frames[0].scale;
-                    mesh_origin = mesh.frames[0].origin;
-                  }
-                  else
-                  {
-                    mesh_scale = { 1, 1, 1 };
-                    mesh_origin = { 0, 0, 0 };
-                  }
-                }
-                for (const auto& face : mesh.faces)
-                {
-                  renderer.new_face(3);
-                  std::array vertices{ std::cref(mesh.vertices[face.vi3]),
-                    std::cref(mesh.vertices[face.vi2]),
-                    std::cref(mesh.vertices[face.vi1]) };
+                renderer.emit_texture_vertex(mesh.texture_vertices[face.ti3]);
+                renderer.emit_texture_vertex(mesh.texture_vertices[face.ti2]);
+                renderer.emit_texture_vertex(mesh.texture_vertices[face.ti1]);
 
-                  std::array texture_vertices{ std::cref(mesh.texture_vertices[face.ti3]),
-                    std::cref(mesh.texture_vertices[face.ti2]),
-                    std::cref(mesh.texture_vertices[face.ti1]) };
+                renderer.end_face();
+              }
+            },
+              local_shape.meshes[object.mesh_index]);
+          }
 
-                  for (const auto& raw_vertex : vertices)
-                  {
-                    auto vertex = glm::vec4(raw_vertex.get().x, raw_vertex.get().y, raw_vertex.get().z, 1.0f);
+          return node_matrix;
+        };
 
-                    auto translation_matrix = glm::translate(glm::mat4(1.0f), glm::vec3(mesh_origin.x, mesh_origin.y, mesh_origin.z));
-                    auto scale_matrix = glm::scale(glm::mat4(1.0f), glm::vec3(mesh_scale.x, mesh_scale.y, mesh_scale.z));
+        visit_nodes(hierarchy, local_shape.details[detail_level_index].root_node_index, glm::mat4(1.0f), render_node);
+      }
+    },
+      shape);
+  }
 
-                    vertex = translation_matrix * scale_matrix * vertex;
+  std::vector<mesh_batch> dts_renderable_shape::get_mesh_batches(const std::vector<std::size_t>& detail_level_indexes, const std::vector<sequence_info>& sequences) const
+  {
+    mesh_batch_builder builder;
+    std::vector<vector3f> transformed_vertices;
 
-                    vertex = node_matrix * vertex;
+    std::visit([&](const auto& local_shape) {
+      if (local_shape.details.empty())
+      {
+        return;
+      }
 
-                    renderer.emit_vertex(vector3f{ vertex.x, vertex.y, vertex.z });
-                  }
+      std::vector<node_pose> pose(animation.get_node_count());
+      animation.sample(sequences, pose);
 
-                  for (const auto& raw_texture_vertex : texture_vertices)
-                  {
-                    renderer.emit_texture_vertex(raw_texture_vertex.get());
-                  }
+      for (auto detail_level_index : detail_level_indexes)
+      {
+        auto add_node = [&](std::int32_t node_index, const glm::mat4& parent_matrix) {
+          const auto& node = local_shape.nodes[node_index];
+          const std::string_view node_name = local_shape.names[node.name_index].data();
+          const auto node_matrix = parent_matrix * to_matrix(pose[node_index]);
 
-                  renderer.end_face();
-                }
-              },
-                local_shape.meshes[object.mesh_index]);
-            }
+          for (const std::int32_t object_index : hierarchy.get_objects(node_index))
+          {
+            const auto& object = local_shape.objects[object_index];
 
-            for (const auto& child_node_item : node_instance.get().node_indexes)
-            {
-              render_node(std::make_pair(child_node_item.first, std::ref(*child_node_item.second)), node_matrix);
-            }
-          };
+            add_object(builder, local_shape, object, node_name, node_matrix, transformed_vertices);
+          }
+
+          return node_matrix;
+        };
 
-        render_node(std::make_pair(instance.root_node.first, std::ref(*instance.root_node.second)), std::nullopt);
+        visit_nodes(hierarchy, local_shape.details[detail_level_index].root_node_index, glm::mat4(1.0f), add_node);
       }
     },
       shape);
+
+    return builder.finish();
+  }
+
+  std::vector<mesh_batch> dts_renderable_shape::get_object_batches(std::int32_t object_index) const
+  {
+    mesh_batch_builder builder;
+    std::vector<vector3f> transformed_vertices;
+
+    std::visit([&](const auto& local_shape) {
+      if (object_index < 0 || std::size_t(object_index) >= local_shape.objects.size())
+      {
+        throw std::out_of_range("The object index is not part of the shape.");
+      }
+
+      const auto& object = local_shape.objects[object_index];
+      std::optional<std::string_view> node_name;
+
+      if (object.node_index >= 0 && std::size_t(object.node_index) < local_shape.nodes.size())
+      {
+        node_name = local_shape.names[local_shape.nodes[object.node_index].name_index].data();
+      }
+
+      add_object(builder, local_shape, object, node_name.value_or(""), glm::mat4(1.0f), transformed_vertices);
+    },
+      shape);
+
+    return builder.finish();
   }
 }// namespace siege::content::dts::darkstar
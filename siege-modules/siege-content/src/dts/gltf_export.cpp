@@ -0,0 +1,234 @@
+#include <algorithm>
+#include <map>
+#include <siege/content/dts/gltf_export.hpp>
+#include <siege/content/dts/dts_renderable_shape.hpp>
+
+namespace siege::content::dts
+{
+  namespace
+  {
+    // Material indexes of the shape and the writer stay the same, so that batches can refer to either.
+    void add_materials(gltf::glb_writer& writer, const renderable_shape& shape, const texture_resolver& resolve_texture)
+    {
+      // Several materials often share one texture, which is only stored once.
+      std::map<std::string, std::optional<std::size_t>> images;
+
+      for (const auto& item : shape.get_materials())
+      {
+        std::optional<std::size_t> image_index;
+        std::array<float, 4> base_colour{ 1, 1, 1, 1 };
+
+        if (!item.filename.empty() && resolve_texture)
+        {
+          auto existing = images.find(item.filename);
+
+          if (existing == images.end())
+          {
+            auto png_data = resolve_texture(item.filename);
+            existing = images.emplace(item.filename, png_data ? std::make_optional(writer.add_image(item.filename, std::move(*png_data))) : std::nullopt).first;
+          }
+
+          image_index = existing->second;
+        }
+
+        if (auto rgb = item.metadata.find("rgbData"); !image_index && rgb != item.metadata.end())
+        {
+          if (auto* colour = std::get_if<rgb_data>(&rgb->second); colour)
+          {
+            base_colour = { float(colour->red) / 255, float(colour->green) / 255, float(colour->blue) / 255, 1 };
+          }
+        }
+
+        writer.add_material(item.filename, image_index, base_colour);
+      }
+    }
+
+    // Rotations in the file turn the other way from what glTF expects, which is what the transpose in to_matrix is for.
+    std::array<float, 4> to_gltf_rotation(const glm::quat& rotation)
+    {
+      return { -rotation.x, -rotation.y, -rotation.z, rotation.w };
+    }
+
+    std::vector<gltf::animation_channel> get_animation_channels(const darkstar::animation_engine& animation, std::size_t sequence_index, std::size_t first_node)
+    {
+      std::vector<gltf::animation_channel> results;
+
+      const auto cyclic = animation.is_cyclic(sequence_index);
+      const auto duration = animation.get_duration(sequence_index) > 0 ? animation.get_duration(sequence_index) : 1.0f;
+
+      for (const auto& channel : animation.get_channels(sequence_index))
+      {
+        // The keyframes themselves, plus both ends of the sequence, so that the wrap around of cyclic sequences is kept.
+        std::vector<float> positions;
+        positions.reserve(channel.positions.size() + 2);
+        positions.emplace_back(0.0f);
+
+        for (auto position : channel.positions)
+        {
+          positions.emplace_back(std::clamp(position, 0.0f, 1.0f));
+        }
+
+        positions.emplace_back(1.0f);
+        std::sort(positions.begin(), positions.end());
+        positions.erase(std::unique(positions.begin(), positions.end()), positions.end());
+
+        const auto node_index = first_node + std::size_t(channel.node_index);
+        gltf::animation_channel translations{ node_index, gltf::animation_path::translation };
+        gltf::animation_channel rotations{ node_index, gltf::animation_path::rotation };
+        gltf::animation_channel scales{ node_index, gltf::animation_path::scale };
+
+        glm::quat previous(1.0f, 0.0f, 0.0f, 0.0f);
+
+        for (auto i = 0u; i < positions.size(); ++i)
+        {
+          // Cyclic sequences wrap back to their first keyframe at the end.
+          auto pose = darkstar::animation_engine::sample(channel, positions[i], cyclic);
+
+          // Neighbouring rotations are kept in the same hemisphere, so that viewers take the short way between them.
+          if (i > 0 && glm::dot(previous, pose.rotation) < 0)
+          {
+            pose.rotation = -pose.rotation;
+          }
+
+          previous = pose.rotation;
+
+          const auto time = positions[i] * duration;
+          auto rotation = to_gltf_rotation(pose.rotation);
+
+          translations.times.emplace_back(time);
+          translations.values.insert(translations.values.end(), { pose.translation.x, pose.translation.y, pose.translation.z });
+          rotations.times.emplace_back(time);
+          rotations.values.insert(rotations.values.end(), rotation.begin(), rotation.end());
+          scales.times.emplace_back(time);
+          scales.values.insert(scales.values.end(), { pose.scale.x, pose.scale.y, pose.scale.z });
+        }
+
+        results.emplace_back(std::move(translations));
+        results.emplace_back(std::move(rotations));
+        results.emplace_back(std::move(scales));
+      }
+
+      return results;
+    }
+
+    void add_darkstar_shape(gltf::glb_writer& writer, const darkstar::dts_renderable_shape& shape)
+    {
+      const auto& hierarchy = shape.get_hierarchy();
+      const auto& animation = shape.get_animation();
+      const auto first_node = writer.get_node_count();
+
+      std::visit([&](const auto& local_shape) {
+        const auto default_pose = animation.get_default_pose();
+
+        for (auto i = 0u; i < local_shape.nodes.size(); ++i)
+        {
+          const auto& pose = default_pose[i];
+
+          writer.add_node(gltf::node{
+            local_shape.names[local_shape.nodes[i].name_index].data(),
+            std::nullopt,
+            {},
+            { pose.translation.x, pose.translation.y, pose.translation.z },
+            to_gltf_rotation(pose.rotation),
+            { pose.scale.x, pose.scale.y, pose.scale.z } });
+        }
+
+        for (auto i = 0u; i < hierarchy.size(); ++i)
+        {
+          for (auto child_index : hierarchy.get_children(std::int32_t(i)))
+          {
+            writer.get_node(first_node + i).children.emplace_back(first_node + std::size_t(child_index));
+          }
+        }
+
+        // A node can only have one mesh, so each object gets a node of its own under the node it belongs to.
+        for (auto i = 0u; i < hierarchy.size(); ++i)
+        {
+          for (auto object_index : hierarchy.get_objects(std::int32_t(i)))
+          {
+            auto batches = shape.get_object_batches(object_index);
+
+            auto has_triangles = std::any_of(batches.begin(), batches.end(), [](const auto& batch) { return batch.get_index_count() > 0; });
+
+            if (!has_triangles)
+            {
+              continue;
+            }
+
+            std::string object_name = local_shape.names[local_shape.objects[object_index].name_index].data();
+            auto mesh_index = writer.add_mesh(object_name, std::move(batches));
+            auto object_node = writer.add_node(gltf::node{ std::move(object_name), mesh_index });
+            writer.get_node(first_node + i).children.emplace_back(object_node);
+          }
+        }
+
+        for (const auto& detail : local_shape.details)
+        {
+          if (detail.root_node_index >= 0 && std::size_t(detail.root_node_index) < local_shape.nodes.size())
+          {
+            writer.add_scene(local_shape.names[local_shape.nodes[detail.root_node_index].name_index].data(), { first_node + std::size_t(detail.root_node_index) });
+          }
+        }
+      },
+        shape.get_shape());
+
+      auto sequences = shape.get_sequences({});
+
+      for (auto i = 0u; i < animation.get_sequence_count(); ++i)
+      {
+        auto name = i < sequences.size() ? sequences[i].name : "sequence " + std::to_string(i);
+        writer.add_animation(std::move(name), get_animation_channels(animation, i, first_node));
+      }
+    }
+
+    void add_other_shape(gltf::glb_writer& writer, const renderable_shape& shape)
+    {
+      auto detail_levels = shape.get_detail_levels();
+
+      for (auto i = 0u; i < detail_levels.size(); ++i)
+      {
+        std::vector<std::size_t> details{ i };
+        auto batches = shape.get_mesh_batches(details, shape.get_sequences(details));
+
+        auto root_node = writer.add_node(gltf::node{ detail_levels[i] });
+
+        // Batches of one object are next to each other, one per material.
+        for (auto first = batches.begin(); first != batches.end();)
+        {
+          auto last = std::find_if(first, batches.end(), [&](const auto& batch) {
+            return batch.node_name != first->node_name || batch.object_name != first->object_name;
+          });
+
+          std::vector<mesh_batch> object_batches(std::make_move_iterator(first), std::make_move_iterator(last));
+          std::string object_name = object_batches.front().object_name;
+          first = last;
+
+          auto has_triangles = std::any_of(object_batches.begin(), object_batches.end(), [](const auto& batch) { return batch.get_index_count() > 0; });
+
+          if (has_triangles)
+          {
+            auto mesh_index = writer.add_mesh(object_name, std::move(object_batches));
+            auto object_node = writer.add_node(gltf::node{ std::move(object_name), mesh_index });
+            writer.get_node(root_node).children.emplace_back(object_node);
+          }
+        }
+
+        writer.add_scene(detail_levels[i], { root_node });
+      }
+    }
+  }// namespace
+
+  void add_shape(gltf::glb_writer& writer, const renderable_shape& shape, const texture_resolver& resolve_texture)
+  {
+    add_materials(writer, shape, resolve_texture);
+
+    if (auto* darkstar_shape = dynamic_cast<const darkstar::dts_renderable_shape*>(&shape); darkstar_shape)
+    {
+      add_darkstar_shape(writer, *darkstar_shape);
+    }
+    else
+    {
+      add_other_shape(writer, shape);
+    }
+  }
+}// namespace siege::content::dts
@@ -1,91 +1,16 @@
-// MDL - Quake 1 model data
-// MD2 version 8 - Quake 2 model data
-// MD2 version 15 - Anachronox model data
-// MDX - Kingpin model data
-// DKM - Daikatana model data
-
-#include <array>
-#include <any>
+#include <algorithm>
+#include <execution>
 #include <siege/platform/shared.hpp>
 #include <siege/platform/stream.hpp>
-#include <siege/platform/endian_arithmetic.hpp>
+#include <siege/content/dts/mdl.hpp>
 
 namespace siege::content::mdl
 {
-  namespace endian = siege::platform;
-
   constexpr auto mdl_tag = platform::to_tag<4>({ 'I', 'D', 'P', 'O' });
   constexpr auto md2_tag = platform::to_tag<4>({ 'I', 'D', 'P', '2' });
   constexpr auto mdx_tag = platform::to_tag<4>({ 'I', 'D', 'P', 'X' });
   constexpr auto dkm_tag = platform::to_tag<4>({ 'D', 'K', 'M', 'D' });
 
-  struct mdl_header
-  {
-    std::array<std::byte, 4> tag;
-    endian::little_uint32_t version;
-    std::array<float, 3> scale;
-    std::array<float, 3> translation;
-    float other;
-    std::array<endian::little_uint32_t, 3> padding;
-    endian::little_uint32_t texture_count;
-    endian::little_uint32_t texture_width;
-    endian::little_uint32_t texture_height;
-    endian::little_uint32_t vertex_and_uv_count;
-    endian::little_uint32_t face_count;
-    endian::little_uint32_t frame_count;
-    endian::little_uint32_t padding2;
-    endian::little_uint32_t padding3;
-    float other2;
-  };
-
-  struct mdl_uv_coordinate
-  {
-    endian::little_uint32_t on_seam;
-    endian::little_uint32_t u;
-    endian::little_uint32_t v;
-  };
-
-  struct mdl_face
-  {
-    endian::little_uint32_t is_front_face;
-    std::array<endian::little_uint32_t, 3> vertex_indices;
-  };
-
-  struct mdl_vertex
-  {
-    std::uint8_t x;
-    std::uint8_t y;
-    std::uint8_t z;
-    std::uint8_t normal;
-  };
-
-  struct mdl_frame
-  {
-    mdl_vertex bounding_min;
-    mdl_vertex bounding_max;
-    std::array<char, 16> name;
-    std::vector<mdl_vertex> vertices;
-  };
-
-  struct animated_texture
-  {
-    float frame_duration;
-    std::vector<std::vector<std::byte>> frame_data;
-  };
-
-  using texture_data = std::variant<std::vector<std::byte>, animated_texture>;
-
-  struct mdl_shape
-  {
-    endian::little_uint32_t texture_width;
-    endian::little_uint32_t texture_height;
-    std::vector<texture_data> textures;
-    std::vector<mdl_uv_coordinate> uv_coordinates;
-    std::vector<mdl_face> faces;
-    std::vector<mdl_frame> frames;
-  };
-
-
   bool is_mdl(std::istream& stream)
   {
     platform::istream_pos_resetter resetter(stream);
@@ -94,18 +19,22 @@ namespace siege::content::mdl
     return tag == mdl_tag;
   }
 
-  std::any load_mdl(std::istream& stream)
+  std::optional<mdl_shape> load_mdl(std::istream& stream)
   {
     mdl_shape shape;
     platform::istream_pos_resetter resetter(stream);
     mdl_header header;
     stream.read((char*)&header, sizeof(header));
 
-    if (header.tag != mdl_tag && header.version != 6)
+    if (!stream || header.tag != mdl_tag || header.version != 6)
     {
-      return std::any{};
+      return std::nullopt;
     }
 
+    shape.scale = header.scale;
+    shape.translation = header.translation;
+    shape.texture_width = header.texture_width;
+    shape.texture_height = header.texture_height;
     shape.textures.reserve(header.texture_count);
     shape.frames.reserve(header.frame_count);
     shape.uv_coordinates.resize(header.vertex_and_uv_count);
@@ -147,6 +76,12 @@ namespace siege::content::mdl
     stream.read((char*)shape.uv_coordinates.data(), shape.uv_coordinates.size() * sizeof(mdl_uv_coordinate));
     stream.read((char*)shape.faces.data(), shape.faces.size() * sizeof(mdl_face));
 
+    auto read_frame = [&](mdl_frame& frame) {
+      stream.read((char*)&frame, sizeof(frame) - sizeof(frame.vertices));
+      frame.vertices.resize(header.vertex_and_uv_count);
+      stream.read((char*)frame.vertices.data(), frame.vertices.size() * sizeof(mdl_vertex));
+    };
+
     for (auto i = 0u; i < header.frame_count; ++i)
     {
       endian::little_uint32_t type{};
@@ -154,74 +89,29 @@ namespace siege::content::mdl
 
       if (type == 0)
       {
-        auto& frame = shape.frames.emplace_back();
+        read_frame(shape.frames.emplace_back());
+        continue;
+      }
 
-        stream.read((char*)&frame, sizeof(frame) - sizeof(frame.vertices));
+      // A group has its own bounds and a time for each frame, followed by the frames themselves.
+      endian::little_uint32_t count{};
+      stream.read((char*)&count, sizeof(count));
+      stream.seekg(sizeof(mdl_vertex) * 2 + sizeof(float) * count, std::ios::cur);
 
-        frame.vertices.resize(header.vertex_and_uv_count);
-        stream.read((char*)frame.vertices.data(), frame.vertices.size() * sizeof(mdl_vertex));
-      }
-      else
+      for (auto f = 0u; f < count && stream; ++f)
       {
-        DebugBreak();
+        read_frame(shape.frames.emplace_back());
       }
     }
 
+    if (!stream)
+    {
+      return std::nullopt;
+    }
+
     return shape;
   }
 
-  struct md2_header
-  {
-    std::array<std::byte, 4> tag;
-    endian::little_uint32_t version;
-    endian::little_uint32_t texture_width;
-    endian::little_uint32_t texture_height;
-    endian::little_uint32_t frame_byte_count;
-    endian::little_uint32_t texture_count;
-    endian::little_uint32_t vertex_per_frame_count;
-    endian::little_uint32_t uv_count;
-    endian::little_uint32_t face_count;
-    endian::little_uint32_t unknown_count;
-    endian::little_uint32_t frame_count;
-    endian::little_uint32_t texture_offset;
-    endian::little_uint32_t uv_offset;
-    endian::little_uint32_t face_offset;
-    endian::little_uint32_t frame_offset;
-    endian::little_uint32_t unknown_offset;
-    endian::little_uint32_t eof_offset;
-  };
-
-  struct md2_uv_coordinate
-  {
-    endian::little_uint16_t u;
-    endian::little_uint16_t v;
-  };
-
-  struct md2_face
-  {
-    std::array<endian::little_uint16_t, 3> vertex_indices;
-    std::array<endian::little_uint16_t, 3> uv_indices;
-  };
-
-  struct md2_frame
-  {
-    std::array<float, 3> scale;
-    std::array<float, 3> translation;
-    std::array<char, 16> name;
-    std::vector<mdl_vertex> vertices;
-  };
-
-  struct md2_shape
-  {
-    endian::little_uint32_t texture_width;
-    endian::little_uint32_t texture_height;
-    std::vector<std::string> texture_filenames;
-    std::vector<md2_face> faces;
-    std::vector<md2_uv_coordinate> uv_coordinates;
-    std::vector<md2_frame> frames;
-  };
-
-
   bool is_md2(std::istream& stream)
   {
     platform::istream_pos_resetter resetter(stream);
@@ -230,7 +120,7 @@ namespace siege::content::mdl
     return tag == md2_tag;
   }
 
-  std::any load_md2(std::istream& stream)
+  std::optional<md2_shape> load_md2(std::istream& stream)
   {
     platform::istream_pos_resetter resetter(stream);
 
@@ -241,9 +131,9 @@ namespace siege::content::mdl
     md2_header header;
     stream.read((char*)&header, sizeof(header));
 
-    if (header.tag != md2_tag && header.version != 8)
+    if (!stream || header.tag != md2_tag || header.version != 8)
     {
-      return std::any{};
+      return std::nullopt;
     }
 
     shape.texture_width = header.texture_width;
@@ -254,7 +144,7 @@ namespace siege::content::mdl
 
     if (header.vertex_per_frame_count * sizeof(mdl_vertex) != extra_data_size)
     {
-      return std::any{};
+      return std::nullopt;
     }
 
     shape.texture_filenames.reserve(header.texture_count);
@@ -279,67 +169,23 @@ namespace siege::content::mdl
 
     stream.seekg(start + header.frame_offset, std::ios::beg);
 
-    for (auto i = 0u; i < header.frame_count; ++i)
+    for (auto i = 0u; i < header.frame_count && stream; ++i)
     {
       auto& frame = shape.frames.emplace_back();
       stream.read((char*)&frame, sizeof(frame) - sizeof(std::vector<mdl_vertex>));
 
-      frame.vertices.reserve(header.vertex_per_frame_count);
-      for (auto v = 0u; v < header.vertex_per_frame_count; ++v)
-      {
-        auto& vertex = frame.vertices.emplace_back();
-        stream.read((char*)&vertex, sizeof(vertex));
-      }
+      frame.vertices.resize(header.vertex_per_frame_count);
+      stream.read((char*)frame.vertices.data(), frame.vertices.size() * sizeof(mdl_vertex));
+    }
+
+    if (!stream)
+    {
+      return std::nullopt;
     }
 
     return shape;
   }
 
-  struct mdx_header
-  {
-    std::array<std::byte, 4> tag;
-    endian::little_uint32_t version;
-    endian::little_uint32_t texture_width;
-    endian::little_uint32_t texture_height;
-    endian::little_uint32_t frame_byte_count;
-    endian::little_uint32_t texture_count;
-    endian::little_uint32_t vertex_per_frame_count;
-    endian::little_uint32_t face_count;
-    endian::little_uint32_t unknown_count;
-    endian::little_uint32_t frame_count;
-    endian::little_uint32_t padding;
-    endian::little_uint32_t padding2;
-    endian::little_uint32_t sub_object_count;
-    endian::little_uint32_t texture_offset;
-    endian::little_uint32_t face_offset;
-    endian::little_uint32_t frame_offset;
-    endian::little_uint32_t unknown_offset;
-    endian::little_uint32_t vertex_group_offset;
-    endian::little_uint32_t padding3;
-    endian::little_uint32_t padding4;
-    endian::little_uint32_t frame_bounding_box_offset;
-  };
-
-  struct mdx_frame : md2_frame
-  {
-    std::array<float, 6> bounding_box;
-  };
-
-  struct mdx_sub_object_grouping
-  {
-    std::vector<endian::little_uint32_t> vertex_groupings;
-  };
-
-  struct mdx_shape
-  {
-    endian::little_uint32_t texture_width;
-    endian::little_uint32_t texture_height;
-    std::vector<std::string> texture_filenames;
-    std::vector<md2_face> faces;
-    std::vector<mdx_frame> frames;
-    std::vector<mdx_sub_object_grouping> sub_object_groupings;
-  };
-
   bool is_mdx(std::istream& stream)
   {
     platform::istream_pos_resetter resetter(stream);
@@ -348,7 +194,7 @@ namespace siege::content::mdl
     return tag == mdx_tag;
   }
 
-  std::any load_mdx(std::istream& stream)
+  std::optional<mdx_shape> load_mdx(std::istream& stream)
   {
     platform::istream_pos_resetter resetter(stream);
 
@@ -359,9 +205,9 @@ namespace siege::content::mdl
     mdx_header header;
     stream.read((char*)&header, sizeof(header));
 
-    if (header.tag != mdx_tag && header.version != 4)
+    if (!stream || header.tag != mdx_tag || header.version != 4)
     {
-      return std::any{};
+      return std::nullopt;
     }
 
     shape.texture_width = header.texture_width;
@@ -372,7 +218,7 @@ namespace siege::content::mdl
 
     if (header.vertex_per_frame_count * sizeof(mdl_vertex) != extra_data_size)
     {
-      return std::any{};
+      return std::nullopt;
     }
 
     shape.texture_filenames.reserve(header.texture_count);
@@ -393,22 +239,18 @@ namespace siege::content::mdl
 
     stream.seekg(start + header.frame_offset, std::ios::beg);
 
-    for (auto i = 0u; i < header.frame_count; ++i)
+    for (auto i = 0u; i < header.frame_count && stream; ++i)
     {
       auto& frame = shape.frames.emplace_back();
       stream.read((char*)&frame, sizeof(frame) - sizeof(frame.vertices) - sizeof(frame.bounding_box));
 
-      frame.vertices.reserve(header.vertex_per_frame_count);
-      for (auto v = 0u; v < header.vertex_per_frame_count; ++v)
-      {
-        auto& vertex = frame.vertices.emplace_back();
-        stream.read((char*)&vertex, sizeof(vertex));
-      }
+      frame.vertices.resize(header.vertex_per_frame_count);
+      stream.read((char*)frame.vertices.data(), frame.vertices.size() * sizeof(mdl_vertex));
     }
 
     stream.seekg(start + header.frame_bounding_box_offset, std::ios::beg);
 
-    for (auto i = 0u; i < header.frame_count; ++i)
+    for (auto i = 0u; i < shape.frames.size() && stream; ++i)
     {
       auto& frame = shape.frames[i];
       stream.read((char*)&frame.bounding_box, sizeof(frame.bounding_box));
@@ -417,48 +259,121 @@ namespace siege::content::mdl
     stream.seekg(start + header.vertex_group_offset, std::ios::beg);
 
     shape.sub_object_groupings.reserve(header.sub_object_count);
-    for (auto g = 0u; g < header.sub_object_count; ++g)
+    for (auto g = 0u; g < header.sub_object_count && stream; ++g)
     {
       auto& grouping = shape.sub_object_groupings.emplace_back();
       grouping.vertex_groupings.resize(header.vertex_per_frame_count);
       stream.read((char*)grouping.vertex_groupings.data(), grouping.vertex_groupings.size() * sizeof(std::uint32_t));
     }
 
+    if (!stream)
+    {
+      return std::nullopt;
+    }
+
     return shape;
   }
 
+  bool is_dkm(std::istream& stream)
+  {
+    platform::istream_pos_resetter resetter(stream);
+    std::array<std::byte, 4> tag;
+    stream.read((char*)&tag, sizeof(tag));
+    return tag == dkm_tag;
+  }
+
+  std::optional<dkm_shape> load_dkm(std::istream& stream)
+  {
+    platform::istream_pos_resetter resetter(stream);
+
+    auto start = (std::size_t)resetter.position;
+
+    dkm_shape shape;
+
+    dkm_header header;
+    stream.read((char*)&header, sizeof(header));
+
+    if (header.tag != dkm_tag)
+    {
+      return std::nullopt;
+    }
+
+    static_assert(sizeof(dkm_packed_vertex) == 5);
+
+    // Frames start with the same scale, translation and name as MD2 frames, and the size of the vertices says which kind they are.
+    constexpr auto frame_header_size = sizeof(md2_frame) - sizeof(std::vector<mdl_vertex>);
+    const auto vertex_count = std::size_t(header.vertex_per_frame_count);
+    const auto vertex_data_size = std::size_t(header.frame_byte_count) - frame_header_size;
+
+    const bool is_packed = vertex_data_size == vertex_count * sizeof(dkm_packed_vertex);
+
+    if (!is_packed && vertex_data_size != vertex_count * sizeof(mdl_vertex))
+    {
+      return std::nullopt;
+    }
+
+    shape.texture_filenames.reserve(header.texture_count);
+    stream.seekg(start + header.texture_offset, std::ios::beg);
+    std::array<char, 64> temp;
+    for (auto i = 0u; i < header.texture_count; ++i)
+    {
+      stream.read(temp.data(), temp.size());
+      temp[63] = 0;
+      shape.texture_filenames.emplace_back(temp.data());
+    }
+
+    shape.faces.resize(header.face_count);
+    stream.seekg(start + header.face_offset, std::ios::beg);
+    stream.read((char*)shape.faces.data(), shape.faces.size() * sizeof(dkm_face));
+
+    shape.frames.reserve(header.frame_count);
 
-  struct dkm_face
+    stream.seekg(start + header.frame_offset, std::ios::beg);
+
+    for (auto i = 0u; i < header.frame_count && stream; ++i)
+    {
+      auto& frame = shape.frames.emplace_back();
+      stream.read((char*)&frame, frame_header_size);
+
+      auto read_vertices = [&](auto vertices) {
+        vertices.resize(vertex_count);
+        stream.read((char*)vertices.data(), vertices.size() * sizeof(typename decltype(vertices)::value_type));
+        frame.vertices = std::move(vertices);
+      };
+
+      if (is_packed)
+      {
+        read_vertices(std::vector<dkm_packed_vertex>{});
+      }
+      else
+      {
+        read_vertices(std::vector<mdl_vertex>{});
+      }
+    }
+
+    if (!stream)
+    {
+      return std::nullopt;
+    }
+
+    return shape;
+  }
+
+  void decode_vertices(std::span<const mdl_vertex> vertices, const std::array<float, 3>& scale, const std::array<float, 3>& translation, std::span<vector3f> results)
   {
-    endian::little_uint32_t padding;
-    std::array<endian::little_uint16_t, 3> vertex_indices;
-    std::array<endian::little_uint16_t, 3> uv_indices;
-  };
+    // Frames of a damaged file can have more vertices than the results have room for.
+    vertices = vertices.first(std::min(vertices.size(), results.size()));
+    std::transform(std::execution::unseq, vertices.begin(), vertices.end(), results.begin(), [scale, translation](const mdl_vertex& vertex) {
+      return vector3f{ vertex.x * scale[0] + translation[0], vertex.y * scale[1] + translation[1], vertex.z * scale[2] + translation[2] };
+    });
+  }
 
-  struct dkm_header
+  void decode_vertices(std::span<const dkm_packed_vertex> vertices, const std::array<float, 3>& scale, const std::array<float, 3>& translation, std::span<vector3f> results)
   {
-    std::array<std::byte, 4> tag;
-    endian::little_uint32_t version;
-    endian::little_uint32_t texture_width;
-    endian::little_uint32_t texture_height;
-    endian::little_uint32_t unknown;
-    endian::little_uint32_t frame_byte_count;
-    endian::little_uint32_t texture_count;
-    endian::little_uint32_t vertex_per_frame_count;
-    endian::little_uint32_t uv_count;
-    endian::little_uint32_t face_count;
-    endian::little_uint32_t unknown_count;
-    endian::little_uint32_t frame_count;
-    endian::little_uint32_t unknown_count2;
-    endian::little_uint32_t texture_offset;
-    endian::little_uint32_t uv_offset;
-    endian::little_uint32_t face_offset;
-    endian::little_uint32_t frame_offset;
-    endian::little_uint32_t unknown_offset;
-    endian::little_uint32_t eof_offset;
-    endian::little_uint32_t unknown_count3;
-    endian::little_uint32_t unknown_offset3;
-  };
-
-
-}// namespace siege::content::mdl
\ No newline at end of file
+    vertices = vertices.first(std::min(vertices.size(), results.size()));
+    std::transform(std::execution::unseq, vertices.begin(), vertices.end(), results.begin(), [scale, translation](const dkm_packed_vertex& vertex) {
+      const std::uint32_t packed = vertex.position;
+      return vector3f{ float(packed >> 21) * scale[0] + translation[0], float((packed >> 11) & 0x3ff) * scale[1] + translation[1], float(packed & 0x7ff) * scale[2] + translation[2] };
+    });
+  }
+}// namespace siege::content::mdl
@@ -0,0 +1,179 @@
+#include <cstring>
+#include <spanstream>
+#include <catch2/catch_test_macros.hpp>
+#include <siege/content/dts/mdl_renderable_shape.hpp>
+#include "test_helpers.hpp"
+
+using namespace siege::content;
+using namespace siege::content::test_helpers;
+
+namespace
+{
+  mdl::md2_frame make_frame(const char* name, float offset)
+  {
+    mdl::md2_frame frame{};
+    frame.scale = { 0.5f, 1, 2 };
+    frame.translation = { offset, 0, 0 };
+    std::strncpy(frame.name.data(), name, frame.name.size());
+    frame.vertices = { { 0, 0, 0, 0 }, { 2, 0, 0, 0 }, { 0, 3, 4, 0 } };
+    return frame;
+  }
+
+  // One triangle with three frames, where each frame moves along x.
+  std::string make_md2()
+  {
+    std::vector<mdl::md2_frame> frames{ make_frame("run1", 0), make_frame("run2", 10), make_frame("stand1", 20) };
+    std::vector<mdl::md2_uv_coordinate> uv_coordinates{ { 0, 0 }, { 32, 0 }, { 0, 16 } };
+    mdl::md2_face face{ { 0, 1, 2 }, { 0, 1, 2 } };
+
+    constexpr auto frame_header_size = sizeof(mdl::md2_frame) - sizeof(std::vector<mdl::mdl_vertex>);
+
+    mdl::md2_header header{};
+    header.tag = siege::platform::to_tag<4>({ 'I', 'D', 'P', '2' });
+    header.version = 8;
+    header.texture_width = 32;
+    header.texture_height = 16;
+    header.frame_byte_count = std::uint32_t(frame_header_size + 3 * sizeof(mdl::mdl_vertex));
+    header.texture_count = 1;
+    header.vertex_per_frame_count = 3;
+    header.uv_count = std::uint32_t(uv_coordinates.size());
+    header.face_count = 1;
+    header.frame_count = std::uint32_t(frames.size());
+    header.texture_offset = sizeof(header);
+    header.uv_offset = header.texture_offset + 64;
+    header.face_offset = header.uv_offset + std::uint32_t(uv_coordinates.size() * sizeof(mdl::md2_uv_coordinate));
+    header.frame_offset = header.face_offset + sizeof(face);
+
+    std::string data;
+    append(data, header);
+
+    std::array<char, 64> skin{ "models/test/skin.pcx" };
+    append(data, skin);
+
+    for (const auto& uv : uv_coordinates)
+    {
+      append(data, uv);
+    }
+
+    append(data, face);
+
+    for (const auto& frame : frames)
+    {
+      data.append(reinterpret_cast<const char*>(&frame), frame_header_size);
+      data.append(reinterpret_cast<const char*>(frame.vertices.data()), frame.vertices.size() * sizeof(mdl::mdl_vertex));
+    }
+
+    return data;
+  }
+}// namespace
+
+TEST_CASE("MD2 frames are decoded with their own scale and translation", "[mdl]")
+{
+  auto data = make_md2();
+  std::ispanstream stream{ std::span<const char>(data) };
+
+  REQUIRE(mdl::is_md2(stream));
+  REQUIRE(!mdl::is_mdl(stream));
+
+  auto shape = mdl::load_md2(stream);
+  REQUIRE(shape.has_value());
+  REQUIRE(shape->frames.size() == 3);
+  REQUIRE(shape->texture_filenames.front() == "models/test/skin.pcx");
+
+  auto model = mdl::to_keyframe_model(*shape);
+  REQUIRE(model.vertex_count == 3);
+  REQUIRE(model.faces.size() == 1);
+
+  auto last = model.get_frame(2);
+  REQUIRE(is_near(last[1].x, 21));
+  REQUIRE(is_near(last[2].y, 3));
+  REQUIRE(is_near(last[2].z, 8));
+
+  REQUIRE(is_near(model.texture_vertices[1].x, 1));
+  REQUIRE(is_near(model.texture_vertices[2].y, 1));
+}
+
+TEST_CASE("MD2 files with another version or a missing frame are not loaded", "[mdl]")
+{
+  auto data = make_md2();
+
+  auto other_version = data;
+  other_version[4] = 9;
+  std::ispanstream version_stream{ std::span<const char>(other_version) };
+  REQUIRE(!mdl::load_md2(version_stream).has_value());
+
+  auto truncated = data.substr(0, data.size() - sizeof(mdl::mdl_vertex));
+  std::ispanstream truncated_stream{ std::span<const char>(truncated) };
+  REQUIRE(!mdl::load_md2(truncated_stream).has_value());
+}
+
+TEST_CASE("MD2 frames become sequences which can be played back", "[mdl]")
+{
+  auto data = make_md2();
+  std::ispanstream stream{ std::span<const char>(data) };
+
+  mdl::mdl_renderable_shape shape(mdl::to_keyframe_model(*mdl::load_md2(stream)));
+
+  auto sequences = shape.get_sequences({ 0 });
+  REQUIRE(sequences.size() == 2);
+  REQUIRE(sequences[0].name == "run");
+  REQUIRE(sequences[0].enabled);
+  REQUIRE(sequences[0].sub_sequences[0].num_key_frames == 2);
+  REQUIRE(sequences[1].name == "stand");
+  REQUIRE(!sequences[1].enabled);
+
+  std::vector<vector3f> positions(3);
+
+  SECTION("Positions between two frames are interpolated")
+  {
+    sequences[0].sub_sequences[0].position = 0.25f;
+    shape.sample(sequences, positions);
+    REQUIRE(is_near(positions[0].x, 5));
+
+    sequences[0].sub_sequences[0].position = 0.75f;
+    shape.sample(sequences, positions);
+    REQUIRE(is_near(positions[0].x, 5));
+  }
+
+  SECTION("Only the enabled sequence is played")
+  {
+    sequences[0].enabled = false;
+    sequences[1].enabled = true;
+    sequences[1].sub_sequences[0].enabled = true;
+    shape.sample(sequences, positions);
+    REQUIRE(is_near(positions[0].x, 20));
+  }
+
+  SECTION("Mesh batches use the skin as their material")
+  {
+    auto batches = shape.get_mesh_batches({ 0 }, sequences);
+    REQUIRE(batches.size() == 1);
+    REQUIRE(batches[0].material_index == 0);
+    REQUIRE(batches[0].vertices.size() == 3);
+    REQUIRE(batches[0].get_index_count() == 3);
+    REQUIRE(shape.get_materials().front().filename == "models/test/skin.pcx");
+  }
+}
+
+TEST_CASE("Packed DKM vertices use 11, 10 and 11 bits", "[mdl]")
+{
+  std::vector<mdl::dkm_packed_vertex> vertices{ { (2047u << 21) | (1023u << 11) | 5u, 0 } };
+  std::vector<vector3f> results(1);
+
+  mdl::decode_vertices(vertices, { 1, 2, 0.5f }, { -1, 0, 1 }, results);
+
+  REQUIRE(is_near(results[0].x, 2046));
+  REQUIRE(is_near(results[0].y, 2046));
+  REQUIRE(is_near(results[0].z, 3.5f));
+}
+
+TEST_CASE("When there is less room than vertices, only the vertices which fit are decoded", "[mdl]")
+{
+  std::vector<mdl::mdl_vertex> vertices{ { 1, 2, 3, 0 }, { 4, 5, 6, 0 }, { 7, 8, 9, 0 } };
+  std::vector<vector3f> results(2);
+
+  mdl::decode_vertices(vertices, { 1, 1, 1 }, { 0, 0, 0 }, results);
+
+  REQUIRE(is_near(results[0].x, 1));
+  REQUIRE(is_near(results[1].z, 6));
+}
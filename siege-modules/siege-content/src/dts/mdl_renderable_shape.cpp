@@ -0,0 +1,336 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <execution>
+#include <numeric>
+#include <siege/content/dts/mdl_renderable_shape.hpp>
+
+namespace siege::content::mdl
+{
+  constexpr std::string_view root_node_name = "root";
+  constexpr std::string_view model_object_name = "model";
+
+  static std::string get_name(const std::array<char, 16>& name)
+  {
+    return std::string(name.data(), strnlen(name.data(), name.size()));
+  }
+
+  // Frames do not depend on each other, so each one is decoded on its own thread.
+  template<typename Frame, typename Decode>
+  static void add_frames(keyframe_model& model, std::size_t vertex_count, const std::vector<Frame>& frames, Decode&& decode)
+  {
+    model.vertex_count = vertex_count;
+    model.positions.resize(vertex_count * frames.size());
+    model.frame_names.reserve(frames.size());
+
+    for (const auto& frame : frames)
+    {
+      model.frame_names.emplace_back(get_name(frame.name));
+    }
+
+    std::vector<std::size_t> frame_indexes(frames.size());
+    std::iota(frame_indexes.begin(), frame_indexes.end(), 0);
+
+    std::for_each(std::execution::par, frame_indexes.begin(), frame_indexes.end(), [&](std::size_t frame_index) {
+      decode(frames[frame_index], std::span<vector3f>(model.positions).subspan(frame_index * vertex_count, vertex_count));
+    });
+  }
+
+  // Faces which point outside of the vertices of the model are left out.
+  template<typename Face>
+  void add_faces(keyframe_model& model, const std::vector<Face>& faces, std::uint32_t texture_vertex_count)
+  {
+    model.faces.reserve(faces.size());
+
+    for (const auto& face : faces)
+    {
+      std::array<keyframe_model::corner, 3> corners;
+      bool is_valid = true;
+
+      for (auto i = 0u; i < corners.size(); ++i)
+      {
+        std::uint32_t texture_index = texture_vertex_count == 1 ? 0u : std::uint32_t(face.uv_indices[i]);
+        corners[i] = keyframe_model::corner{ face.vertex_indices[i], texture_index };
+        is_valid = is_valid && corners[i].vertex_index < model.vertex_count && corners[i].texture_index < texture_vertex_count;
+      }
+
+      if (is_valid)
+      {
+        model.faces.emplace_back(corners);
+      }
+    }
+  }
+
+  keyframe_model to_keyframe_model(const mdl_shape& shape)
+  {
+    keyframe_model result;
+    result.skins.resize(shape.textures.size());
+
+    add_frames(result, shape.uv_coordinates.size(), shape.frames, [&](const mdl_frame& frame, std::span<vector3f> positions) {
+      decode_vertices(frame.vertices, shape.scale, shape.translation, positions);
+    });
+
+    // Vertices on a seam use the other half of the skin when they are part of a back face, so each one has two texture vertices.
+    const auto width = float(std::max<std::uint32_t>(shape.texture_width, 1));
+    const auto height = float(std::max<std::uint32_t>(shape.texture_height, 1));
+    const auto count = std::uint32_t(shape.uv_coordinates.size());
+
+    result.texture_vertices.resize(count * 2);
+
+    for (auto i = 0u; i < count; ++i)
+    {
+      const auto& uv = shape.uv_coordinates[i];
+      result.texture_vertices[i] = texture_vertex{ (std::uint32_t(uv.u) + 0.5f) / width, (std::uint32_t(uv.v) + 0.5f) / height };
+      result.texture_vertices[i + count] = texture_vertex{ (std::uint32_t(uv.u) + width / 2 + 0.5f) / width, result.texture_vertices[i].y };
+    }
+
+    result.faces.reserve(shape.faces.size());
+
+    for (const auto& face : shape.faces)
+    {
+      std::array<keyframe_model::corner, 3> corners;
+      bool is_valid = true;
+
+      for (auto i = 0u; i < corners.size(); ++i)
+      {
+        std::uint32_t vertex_index = face.vertex_indices[i];
+        is_valid = is_valid && vertex_index < count;
+
+        auto is_back_seam = is_valid && face.is_front_face == 0 && shape.uv_coordinates[vertex_index].on_seam != 0;
+        corners[i] = keyframe_model::corner{ vertex_index, is_back_seam ? vertex_index + count : vertex_index };
+      }
+
+      if (is_valid)
+      {
+        result.faces.emplace_back(corners);
+      }
+    }
+
+    return result;
+  }
+
+  keyframe_model to_keyframe_model(const md2_shape& shape)
+  {
+    keyframe_model result;
+    result.skins = shape.texture_filenames;
+
+    add_frames(result, shape.frames.empty() ? 0 : shape.frames.front().vertices.size(), shape.frames, [](const md2_frame& frame, std::span<vector3f> positions) {
+      decode_vertices(frame.vertices, frame.scale, frame.translation, positions);
+    });
+
+    const auto width = float(std::max<std::uint32_t>(shape.texture_width, 1));
+    const auto height = float(std::max<std::uint32_t>(shape.texture_height, 1));
+
+    result.texture_vertices.reserve(shape.uv_coordinates.size());
+
+    for (const auto& uv : shape.uv_coordinates)
+    {
+      result.texture_vertices.emplace_back(texture_vertex{ std::uint16_t(uv.u) / width, std::uint16_t(uv.v) / height });
+    }
+
+    add_faces(result, shape.faces, std::uint32_t(result.texture_vertices.size()));
+
+    return result;
+  }
+
+  // Kingpin keeps its texture coordinates in the GL commands, which are not read yet, so every corner uses the same one.
+  keyframe_model to_keyframe_model(const mdx_shape& shape)
+  {
+    keyframe_model result;
+    result.skins = shape.texture_filenames;
+    result.texture_vertices.emplace_back(texture_vertex{ 0, 0 });
+
+    add_frames(result, shape.frames.empty() ? 0 : shape.frames.front().vertices.size(), shape.frames, [](const mdx_frame& frame, std::span<vector3f> positions) {
+      decode_vertices(frame.vertices, frame.scale, frame.translation, positions);
+    });
+
+    add_faces(result, shape.faces, 1);
+
+    return result;
+  }
+
+  // The texture coordinates of Daikatana are not read yet either, because the header does not have the size of the skins.
+  keyframe_model to_keyframe_model(const dkm_shape& shape)
+  {
+    keyframe_model result;
+    result.skins = shape.texture_filenames;
+    result.texture_vertices.emplace_back(texture_vertex{ 0, 0 });
+
+    auto vertex_count = shape.frames.empty() ? 0 : std::visit([](const auto& vertices) { return vertices.size(); }, shape.frames.front().vertices);
+
+    add_frames(result, vertex_count, shape.frames, [](const dkm_frame& frame, std::span<vector3f> positions) {
+      std::visit([&](const auto& vertices) { decode_vertices(vertices, frame.scale, frame.translation, positions); }, frame.vertices);
+    });
+
+    add_faces(result, shape.faces, 1);
+
+    return result;
+  }
+
+  mdl_renderable_shape::mdl_renderable_shape(keyframe_model model)
+    : model(std::move(model))
+  {
+    for (auto i = 0u; i < this->model.frame_names.size(); ++i)
+    {
+      auto name = this->model.frame_names[i];
+      name.erase(name.find_last_not_of("0123456789") + 1);
+
+      if (ranges.empty() || ranges.back().name != name)
+      {
+        ranges.emplace_back(frame_range{ std::move(name), i, 0 });
+      }
+
+      ranges.back().frame_count++;
+    }
+  }
+
+  std::vector<sequence_info> mdl_renderable_shape::get_sequences(const std::vector<std::size_t>&) const
+  {
+    std::vector<sequence_info> results;
+    results.reserve(ranges.size());
+
+    for (auto i = 0u; i < ranges.size(); ++i)
+    {
+      const auto& range = ranges[i];
+      const auto index = std::int32_t(i);
+
+      sub_sequence_info sub_sequence{
+        .node_index = 0,
+        .node_name = std::string(root_node_name),
+        .frame_index = std::int32_t(range.first_frame),
+        .first_key_frame_index = std::int32_t(range.first_frame),
+        .num_key_frames = std::int32_t(range.frame_count),
+        .min_position = 0.0f,
+        .max_position = 1.0f,
+        .position = 0.0f,
+        .enabled = index == 0
+      };
+
+      results.emplace_back(sequence_info{ index, range.name, index == 0, { std::move(sub_sequence) } });
+    }
+
+    return results;
+  }
+
+  std::vector<std::string> mdl_renderable_shape::get_detail_levels() const
+  {
+    return { "default" };
+  }
+
+  std::vector<material> mdl_renderable_shape::get_materials() const
+  {
+    std::vector<material> results;
+    results.reserve(model.skins.size());
+
+    for (const auto& skin : model.skins)
+    {
+      results.emplace_back(material{ skin });
+    }
+
+    return results;
+  }
+
+  void mdl_renderable_shape::sample(const std::vector<sequence_info>& sequences, std::span<vector3f> results) const
+  {
+    if (model.frame_names.empty())
+    {
+      return;
+    }
+
+    std::uint32_t first_frame = 0;
+    std::uint32_t second_frame = 0;
+    float amount = 0;
+
+    for (const auto& sequence : sequences)
+    {
+      if (!sequence.enabled || sequence.index < 0 || std::size_t(sequence.index) >= ranges.size() || sequence.sub_sequences.empty() || !sequence.sub_sequences.front().enabled)
+      {
+        continue;
+      }
+
+      const auto& sub_sequence = sequence.sub_sequences.front();
+      const auto& range = ranges[sequence.index];
+
+      // The sequence loops, so the end of it goes from the last frame back to the first one.
+      const auto length = sub_sequence.max_position - sub_sequence.min_position;
+      auto position = length > 0 ? (sub_sequence.position - sub_sequence.min_position) / length : 0.0f;
+      position = (position - std::floor(position)) * float(range.frame_count);
+
+      const auto offset = std::min(std::uint32_t(position), range.frame_count - 1);
+      first_frame = range.first_frame + offset;
+      second_frame = range.first_frame + (offset + 1) % range.frame_count;
+      amount = position - float(offset);
+      break;
+    }
+
+    auto first = model.get_frame(first_frame);
+    auto second = model.get_frame(second_frame);
+
+    std::transform(std::execution::unseq, first.begin(), first.end(), second.begin(), results.begin(), [amount](const vector3f& a, const vector3f& b) {
+      return vector3f{ a.x + (b.x - a.x) * amount, a.y + (b.y - a.y) * amount, a.z + (b.z - a.z) * amount };
+    });
+  }
+
+  void mdl_renderable_shape::render_shape(shape_renderer& renderer, const std::vector<std::size_t>& detail_level_indexes, const std::vector<sequence_info>& sequences) const
+  {
+    if (std::find(detail_level_indexes.begin(), detail_level_indexes.end(), 0) == detail_level_indexes.end() || model.frame_names.empty())
+    {
+      return;
+    }
+
+    std::vector<vector3f> positions(model.vertex_count);
+    sample(sequences, positions);
+
+    renderer.update_node(std::nullopt, root_node_name);
+    renderer.update_object(root_node_name, model_object_name);
+
+    // The models use the opposite winding to the other shapes.
+    for (const auto& face : model.faces)
+    {
+      renderer.new_face(3);
+
+      renderer.emit_vertex(positions[face[2].vertex_index]);
+      renderer.emit_vertex(positions[face[1].vertex_index]);
+      renderer.emit_vertex(positions[face[0].vertex_index]);
+
+      renderer.emit_texture_vertex(model.texture_vertices[face[2].texture_index]);
+      renderer.emit_texture_vertex(model.texture_vertices[face[1].texture_index]);
+      renderer.emit_texture_vertex(model.texture_vertices[face[0].texture_index]);
+
+      renderer.end_face();
+    }
+  }
+
+  std::vector<mesh_batch> mdl_renderable_shape::get_mesh_batches(const std::vector<std::size_t>& detail_level_indexes, const std::vector<sequence_info>& sequences) const
+  {
+    mesh_batch_builder builder;
+
+    if (std::find(detail_level_indexes.begin(), detail_level_indexes.end(), 0) == detail_level_indexes.end() || model.frame_names.empty())
+    {
+      return builder.finish();
+    }
+
+    std::vector<vector3f> positions(model.vertex_count);
+    sample(sequences, positions);
+
+    // Every face uses the first skin, since the others are swapped in as a whole.
+    const auto material_index = model.skins.empty() ? -1 : 0;
+
+    builder.begin_object(root_node_name, model_object_name, model.vertex_count);
+
+    for (const auto& face : model.faces)
+    {
+      std::array<mesh_batch_builder::corner, 3> corners;
+
+      for (auto i = 0u; i < corners.size(); ++i)
+      {
+        const auto& item = face[corners.size() - 1 - i];
+        corners[i] = mesh_batch_builder::corner{ item.vertex_index, item.texture_index, positions[item.vertex_index], model.texture_vertices[item.texture_index] };
+      }
+
+      builder.add_triangle(material_index, corners);
+    }
+
+    return builder.finish();
+  }
+}// namespace siege::content::mdl
@@ -1,12 +1,20 @@
+#include <algorithm>
+#include <iterator>
+#include <spanstream>
+#include <siege/content/dts/renderable_shape_factory.hpp>
 #include <siege/content/dts/darkstar.hpp>
 #include <siege/content/dts/3space.hpp>
 #include <siege/content/dts/dts_renderable_shape.hpp>
 #include <siege/content/dts/3space_renderable_shape.hpp>
+#include <siege/content/dts/mdl_renderable_shape.hpp>
+#include <siege/content/dts/tmd_renderable_shape.hpp>
+#include <siege/content/dts/bwd_renderable_shape.hpp>
+#include <siege/content/dts/bnd.hpp>
 #include <siege/content/dts/null_renderable_shape.hpp>
 
 namespace siege::content::dts
 {
-  std::unique_ptr<content::renderable_shape> make_shape(std::istream& shape_stream)
+  std::unique_ptr<content::renderable_shape> make_shape(std::istream& shape_stream, const related_files& files)
   {
     if (content::dts::darkstar::is_darkstar_dts(shape_stream))
     {
@@ -25,6 +33,82 @@ namespace siege::content::dts
       return std::make_unique<three_space::dts_renderable_shape>(shapes.front());
     }
 
+    // The id Tech models all become the same keyframe model, whichever format they were in.
+    auto make_mdl_shape = [](auto shape) -> std::unique_ptr<content::renderable_shape> {
+      if (!shape)
+      {
+        return std::make_unique<null_renderable_shape>();
+      }
+
+      return std::make_unique<mdl::mdl_renderable_shape>(mdl::to_keyframe_model(*shape));
+    };
+
+    if (mdl::is_mdl(shape_stream))
+    {
+      return make_mdl_shape(mdl::load_mdl(shape_stream));
+    }
+
+    if (mdl::is_md2(shape_stream))
+    {
+      return make_mdl_shape(mdl::load_md2(shape_stream));
+    }
+
+    if (mdl::is_mdx(shape_stream))
+    {
+      return make_mdl_shape(mdl::load_mdx(shape_stream));
+    }
+
+    if (mdl::is_dkm(shape_stream))
+    {
+      return make_mdl_shape(mdl::load_dkm(shape_stream));
+    }
+
+    if (tmd::is_tmd(shape_stream))
+    {
+      return std::make_unique<tmd::tmd_renderable_shape>(tmd::load_tmd(shape_stream));
+    }
+
+    // The meshes and textures of BWD files are in other files of the same archive, so without them there is nothing to show.
+    if (bwd::is_bwd(shape_stream))
+    {
+      auto model = files.read ? bwd::load_bwd(shape_stream) : std::nullopt;
+
+      if (!model)
+      {
+        return std::make_unique<null_renderable_shape>();
+      }
+
+      auto resolve_mesh = [&](std::int16_t file_id) -> std::optional<wtb::wtb_shape> {
+        auto contents = files.read(std::uint16_t(file_id));
+        std::ispanstream stream(std::span<const char>(contents.data(), contents.size()));
+
+        if (!wtb::is_wtb(stream))
+        {
+          return std::nullopt;
+        }
+
+        return wtb::load_wtb(stream);
+      };
+
+      return std::make_unique<bwd::bwd_renderable_shape>(*model, resolve_mesh, files.get_filename);
+    }
+
+    if (bnd::is_bnd(shape_stream))
+    {
+      auto data = bnd::load_bnd(shape_stream);
+
+      if (!data)
+      {
+        return std::make_unique<null_renderable_shape>();
+      }
+
+      std::vector<tmd::tmd_object> objects;
+      objects.reserve(data->shapes.size());
+      std::transform(data->shapes.begin(), data->shapes.end(), std::back_inserter(objects), [](const bnd::bnd_shape& shape) { return bnd::to_tmd_object(shape); });
+
+      return std::make_unique<tmd::tmd_renderable_shape>(std::move(objects), std::move(data->textures));
+    }
+
     return std::make_unique<null_renderable_shape>();
   }
 }
\ No newline at end of file
@@ -1,17 +1,14 @@
 // TMD - PlayStation standard model format. Embedded inside of BND files from Colony Wars
 
+#include <algorithm>
 #include <array>
-#include <variant>
-#include <any>
+#include <execution>
 #include <siege/content/dts/tmd.hpp>
 #include <siege/platform/shared.hpp>
 #include <siege/platform/stream.hpp>
-#include <siege/platform/endian_arithmetic.hpp>
 
 namespace siege::content::tmd
 {
-  namespace endian = siege::platform;
-
   constexpr static std::uint8_t magic_number = 65;
 
   struct tmd_header
@@ -34,56 +31,21 @@ namespace siege::content::tmd
 
   struct tmd_primitive_header
   {
-    std::byte padding;
+    std::uint8_t output_size;
+    // The size of the packet which follows, in 32-bit words.
     std::uint8_t size;
-    std::byte padding2;
-    enum primitive_type : std::uint8_t
-    {
-      single_colour_triangle = 0x20,
-      single_colour_triangle_alt = 0x22,
-      gouraud_triangle = 0x24,
-      single_colour_quad = 0x28,
-      flat_triangle = 0x30,
-      textured_triangle = 0x34,
-      flat_quad = 0x38,
-    } type;
+    std::uint8_t flags;
+    std::uint8_t mode;
   };
 
-  struct tmd_single_colour_quad_primitive
-  {
-    tmd_primitive_header header;
-    endian::little_uint32_t first_value;
-    endian::little_uint32_t second_value;
-    endian::little_uint32_t third_value;
-    endian::little_uint32_t fourth_value;
-  };
-
-  struct tmd_textured_triangle_primitive
-  {
-    tmd_primitive_header header;
-    struct
-    {
-      endian::little_uint16_t padding;
-      std::uint8_t v_coord;
-      std::uint8_t u_coord;
-    } texture_coordinates[3];
-
-    struct
-    {
-      endian::little_uint16_t padding;
-      endian::little_uint16_t v_coord;
-      endian::little_uint16_t u_coord;
-    } vertex_indices[3];
-  };
-
-  using tmd_primitive = std::variant<tmd_single_colour_quad_primitive>;
-
-  struct tmd_shape
-  {
-    std::vector<tmd_vertex> vertices;
-    std::vector<tmd_vertex> normals;
-    std::vector<tmd_primitive> primitives;
-  };
+  // The bits of the mode and flags of a primitive which change the layout of its packet.
+  constexpr static std::uint8_t mode_type_mask = 0xe0;
+  constexpr static std::uint8_t mode_polygon = 0x20;
+  constexpr static std::uint8_t mode_gouraud = 0x10;
+  constexpr static std::uint8_t mode_quad = 0x08;
+  constexpr static std::uint8_t mode_textured = 0x04;
+  constexpr static std::uint8_t flag_unlit = 0x01;
+  constexpr static std::uint8_t flag_gradation = 0x04;
 
   bool is_tmd(std::istream& stream)
   {
@@ -105,9 +67,88 @@ namespace siege::content::tmd
     return false;
   }
 
-  std::vector<std::any> load_tmd(std::istream& stream)
+  std::optional<tmd_polygon> read_polygon(std::uint8_t mode, std::uint8_t flags, std::span<const std::byte> packet)
   {
-    std::vector<std::any> results;
+    if ((mode & mode_type_mask) != mode_polygon)
+    {
+      return std::nullopt;
+    }
+
+    const bool is_lit = (flags & flag_unlit) == 0;
+    const bool is_gouraud = (mode & mode_gouraud) != 0;
+
+    tmd_polygon result{};
+    result.corner_count = (mode & mode_quad) != 0 ? 4 : 3;
+    result.is_textured = (mode & mode_textured) != 0;
+
+    const std::size_t corner_count = result.corner_count;
+
+    // Texture coordinates come first, then colours, and then normal and vertex indexes.
+    const auto texture_words = result.is_textured ? corner_count : 0;
+    const auto colour_words = result.is_textured && is_lit ? 0 : ((is_lit ? (flags & flag_gradation) != 0 : is_gouraud) ? corner_count : 1);
+    const auto index_words = is_lit && is_gouraud ? corner_count : (is_lit ? corner_count / 2 + 1 : 2);
+
+    if (packet.size() < (texture_words + colour_words + index_words) * 4)
+    {
+      return std::nullopt;
+    }
+
+    auto read_uint16 = [&](std::size_t offset) {
+      return std::uint16_t(std::uint16_t(packet[offset]) | (std::uint16_t(packet[offset + 1]) << 8));
+    };
+
+    for (auto i = 0u; i < texture_words; ++i)
+    {
+      result.corners[i].u = std::uint8_t(packet[i * 4]);
+      result.corners[i].v = std::uint8_t(packet[i * 4 + 1]);
+    }
+
+    if (result.is_textured)
+    {
+      result.clut = read_uint16(2);
+      result.texture_page = read_uint16(6);
+    }
+
+    const auto colour_offset = texture_words * 4;
+
+    if (colour_words > 0)
+    {
+      result.colour = rgb_data{ std::uint8_t(packet[colour_offset]), std::uint8_t(packet[colour_offset + 1]), std::uint8_t(packet[colour_offset + 2]), 0 };
+    }
+    else
+    {
+      result.colour = rgb_data{ 128, 128, 128, 0 };
+    }
+
+    const auto index_offset = colour_offset + colour_words * 4;
+
+    if (is_lit && is_gouraud)
+    {
+      for (auto i = 0u; i < corner_count; ++i)
+      {
+        result.corners[i].normal_index = read_uint16(index_offset + i * 4);
+        result.corners[i].vertex_index = read_uint16(index_offset + i * 4 + 2);
+      }
+    }
+    else
+    {
+      // Flat polygons only have the one normal, in front of the vertex indexes.
+      const auto first_vertex = is_lit ? index_offset + 2 : index_offset;
+      const auto normal_index = is_lit ? read_uint16(index_offset) : std::uint16_t(0);
+
+      for (auto i = 0u; i < corner_count; ++i)
+      {
+        result.corners[i].normal_index = normal_index;
+        result.corners[i].vertex_index = read_uint16(first_vertex + i * 2);
+      }
+    }
+
+    return result;
+  }
+
+  std::vector<tmd_object> load_tmd(std::istream& stream)
+  {
+    std::vector<tmd_object> results;
     platform::istream_pos_resetter resetter(stream);
 
     tmd_header main_header{};
@@ -116,19 +157,27 @@ namespace siege::content::tmd
     if (main_header.magic_number == magic_number && main_header.object_count > 0)
     {
       auto start_offset = (std::size_t)stream.tellg();
-      
+
       results.reserve(main_header.object_count);
 
+      std::vector<std::byte> packet;
+
       for (auto i = 0u; i < main_header.object_count; ++i)
       {
         tmd_object_header object_header{};
+        stream.seekg(start_offset + i * sizeof(object_header), std::ios::beg);
         stream.read((char*)&object_header, sizeof(object_header));
 
-        tmd_shape shape;
+        if (!stream)
+        {
+          break;
+        }
+
+        auto& shape = results.emplace_back();
 
         shape.vertices.resize(object_header.vertex_count);
         shape.normals.resize(object_header.normal_count);
-        shape.primitives.reserve(object_header.primitive_count);
+        shape.polygons.reserve(object_header.primitive_count);
 
         stream.seekg(start_offset + object_header.vertex_offset, std::ios::beg);
         stream.read((char*)shape.vertices.data(), sizeof(tmd_vertex) * shape.vertices.size());
@@ -138,39 +187,34 @@ namespace siege::content::tmd
 
         stream.seekg(start_offset + object_header.primitive_offset, std::ios::beg);
 
-        for (auto i = 0u; i < object_header.primitive_count; ++i)
+        for (auto p = 0u; p < object_header.primitive_count; ++p)
         {
           tmd_primitive_header header{};
-
           stream.read((char*)&header, sizeof(header));
 
-          if (header.type != tmd_primitive_header::single_colour_quad)
+          packet.resize(header.size * 4);
+          stream.read((char*)packet.data(), packet.size());
+
+          if (!stream)
           {
             break;
           }
 
-          tmd_single_colour_quad_primitive quad;
-          quad.header = header;
-
-          auto quad_size = sizeof(quad) - sizeof(header);
-
-          if (header.size * 4 > quad_size)
-          {
-            stream.read((char*)&quad.first_value, quad_size);
-            stream.seekg(header.size * 4 - quad_size, std::ios::cur);
-          }
-          else
+          if (auto polygon = read_polygon(header.mode, header.flags, packet); polygon)
           {
-            stream.read((char*)&quad.first_value, header.size * 4);
+            shape.polygons.emplace_back(*polygon);
           }
-
-          shape.primitives.emplace_back(std::move(quad));
         }
-
-        results.emplace_back(std::move(shape));
       }
     }
 
     return results;
   }
-}
\ No newline at end of file
+
+  void decode_vertices(std::span<const tmd_vertex> vertices, std::span<vector3f> results)
+  {
+    std::transform(std::execution::unseq, vertices.begin(), vertices.end(), results.begin(), [](const tmd_vertex& vertex) {
+      return vector3f{ float(std::int16_t(vertex.x)), -float(std::int16_t(vertex.y)), -float(std::int16_t(vertex.z)) };
+    });
+  }
+}// namespace siege::content::tmd
@@ -0,0 +1,178 @@
+#include <algorithm>
+#include <cstring>
+#include <spanstream>
+#include <catch2/catch_test_macros.hpp>
+#include <siege/content/dts/tmd_renderable_shape.hpp>
+#include <siege/content/dts/wtb.hpp>
+#include "test_helpers.hpp"
+
+using namespace siege::content;
+using namespace siege::content::test_helpers;
+
+namespace
+{
+  // A lit, flat shaded, textured triangle.
+  std::vector<std::byte> make_textured_triangle(std::uint16_t clut, std::uint16_t texture_page)
+  {
+    std::vector<std::byte> packet;
+    append<std::uint8_t>(packet, 10);
+    append<std::uint8_t>(packet, 20);
+    append<std::uint16_t>(packet, clut);
+    append<std::uint8_t>(packet, 30);
+    append<std::uint8_t>(packet, 20);
+    append<std::uint16_t>(packet, texture_page);
+    append<std::uint8_t>(packet, 10);
+    append<std::uint8_t>(packet, 40);
+    append<std::uint16_t>(packet, 0);
+
+    append<std::uint16_t>(packet, 7);
+    append<std::uint16_t>(packet, 0);
+    append<std::uint16_t>(packet, 1);
+    append<std::uint16_t>(packet, 2);
+    return packet;
+  }
+
+  // A lit, flat shaded quad with one colour.
+  std::vector<std::byte> make_coloured_quad()
+  {
+    std::vector<std::byte> packet;
+    append<std::uint8_t>(packet, 200);
+    append<std::uint8_t>(packet, 100);
+    append<std::uint8_t>(packet, 50);
+    append<std::uint8_t>(packet, 0x28);
+
+    append<std::uint16_t>(packet, 3);
+    append<std::uint16_t>(packet, 0);
+    append<std::uint16_t>(packet, 1);
+    append<std::uint16_t>(packet, 2);
+    append<std::uint16_t>(packet, 3);
+    append<std::uint16_t>(packet, 0);
+    return packet;
+  }
+}// namespace
+
+TEST_CASE("TMD polygon packets are read according to their mode and flags", "[tmd]")
+{
+  auto triangle = tmd::read_polygon(0x24, 0, make_textured_triangle(0x1234, 0x000a));
+
+  REQUIRE(triangle.has_value());
+  REQUIRE(triangle->corner_count == 3);
+  REQUIRE(triangle->is_textured);
+  REQUIRE(triangle->clut == 0x1234);
+  REQUIRE(triangle->texture_page == 0x000a);
+  REQUIRE(triangle->corners[1].u == 30);
+  REQUIRE(triangle->corners[2].v == 40);
+  REQUIRE(triangle->corners[0].normal_index == 7);
+  REQUIRE(triangle->corners[2].normal_index == 7);
+  REQUIRE(triangle->corners[2].vertex_index == 2);
+
+  auto quad = tmd::read_polygon(0x28, 0, make_coloured_quad());
+
+  REQUIRE(quad.has_value());
+  REQUIRE(quad->corner_count == 4);
+  REQUIRE_FALSE(quad->is_textured);
+  REQUIRE(quad->colour.red == 200);
+  REQUIRE(quad->colour.blue == 50);
+  REQUIRE(quad->corners[3].vertex_index == 3);
+
+  // Lines and sprites are not polygons, and packets which are too short are not read.
+  REQUIRE_FALSE(tmd::read_polygon(0x40, 0, make_coloured_quad()).has_value());
+  REQUIRE_FALSE(tmd::read_polygon(0x2c, 0, make_coloured_quad()).has_value());
+}
+
+TEST_CASE("TMD vertices are converted from fixed point with y and z flipped", "[tmd]")
+{
+  std::vector<tmd::tmd_vertex> vertices{ { 100, -200, 300, 0 }, { -1, 0, 1, 0 } };
+  std::vector<vector3f> results(vertices.size());
+
+  tmd::decode_vertices(vertices, results);
+
+  REQUIRE(is_near(results[0].x, 100));
+  REQUIRE(is_near(results[0].y, 200));
+  REQUIRE(is_near(results[0].z, -300));
+  REQUIRE(is_near(results[1].x, -1));
+  REQUIRE(is_near(results[1].z, -1));
+}
+
+TEST_CASE("Textured TMD polygons are bound to TIM images by where they are in VRAM", "[tmd]")
+{
+  tim::tim_image image{};
+  image.format = tim::tim_format::eight_bit;
+  image.pixels = siege::platform::bitmap::pixel_buffer(siege::platform::bitmap::pixel_format::indexed_8, 128, 64);
+  image.cluts.resize(2, std::vector<siege::platform::palette::colour>(256));
+  image.cluts[1][0].red = std::byte{ 255 };
+  image.vram_x = 640;
+  image.vram_y = 0;
+  image.clut_x = 0;
+  image.clut_y = 480;
+  image.clut_row_size = 256;
+
+  tmd::tmd_object object{};
+  object.vertices = { { 0, 0, 0, 0 }, { 10, 0, 0, 0 }, { 0, 10, 0, 0 }, { 10, 10, 0, 0 } };
+  // Texture page 10 starts at x 640, and the second row of colour tables is the second table.
+  object.polygons.emplace_back(*tmd::read_polygon(0x24, 0, make_textured_triangle(std::uint16_t(481 << 6), 0x000a)));
+  object.polygons.emplace_back(*tmd::read_polygon(0x28, 0, make_coloured_quad()));
+
+  tmd::tmd_renderable_shape shape({ object }, { image });
+
+  auto materials = shape.get_materials();
+  REQUIRE(materials.size() == 2);
+  REQUIRE(materials[0].filename == "tim_0_1");
+
+  auto texture = shape.get_texture("tim_0_1");
+  REQUIRE(texture.has_value());
+  REQUIRE(texture->colours.size() == 256);
+  REQUIRE(texture->colours[0].red == std::byte{ 255 });
+  REQUIRE_FALSE(shape.get_texture("tim_0_0").has_value());
+
+  auto batches = shape.get_mesh_batches({ 0 }, {});
+  REQUIRE(batches.size() == 2);
+
+  auto textured = std::find_if(batches.begin(), batches.end(), [](const auto& batch) { return batch.material_index == 0; });
+  REQUIRE(textured != batches.end());
+  REQUIRE(textured->get_index_count() == 3);
+  REQUIRE(is_near(textured->vertices[0].texture_coordinate.x, 10.0f / 128));
+  REQUIRE(is_near(textured->vertices[0].texture_coordinate.y, 20.0f / 64));
+
+  // Quads become two triangles.
+  auto coloured = std::find_if(batches.begin(), batches.end(), [](const auto& batch) { return batch.material_index == 1; });
+  REQUIRE(coloured != batches.end());
+  REQUIRE(coloured->get_index_count() == 6);
+  REQUIRE(coloured->vertices.size() == 4);
+}
+
+TEST_CASE("WTB points and polygons are read from after the header", "[wtb]")
+{
+  std::vector<std::byte> data;
+  append(data, std::array<char, 4>{ 'W', 'T', 'B', 'O' });
+  data.resize(24);
+  append<std::uint16_t>(data, 5);
+  append<std::uint16_t>(data, 2);
+  append<std::uint32_t>(data, 0);
+
+  for (auto i = 0; i < 5; ++i)
+  {
+    append(data, std::array<std::int32_t, 4>{ i, -i, i * 2, 0 });
+  }
+
+  // A triangle in the short layout, then a pentagon in the long one.
+  append(data, std::array<std::uint16_t, 6>{ 12, 3, 0, 1, 2, 0 });
+  append(data, std::array<std::uint16_t, 9>{ 0, 5, 0, 1, 2, 3, 4, 0, 0 });
+
+  std::ispanstream stream{ std::span<const char>(reinterpret_cast<const char*>(data.data()), data.size()) };
+
+  REQUIRE(wtb::is_wtb(stream));
+  auto shape = wtb::load_wtb(stream);
+
+  REQUIRE(shape.has_value());
+  REQUIRE(shape->points.size() == 5);
+  REQUIRE(shape->polygons.size() == 2);
+  REQUIRE(shape->polygons[0].surface == 12);
+  REQUIRE(shape->polygons[0].points == std::vector<std::uint16_t>{ 0, 1, 2 });
+  REQUIRE(shape->polygons[1].points == std::vector<std::uint16_t>{ 0, 1, 2, 3, 4 });
+
+  std::vector<vector3f> positions(shape->points.size());
+  wtb::decode_points(shape->points, positions);
+  REQUIRE(is_near(positions[4].y, -4));
+  REQUIRE(is_near(positions[4].z, 8));
+}
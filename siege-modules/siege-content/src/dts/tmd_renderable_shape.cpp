@@ -0,0 +1,244 @@
+#include <algorithm>
+#include <siege/content/dts/tmd_renderable_shape.hpp>
+
+namespace siege::content::tmd
+{
+  constexpr std::string_view root_node_name = "root";
+
+  // How many pixels of an image fit into one 16-bit unit of VRAM.
+  static float get_pixels_per_unit(tim::tim_format format)
+  {
+    switch (format)
+    {
+    case tim::tim_format::four_bit:
+      return 4;
+    case tim::tim_format::eight_bit:
+      return 2;
+    case tim::tim_format::twenty_four_bit:
+      return 2.0f / 3.0f;
+    default:
+      return 1;
+    }
+  }
+
+  tmd_renderable_shape::tmd_renderable_shape(std::vector<tmd_object> source, std::vector<tim::tim_image> images)
+    : images(std::move(images))
+  {
+    material_keys keys;
+    objects.reserve(source.size());
+
+    for (auto i = 0u; i < source.size(); ++i)
+    {
+      const auto& item = source[i];
+      auto& object = objects.emplace_back();
+      object.name = "object_" + std::to_string(i);
+
+      // Every vertex is converted up front, so drawing a frame does no more than look them up.
+      object.positions.resize(item.vertices.size());
+      decode_vertices(item.vertices, object.positions);
+
+      object.faces.reserve(item.polygons.size() * 2);
+
+      for (const auto& polygon : item.polygons)
+      {
+        auto is_valid = std::all_of(polygon.corners.begin(), polygon.corners.begin() + polygon.corner_count, [&](const tmd_corner& corner) {
+          return corner.vertex_index < object.positions.size();
+        });
+
+        if (!is_valid)
+        {
+          continue;
+        }
+
+        std::array<texture_vertex, 4> texture_vertices{};
+        auto material_index = get_material(polygon, texture_vertices, keys);
+
+        auto add_face = [&](const std::array<std::size_t, 3>& order) {
+          face result{ material_index };
+
+          for (auto index = 0u; index < order.size(); ++index)
+          {
+            const auto& corner = polygon.corners[order[index]];
+            result.vertex_indexes[index] = corner.vertex_index;
+            result.texture_vertices[index] = texture_vertices[order[index]];
+            result.texture_keys[index] = std::uint16_t(corner.u | (corner.v << 8));
+          }
+
+          object.faces.emplace_back(result);
+        };
+
+        add_face({ 0, 1, 2 });
+
+        if (polygon.corner_count == 4)
+        {
+          add_face({ 1, 3, 2 });
+        }
+      }
+    }
+  }
+
+  std::int32_t tmd_renderable_shape::get_material(const tmd_polygon& polygon, std::array<texture_vertex, 4>& texture_vertices, material_keys& keys)
+  {
+    if (polygon.is_textured)
+    {
+      const auto page_x = std::int32_t(polygon.texture_page & 0x0f) * 64;
+      const auto page_y = std::int32_t((polygon.texture_page >> 4) & 0x01) * 256;
+
+      for (auto i = 0u; i < images.size(); ++i)
+      {
+        const auto& image = images[i];
+        const auto pixels_per_unit = get_pixels_per_unit(image.format);
+        const auto width = float(image.pixels.get_width());
+        const auto height = float(image.pixels.get_height());
+
+        // Where the texture page starts, in pixels of the image.
+        const auto left = float(page_x - image.vram_x) * pixels_per_unit;
+        const auto top = float(page_y - image.vram_y);
+
+        const auto x = left + polygon.corners[0].u;
+        const auto y = top + polygon.corners[0].v;
+
+        if (x < 0 || y < 0 || x >= width || y >= height)
+        {
+          continue;
+        }
+
+        std::size_t clut_index = 0;
+
+        if (image.format == tim::tim_format::four_bit || image.format == tim::tim_format::eight_bit)
+        {
+          const auto clut_x = std::int32_t(polygon.clut & 0x3f) * 16 - image.clut_x;
+          const auto clut_y = std::int32_t(polygon.clut >> 6) - image.clut_y;
+          const auto tables_per_row = image.format == tim::tim_format::four_bit ? std::max<std::size_t>(image.clut_row_size / 16, 1) : 1;
+
+          if (clut_x >= 0 && clut_y >= 0)
+          {
+            clut_index = std::size_t(clut_y) * tables_per_row + (image.format == tim::tim_format::four_bit ? std::size_t(clut_x) / 16 : 0);
+          }
+
+          if (clut_index >= image.cluts.size())
+          {
+            clut_index = 0;
+          }
+        }
+
+        for (auto c = 0u; c < polygon.corner_count; ++c)
+        {
+          texture_vertices[c] = texture_vertex{ (left + polygon.corners[c].u) / width, (top + polygon.corners[c].v) / height };
+        }
+
+        auto key = (std::uint64_t(1) << 63) | (std::uint64_t(i) << 32) | clut_index;
+        auto [existing, added] = keys.try_emplace(key, std::int32_t(materials.size()));
+
+        if (added)
+        {
+          materials.emplace_back(material{ "tim_" + std::to_string(i) + "_" + std::to_string(clut_index) });
+          texture_sources.emplace_back(texture_source{ i, clut_index });
+        }
+
+        return existing->second;
+      }
+    }
+
+    auto key = std::uint64_t(polygon.colour.red) | (std::uint64_t(polygon.colour.green) << 8) | (std::uint64_t(polygon.colour.blue) << 16);
+    auto [existing, added] = keys.try_emplace(key, std::int32_t(materials.size()));
+
+    if (added)
+    {
+      auto& result = materials.emplace_back();
+      result.metadata.emplace("rgbData", polygon.colour);
+      texture_sources.emplace_back(std::nullopt);
+    }
+
+    return existing->second;
+  }
+
+  std::vector<sequence_info> tmd_renderable_shape::get_sequences(const std::vector<std::size_t>&) const
+  {
+    return {};
+  }
+
+  std::vector<std::string> tmd_renderable_shape::get_detail_levels() const
+  {
+    return { "default" };
+  }
+
+  std::vector<material> tmd_renderable_shape::get_materials() const
+  {
+    return materials;
+  }
+
+  std::optional<platform::bitmap::windows_bmp_data> tmd_renderable_shape::get_texture(std::string_view filename) const
+  {
+    for (auto i = 0u; i < materials.size(); ++i)
+    {
+      if (materials[i].filename == filename && texture_sources[i])
+      {
+        return tim::to_bitmap(images[texture_sources[i]->image_index], texture_sources[i]->clut_index);
+      }
+    }
+
+    return std::nullopt;
+  }
+
+  void tmd_renderable_shape::render_shape(shape_renderer& renderer, const std::vector<std::size_t>& detail_level_indexes, const std::vector<sequence_info>&) const
+  {
+    if (std::find(detail_level_indexes.begin(), detail_level_indexes.end(), 0) == detail_level_indexes.end())
+    {
+      return;
+    }
+
+    renderer.update_node(std::nullopt, root_node_name);
+
+    for (const auto& object : objects)
+    {
+      renderer.update_object(root_node_name, object.name);
+
+      for (const auto& face : object.faces)
+      {
+        renderer.new_face(3);
+
+        for (auto index : face.vertex_indexes)
+        {
+          renderer.emit_vertex(object.positions[index]);
+        }
+
+        for (const auto& vertex : face.texture_vertices)
+        {
+          renderer.emit_texture_vertex(vertex);
+        }
+
+        renderer.end_face();
+      }
+    }
+  }
+
+  std::vector<mesh_batch> tmd_renderable_shape::get_mesh_batches(const std::vector<std::size_t>& detail_level_indexes, const std::vector<sequence_info>&) const
+  {
+    mesh_batch_builder builder;
+
+    if (std::find(detail_level_indexes.begin(), detail_level_indexes.end(), 0) == detail_level_indexes.end())
+    {
+      return builder.finish();
+    }
+
+    for (const auto& object : objects)
+    {
+      builder.begin_object(root_node_name, object.name, object.positions.size());
+
+      for (const auto& face : object.faces)
+      {
+        std::array<mesh_batch_builder::corner, 3> corners;
+
+        for (auto i = 0u; i < corners.size(); ++i)
+        {
+          corners[i] = mesh_batch_builder::corner{ face.vertex_indexes[i], face.texture_keys[i], object.positions[face.vertex_indexes[i]], face.texture_vertices[i] };
+        }
+
+        builder.add_triangle(face.material_index, corners);
+      }
+    }
+
+    return builder.finish();
+  }
+}// namespace siege::content::tmd
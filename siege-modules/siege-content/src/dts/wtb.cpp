@@ -1,23 +1,17 @@
 // WTB - MechWarrior 2 - individual mesh shape
 
+#include <algorithm>
 #include <array>
+#include <execution>
+#include <iterator>
+#include <siege/content/dts/wtb.hpp>
 #include <siege/platform/shared.hpp>
 #include <siege/platform/stream.hpp>
-#include <siege/platform/endian_arithmetic.hpp>
 
 namespace siege::content::wtb
 {
-  namespace endian = siege::platform;
-
   constexpr auto header_tag = platform::to_tag<4>({ 'W', 'T', 'B', 'O' });
 
-  // each tag must represent a type of shading or texturing
-  constexpr auto polygon_tag = platform::to_tag<2>({ 0x00, 0x78 });
-  constexpr auto polygon_tag_2 = platform::to_tag<2>({ 0xf0, 0x4c });
-  constexpr auto polygon_tag_3 = platform::to_tag<2>({ 0x22, 0x54 });
-  constexpr auto polygon_tag_4 = platform::to_tag<2>({ 0x1f, 0x74 });
-  constexpr auto polygon_tag_5 = platform::to_tag<2>({ 0xf0, 0x44 });
-
   struct wtb_header
   {
     std::array<std::byte, 4> tag;
@@ -32,85 +26,69 @@ namespace siege::content::wtb
     endian::little_uint32_t unknown3;
   };
 
-  struct surface_header
-  {
-    std::array<std::byte, 2> tag;
-    endian::little_uint16_t number_of_points;
-  };
+  // Each polygon starts with its surface and the number of points it has,
+  // followed by room for four points, or seven for polygons with five or more.
+  constexpr std::size_t short_polygon_size = 6;
+  constexpr std::size_t long_polygon_size = 9;
+  constexpr std::size_t long_polygon_point_count = 5;
 
-  struct face_3v
+  bool is_wtb(std::istream& stream)
   {
-    std::array<endian::little_uint16_t, 3> values;
-    endian::little_uint16_t padding;
-  };
+    platform::istream_pos_resetter resetter(stream);
+    std::array<std::byte, 4> tag;
+    stream.read((char*)&tag, sizeof(tag));
+    return stream && tag == header_tag;
+  }
 
-  struct face_4v
+  std::optional<wtb_shape> load_wtb(std::istream& stream)
   {
-    std::array<endian::little_uint16_t, 4> values;
-  };
+    platform::istream_pos_resetter resetter(stream);
 
-  struct face_5v
-  {
-    std::array<endian::little_uint16_t, 5> values;
-    std::array<endian::little_uint16_t, 2> padding;
-  };
+    wtb_header header{};
+    stream.read((char*)&header, sizeof(header));
 
-  using face_value = std::variant<face_3v, face_4v, face_5v>;
+    if (!stream || header.tag != header_tag)
+    {
+      return std::nullopt;
+    }
 
-  struct surface
-  {
-    surface_header header;
-    std::vector<face_value> vertices;
-  };
+    wtb_shape shape;
+    shape.points.resize(header.vertex_count);
+    stream.read((char*)shape.points.data(), shape.points.size() * sizeof(wtb_point));
 
-  bool is_wtb(std::istream& stream)
+    shape.polygons.reserve(header.surface_count);
+
+    std::array<endian::little_uint16_t, long_polygon_size> values{};
+
+    while (shape.polygons.size() < header.surface_count && stream)
+    {
+      stream.read((char*)values.data(), short_polygon_size * sizeof(std::uint16_t));
+
+      std::size_t count = values[1];
+
+      if (count >= long_polygon_point_count)
+      {
+        stream.read((char*)(values.data() + short_polygon_size), (long_polygon_size - short_polygon_size) * sizeof(std::uint16_t));
+        count = std::min(count, long_polygon_size - 2);
+      }
+
+      if (!stream)
+      {
+        break;
+      }
+
+      auto& polygon = shape.polygons.emplace_back(wtb_polygon{ values[0] });
+      polygon.points.reserve(count);
+      std::transform(values.begin() + 2, values.begin() + 2 + count, std::back_inserter(polygon.points), [](auto value) { return std::uint16_t(value); });
+    }
+
+    return shape;
+  }
+
+  void decode_points(std::span<const wtb_point> points, std::span<vector3f> results)
   {
-    return false;
+    std::transform(std::execution::unseq, points.begin(), points.end(), results.begin(), [](const wtb_point& point) {
+      return vector3f{ float(std::int32_t(point.x)), float(std::int32_t(point.y)), float(std::int32_t(point.z)) };
+    });
   }
 }// namespace siege::content::wtb
-
-// from collections import namedtuple
-// import struct
-
-// def loadWTB(rawData):
-//     offset = 0
-//     # Do not change polygon winding
-//     flipPolygons = False
-//     # Magic numbers eat away at my soul
-//     pointRecordFmt = "<4l"
-//     pointBaseOffset = 32
-//     polyHeaderFmt = "<2H"
-//     shortPolyFmt = "<6H"
-//     longPolyFmt = "<9H"
-//     longPolyRecordVertices = 5
-//     fileHeader =  struct.unpack_from(">4s", rawData, offset)[0]
-//     polygons = []
-//     points = []
-//     if len(rawData) > 32 and fileHeader == "WTBO":
-//         offset = 24 #TODO why do we skip so far into the file?
-//         pointCount, polygonCount = struct.unpack_from("<2H", rawData, offset)
-//         print (pointCount, polygonCount)
-//          # Read points
-//         offset = pointBaseOffset
-//         for i in range(pointCount):
-//             points.append(struct.unpack_from(pointRecordFmt, rawData, offset))
-//             offset += struct.calcsize(pointRecordFmt)
-//          # Read polygons
-
-//         print (pointCount, offset)
-//         while len(polygons) < polygonCount:
-//             polygon = struct.unpack_from(shortPolyFmt, rawData, offset)
-//             someNumber = polygon[0]
-//             count = polygon[1]
-//             fmt = shortPolyFmt
-//             if count >= longPolyRecordVertices:
-//                 polygon = struct.unpack_from(longPolyFmt, rawData, offset)
-//                 fmt = longPolyFmt
-//             faceFormat = ">" + str(count) + "H"
-//             if count > 0:
-//                 polygons.append(polygon[2:][:count])
-
-//             offset += struct.calcsize(fmt)
-
-
-//     return (points, polygons)
@@ -0,0 +1,412 @@
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <nlohmann/json.hpp>
+#include <siege/platform/endian_arithmetic.hpp>
+#include <siege/content/gltf.hpp>
+
+namespace siege::content::gltf
+{
+  namespace endian = siege::platform;
+
+  namespace
+  {
+    constexpr std::uint32_t array_buffer = 34962;
+    constexpr std::uint32_t element_array_buffer = 34963;
+
+    struct glb_header
+    {
+      endian::little_uint32_t magic;
+      endian::little_uint32_t version;
+      endian::little_uint32_t length;
+    };
+
+    struct chunk_header
+    {
+      endian::little_uint32_t length;
+      endian::little_uint32_t type;
+    };
+
+    static_assert(sizeof(glb_header) == 12);
+    static_assert(sizeof(chunk_header) == 8);
+
+    constexpr std::uint32_t glb_magic = 0x46546C67;
+    constexpr std::uint32_t json_chunk = 0x4E4F534A;
+    constexpr std::uint32_t bin_chunk = 0x004E4942;
+
+    constexpr std::size_t align_to_four(std::size_t value)
+    {
+      return (value + 3) & ~std::size_t(3);
+    }
+
+    std::string_view get_path_name(animation_path path)
+    {
+      switch (path)
+      {
+      case animation_path::translation:
+        return "translation";
+      case animation_path::rotation:
+        return "rotation";
+      default:
+        return "scale";
+      }
+    }
+  }// namespace
+
+  std::size_t glb_writer::add_view(std::span<const std::byte> data, std::optional<std::size_t> stride, std::optional<std::uint32_t> target)
+  {
+    views.emplace_back(buffer_view{ data, stride, target });
+    return views.size() - 1;
+  }
+
+  std::size_t glb_writer::add_floats(std::vector<float> values)
+  {
+    auto& owned = owned_data.emplace_back(values.size() * sizeof(float));
+    std::memcpy(owned.data(), values.data(), owned.size());
+    return add_view(owned);
+  }
+
+  std::size_t glb_writer::add_image(std::string name, std::vector<std::byte> png_data)
+  {
+    auto& owned = owned_data.emplace_back(std::move(png_data));
+    images.emplace_back(image{ std::move(name), add_view(owned) });
+    return images.size() - 1;
+  }
+
+  std::size_t glb_writer::add_material(std::string name, std::optional<std::size_t> image_index, std::array<float, 4> base_colour)
+  {
+    if (image_index && *image_index >= images.size())
+    {
+      throw std::out_of_range("The image of a material has to be added before the material.");
+    }
+
+    materials.emplace_back(material{ std::move(name), image_index, base_colour });
+    return materials.size() - 1;
+  }
+
+  std::size_t glb_writer::add_mesh(std::string name, std::span<const mesh_batch> batches)
+  {
+    mesh result{ std::move(name) };
+
+    for (const auto& batch : batches)
+    {
+      if (batch.vertices.empty() || batch.get_index_count() == 0)
+      {
+        continue;
+      }
+
+      std::vector<float> min(3, std::numeric_limits<float>::max());
+      std::vector<float> max(3, std::numeric_limits<float>::lowest());
+
+      for (const auto& vertex : batch.vertices)
+      {
+        min[0] = std::min(min[0], vertex.position.x);
+        min[1] = std::min(min[1], vertex.position.y);
+        min[2] = std::min(min[2], vertex.position.z);
+        max[0] = std::max(max[0], vertex.position.x);
+        max[1] = std::max(max[1], vertex.position.y);
+        max[2] = std::max(max[2], vertex.position.z);
+      }
+
+      // Every attribute comes from the same interleaved view, straight out of the batch.
+      auto vertex_view = add_view(std::as_bytes(std::span(batch.vertices)), sizeof(mesh_vertex), array_buffer);
+      const auto count = batch.vertices.size();
+
+      primitive item{};
+      item.position_accessor = accessors.size();
+      accessors.emplace_back(accessor{ vertex_view, offsetof(mesh_vertex, position), component_type::float_value, count, "VEC3", std::move(min), std::move(max) });
+      item.texture_accessor = accessors.size();
+      accessors.emplace_back(accessor{ vertex_view, offsetof(mesh_vertex, texture_coordinate), component_type::float_value, count, "VEC2" });
+      item.normal_accessor = accessors.size();
+      accessors.emplace_back(accessor{ vertex_view, offsetof(mesh_vertex, normal), component_type::float_value, count, "VEC3" });
+
+      item.index_accessor = accessors.size();
+      std::visit([&](const auto& indexes) {
+        using index_type = typename std::decay_t<decltype(indexes)>::value_type;
+        auto index_view = add_view(std::as_bytes(std::span(indexes)), std::nullopt, element_array_buffer);
+        accessors.emplace_back(accessor{ index_view, 0, sizeof(index_type) == 2 ? component_type::unsigned_short : component_type::unsigned_int, indexes.size(), "SCALAR" });
+      },
+        batch.indexes);
+
+      if (batch.material_index >= 0 && std::size_t(batch.material_index) < materials.size())
+      {
+        item.material_index = std::size_t(batch.material_index);
+      }
+
+      result.primitives.emplace_back(item);
+    }
+
+    if (result.primitives.empty())
+    {
+      throw std::invalid_argument("A glTF mesh needs at least one batch with triangles in it.");
+    }
+
+    meshes.emplace_back(std::move(result));
+    return meshes.size() - 1;
+  }
+
+  std::size_t glb_writer::add_mesh(std::string name, std::vector<mesh_batch>&& batches)
+  {
+    auto result = add_mesh(std::move(name), std::span<const mesh_batch>(batches));
+    owned_batches.emplace_back(std::move(batches));
+    return result;
+  }
+
+  std::size_t glb_writer::add_node(node value)
+  {
+    nodes.emplace_back(std::move(value));
+    return nodes.size() - 1;
+  }
+
+  std::size_t glb_writer::add_scene(std::string name, std::vector<std::size_t> root_nodes)
+  {
+    scenes.emplace_back(scene{ std::move(name), std::move(root_nodes) });
+    return scenes.size() - 1;
+  }
+
+  void glb_writer::add_animation(std::string name, std::vector<animation_channel> channels)
+  {
+    animation result{ std::move(name) };
+
+    for (auto& channel : channels)
+    {
+      const auto width = channel.path == animation_path::rotation ? 4u : 3u;
+
+      if (channel.times.empty() || channel.values.size() != channel.times.size() * width)
+      {
+        throw std::invalid_argument("Each keyframe time of an animation channel needs exactly one value.");
+      }
+
+      const auto count = channel.times.size();
+      std::vector<float> min{ channel.times.front() };
+      std::vector<float> max{ channel.times.back() };
+
+      auto input = accessors.size();
+      accessors.emplace_back(accessor{ add_floats(std::move(channel.times)), 0, component_type::float_value, count, "SCALAR", std::move(min), std::move(max) });
+
+      auto output = accessors.size();
+      accessors.emplace_back(accessor{ add_floats(std::move(channel.values)), 0, component_type::float_value, count, width == 4 ? "VEC4" : "VEC3" });
+
+      result.targets.emplace_back(channel.node_index, channel.path);
+      result.samplers.emplace_back(sampler{ input, output });
+    }
+
+    if (!result.samplers.empty())
+    {
+      animations.emplace_back(std::move(result));
+    }
+  }
+
+  void glb_writer::write(std::ostream& output) const
+  {
+    nlohmann::json document;
+    document["asset"] = { { "version", "2.0" }, { "generator", "siege-content" } };
+
+    // Where each view starts in the BIN chunk. Every view is aligned to four bytes, which suits every component type.
+    std::vector<std::size_t> view_offsets;
+    view_offsets.reserve(views.size());
+    std::size_t bin_length = 0;
+
+    for (const auto& view : views)
+    {
+      bin_length = align_to_four(bin_length);
+      view_offsets.emplace_back(bin_length);
+      bin_length += view.data.size();
+    }
+
+    bin_length = align_to_four(bin_length);
+
+    if (bin_length > 0)
+    {
+      document["buffers"] = nlohmann::json::array({ { { "byteLength", bin_length } } });
+
+      auto& json_views = document["bufferViews"] = nlohmann::json::array();
+
+      for (auto i = 0u; i < views.size(); ++i)
+      {
+        nlohmann::json item = { { "buffer", 0 }, { "byteOffset", view_offsets[i] }, { "byteLength", views[i].data.size() } };
+
+        if (views[i].stride)
+        {
+          item["byteStride"] = *views[i].stride;
+        }
+
+        if (views[i].target)
+        {
+          item["target"] = *views[i].target;
+        }
+
+        json_views.emplace_back(std::move(item));
+      }
+    }
+
+    if (!accessors.empty())
+    {
+      auto& json_accessors = document["accessors"] = nlohmann::json::array();
+
+      for (const auto& item : accessors)
+      {
+        nlohmann::json value = { { "bufferView", item.view_index }, { "byteOffset", item.byte_offset }, { "componentType", std::uint32_t(item.type) }, { "count", item.count }, { "type", item.shape } };
+
+        if (!item.min.empty())
+        {
+          value["min"] = item.min;
+          value["max"] = item.max;
+        }
+
+        json_accessors.emplace_back(std::move(value));
+      }
+    }
+
+    if (!meshes.empty())
+    {
+      auto& json_meshes = document["meshes"] = nlohmann::json::array();
+
+      for (const auto& item : meshes)
+      {
+        auto primitives = nlohmann::json::array();
+
+        for (const auto& part : item.primitives)
+        {
+          nlohmann::json value = {
+            { "attributes", { { "POSITION", part.position_accessor }, { "NORMAL", part.normal_accessor }, { "TEXCOORD_0", part.texture_accessor } } },
+            { "indices", part.index_accessor }
+          };
+
+          if (part.material_index)
+          {
+            value["material"] = *part.material_index;
+          }
+
+          primitives.emplace_back(std::move(value));
+        }
+
+        json_meshes.emplace_back(nlohmann::json{ { "name", item.name }, { "primitives", std::move(primitives) } });
+      }
+    }
+
+    if (!images.empty())
+    {
+      auto& json_images = document["images"] = nlohmann::json::array();
+      auto& json_textures = document["textures"] = nlohmann::json::array();
+
+      for (auto i = 0u; i < images.size(); ++i)
+      {
+        json_images.emplace_back(nlohmann::json{ { "name", images[i].name }, { "bufferView", images[i].view_index }, { "mimeType", "image/png" } });
+        json_textures.emplace_back(nlohmann::json{ { "source", i }, { "sampler", 0 } });
+      }
+
+      // Nearest filtering, which is how the games drew their palette based textures.
+      document["samplers"] = nlohmann::json::array({ { { "magFilter", 9728 }, { "minFilter", 9728 } } });
+    }
+
+    if (!materials.empty())
+    {
+      auto& json_materials = document["materials"] = nlohmann::json::array();
+
+      for (const auto& item : materials)
+      {
+        nlohmann::json pbr = { { "baseColorFactor", item.base_colour }, { "metallicFactor", 0.0f }, { "roughnessFactor", 1.0f } };
+
+        if (item.image_index)
+        {
+          pbr["baseColorTexture"] = { { "index", *item.image_index } };
+        }
+
+        json_materials.emplace_back(nlohmann::json{ { "name", item.name }, { "pbrMetallicRoughness", std::move(pbr) } });
+      }
+    }
+
+    if (!nodes.empty())
+    {
+      auto& json_nodes = document["nodes"] = nlohmann::json::array();
+
+      for (const auto& item : nodes)
+      {
+        nlohmann::json value = { { "name", item.name }, { "translation", item.translation }, { "rotation", item.rotation }, { "scale", item.scale } };
+
+        if (item.mesh_index)
+        {
+          value["mesh"] = *item.mesh_index;
+        }
+
+        if (!item.children.empty())
+        {
+          value["children"] = item.children;
+        }
+
+        json_nodes.emplace_back(std::move(value));
+      }
+    }
+
+    if (!scenes.empty())
+    {
+      document["scene"] = 0;
+      auto& json_scenes = document["scenes"] = nlohmann::json::array();
+
+      for (const auto& item : scenes)
+      {
+        json_scenes.emplace_back(nlohmann::json{ { "name", item.name }, { "nodes", item.nodes } });
+      }
+    }
+
+    if (!animations.empty())
+    {
+      auto& json_animations = document["animations"] = nlohmann::json::array();
+
+      for (const auto& item : animations)
+      {
+        auto channels = nlohmann::json::array();
+        auto samplers = nlohmann::json::array();
+
+        for (auto i = 0u; i < item.samplers.size(); ++i)
+        {
+          channels.emplace_back(nlohmann::json{ { "sampler", i }, { "target", { { "node", item.targets[i].first }, { "path", get_path_name(item.targets[i].second) } } } });
+          samplers.emplace_back(nlohmann::json{ { "input", item.samplers[i].input_accessor }, { "output", item.samplers[i].output_accessor }, { "interpolation", "LINEAR" } });
+        }
+
+        json_animations.emplace_back(nlohmann::json{ { "name", item.name }, { "channels", std::move(channels) }, { "samplers", std::move(samplers) } });
+      }
+    }
+
+    // The JSON chunk is padded with spaces and the BIN chunk with zeros.
+    auto json_text = document.dump();
+    json_text.resize(align_to_four(json_text.size()), ' ');
+
+    auto total_length = sizeof(glb_header) + sizeof(chunk_header) + json_text.size();
+
+    if (bin_length > 0)
+    {
+      total_length += sizeof(chunk_header) + bin_length;
+    }
+
+    glb_header header{ glb_magic, 2, std::uint32_t(total_length) };
+    output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    chunk_header json_header{ std::uint32_t(json_text.size()), json_chunk };
+    output.write(reinterpret_cast<const char*>(&json_header), sizeof(json_header));
+    output.write(json_text.data(), std::streamsize(json_text.size()));
+
+    if (bin_length == 0)
+    {
+      return;
+    }
+
+    chunk_header binary_header{ std::uint32_t(bin_length), bin_chunk };
+    output.write(reinterpret_cast<const char*>(&binary_header), sizeof(binary_header));
+
+    constexpr std::array<char, 4> padding{};
+    std::size_t written = 0;
+
+    for (auto i = 0u; i < views.size(); ++i)
+    {
+      output.write(padding.data(), std::streamsize(view_offsets[i] - written));
+      output.write(reinterpret_cast<const char*>(views[i].data.data()), std::streamsize(views[i].data.size()));
+      written = view_offsets[i] + views[i].data.size();
+    }
+
+    output.write(padding.data(), std::streamsize(bin_length - written));
+  }
+}// namespace siege::content::gltf
@@ -0,0 +1,112 @@
+#include <cstring>
+#include <sstream>
+#include <catch2/catch_test_macros.hpp>
+#include <nlohmann/json.hpp>
+#include <siege/content/gltf.hpp>
+
+using namespace siege::content;
+
+namespace
+{
+  std::uint32_t read_uint32(const std::string& data, std::size_t offset)
+  {
+    std::uint32_t result{};
+    std::memcpy(&result, data.data() + offset, sizeof(result));
+    return result;
+  }
+
+  mesh_batch make_triangle()
+  {
+    mesh_batch result;
+    result.object_name = "triangle";
+    result.material_index = 0;
+    result.vertices = {
+      mesh_vertex{ { 0, 0, 0 }, { 0, 0 }, { 0, 0, 1 } },
+      mesh_vertex{ { 1, 0, 0 }, { 1, 0 }, { 0, 0, 1 } },
+      mesh_vertex{ { 0, 2, 0 }, { 0, 1 }, { 0, 0, 1 } }
+    };
+    result.indexes = std::vector<std::uint16_t>{ 0, 1, 2 };
+    return result;
+  }
+}// namespace
+
+TEST_CASE("A GLB file has a JSON chunk followed by one binary chunk", "[gltf]")
+{
+  std::vector<mesh_batch> batches{ make_triangle() };
+
+  gltf::glb_writer writer;
+  writer.add_material("red", std::nullopt, { 1, 0, 0, 1 });
+  auto mesh_index = writer.add_mesh("triangle", std::span<const mesh_batch>(batches));
+  auto node_index = writer.add_node(gltf::node{ "root", mesh_index });
+  writer.add_scene("default", { node_index });
+  writer.add_animation("move", { gltf::animation_channel{ node_index, gltf::animation_path::translation, { 0, 1 }, { 0, 0, 0, 1, 0, 0 } } });
+
+  std::stringstream output;
+  writer.write(output);
+  auto data = output.str();
+
+  REQUIRE(read_uint32(data, 0) == 0x46546C67);
+  REQUIRE(read_uint32(data, 4) == 2);
+  REQUIRE(read_uint32(data, 8) == data.size());
+
+  auto json_length = read_uint32(data, 12);
+  REQUIRE(json_length % 4 == 0);
+  REQUIRE(read_uint32(data, 16) == 0x4E4F534A);
+
+  auto document = nlohmann::json::parse(data.substr(20, json_length));
+
+  auto bin_offset = 20 + json_length;
+  auto bin_length = read_uint32(data, bin_offset);
+  REQUIRE(read_uint32(data, bin_offset + 4) == 0x004E4942);
+  REQUIRE(bin_length % 4 == 0);
+  REQUIRE(bin_offset + 8 + bin_length == data.size());
+  REQUIRE(document["buffers"][0]["byteLength"] == bin_length);
+
+  SECTION("Vertices are written as they are in the batch")
+  {
+    const auto& primitive = document["meshes"][0]["primitives"][0];
+    REQUIRE(primitive["material"] == 0);
+
+    const auto& position = document["accessors"][primitive["attributes"]["POSITION"].get<std::size_t>()];
+    REQUIRE(position["count"] == 3);
+    REQUIRE(position["max"][1] == 2.0f);
+
+    const auto& view = document["bufferViews"][position["bufferView"].get<std::size_t>()];
+    REQUIRE(view["byteStride"] == sizeof(mesh_vertex));
+
+    auto vertex_offset = bin_offset + 8 + view["byteOffset"].get<std::size_t>();
+    REQUIRE(std::memcmp(data.data() + vertex_offset, batches[0].vertices.data(), sizeof(mesh_vertex) * 3) == 0);
+
+    const auto& indexes = document["accessors"][primitive["indices"].get<std::size_t>()];
+    REQUIRE(indexes["componentType"] == 5123);
+    REQUIRE(indexes["count"] == 3);
+  }
+
+  SECTION("Animations point at the node they move")
+  {
+    const auto& animation = document["animations"][0];
+    REQUIRE(animation["name"] == "move");
+    REQUIRE(animation["channels"][0]["target"]["node"] == node_index);
+    REQUIRE(animation["channels"][0]["target"]["path"] == "translation");
+
+    const auto& times = document["accessors"][animation["samplers"][0]["input"].get<std::size_t>()];
+    REQUIRE(times["count"] == 2);
+    REQUIRE(times["max"][0] == 1.0f);
+  }
+
+  SECTION("Every view starts on a four byte boundary")
+  {
+    for (const auto& view : document["bufferViews"])
+    {
+      REQUIRE(view["byteOffset"].get<std::size_t>() % 4 == 0);
+    }
+  }
+}
+
+TEST_CASE("Animation channels need one value per keyframe", "[gltf]")
+{
+  gltf::glb_writer writer;
+  auto node_index = writer.add_node(gltf::node{ "root" });
+
+  REQUIRE_THROWS_AS(writer.add_animation("broken", { gltf::animation_channel{ node_index, gltf::animation_path::rotation, { 0, 1 }, { 0, 0, 0, 1 } } }), std::invalid_argument);
+}
@@ -0,0 +1,236 @@
+#include <charconv>
+#include <cmath>
+#include <stdexcept>
+#include <siege/content/json_stream.hpp>
+
+namespace siege::content
+{
+  // Big enough that the output stream is only written to now and then, even for shapes with many thousands of vertices.
+  constexpr std::size_t buffer_size = 64 * 1024;
+  constexpr std::size_t indent_size = 4;
+
+  json_stream_writer::json_stream_writer(std::ostream& output, json_style style)
+    : output(output), style(style)
+  {
+    buffer.reserve(buffer_size + 256);
+  }
+
+  json_stream_writer::~json_stream_writer()
+  {
+    flush();
+  }
+
+  void json_stream_writer::flush()
+  {
+    output.write(buffer.data(), std::streamsize(buffer.size()));
+    buffer.clear();
+  }
+
+  void json_stream_writer::new_line(std::size_t depth)
+  {
+    if (style == json_style::pretty)
+    {
+      buffer.push_back('\n');
+      buffer.append(depth * indent_size, ' ');
+    }
+  }
+
+  void json_stream_writer::begin_value()
+  {
+    if (buffer.size() >= buffer_size)
+    {
+      flush();
+    }
+
+    if (after_key)
+    {
+      after_key = false;
+      return;
+    }
+
+    if (levels.empty())
+    {
+      return;
+    }
+
+    if (levels.back().count++ > 0)
+    {
+      buffer.push_back(',');
+    }
+
+    new_line(levels.size());
+  }
+
+  void json_stream_writer::begin_container(char bracket, bool is_object)
+  {
+    begin_value();
+    buffer.push_back(bracket);
+    levels.emplace_back(level{ is_object, 0 });
+  }
+
+  void json_stream_writer::end_container(char bracket)
+  {
+    if (levels.empty())
+    {
+      throw std::logic_error("There is no object or array to end");
+    }
+
+    const auto count = levels.back().count;
+    levels.pop_back();
+
+    // Empty objects and arrays stay on one line, as {} and [].
+    if (count > 0)
+    {
+      new_line(levels.size());
+    }
+
+    buffer.push_back(bracket);
+  }
+
+  void json_stream_writer::begin_object()
+  {
+    begin_container('{', true);
+  }
+
+  void json_stream_writer::end_object()
+  {
+    end_container('}');
+  }
+
+  void json_stream_writer::begin_array()
+  {
+    begin_container('[', false);
+  }
+
+  void json_stream_writer::end_array()
+  {
+    end_container(']');
+  }
+
+  void json_stream_writer::key(std::string_view name)
+  {
+    if (levels.empty() || !levels.back().is_object)
+    {
+      throw std::logic_error("Keys can only be written inside of an object");
+    }
+
+    begin_value();
+    write_string(name);
+    buffer.append(style == json_style::pretty ? ": " : ":");
+    after_key = true;
+  }
+
+  void json_stream_writer::null()
+  {
+    begin_value();
+    buffer.append("null");
+  }
+
+  void json_stream_writer::value(bool item)
+  {
+    begin_value();
+    buffer.append(item ? "true" : "false");
+  }
+
+  void json_stream_writer::value(std::int64_t item)
+  {
+    begin_value();
+    std::array<char, 24> text;
+    auto result = std::to_chars(text.data(), text.data() + text.size(), item);
+    buffer.append(text.data(), result.ptr);
+  }
+
+  void json_stream_writer::value(std::uint64_t item)
+  {
+    begin_value();
+    std::array<char, 24> text;
+    auto result = std::to_chars(text.data(), text.data() + text.size(), item);
+    buffer.append(text.data(), result.ptr);
+  }
+
+  void json_stream_writer::value(float item)
+  {
+    write_float(item, true);
+  }
+
+  void json_stream_writer::value(double item)
+  {
+    write_float(item, false);
+  }
+
+  void json_stream_writer::write_float(double item, bool is_single)
+  {
+    if (!std::isfinite(item))
+    {
+      null();
+      return;
+    }
+
+    begin_value();
+    std::array<char, 32> text;
+    auto result = is_single ? std::to_chars(text.data(), text.data() + text.size(), float(item)) : std::to_chars(text.data(), text.data() + text.size(), item);
+    std::string_view written(text.data(), result.ptr);
+    buffer.append(written);
+
+    // Whole numbers keep a decimal point, so that they are still read back as floats.
+    if (written.find_first_of(".e") == std::string_view::npos)
+    {
+      buffer.append(".0");
+    }
+  }
+
+  void json_stream_writer::value(std::string_view item)
+  {
+    begin_value();
+    write_string(item);
+  }
+
+  void json_stream_writer::write_string(std::string_view item)
+  {
+    constexpr static std::string_view hex_digits = "0123456789abcdef";
+
+    buffer.push_back('"');
+
+    for (auto character : item)
+    {
+      switch (character)
+      {
+      case '"':
+        buffer.append("\\\"");
+        break;
+      case '\\':
+        buffer.append("\\\\");
+        break;
+      case '\b':
+        buffer.append("\\b");
+        break;
+      case '\f':
+        buffer.append("\\f");
+        break;
+      case '\n':
+        buffer.append("\\n");
+        break;
+      case '\r':
+        buffer.append("\\r");
+        break;
+      case '\t':
+        buffer.append("\\t");
+        break;
+      default:
+        if (std::uint8_t(character) < 0x20)
+        {
+          buffer.append("\\u00");
+          buffer.push_back(hex_digits[std::uint8_t(character) >> 4]);
+          buffer.push_back(hex_digits[std::uint8_t(character) & 0x0f]);
+        }
+        else
+        {
+          buffer.push_back(character);
+        }
+        break;
+      }
+    }
+
+    buffer.push_back('"');
+  }
+}// namespace siege::content
@@ -0,0 +1,108 @@
+#include <sstream>
+#include <catch2/catch_test_macros.hpp>
+#include <siege/content/json_boost.hpp>
+#include <siege/content/dts/complex_serializer.hpp>
+#include <siege/content/json_stream.hpp>
+
+using namespace siege::content;
+
+namespace json_stream_test
+{
+  using siege::content::to_json;
+  namespace endian = siege::platform;
+
+  struct point
+  {
+    KEYS_CONSTEXPR static auto keys = siege::platform::make_keys({ "x", "y", "z" });
+    float x;
+    float y;
+    endian::little_int16_t z;
+  };
+
+  struct named_points
+  {
+    KEYS_CONSTEXPR static auto keys = siege::platform::make_keys({ "name", "flags", "points", "tag", "empty" });
+    std::array<char, 8> name;
+    std::byte flags;
+    std::vector<point> points;
+    std::array<endian::little_uint16_t, 2> tag;
+    std::vector<std::int32_t> empty;
+  };
+
+  struct first_kind
+  {
+    constexpr static auto type_name = std::string_view{ "Test::First" };
+    constexpr static auto version = 1;
+    KEYS_CONSTEXPR static auto keys = siege::platform::make_keys({ "value" });
+    endian::little_int32_t value;
+  };
+
+  struct second_kind
+  {
+    constexpr static auto type_name = std::string_view{ "Test::Second" };
+    constexpr static auto version = 2;
+    KEYS_CONSTEXPR static auto keys = siege::platform::make_keys({ "label", "points" });
+    std::array<char, 16> label;
+    named_points points;
+  };
+
+  using kind = std::variant<first_kind, second_kind>;
+
+  named_points make_points()
+  {
+    return named_points{ { "quad\t1" }, std::byte{ 7 }, { { 0.5f, -2, 3 }, { 1.25f, 4, -5 } }, { 1, 2 }, {} };
+  }
+}// namespace json_stream_test
+
+TEST_CASE("Pretty JSON is the same as what nlohmann::json writes", "[json_stream]")
+{
+  std::vector<json_stream_test::kind> items{ json_stream_test::first_kind{ -10 }, json_stream_test::second_kind{ { "second" }, json_stream_test::make_points() } };
+
+  nlohmann::ordered_json document = items;
+
+  std::ostringstream output;
+  {
+    json_stream_writer writer(output);
+    write_json(writer, items);
+  }
+
+  REQUIRE(output.str() == document.dump(4));
+}
+
+TEST_CASE("Compact JSON writes structs of numbers as flat arrays", "[json_stream]")
+{
+  std::ostringstream output;
+  {
+    json_stream_writer writer(output, json_style::compact);
+    write_json(writer, json_stream_test::make_points());
+  }
+
+  REQUIRE(output.str() == R"({"name":"quad\t1","flags":7,"points":[0.5,-2.0,3,1.25,4.0,-5],"tag":[1,2],"empty":[]})");
+}
+
+TEST_CASE("Floats are written as the shortest text which reads back the same", "[json_stream]")
+{
+  std::ostringstream output;
+  {
+    json_stream_writer writer(output, json_style::compact);
+    writer.begin_array();
+    writer.value(0.1f);
+    writer.value(1e20f);
+    writer.value(std::numeric_limits<float>::quiet_NaN());
+    writer.end_array();
+  }
+
+  REQUIRE(output.str() == "[0.1,1e+20,null]");
+
+  auto parsed = nlohmann::json::parse(output.str());
+  REQUIRE(parsed[0].get<float>() == 0.1f);
+}
+
+TEST_CASE("Keys outside of an object and unbalanced ends are errors", "[json_stream]")
+{
+  std::ostringstream output;
+  json_stream_writer writer(output);
+
+  REQUIRE_THROWS_AS(writer.key("name"), std::logic_error);
+  REQUIRE_THROWS_AS(writer.end_array(), std::logic_error);
+}
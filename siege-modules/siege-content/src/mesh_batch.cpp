@@ -0,0 +1,220 @@
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <unordered_map>
+#include <siege/content/mesh_batch.hpp>
+#include <siege/content/renderable_shape.hpp>
+
+namespace siege::content
+{
+  void mesh_batch_builder::begin_object(std::optional<std::string_view> node_name, std::string_view object_name, std::size_t vertex_key_count)
+  {
+    finish_object();
+    this->node_name = node_name.transform([](auto value) { return std::string(value); });
+    this->object_name = object_name;
+    this->vertex_key_count = vertex_key_count;
+  }
+
+  mesh_batch_builder::pending_batch& mesh_batch_builder::get_batch(std::int32_t material_index)
+  {
+    // Objects rarely have more than a handful of materials, so a linear search beats a map.
+    for (auto& pending : current)
+    {
+      if (pending.batch.material_index == material_index)
+      {
+        return pending;
+      }
+    }
+
+    auto& pending = current.emplace_back();
+    pending.batch.node_name = node_name;
+    pending.batch.object_name = object_name;
+    pending.batch.material_index = material_index;
+    pending.first_vertex.assign(vertex_key_count, no_vertex);
+    return pending;
+  }
+
+  std::uint32_t mesh_batch_builder::find_vertex(const pending_batch& pending, std::uint32_t vertex_key, std::uint32_t texture_key) const
+  {
+    if (vertex_key >= pending.first_vertex.size())
+    {
+      return no_vertex;
+    }
+
+    for (auto index = pending.first_vertex[vertex_key]; index != no_vertex; index = pending.next_vertex[index])
+    {
+      if (pending.texture_keys[index] == texture_key)
+      {
+        return index;
+      }
+    }
+
+    return no_vertex;
+  }
+
+  std::uint32_t mesh_batch_builder::add_vertex(pending_batch& pending, std::uint32_t vertex_key, std::uint32_t texture_key, const vector3f& position, const texture_vertex& texture_coordinate)
+  {
+    if (vertex_key >= pending.first_vertex.size())
+    {
+      pending.first_vertex.resize(std::max<std::size_t>(vertex_key + 1, pending.first_vertex.size() * 2), no_vertex);
+    }
+
+    auto index = std::uint32_t(pending.batch.vertices.size());
+    pending.batch.vertices.emplace_back(mesh_vertex{ position, texture_coordinate, vector3f{} });
+    pending.texture_keys.emplace_back(texture_key);
+    pending.next_vertex.emplace_back(pending.first_vertex[vertex_key]);
+    pending.first_vertex[vertex_key] = index;
+
+    return index;
+  }
+
+  void mesh_batch_builder::finish_object()
+  {
+    for (auto& pending : current)
+    {
+      if (pending.batch.vertices.size() <= std::size_t(std::numeric_limits<std::uint16_t>::max()) + 1)
+      {
+        pending.batch.indexes = std::vector<std::uint16_t>(pending.indexes.begin(), pending.indexes.end());
+      }
+      else
+      {
+        pending.batch.indexes = std::move(pending.indexes);
+      }
+
+      compute_normals(pending.batch);
+      results.emplace_back(std::move(pending.batch));
+    }
+
+    current.clear();
+  }
+
+  std::vector<mesh_batch> mesh_batch_builder::finish()
+  {
+    finish_object();
+    return std::move(results);
+  }
+
+  void compute_normals(mesh_batch& batch)
+  {
+    for (auto& vertex : batch.vertices)
+    {
+      vertex.normal = vector3f{};
+    }
+
+    std::visit([&](const auto& indexes) {
+      for (auto i = 0u; i + 2 < indexes.size(); i += 3)
+      {
+        auto& a = batch.vertices[indexes[i]];
+        auto& b = batch.vertices[indexes[i + 1]];
+        auto& c = batch.vertices[indexes[i + 2]];
+
+        auto edge1 = b.position - a.position;
+        auto edge2 = c.position - a.position;
+
+        // The cross product is as long as twice the area of the triangle, which weights each face for free.
+        vector3f normal{
+          edge1.y * edge2.z - edge1.z * edge2.y,
+          edge1.z * edge2.x - edge1.x * edge2.z,
+          edge1.x * edge2.y - edge1.y * edge2.x
+        };
+
+        a.normal += normal;
+        b.normal += normal;
+        c.normal += normal;
+      }
+    },
+      batch.indexes);
+
+    for (auto& vertex : batch.vertices)
+    {
+      auto length = std::sqrt(vertex.normal.x * vertex.normal.x + vertex.normal.y * vertex.normal.y + vertex.normal.z * vertex.normal.z);
+
+      if (length > 0)
+      {
+        vertex.normal = vector3f{ vertex.normal.x / length, vertex.normal.y / length, vertex.normal.z / length };
+      }
+    }
+  }
+
+  // Collects the triangles of shapes which only know how to draw themselves one vertex at a time.
+  // Vertices are merged when their position and texture coordinate are exactly the same.
+  struct batching_renderer final : shape_renderer
+  {
+    struct value_hash
+    {
+      template<typename Value>
+      std::size_t operator()(const Value& value) const
+      {
+        return std::hash<std::string_view>{}(std::string_view(reinterpret_cast<const char*>(&value), sizeof(value)));
+      }
+    };
+
+    // Compared by their bytes, to agree with the hash.
+    struct value_equal
+    {
+      template<typename Value>
+      bool operator()(const Value& left, const Value& right) const
+      {
+        return std::memcmp(&left, &right, sizeof(Value)) == 0;
+      }
+    };
+
+    mesh_batch_builder builder;
+    std::optional<std::string> node_name;
+    std::unordered_map<vector3f, std::uint32_t, value_hash, value_equal> position_keys;
+    std::unordered_map<texture_vertex, std::uint32_t, value_hash, value_equal> texture_keys;
+    std::vector<vector3f> positions;
+    std::vector<texture_vertex> texture_vertices;
+
+    void update_node(std::optional<std::string_view>, std::string_view node_name) override
+    {
+      this->node_name = std::string(node_name);
+    }
+
+    void update_object(std::optional<std::string_view> parent_node_name, std::string_view object_name) override
+    {
+      builder.begin_object(parent_node_name ? parent_node_name : node_name, object_name);
+      position_keys.clear();
+      texture_keys.clear();
+    }
+
+    void new_face(std::size_t) override
+    {
+      positions.clear();
+      texture_vertices.clear();
+    }
+
+    void emit_vertex(const vector3f& vertex) override
+    {
+      positions.emplace_back(vertex);
+    }
+
+    void emit_texture_vertex(const texture_vertex& vertex) override
+    {
+      texture_vertices.emplace_back(vertex);
+    }
+
+    void end_face() override
+    {
+      auto get_corner = [&](std::size_t index) {
+        auto texture = index < texture_vertices.size() ? texture_vertices[index] : texture_vertex{};
+        auto vertex_key = position_keys.emplace(positions[index], std::uint32_t(position_keys.size())).first->second;
+        auto texture_key = texture_keys.emplace(texture, std::uint32_t(texture_keys.size())).first->second;
+        return mesh_batch_builder::corner{ vertex_key, texture_key, positions[index], texture };
+      };
+
+      // Faces with more than three vertices are split into a fan.
+      for (auto i = 2u; i < positions.size(); ++i)
+      {
+        builder.add_triangle(-1, { get_corner(0), get_corner(i - 1), get_corner(i) });
+      }
+    }
+  };
+
+  std::vector<mesh_batch> renderable_shape::get_mesh_batches(const std::vector<std::size_t>& detail_level_indexes, const std::vector<sequence_info>& sequences) const
+  {
+    batching_renderer renderer;
+    render_shape(renderer, detail_level_indexes, sequences);
+    return renderer.builder.finish();
+  }
+}// namespace siege::content
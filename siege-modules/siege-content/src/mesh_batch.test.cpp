@@ -0,0 +1,142 @@
+#include <catch2/catch_test_macros.hpp>
+#include <siege/content/renderable_shape.hpp>
+
+using namespace siege::content;
+
+namespace
+{
+  mesh_batch_builder::corner make_corner(std::uint32_t vertex_key, std::uint32_t texture_key, float x, float y)
+  {
+    return mesh_batch_builder::corner{ vertex_key, texture_key, vector3f{ x, y, 0 }, texture_vertex{ x, y } };
+  }
+
+  // Draws a square as two triangles, one vertex at a time.
+  struct square_shape final : renderable_shape
+  {
+    std::vector<sequence_info> get_sequences(const std::vector<std::size_t>&) const override
+    {
+      return {};
+    }
+
+    std::vector<std::string> get_detail_levels() const override
+    {
+      return {};
+    }
+
+    std::vector<material> get_materials() const override
+    {
+      return {};
+    }
+
+    void render_shape(shape_renderer& renderer, const std::vector<std::size_t>&, const std::vector<sequence_info>&) const override
+    {
+      renderer.update_node(std::nullopt, "root");
+      renderer.update_object("root", "square");
+
+      std::array<std::array<vector3f, 3>, 2> faces{ { { { { 0, 0, 0 }, { 1, 0, 0 }, { 1, 1, 0 } } }, { { { 0, 0, 0 }, { 1, 1, 0 }, { 0, 1, 0 } } } } };
+
+      for (auto& face : faces)
+      {
+        renderer.new_face(3);
+
+        for (auto& vertex : face)
+        {
+          renderer.emit_vertex(vertex);
+        }
+
+        for (auto& vertex : face)
+        {
+          renderer.emit_texture_vertex(texture_vertex{ vertex.x, vertex.y });
+        }
+
+        renderer.end_face();
+      }
+    }
+  };
+}// namespace
+
+TEST_CASE("With corners that share keys, the batch shares their vertices", "[mesh_batch]")
+{
+  mesh_batch_builder builder;
+  builder.begin_object("root", "square", 4);
+  builder.add_triangle(0, { make_corner(0, 0, 0, 0), make_corner(1, 1, 1, 0), make_corner(2, 2, 1, 1) });
+  builder.add_triangle(0, { make_corner(0, 0, 0, 0), make_corner(2, 2, 1, 1), make_corner(3, 3, 0, 1) });
+
+  auto batches = builder.finish();
+
+  REQUIRE(batches.size() == 1);
+  REQUIRE(batches[0].node_name == "root");
+  REQUIRE(batches[0].object_name == "square");
+  REQUIRE(batches[0].vertices.size() == 4);
+  REQUIRE(batches[0].get_index_count() == 6);
+  REQUIRE(std::holds_alternative<std::vector<std::uint16_t>>(batches[0].indexes));
+  REQUIRE(batches[0].get_index(3) == 0);
+  REQUIRE(batches[0].get_index(4) == 2);
+
+  // Both triangles face towards positive z.
+  for (auto& vertex : batches[0].vertices)
+  {
+    REQUIRE(vertex.normal.z == 1.0f);
+  }
+}
+
+TEST_CASE("With the same vertex and a different texture vertex, the batch keeps both", "[mesh_batch]")
+{
+  mesh_batch_builder builder;
+  builder.begin_object(std::nullopt, "seam");
+  builder.add_triangle(0, { make_corner(0, 0, 0, 0), make_corner(1, 1, 1, 0), make_corner(2, 2, 1, 1) });
+  builder.add_triangle(0, { make_corner(0, 5, 0, 0), make_corner(2, 2, 1, 1), make_corner(3, 3, 0, 1) });
+
+  auto batches = builder.finish();
+
+  REQUIRE(batches.size() == 1);
+  REQUIRE(batches[0].vertices.size() == 5);
+}
+
+TEST_CASE("With several materials and objects, each pair gets its own batch", "[mesh_batch]")
+{
+  mesh_batch_builder builder;
+  builder.begin_object("root", "first");
+  builder.add_triangle(0, { make_corner(0, 0, 0, 0), make_corner(1, 1, 1, 0), make_corner(2, 2, 1, 1) });
+  builder.add_triangle(3, { make_corner(0, 0, 0, 0), make_corner(2, 2, 1, 1), make_corner(3, 3, 0, 1) });
+  builder.begin_object("root", "second");
+  builder.add_triangle(0, { make_corner(0, 0, 0, 0), make_corner(1, 1, 1, 0), make_corner(2, 2, 1, 1) });
+
+  auto batches = builder.finish();
+
+  REQUIRE(batches.size() == 3);
+  REQUIRE(batches[0].material_index == 0);
+  REQUIRE(batches[1].material_index == 3);
+  REQUIRE(batches[1].vertices.size() == 3);
+  REQUIRE(batches[2].object_name == "second");
+}
+
+TEST_CASE("With more vertices than 16 bits can index, the batch uses 32-bit indexes", "[mesh_batch]")
+{
+  mesh_batch_builder builder;
+  builder.begin_object(std::nullopt, "large");
+
+  for (auto i = 0u; i < 30000; ++i)
+  {
+    builder.add_triangle(0, { make_corner(i * 3, 0, 0, 0), make_corner(i * 3 + 1, 0, 1, 0), make_corner(i * 3 + 2, 0, 1, 1) });
+  }
+
+  auto batches = builder.finish();
+
+  REQUIRE(batches[0].vertices.size() == 90000);
+  REQUIRE(std::holds_alternative<std::vector<std::uint32_t>>(batches[0].indexes));
+  REQUIRE(batches[0].get_index(89999) == 89999);
+}
+
+TEST_CASE("With a shape that only renders vertices, the default batches merge identical ones", "[mesh_batch]")
+{
+  square_shape shape;
+  auto batches = shape.get_mesh_batches({}, {});
+
+  REQUIRE(batches.size() == 1);
+  REQUIRE(batches[0].node_name == "root");
+  REQUIRE(batches[0].object_name == "square");
+  REQUIRE(batches[0].material_index == -1);
+  REQUIRE(batches[0].vertices.size() == 4);
+  REQUIRE(batches[0].get_index_count() == 6);
+}
@@ -0,0 +1,242 @@
+#include <bit>
+#include <charconv>
+#include <filesystem>
+#include <siege/content/obj_renderer.hpp>
+#include <siege/content/bmp/png.hpp>
+
+namespace siege::content
+{
+  obj_writer::obj_writer(std::ostream& output, std::size_t buffer_size)
+    : output(output), buffer_size(buffer_size)
+  {
+    buffer.reserve(buffer_size + 256);
+  }
+
+  obj_writer::~obj_writer()
+  {
+    flush();
+  }
+
+  void obj_writer::flush()
+  {
+    output.write(buffer.data(), std::streamsize(buffer.size()));
+    buffer.clear();
+  }
+
+  void obj_writer::reserve(std::size_t size)
+  {
+    if (buffer.size() + size > buffer_size)
+    {
+      flush();
+    }
+  }
+
+  std::size_t obj_writer::key_hash::operator()(const key& value) const noexcept
+  {
+    std::uint64_t result = 0xcbf29ce484222325;
+
+    for (auto part : value)
+    {
+      result = (result ^ part) * 0x100000001b3;
+    }
+
+    return std::size_t(result ^ (result >> 32));
+  }
+
+  obj_writer::key obj_writer::to_key(float x, float y, float z)
+  {
+    return { std::bit_cast<std::uint32_t>(x + 0.0f), std::bit_cast<std::uint32_t>(y + 0.0f), std::bit_cast<std::uint32_t>(z + 0.0f) };
+  }
+
+  void obj_writer::write_floats(std::string_view prefix, std::span<const float> values)
+  {
+    reserve(prefix.size() + values.size() * 32);
+    buffer.append(prefix);
+
+    std::array<char, 32> text;
+
+    for (auto value : values)
+    {
+      auto [end, error] = std::to_chars(text.data(), text.data() + text.size(), value);
+      buffer.push_back(' ');
+      buffer.append(text.data(), end);
+    }
+
+    buffer.push_back('\n');
+  }
+
+  void obj_writer::write_index(std::uint32_t value)
+  {
+    std::array<char, 16> text;
+    auto [end, error] = std::to_chars(text.data(), text.data() + text.size(), value);
+    buffer.append(text.data(), end);
+  }
+
+  void obj_writer::write_material_library(std::string_view filename)
+  {
+    reserve(filename.size() + 8);
+    buffer.append("mtllib ").append(filename).push_back('\n');
+  }
+
+  void obj_writer::write_object(std::string_view name)
+  {
+    reserve(name.size() + 3);
+    buffer.append("o ").append(name).push_back('\n');
+  }
+
+  void obj_writer::use_material(std::string_view name)
+  {
+    reserve(name.size() + 8);
+    buffer.append("usemtl ").append(name).push_back('\n');
+  }
+
+  std::uint32_t obj_writer::add_position(const vector3f& position)
+  {
+    auto [existing, added] = positions.try_emplace(to_key(position.x, position.y, position.z), std::uint32_t(positions.size() + 1));
+
+    if (added)
+    {
+      write_floats("v", std::array<float, 3>{ position.x, position.y, position.z });
+    }
+
+    return existing->second;
+  }
+
+  std::uint32_t obj_writer::add_texture_vertex(const texture_vertex& vertex)
+  {
+    auto [existing, added] = texture_vertices.try_emplace(to_key(vertex.x, vertex.y, 0), std::uint32_t(texture_vertices.size() + 1));
+
+    if (added)
+    {
+      write_floats("vt", std::array<float, 2>{ vertex.x, vertex.y });
+    }
+
+    return existing->second;
+  }
+
+  std::uint32_t obj_writer::add_normal(const vector3f& normal)
+  {
+    auto [existing, added] = normals.try_emplace(to_key(normal.x, normal.y, normal.z), std::uint32_t(normals.size() + 1));
+
+    if (added)
+    {
+      write_floats("vn", std::array<float, 3>{ normal.x, normal.y, normal.z });
+    }
+
+    return existing->second;
+  }
+
+  void obj_writer::write_face(std::span<const corner> corners)
+  {
+    reserve(2 + corners.size() * 36);
+    buffer.push_back('f');
+
+    for (const auto& item : corners)
+    {
+      buffer.push_back(' ');
+      write_index(item.position);
+
+      if (item.texture_vertex == 0 && item.normal == 0)
+      {
+        continue;
+      }
+
+      buffer.push_back('/');
+
+      if (item.texture_vertex != 0)
+      {
+        write_index(item.texture_vertex);
+      }
+
+      if (item.normal != 0)
+      {
+        buffer.push_back('/');
+        write_index(item.normal);
+      }
+    }
+
+    buffer.push_back('\n');
+  }
+
+  void obj_writer::write_batches(std::span<const mesh_batch> batches, std::span<const std::string> material_names)
+  {
+    std::vector<corner> corners;
+
+    for (const auto& batch : batches)
+    {
+      write_object(batch.object_name);
+
+      if (batch.material_index >= 0 && std::size_t(batch.material_index) < material_names.size())
+      {
+        use_material(material_names[batch.material_index]);
+      }
+
+      // Batch vertices are already shared within the batch, so each one is only looked up once.
+      corners.resize(batch.vertices.size());
+
+      for (auto i = 0u; i < batch.vertices.size(); ++i)
+      {
+        const auto& vertex = batch.vertices[i];
+        corners[i] = corner{ add_position(vertex.position), add_texture_vertex(vertex.texture_coordinate), add_normal(vertex.normal) };
+      }
+
+      std::visit([&](const auto& indexes) {
+        for (auto i = 0u; i + 2 < indexes.size(); i += 3)
+        {
+          std::array<corner, 3> face{ corners[indexes[i]], corners[indexes[i + 1]], corners[indexes[i + 2]] };
+          write_face(face);
+        }
+      },
+        batch.indexes);
+    }
+  }
+
+  std::string get_material_name(std::size_t index, const material& value)
+  {
+    auto result = "material_" + std::to_string(index);
+
+    if (!value.filename.empty())
+    {
+      result += "_" + std::filesystem::path(value.filename).stem().string();
+    }
+
+    return result;
+  }
+
+  void write_mtl(std::ostream& output, std::span<const material> materials)
+  {
+    std::string buffer;
+    std::array<char, 32> text;
+
+    auto append_float = [&](float value) {
+      auto [end, error] = std::to_chars(text.data(), text.data() + text.size(), value);
+      buffer.push_back(' ');
+      buffer.append(text.data(), end);
+    };
+
+    for (auto i = 0u; i < materials.size(); ++i)
+    {
+      const auto& item = materials[i];
+      buffer.append("newmtl ").append(get_material_name(i, item)).push_back('\n');
+
+      if (!item.filename.empty())
+      {
+        auto texture = std::filesystem::path(item.filename);
+        buffer.append("Kd 1 1 1\nmap_Kd ").append((texture.parent_path() / bmp::get_png_filename(texture)).string()).push_back('\n');
+      }
+      else if (auto rgb = item.metadata.find("rgbData"); rgb != item.metadata.end() && std::holds_alternative<rgb_data>(rgb->second))
+      {
+        const auto& colour = std::get<rgb_data>(rgb->second);
+        buffer.append("Kd");
+        append_float(float(colour.red) / 255);
+        append_float(float(colour.green) / 255);
+        append_float(float(colour.blue) / 255);
+        buffer.push_back('\n');
+      }
+
+      buffer.push_back('\n');
+    }
+
+    output.write(buffer.data(), std::streamsize(buffer.size()));
+  }
+}// namespace siege::content
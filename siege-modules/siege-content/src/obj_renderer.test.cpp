@@ -0,0 +1,120 @@
+#include <sstream>
+#include <catch2/catch_test_macros.hpp>
+#include <siege/content/obj_renderer.hpp>
+#include <siege/content/bmp/png.hpp>
+
+using namespace siege::content;
+
+namespace
+{
+  std::size_t count_lines(const std::string& text, std::string_view prefix)
+  {
+    std::size_t result = 0;
+    std::istringstream stream(text);
+
+    for (std::string line; std::getline(stream, line);)
+    {
+      if (line.starts_with(prefix))
+      {
+        ++result;
+      }
+    }
+
+    return result;
+  }
+
+  // Two triangles of a square, in two batches which share an edge.
+  std::vector<mesh_batch> make_square()
+  {
+    std::vector<mesh_batch> results(2);
+
+    results[0].object_name = "first";
+    results[0].material_index = 0;
+    results[0].vertices = { { { 0, 0, 0 }, { 0, 0 }, { 0, 0, 1 } }, { { 0.1f, 0, 0 }, { 1, 0 }, { 0, 0, 1 } }, { { 0.1f, 0.1f, 0 }, { 1, 1 }, { 0, 0, 1 } } };
+    results[0].indexes = std::vector<std::uint16_t>{ 0, 1, 2 };
+
+    results[1].object_name = "second";
+    results[1].material_index = 1;
+    results[1].vertices = { { { 0, 0, 0 }, { 0, 0 }, { 0, 0, 1 } }, { { 0.1f, 0.1f, 0 }, { 1, 1 }, { 0, 0, 1 } }, { { -0.0f, 0.1f, 0 }, { 0, 1 }, { 0, 0, 1 } } };
+    results[1].indexes = std::vector<std::uint16_t>{ 0, 1, 2 };
+
+    return results;
+  }
+}// namespace
+
+TEST_CASE("Vertices which are the same are only written once", "[obj]")
+{
+  auto batches = make_square();
+  std::vector<std::string> material_names{ "red", "blue" };
+
+  std::ostringstream output;
+
+  {
+    obj_writer writer(output);
+    writer.write_material_library("square.mtl");
+    writer.write_batches(batches, material_names);
+  }
+
+  auto text = output.str();
+
+  REQUIRE(text.starts_with("mtllib square.mtl\n"));
+  REQUIRE(count_lines(text, "v ") == 4);
+  REQUIRE(count_lines(text, "vt ") == 4);
+  REQUIRE(count_lines(text, "vn ") == 1);
+  REQUIRE(count_lines(text, "f ") == 2);
+  REQUIRE(count_lines(text, "usemtl ") == 2);
+
+  SECTION("Numbers use the shortest text which reads back the same")
+  {
+    REQUIRE(text.find("v 0.1 0.1 0\n") != std::string::npos);
+  }
+
+  SECTION("Faces refer to the welded vertices")
+  {
+    REQUIRE(text.find("f 1/1/1 2/2/1 3/3/1\n") != std::string::npos);
+    REQUIRE(text.find("f 1/1/1 3/3/1 4/4/1\n") != std::string::npos);
+  }
+}
+
+TEST_CASE("Small buffers are flushed as they fill up", "[obj]")
+{
+  auto batches = make_square();
+  std::ostringstream small_output;
+  std::ostringstream large_output;
+
+  {
+    obj_writer small_writer(small_output, 16);
+    obj_writer large_writer(large_output);
+    small_writer.write_batches(batches, {});
+    large_writer.write_batches(batches, {});
+  }
+
+  REQUIRE(small_output.str() == large_output.str());
+  REQUIRE(count_lines(small_output.str(), "usemtl ") == 0);
+}
+
+TEST_CASE("Materials use their texture or their colour", "[obj]")
+{
+  std::vector<material> materials(2);
+  materials[0].filename = "tank.bmp";
+  materials[1].metadata.emplace("rgbData", rgb_data{ 255, 0, 0, 0 });
+
+  std::ostringstream output;
+  write_mtl(output, materials);
+  auto text = output.str();
+
+  REQUIRE(text.find("newmtl material_0_tank\n") != std::string::npos);
+  REQUIRE(text.find("map_Kd tank.png\n") != std::string::npos);
+  REQUIRE(text.find("newmtl material_1\nKd 1 0 0\n") != std::string::npos);
+}
+
+TEST_CASE("Textures from bitmaps with many frames point at the PNG of the first frame", "[obj]")
+{
+  std::vector<material> materials(1);
+  materials[0].filename = "sky.pba";
+
+  std::ostringstream output;
+  write_mtl(output, materials);
+
+  REQUIRE(output.str().find("map_Kd " + bmp::get_png_filename("sky.pba", 0).string() + "\n") != std::string::npos);
+}
@@ -17,3 +17,36 @@ TEST_CASE("Phoenix PAL is detected correctly", "[pal.darkstar]")
   REQUIRE(siege::content::pal::is_phoenix_pal(mem_buffer) == true);
   REQUIRE(mem_buffer.tellg() == 0);
 }
+
+TEST_CASE("Remap table uses exact matches first and the closest colour otherwise", "[pal.remap]")
+{
+  namespace pal = siege::content::pal;
+  namespace palette = siege::platform::palette;
+
+  std::vector<pal::colour> original = {
+    { std::byte{ 0 }, std::byte{ 0 }, std::byte{ 0 }, std::byte{ 0 } },
+    { std::byte{ 250 }, std::byte{ 10 }, std::byte{ 10 }, std::byte{ 0 } },
+    { std::byte{ 0 }, std::byte{ 0 }, std::byte{ 255 }, std::byte{ 0 } },
+    { std::byte{ 5 }, std::byte{ 5 }, std::byte{ 5 }, std::byte{ 0 } },
+  };
+
+  std::vector<pal::colour> other = {
+    { std::byte{ 0 }, std::byte{ 0 }, std::byte{ 250 }, std::byte{ 0 } },
+    { std::byte{ 255 }, std::byte{ 0 }, std::byte{ 0 }, std::byte{ 0 } },
+    { std::byte{ 0 }, std::byte{ 0 }, std::byte{ 0 }, std::byte{ 0 } },
+    { std::byte{ 128 }, std::byte{ 128 }, std::byte{ 128 }, std::byte{ 0 } },
+  };
+
+  auto table = palette::make_remap_table(original, other);
+  REQUIRE(table == std::vector<std::size_t>{ 2, 1, 0, 2 });
+
+  auto unique_table = palette::make_remap_table(original, other, true);
+  REQUIRE(unique_table == std::vector<std::size_t>{ 2, 1, 0, 3 });
+
+  REQUIRE(palette::get_remap_table(original, other).get() == palette::get_remap_table(original, other).get());
+
+  std::vector<std::byte> pixels = { std::byte{ 3 }, std::byte{ 1 }, std::byte{ 200 }, std::byte{ 2 } };
+  std::vector<std::byte> output(pixels.size());
+  palette::apply_remap_table(table, pixels, output);
+  REQUIRE(output == std::vector<std::byte>{ std::byte{ 2 }, std::byte{ 1 }, std::byte{ 0 }, std::byte{ 0 } });
+}
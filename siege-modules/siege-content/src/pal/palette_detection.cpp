@@ -0,0 +1,369 @@
+#include <algorithm>
+#include <cmath>
+#include <execution>
+#include <fstream>
+#include <limits>
+#include <mutex>
+#include <siege/content/pal/palette_detection.hpp>
+#include <siege/content/bmp/bitmap.hpp>
+#include <siege/platform/stream.hpp>
+#include "palette_index_io.hpp"
+
+namespace siege::content::pal
+{
+  namespace fs = std::filesystem;
+  using namespace index_io;
+  using mapping_tag = std::array<std::byte, 4>;
+
+  constexpr mapping_tag palette_mapping_tag = platform::to_tag<4>({ 'S', 'P', 'M', 'P' });
+  constexpr std::uint32_t palette_mapping_version = 1;
+
+  struct indexed_frame
+  {
+    std::size_t width;
+    std::size_t height;
+    std::span<const std::byte> pixels;
+  };
+
+  // How often each pair of different indexes sits next to each other.
+  // The right palette makes neighbouring pixels look alike, so this is all that is needed to score a palette.
+  using neighbour_histogram = std::vector<std::pair<std::uint16_t, std::uint32_t>>;
+
+  static neighbour_histogram get_neighbour_histogram(std::span<const indexed_frame> frames)
+  {
+    std::vector<std::uint32_t> counts(256 * 256);
+
+    auto add_pair = [&](std::byte a, std::byte b) {
+      if (a != b)
+      {
+        auto low = std::min(a, b);
+        auto high = std::max(a, b);
+        counts[std::size_t(low) * 256 + std::size_t(high)]++;
+      }
+    };
+
+    for (auto& frame : frames)
+    {
+      if (frame.pixels.size() < frame.width * frame.height)
+      {
+        continue;
+      }
+
+      for (auto y = 0u; y < frame.height; ++y)
+      {
+        auto row = frame.pixels.subspan(y * frame.width, frame.width);
+
+        for (auto x = 1u; x < row.size(); ++x)
+        {
+          add_pair(row[x - 1], row[x]);
+        }
+
+        if (y > 0)
+        {
+          auto previous = frame.pixels.subspan((y - 1) * frame.width, frame.width);
+
+          for (auto x = 0u; x < row.size(); ++x)
+          {
+            add_pair(previous[x], row[x]);
+          }
+        }
+      }
+    }
+
+    neighbour_histogram results;
+
+    for (auto i = 0u; i < counts.size(); ++i)
+    {
+      if (counts[i] != 0)
+      {
+        results.emplace_back(std::uint16_t(i), counts[i]);
+      }
+    }
+
+    return results;
+  }
+
+  static float get_histogram_score(const neighbour_histogram& histogram, std::span<const colour> colours)
+  {
+    static const auto max_distance = pal::colour_distance(colour{}, colour{ std::byte{ 255 }, std::byte{ 255 }, std::byte{ 255 }, std::byte{ 255 } });
+
+    double total = 0;
+    double count = 0;
+
+    for (auto [key, pair_count] : histogram)
+    {
+      auto a = std::size_t(key >> 8);
+      auto b = std::size_t(key & 0xff);
+
+      auto distance = a < colours.size() && b < colours.size() ? pal::colour_distance(colours[a], colours[b]) : max_distance;
+      total += distance * pair_count;
+      count += pair_count;
+    }
+
+    return count == 0 ? 1.0f : float(1.0 - (total / count) / max_distance);
+  }
+
+  std::vector<palette_entry> get_nearby_palettes(const palette_registry& registry, const fs::path& folder)
+  {
+    for (auto current = folder; !current.empty(); current = current.parent_path())
+    {
+      auto results = registry.get_palettes(current);
+
+      if (!results.empty())
+      {
+        auto shared_depth = [&](const palette_entry& entry) {
+          auto parent = entry.path.parent_path();
+          return std::distance(parent.begin(), std::mismatch(parent.begin(), parent.end(), folder.begin(), folder.end()).first);
+        };
+
+        std::stable_sort(results.begin(), results.end(), [&](auto& a, auto& b) { return shared_depth(a) > shared_depth(b); });
+        return results;
+      }
+
+      if (current == current.root_path())
+      {
+        break;
+      }
+    }
+
+    return {};
+  }
+
+  static std::optional<palette_assignment> detect_palette(const palette_registry& registry, const fs::path& bitmap, const palette_detection_settings& settings)
+  {
+    std::ifstream stream(bitmap, std::ios::binary);
+
+    if (!stream)
+    {
+      return std::nullopt;
+    }
+
+    std::optional<std::uint32_t> palette_index;
+    std::vector<bmp::pbmp_frame_layout> phoenix_frames;
+    std::vector<bmp::dbm_data> earthsiege_frames;
+
+    if (bmp::is_phoenix_bmp(stream) || bmp::is_phoenix_bmp_array(stream))
+    {
+      // Only the chunk headers are read here, and the pixels only if the histogram needs them.
+      phoenix_frames = bmp::get_pbmp_layout(stream);
+    }
+    else if (bmp::is_earthsiege_bmp(stream))
+    {
+      earthsiege_frames.emplace_back(bmp::read_earthsiege_bmp(stream));
+    }
+    else if (bmp::is_earthsiege_bmp_array(stream))
+    {
+      earthsiege_frames = bmp::read_earthsiege_bmp_array(stream);
+    }
+    else
+    {
+      return std::nullopt;
+    }
+
+    if (!phoenix_frames.empty())
+    {
+      palette_index = phoenix_frames.front().palette_index;
+    }
+
+    auto folder = bitmap.parent_path();
+    std::vector<palette_entry> candidates;
+
+    // Every candidate is scored, so each one is kept.
+    if (palette_index)
+    {
+      registry.find_by_index(*palette_index, folder, [&](const palette_entry& entry) {
+        candidates.emplace_back(entry);
+        return true;
+      });
+    }
+
+    if (candidates.empty())
+    {
+      candidates = get_nearby_palettes(registry, folder);
+    }
+
+    if (candidates.empty())
+    {
+      return std::nullopt;
+    }
+
+    auto best = candidates.begin();
+    float best_score = 1.0f;
+
+    if (settings.score_by_histogram && candidates.size() > 1)
+    {
+      std::vector<platform::bitmap::pixel_buffer> phoenix_pixels;
+      std::vector<indexed_frame> frames;
+      phoenix_pixels.reserve(phoenix_frames.size());
+
+      for (auto& frame : phoenix_frames)
+      {
+        if (frame.bmp_header.bit_depth == 8 && frame.data_size > 0)
+        {
+          auto& pixels = phoenix_pixels.emplace_back(bmp::read_pbmp_pixels(stream, frame));
+          frames.emplace_back(indexed_frame{ pixels.get_width(), pixels.get_height(), pixels.bytes() });
+        }
+      }
+
+      for (auto& frame : earthsiege_frames)
+      {
+        frames.emplace_back(indexed_frame{ frame.header.width, frame.header.height, frame.pixels });
+      }
+
+      auto histogram = get_neighbour_histogram(frames);
+      best_score = -1.0f;
+
+      auto last = candidates.begin() + std::min(candidates.size(), std::max<std::size_t>(settings.max_candidates, 1));
+
+      for (auto candidate = candidates.begin(); candidate != last; ++candidate)
+      {
+        auto score = get_histogram_score(histogram, candidate->colours);
+
+        // Candidates are ordered by how close they are, so the closer one wins a tie.
+        if (score > best_score)
+        {
+          best_score = score;
+          best = candidate;
+        }
+      }
+    }
+
+    return palette_assignment{ bitmap, best->path, best->position, best_score };
+  }
+
+  std::vector<palette_assignment> detect_palettes(const palette_registry& registry,
+    std::span<const fs::path> bitmaps,
+    palette_detection_settings settings)
+  {
+    std::vector<std::optional<palette_assignment>> detected(bitmaps.size());
+
+    std::transform(std::execution::par, bitmaps.begin(), bitmaps.end(), detected.begin(), [&](const fs::path& bitmap) -> std::optional<palette_assignment> {
+      try
+      {
+        return detect_palette(registry, bitmap, settings);
+      }
+      catch (...)
+      {
+        return std::nullopt;
+      }
+    });
+
+    std::vector<palette_assignment> results;
+    results.reserve(detected.size());
+
+    for (auto& item : detected)
+    {
+      if (item)
+      {
+        results.emplace_back(std::move(*item));
+      }
+    }
+
+    return results;
+  }
+
+  palette_mapping::palette_mapping(fs::path mapping_path) : mapping_path(std::move(mapping_path))
+  {
+    load();
+  }
+
+  void palette_mapping::load()
+  {
+    std::ifstream input(mapping_path, std::ios::binary);
+
+    if (!input)
+    {
+      return;
+    }
+
+    try
+    {
+      input.exceptions(std::ios::failbit | std::ios::badbit);
+      mapping_tag tag{};
+      platform::read(input, tag.data(), tag.size());
+
+      if (tag != palette_mapping_tag || read_int<std::uint32_t>(input) != palette_mapping_version)
+      {
+        return;
+      }
+
+      std::map<fs::path, palette_assignment> loaded;
+      auto count = read_int<std::uint32_t>(input);
+
+      for (auto i = 0u; i < count; ++i)
+      {
+        palette_assignment assignment{};
+        assignment.bitmap = read_path(input);
+        assignment.palette_path = read_path(input);
+        assignment.position = read_int<std::uint32_t>(input);
+        assignment.score = float(read_int<std::uint32_t>(input)) / std::numeric_limits<std::uint32_t>::max();
+        loaded.insert_or_assign(assignment.bitmap, std::move(assignment));
+      }
+
+      std::unique_lock lock(mutex);
+      assignments = std::move(loaded);
+    }
+    catch (...)
+    {
+      // A damaged mapping gets detected again rather than stopping anything from loading.
+    }
+  }
+
+  void palette_mapping::assign(std::span<const palette_assignment> new_assignments)
+  {
+    std::unique_lock lock(mutex);
+
+    for (auto& assignment : new_assignments)
+    {
+      assignments.insert_or_assign(assignment.bitmap, assignment);
+    }
+  }
+
+  std::optional<palette_assignment> palette_mapping::find(const fs::path& bitmap) const
+  {
+    std::shared_lock lock(mutex);
+
+    auto existing = assignments.find(bitmap);
+
+    if (existing == assignments.end())
+    {
+      return std::nullopt;
+    }
+
+    return existing->second;
+  }
+
+  std::size_t palette_mapping::size() const
+  {
+    std::shared_lock lock(mutex);
+    return assignments.size();
+  }
+
+  void palette_mapping::save() const
+  {
+    std::shared_lock lock(mutex);
+
+    std::error_code last_error;
+    fs::create_directories(mapping_path.parent_path(), last_error);
+
+    std::ofstream output(mapping_path, std::ios::binary | std::ios::trunc);
+
+    if (!output)
+    {
+      return;
+    }
+
+    platform::write(output, palette_mapping_tag.data(), palette_mapping_tag.size());
+    write_int<std::uint32_t>(output, palette_mapping_version);
+    write_int<std::uint32_t>(output, std::uint32_t(assignments.size()));
+
+    for (auto& [bitmap, assignment] : assignments)
+    {
+      write_path(output, bitmap);
+      write_path(output, assignment.palette_path);
+      write_int<std::uint32_t>(output, assignment.position);
+      // The score is stored as a fraction of the largest 32-bit value, to keep the format free of floats.
+      write_int<std::uint32_t>(output, std::uint32_t(std::clamp(assignment.score, 0.0f, 1.0f) * double(std::numeric_limits<std::uint32_t>::max())));
+    }
+  }
+}// namespace siege::content::pal
@@ -0,0 +1,77 @@
+#include <catch2/catch_test_macros.hpp>
+#include <fstream>
+#include <siege/content/pal/palette_detection.hpp>
+#include <siege/content/bmp/bitmap.hpp>
+
+namespace fs = std::filesystem;
+namespace pal = siege::content::pal;
+
+TEST_CASE("With two palettes sharing an index, histogram scoring picks the one which fits the pixels", "[pal.detection]")
+{
+  auto root = fs::temp_directory_path() / "palette_detection_test";
+  fs::remove_all(root);
+  fs::create_directories(root / "bitmaps");
+
+  std::vector<pal::colour> gradient(256);
+  std::vector<pal::colour> noise(256);
+
+  for (auto i = 0u; i < 256; ++i)
+  {
+    gradient[i] = pal::colour{ std::byte(i), std::byte(i), std::byte(i), std::byte{} };
+    noise[i] = pal::colour{ std::byte((i * 97) % 256), std::byte((i * 57) % 256), std::byte((i * 31) % 256), std::byte{} };
+  }
+
+  {
+    std::ofstream output(root / "a_noise.pal", std::ios::binary);
+    siege::platform::palette::write_pal_data(output, noise);
+  }
+
+  {
+    std::ofstream output(root / "b_gradient.pal", std::ios::binary);
+    siege::platform::palette::write_pal_data(output, gradient);
+  }
+
+  // A smooth ramp across the image only looks smooth with the gradient palette.
+  std::vector<std::byte> pixels(64 * 64);
+
+  for (auto i = 0u; i < pixels.size(); ++i)
+  {
+    pixels[i] = std::byte((i % 64) * 4);
+  }
+
+  auto bitmap_path = root / "bitmaps" / "ramp.bmp";
+
+  {
+    std::ofstream output(bitmap_path, std::ios::binary);
+    siege::content::bmp::write_pbmp_data(output, 64, 64, gradient, pixels, 0);
+  }
+
+  pal::palette_registry registry(root / "index" / "palettes.idx");
+  constexpr auto extensions = std::array<siege::fs_string_view, 1>{ { FSL".pal" } };
+  registry.scan(root, extensions, [](auto) { return std::set<fs::path>{}; }, [](auto) { return std::vector<char>{}; });
+
+  auto bitmaps = std::vector<fs::path>{ bitmap_path, root / "a_noise.pal" };
+
+  auto closest = pal::detect_palettes(registry, bitmaps);
+  REQUIRE(closest.size() == 1);
+  REQUIRE(closest[0].palette_path == root / "a_noise.pal");
+
+  auto scored = pal::detect_palettes(registry, bitmaps, { .score_by_histogram = true });
+  REQUIRE(scored.size() == 1);
+  REQUIRE(scored[0].palette_path == root / "b_gradient.pal");
+  REQUIRE(scored[0].score > 0.9f);
+
+  {
+    pal::palette_mapping mapping(root / "index" / "mapping.idx");
+    mapping.assign(scored);
+    mapping.save();
+  }
+
+  pal::palette_mapping reloaded(root / "index" / "mapping.idx");
+  auto found = reloaded.find(bitmap_path);
+  REQUIRE(found.has_value());
+  REQUIRE(found->palette_path == root / "b_gradient.pal");
+  REQUIRE(found->position == 0);
+
+  fs::remove_all(root);
+}
@@ -0,0 +1,42 @@
+#ifndef SIEGE_CONTENT_PALETTE_INDEX_IO_HPP
+#define SIEGE_CONTENT_PALETTE_INDEX_IO_HPP
+
+#include <filesystem>
+#include <string>
+#include <siege/platform/endian_arithmetic.hpp>
+#include <siege/platform/stream.hpp>
+
+// Shared by the palette index and the palette mapping, which are both saved as little endian binary files.
+namespace siege::content::pal::index_io
+{
+  template<typename IntType>
+  inline void write_int(std::ostream& output, IntType value)
+  {
+    platform::endian_int_t<std::endian::little, IntType> temp = value;
+    platform::write(output, reinterpret_cast<const char*>(&temp), sizeof(temp));
+  }
+
+  template<typename IntType>
+  inline IntType read_int(std::istream& input)
+  {
+    platform::endian_int_t<std::endian::little, IntType> temp{};
+    platform::read(input, reinterpret_cast<char*>(&temp), sizeof(temp));
+    return temp;
+  }
+
+  inline void write_path(std::ostream& output, const std::filesystem::path& path)
+  {
+    auto value = path.generic_u8string();
+    write_int<std::uint32_t>(output, std::uint32_t(value.size()));
+    platform::write(output, reinterpret_cast<const char*>(value.data()), value.size());
+  }
+
+  inline std::filesystem::path read_path(std::istream& input)
+  {
+    std::u8string value(read_int<std::uint32_t>(input), u8'\0');
+    platform::read(input, reinterpret_cast<char*>(value.data()), value.size());
+    return std::filesystem::path(value);
+  }
+}// namespace siege::content::pal::index_io
+
+#endif// SIEGE_CONTENT_PALETTE_INDEX_IO_HPP
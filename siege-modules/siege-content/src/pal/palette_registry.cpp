@@ -0,0 +1,391 @@
+#include <algorithm>
+#include <cstdlib>
+#include <execution>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <mutex>
+#include <spanstream>
+#include <siege/content/pal/palette_registry.hpp>
+#include <siege/platform/stream.hpp>
+#include "palette_index_io.hpp"
+
+namespace siege::content::pal
+{
+  namespace fs = std::filesystem;
+  using namespace index_io;
+  using index_tag = std::array<std::byte, 4>;
+
+  constexpr index_tag palette_index_tag = platform::to_tag<4>({ 'S', 'P', 'I', 'X' });
+  constexpr std::uint32_t palette_index_version = 1;
+
+  std::uint64_t get_colour_hash(std::span<const colour> colours)
+  {
+    // FNV-1a, which is plenty for telling palettes apart.
+    std::uint64_t hash = 14695981039346656037ull;
+
+    for (auto byte : std::as_bytes(colours))
+    {
+      hash ^= std::uint64_t(byte);
+      hash *= 1099511628211ull;
+    }
+
+    return hash;
+  }
+
+  fs::path get_default_palette_index_folder()
+  {
+#if WIN32
+    if (auto* local_app_data = std::getenv("LOCALAPPDATA"); local_app_data && *local_app_data)
+    {
+      return fs::path(local_app_data) / "open-siege";
+    }
+#else
+    if (auto* cache_home = std::getenv("XDG_CACHE_HOME"); cache_home && *cache_home)
+    {
+      return fs::path(cache_home) / "open-siege";
+    }
+
+    if (auto* home = std::getenv("HOME"); home && *home)
+    {
+      return fs::path(home) / ".cache" / "open-siege";
+    }
+#endif
+
+    // Only when there is no user to speak of, such as for services.
+    return fs::temp_directory_path() / "open-siege";
+  }
+
+  std::vector<palette_entry> get_palette_entries(const fs::path& path, std::istream& raw_data)
+  {
+    std::vector<palette_entry> results;
+
+    auto add_entry = [&](std::uint32_t index, std::vector<colour> colours) {
+      auto hash = get_colour_hash(colours);
+      results.emplace_back(palette_entry{ path, index, std::uint32_t(results.size()), hash, std::move(colours) });
+    };
+
+    if (platform::palette::is_microsoft_pal(raw_data))
+    {
+      add_entry(0, platform::palette::get_pal_data(raw_data));
+    }
+    else if (is_earthsiege_pal(raw_data))
+    {
+      add_entry(0, get_earthsiege_pal(raw_data));
+    }
+    else if (is_phoenix_pal(raw_data))
+    {
+      for (auto& palette : get_ppl_data(raw_data))
+      {
+        add_entry(palette.index, std::move(palette.colours));
+      }
+    }
+
+    return results;
+  }
+
+  // The number of leading path components which a and b have in common.
+  static std::size_t get_shared_depth(const fs::path& a, const fs::path& b)
+  {
+    auto [a_end, b_end] = std::mismatch(a.begin(), a.end(), b.begin(), b.end());
+    return std::size_t(std::distance(a.begin(), a_end));
+  }
+
+  static bool is_under(const fs::path& path, const fs::path& root)
+  {
+    return get_shared_depth(path, root) == std::size_t(std::distance(root.begin(), root.end()));
+  }
+
+  palette_registry::palette_registry(fs::path index_path) : index_path(std::move(index_path))
+  {
+    load();
+  }
+
+  void palette_registry::load()
+  {
+    std::ifstream input(index_path, std::ios::binary);
+
+    if (!input)
+    {
+      return;
+    }
+
+    try
+    {
+      input.exceptions(std::ios::failbit | std::ios::badbit);
+      index_tag tag{};
+      platform::read(input, tag.data(), tag.size());
+
+      if (tag != palette_index_tag || read_int<std::uint32_t>(input) != palette_index_version)
+      {
+        return;
+      }
+
+      std::map<fs::path, indexed_file> loaded;
+      auto file_count = read_int<std::uint32_t>(input);
+
+      for (auto i = 0u; i < file_count; ++i)
+      {
+        auto path = read_path(input);
+        auto& file = loaded[path];
+        file.size = read_int<std::uint64_t>(input);
+        file.last_write_time = read_int<std::int64_t>(input);
+        file.palettes.resize(read_int<std::uint32_t>(input));
+
+        for (auto& palette : file.palettes)
+        {
+          palette.path = read_path(input);
+          palette.index = read_int<std::uint32_t>(input);
+          palette.position = read_int<std::uint32_t>(input);
+          palette.colour_hash = read_int<std::uint64_t>(input);
+          palette.colours.resize(read_int<std::uint32_t>(input));
+          platform::read(input, reinterpret_cast<char*>(palette.colours.data()), palette.colours.size() * sizeof(colour));
+        }
+      }
+
+      std::unique_lock lock(mutex);
+      files = std::move(loaded);
+      rebuild_lookups();
+    }
+    catch (...)
+    {
+      // A damaged index is only a cache, so everything gets scanned again instead.
+    }
+  }
+
+  void palette_registry::save() const
+  {
+    std::shared_lock lock(mutex);
+
+    std::error_code last_error;
+    fs::create_directories(index_path.parent_path(), last_error);
+
+    std::ofstream output(index_path, std::ios::binary | std::ios::trunc);
+
+    if (!output)
+    {
+      return;
+    }
+
+    platform::write(output, palette_index_tag.data(), palette_index_tag.size());
+    write_int<std::uint32_t>(output, palette_index_version);
+    write_int<std::uint32_t>(output, std::uint32_t(files.size()));
+
+    for (auto& [path, file] : files)
+    {
+      write_path(output, path);
+      write_int<std::uint64_t>(output, file.size);
+      write_int<std::int64_t>(output, file.last_write_time);
+      write_int<std::uint32_t>(output, std::uint32_t(file.palettes.size()));
+
+      for (auto& palette : file.palettes)
+      {
+        write_path(output, palette.path);
+        write_int<std::uint32_t>(output, palette.index);
+        write_int<std::uint32_t>(output, palette.position);
+        write_int<std::uint64_t>(output, palette.colour_hash);
+        write_int<std::uint32_t>(output, std::uint32_t(palette.colours.size()));
+        platform::write(output, reinterpret_cast<const char*>(palette.colours.data()), palette.colours.size() * sizeof(colour));
+      }
+    }
+  }
+
+  void palette_registry::rebuild_lookups()
+  {
+    by_index.clear();
+    by_hash.clear();
+
+    for (auto& [path, file] : files)
+    {
+      for (auto& palette : file.palettes)
+      {
+        by_index.emplace(std::make_pair(palette.index, palette.path.parent_path()), &palette);
+        by_hash.emplace(palette.colour_hash, &palette);
+      }
+    }
+  }
+
+  bool palette_registry::scan(const fs::path& root,
+    std::span<const siege::fs_string_view> palette_extensions,
+    std::move_only_function<get_embedded_palettes> get_embedded,
+    std::move_only_function<resolve_embedded_palette> resolve_embedded,
+    int max_depth,
+    bool force)
+  {
+    {
+      std::shared_lock lock(mutex);
+
+      if (!force && std::any_of(scanned_roots.begin(), scanned_roots.end(), [&](auto& scanned) { return is_under(root, scanned); }))
+      {
+        return false;
+      }
+    }
+
+    struct pending_file
+    {
+      fs::path path;
+      indexed_file file;
+      bool is_palette;
+      bool is_cached;
+    };
+
+    std::vector<pending_file> found;
+    std::error_code last_error;
+
+    {
+      std::shared_lock lock(mutex);
+
+      for (auto entry = fs::recursive_directory_iterator(root, fs::directory_options::skip_permission_denied, last_error);
+           entry != fs::recursive_directory_iterator();
+           entry.increment(last_error))
+      {
+        if (last_error)
+        {
+          break;
+        }
+
+        if (entry.depth() > max_depth)
+        {
+          entry.disable_recursion_pending();
+          continue;
+        }
+
+        if (!entry->is_regular_file(last_error))
+        {
+          continue;
+        }
+
+        auto size = std::uint64_t(entry->file_size(last_error));
+        auto last_write_time = std::int64_t(entry->last_write_time(last_error).time_since_epoch().count());
+        auto is_palette = std::any_of(palette_extensions.begin(), palette_extensions.end(), [&](auto& ext) {
+          return entry->path().extension() == ext;
+        });
+
+        auto existing = files.find(entry->path());
+
+        if (existing != files.end() && existing->second.size == size && existing->second.last_write_time == last_write_time)
+        {
+          found.emplace_back(pending_file{ entry->path(), existing->second, is_palette, true });
+        }
+        else
+        {
+          found.emplace_back(pending_file{ entry->path(), indexed_file{ size, last_write_time, {} }, is_palette, false });
+        }
+      }
+    }
+
+    // Palette files are independent of each other, while the embedded ones go through callbacks which may not be thread safe.
+    std::for_each(std::execution::par, found.begin(), found.end(), [](pending_file& pending) {
+      if (pending.is_cached || !pending.is_palette)
+      {
+        return;
+      }
+
+      try
+      {
+        std::ifstream file_data(pending.path, std::ios::binary);
+        pending.file.palettes = get_palette_entries(pending.path, file_data);
+      }
+      catch (...)
+      {
+      }
+    });
+
+    for (auto& pending : found)
+    {
+      if (pending.is_cached || pending.is_palette)
+      {
+        continue;
+      }
+
+      for (auto& embedded_path : get_embedded(pending.path))
+      {
+        try
+        {
+          auto data = resolve_embedded(embedded_path);
+          std::spanstream span_data(data);
+          auto palettes = get_palette_entries(embedded_path, span_data);
+          std::move(palettes.begin(), palettes.end(), std::back_inserter(pending.file.palettes));
+        }
+        catch (...)
+        {
+        }
+      }
+    }
+
+    std::unique_lock lock(mutex);
+
+    // Anything under the root which was not found again has been removed from the disk.
+    std::erase_if(files, [&](auto& item) { return is_under(item.first, root); });
+
+    for (auto& pending : found)
+    {
+      files.insert_or_assign(std::move(pending.path), std::move(pending.file));
+    }
+
+    std::erase_if(scanned_roots, [&](auto& scanned) { return is_under(scanned, root); });
+    scanned_roots.emplace(root);
+    rebuild_lookups();
+
+    return true;
+  }
+
+  void palette_registry::find_by_index(std::uint32_t index, const fs::path& folder, const std::function<bool(const palette_entry&)>& visit) const
+  {
+    std::shared_lock lock(mutex);
+
+    auto last = index == std::numeric_limits<std::uint32_t>::max() ? by_index.end() : by_index.lower_bound(std::make_pair(index + 1, fs::path{}));
+
+    auto visit_range = [&](auto first, auto range_last) {
+      return std::all_of(first, range_last, [&](auto& item) { return visit(*item.second); });
+    };
+
+    // Each folder from folder up to the root shares one less level with it, so its palettes which were not already visited come next.
+    // The last level is the empty path, which every palette is under.
+    auto visited_first = last;
+    auto visited_last = last;
+
+    for (auto current = folder;; current = current.parent_path() == current ? fs::path{} : current.parent_path())
+    {
+      auto level_first = by_index.lower_bound(std::make_pair(index, current));
+      auto level_last = std::partition_point(level_first, last, [&](auto& item) { return is_under(item.first.second, current); });
+
+      if (visited_first == visited_last ? !visit_range(level_first, level_last) : !visit_range(level_first, visited_first) || !visit_range(visited_last, level_last))
+      {
+        return;
+      }
+
+      visited_first = level_first;
+      visited_last = level_last;
+
+      if (current.empty())
+      {
+        return;
+      }
+    }
+  }
+
+  std::vector<palette_entry> palette_registry::find_by_hash(std::uint64_t colour_hash) const
+  {
+    std::shared_lock lock(mutex);
+
+    auto [first, last] = by_hash.equal_range(colour_hash);
+    std::vector<palette_entry> results;
+    std::transform(first, last, std::back_inserter(results), [](auto& item) { return *item.second; });
+    return results;
+  }
+
+  std::vector<palette_entry> palette_registry::get_palettes(const fs::path& root) const
+  {
+    std::shared_lock lock(mutex);
+
+    std::vector<palette_entry> results;
+
+    for (auto file = files.lower_bound(root); file != files.end() && is_under(file->first, root); ++file)
+    {
+      results.insert(results.end(), file->second.palettes.begin(), file->second.palettes.end());
+    }
+
+    return results;
+  }
+}// namespace siege::content::pal
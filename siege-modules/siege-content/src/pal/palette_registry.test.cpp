@@ -0,0 +1,130 @@
+#include <catch2/catch_test_macros.hpp>
+#include <cstdlib>
+#include <fstream>
+#include <optional>
+#include <string>
+#include <siege/content/pal/palette_registry.hpp>
+
+namespace fs = std::filesystem;
+namespace pal = siege::content::pal;
+
+namespace
+{
+  constexpr auto palette_extensions = std::array<siege::fs_string_view, 1>{ { FSL".pal" } };
+
+  void write_palette(const fs::path& path, std::byte shade)
+  {
+    fs::create_directories(path.parent_path());
+    std::ofstream output(path, std::ios::binary | std::ios::trunc);
+    siege::platform::palette::write_pal_data(output, std::vector<pal::colour>(256, pal::colour{ shade, shade, shade, std::byte{} }));
+  }
+
+  std::vector<fs::path> find_paths(const pal::palette_registry& registry, std::uint32_t index, const fs::path& folder)
+  {
+    std::vector<fs::path> results;
+    registry.find_by_index(index, folder, [&](const pal::palette_entry& entry) {
+      results.emplace_back(entry.path);
+      return true;
+    });
+    return results;
+  }
+
+  void scan(pal::palette_registry& registry, const fs::path& root, bool force = false)
+  {
+    registry.scan(
+      root, palette_extensions, [](auto) { return std::set<fs::path>{}; }, [](auto) { return std::vector<char>{}; }, 3, force);
+  }
+}// namespace
+
+TEST_CASE("With palettes in nested folders, the closest palette is found first and the index is reused", "[pal.registry]")
+{
+  auto root = fs::temp_directory_path() / "palette_registry_test";
+  auto index_path = root / "index" / "palettes.idx";
+  fs::remove_all(root);
+
+  write_palette(root / "game" / "base.pal", std::byte{ 1 });
+  write_palette(root / "game" / "missions" / "desert.pal", std::byte{ 2 });
+
+  {
+    pal::palette_registry registry(index_path);
+    scan(registry, root / "game");
+
+    REQUIRE(registry.get_palettes(root / "game").size() == 2);
+
+    REQUIRE(find_paths(registry, 0, root / "game" / "missions") == std::vector<fs::path>{ root / "game" / "missions" / "desert.pal", root / "game" / "base.pal" });
+    REQUIRE(find_paths(registry, 0, root / "game") == std::vector<fs::path>{ root / "game" / "base.pal", root / "game" / "missions" / "desert.pal" });
+    REQUIRE(find_paths(registry, 1, root).empty());
+
+    // Nothing past the closest palette is looked at once the caller has what it needs.
+    std::vector<std::uint64_t> hashes;
+    registry.find_by_index(0, root / "game" / "missions", [&](const pal::palette_entry& entry) {
+      hashes.emplace_back(entry.colour_hash);
+      return false;
+    });
+    REQUIRE(hashes.size() == 1);
+    REQUIRE(registry.find_by_hash(hashes[0]).size() == 1);
+
+    // Already scanned folders are not looked at again, until forced to.
+    fs::remove(root / "game" / "base.pal");
+    scan(registry, root / "game" / "missions");
+    REQUIRE(registry.get_palettes(root / "game").size() == 2);
+
+    scan(registry, root / "game", true);
+    REQUIRE(registry.get_palettes(root / "game").size() == 1);
+
+    registry.save();
+  }
+
+  pal::palette_registry reloaded(index_path);
+  auto palettes = reloaded.get_palettes(root / "game");
+  REQUIRE(palettes.size() == 1);
+  REQUIRE(palettes[0].colours.size() == 256);
+  REQUIRE(palettes[0].colours[0].red == std::byte{ 2 });
+
+  fs::remove_all(root);
+}
+
+TEST_CASE("Palettes in sibling and deeper folders come after the ones which share more of the path", "[pal.registry]")
+{
+  auto root = fs::temp_directory_path() / "palette_registry_order_test";
+  fs::remove_all(root);
+
+  write_palette(root / "game" / "a_maps" / "arctic.pal", std::byte{ 1 });
+  write_palette(root / "game" / "base.pal", std::byte{ 2 });
+  write_palette(root / "game" / "missions" / "desert.pal", std::byte{ 3 });
+  write_palette(root / "game" / "missions" / "hard" / "night.pal", std::byte{ 4 });
+  write_palette(root / "game" / "z_units" / "tanks.pal", std::byte{ 5 });
+
+  pal::palette_registry registry(root / "index" / "palettes.idx");
+  scan(registry, root);
+
+  REQUIRE(find_paths(registry, 0, root / "game" / "missions") == std::vector<fs::path>{
+    root / "game" / "missions" / "desert.pal",
+    root / "game" / "missions" / "hard" / "night.pal",
+    root / "game" / "base.pal",
+    root / "game" / "a_maps" / "arctic.pal",
+    root / "game" / "z_units" / "tanks.pal",
+  });
+
+  fs::remove_all(root);
+}
+
+#if !WIN32
+TEST_CASE("The palette index is kept in the cache folder of the user, which temporary file cleanup leaves alone", "[pal.registry]")
+{
+  auto* existing = std::getenv("XDG_CACHE_HOME");
+  std::optional<std::string> previous = existing ? std::make_optional<std::string>(existing) : std::nullopt;
+
+  ::setenv("XDG_CACHE_HOME", "/home/player/.cache", 1);
+  REQUIRE(pal::get_default_palette_index_folder() == fs::path("/home/player/.cache") / "open-siege");
+
+  if (previous)
+  {
+    ::setenv("XDG_CACHE_HOME", previous->c_str(), 1);
+  }
+  else
+  {
+    ::unsetenv("XDG_CACHE_HOME");
+  }
+}
+#endif
@@ -0,0 +1,83 @@
+#include <siege/content/pal/palette_resolver.hpp>
+
+namespace siege::content::pal
+{
+  void scan_input_palettes(palette_registry& registry,
+    std::span<const std::filesystem::path> inputs,
+    const std::function<std::set<std::filesystem::path>(std::filesystem::path)>& get_embedded,
+    const std::function<std::vector<char>(std::filesystem::path)>& resolve_embedded)
+  {
+    bool scanned_any = false;
+
+    for (auto& input : inputs)
+    {
+      auto root = std::filesystem::is_directory(input) ? input : input.parent_path();
+
+      scanned_any |= registry.scan(
+        root.empty() ? std::filesystem::current_path() : root, palette_file_extensions, [&](auto path) { return get_embedded(std::move(path)); }, [&](auto path) { return resolve_embedded(std::move(path)); });
+    }
+
+    if (scanned_any)
+    {
+      registry.save();
+    }
+  }
+
+  std::vector<colour> get_greyscale_palette()
+  {
+    std::vector<colour> greyscale(256);
+
+    for (auto i = 0u; i < greyscale.size(); ++i)
+    {
+      greyscale[i] = colour{ std::byte(i), std::byte(i), std::byte(i), std::byte{ 0xff } };
+    }
+
+    return greyscale;
+  }
+
+  palette_resolver::palette_resolver(const palette_registry& registry, const palette_mapping& mapping, std::optional<palette_entry> forced)
+    : registry(registry), mapping(mapping), forced(std::move(forced))
+  {
+  }
+
+  std::vector<colour> palette_resolver::resolve(const std::filesystem::path& bitmap, std::optional<std::uint32_t> palette_index) const
+  {
+    if (forced)
+    {
+      return forced->colours;
+    }
+
+    if (auto assigned = mapping.find(bitmap); assigned)
+    {
+      for (auto& entry : registry.get_palettes(assigned->palette_path.parent_path()))
+      {
+        if (entry.path == assigned->palette_path && entry.position == assigned->position)
+        {
+          return std::move(entry.colours);
+        }
+      }
+    }
+
+    std::optional<std::vector<colour>> closest;
+
+    if (palette_index)
+    {
+      registry.find_by_index(*palette_index, bitmap.parent_path(), [&](const palette_entry& entry) {
+        closest = entry.colours;
+        return false;
+      });
+    }
+
+    if (closest)
+    {
+      return std::move(*closest);
+    }
+
+    if (auto nearby = get_nearby_palettes(registry, bitmap.parent_path()); !nearby.empty())
+    {
+      return std::move(nearby.front().colours);
+    }
+
+    return get_greyscale_palette();
+  }
+}// namespace siege::content::pal
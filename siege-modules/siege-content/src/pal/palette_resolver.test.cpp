@@ -0,0 +1,71 @@
+#include <catch2/catch_test_macros.hpp>
+#include <fstream>
+#include <siege/content/pal/palette_resolver.hpp>
+
+namespace fs = std::filesystem;
+namespace pal = siege::content::pal;
+
+TEST_CASE("The palette resolver prefers a forced palette, then an assigned one, then a nearby one, then greyscale", "[pal.resolver]")
+{
+  auto root = fs::temp_directory_path() / "palette_resolver_test";
+  fs::remove_all(root);
+  fs::create_directories(root / "bitmaps");
+
+  std::vector<pal::colour> reds(256, pal::colour{ std::byte{ 0xff }, std::byte{}, std::byte{}, std::byte{} });
+  std::vector<pal::colour> blues(256, pal::colour{ std::byte{}, std::byte{}, std::byte{ 0xff }, std::byte{} });
+
+  {
+    std::ofstream output(root / "a_reds.pal", std::ios::binary);
+    siege::platform::palette::write_pal_data(output, reds);
+  }
+
+  {
+    std::ofstream output(root / "b_blues.pal", std::ios::binary);
+    siege::platform::palette::write_pal_data(output, blues);
+  }
+
+  auto bitmap_path = root / "bitmaps" / "texture.bmp";
+  pal::palette_mapping mapping(root / "index" / "mapping.idx");
+
+  SECTION("Without any palettes, bitmaps are greyscale")
+  {
+    pal::palette_registry registry(root / "index" / "empty.idx");
+    pal::palette_resolver resolver(registry, mapping);
+
+    auto colours = resolver.resolve(bitmap_path, std::nullopt);
+    REQUIRE(colours == pal::get_greyscale_palette());
+  }
+
+  pal::palette_registry registry(root / "index" / "palettes.idx");
+  registry.scan(root, pal::palette_file_extensions, [](auto) { return std::set<fs::path>{}; }, [](auto) { return std::vector<char>{}; });
+
+  SECTION("A nearby palette is used when nothing else is known")
+  {
+    pal::palette_resolver resolver(registry, mapping);
+    REQUIRE(resolver.resolve(bitmap_path, std::nullopt).size() == 256);
+    REQUIRE(resolver.resolve(bitmap_path, std::nullopt) != pal::get_greyscale_palette());
+  }
+
+  SECTION("An assigned palette wins over a nearby one")
+  {
+    auto nearby = pal::get_nearby_palettes(registry, bitmap_path.parent_path());
+    REQUIRE(!nearby.empty());
+
+    auto other = nearby.front().path == root / "a_reds.pal" ? root / "b_blues.pal" : root / "a_reds.pal";
+    mapping.assign(std::vector<pal::palette_assignment>{ pal::palette_assignment{ bitmap_path, other, 0, 1.0f } });
+
+    pal::palette_resolver resolver(registry, mapping);
+    REQUIRE(resolver.resolve(bitmap_path, std::nullopt) == (other == root / "a_reds.pal" ? reds : blues));
+  }
+
+  SECTION("A forced palette wins over everything")
+  {
+    pal::palette_entry forced{};
+    forced.colours = pal::get_greyscale_palette();
+    pal::palette_resolver resolver(registry, mapping, forced);
+
+    REQUIRE(resolver.resolve(bitmap_path, 7) == pal::get_greyscale_palette());
+  }
+
+  fs::remove_all(root);
+}
@@ -0,0 +1,350 @@
+#include <algorithm>
+#include <cstring>
+#include <execution>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+#include <thread>
+#include <siege/content/pal/quantizer.hpp>
+#include <siege/platform/bitmap.hpp>
+
+namespace siege::content::pal
+{
+  using namespace siege::platform::bitmap;
+
+  // The value under the square root of colour_distance, which orders colours the same way without the root.
+  static long get_distance_squared(const colour& e1, long red, long green, long blue)
+  {
+    long rmean = ((long)e1.red + red) / 2;
+    long r = (long)e1.red - red;
+    long g = (long)e1.green - green;
+    long b = (long)e1.blue - blue;
+    return (((512 + rmean) * r * r) >> 8) + 4 * g * g + (((767 - rmean) * b * b) >> 8);
+  }
+
+  nearest_colour_cache::nearest_colour_cache(std::span<const colour> colours, std::optional<std::uint8_t> excluded_index)
+    : colours(colours.begin(), colours.begin() + std::min<std::size_t>(colours.size(), 256)),
+      answers(std::make_unique<std::atomic<std::uint32_t>[]>(answer_count))
+  {
+    if (this->colours.empty())
+    {
+      throw std::invalid_argument("A palette needs at least one colour to quantize to.");
+    }
+
+    constexpr long cell_size = 256 / cells_per_channel;
+
+    // The weights of red and blue in the metric only depend on the average red,
+    // which is what bounds the distance from a colour to anywhere in a cell from both sides.
+    auto get_axis_range = [](long value, long low) {
+      long high = low + cell_size - 1;
+      long nearest = value < low ? low - value : (value > high ? value - high : 0);
+      long furthest = std::max(std::abs(value - low), std::abs(value - high));
+      return std::make_pair(nearest, furthest);
+    };
+
+    auto is_excluded = [&](std::size_t index) {
+      return excluded_index && *excluded_index == index && this->colours.size() > 1;
+    };
+
+    std::vector<std::pair<long, long>> bounds(this->colours.size());
+
+    for (auto cell = 0u; cell < cell_offsets.size() - 1; ++cell)
+    {
+      long red_low = long(cell >> (cell_bits * 2)) * cell_size;
+      long green_low = long((cell >> cell_bits) & (cells_per_channel - 1)) * cell_size;
+      long blue_low = long(cell & (cells_per_channel - 1)) * cell_size;
+
+      long best_upper = std::numeric_limits<long>::max();
+
+      for (auto i = 0u; i < this->colours.size(); ++i)
+      {
+        auto& item = this->colours[i];
+        auto [red_near, red_far] = get_axis_range(long(item.red), red_low);
+        auto [green_near, green_far] = get_axis_range(long(item.green), green_low);
+        auto [blue_near, blue_far] = get_axis_range(long(item.blue), blue_low);
+
+        long lowest_mean = (long(item.red) + red_low) / 2;
+        long highest_mean = (long(item.red) + red_low + cell_size - 1) / 2;
+
+        long lower = (((512 + lowest_mean) * red_near * red_near) >> 8) + 4 * green_near * green_near + (((767 - highest_mean) * blue_near * blue_near) >> 8);
+        long upper = (((512 + highest_mean) * red_far * red_far) >> 8) + 4 * green_far * green_far + (((767 - lowest_mean) * blue_far * blue_far) >> 8);
+        bounds[i] = std::make_pair(lower, upper);
+
+        if (!is_excluded(i))
+        {
+          best_upper = std::min(best_upper, upper);
+        }
+      }
+
+      cell_offsets[cell] = std::uint32_t(candidates.size());
+
+      for (auto i = 0u; i < this->colours.size(); ++i)
+      {
+        if (!is_excluded(i) && bounds[i].first <= best_upper)
+        {
+          candidates.emplace_back(std::uint8_t(i));
+        }
+      }
+    }
+
+    cell_offsets.back() = std::uint32_t(candidates.size());
+  }
+
+  std::uint8_t nearest_colour_cache::find(std::uint8_t red, std::uint8_t green, std::uint8_t blue) const
+  {
+    auto key = std::uint32_t(red) << 16 | std::uint32_t(green) << 8 | std::uint32_t(blue);
+    auto& slot = answers[(key * 2654435761u) >> 16 & (answer_count - 1)];
+
+    if (auto answer = slot.load(std::memory_order_relaxed); answer != 0 && answer >> 8 == key)
+    {
+      return std::uint8_t(answer & 0xff);
+    }
+
+    auto cell = (red >> (8 - cell_bits)) << (cell_bits * 2) | (green >> (8 - cell_bits)) << cell_bits | (blue >> (8 - cell_bits));
+
+    auto best = candidates[cell_offsets[cell]];
+    auto best_distance = std::numeric_limits<long>::max();
+
+    for (auto i = cell_offsets[cell]; i < cell_offsets[cell + 1]; ++i)
+    {
+      auto distance = get_distance_squared(colours[candidates[i]], red, green, blue);
+
+      if (distance < best_distance)
+      {
+        best_distance = distance;
+        best = candidates[i];
+      }
+    }
+
+    slot.store(key << 8 | best, std::memory_order_relaxed);
+    return best;
+  }
+
+  namespace
+  {
+    // Thresholds from 0 to 63, spread out so that neighbouring pixels are far apart.
+    constexpr std::array<std::array<std::uint8_t, 8>, 8> bayer_matrix{ { { 0, 32, 8, 40, 2, 34, 10, 42 },
+      { 48, 16, 56, 24, 50, 18, 58, 26 },
+      { 12, 44, 4, 36, 14, 46, 6, 38 },
+      { 60, 28, 52, 20, 62, 30, 54, 22 },
+      { 3, 35, 11, 43, 1, 33, 9, 41 },
+      { 51, 19, 59, 27, 49, 17, 57, 25 },
+      { 15, 47, 7, 39, 13, 45, 5, 37 },
+      { 63, 31, 55, 23, 61, 29, 53, 21 } } };
+
+    // How far apart the colours of a typical 256 colour game palette are, which is how far the ordered pattern moves a pixel.
+    constexpr float ordered_spread = 32.0f;
+
+    constexpr std::size_t error_ring_size = 4;
+    constexpr std::size_t progress_interval = 32;
+
+    std::uint8_t clamp_channel(int value)
+    {
+      return std::uint8_t(std::clamp(value, 0, 255));
+    }
+
+    const colour* get_pixel(const_pixel_view pixels, std::size_t x, std::size_t y)
+    {
+      return reinterpret_cast<const colour*>(pixels.row(y).data()) + x;
+    }
+
+    bool is_transparent(const colour& pixel, const quantize_settings& settings)
+    {
+      return settings.transparent_index && std::uint8_t(pixel.flags) < settings.alpha_threshold;
+    }
+
+    // Every pixel stands alone, so without a thread limit the rows are handed out to the standard parallel algorithms.
+    // With a limit, each of the threads takes every nth row instead.
+    void quantize_independent(const_pixel_view pixels, const nearest_colour_cache& cache, const quantize_settings& settings, pixel_buffer& result)
+    {
+      const auto spread = settings.dither == dither_method::ordered ? ordered_spread * settings.strength : 0.0f;
+
+      auto process_row = [&](std::size_t y) {
+        auto output = result.row(y);
+
+        for (auto x = 0u; x < pixels.width; ++x)
+        {
+          auto& pixel = *get_pixel(pixels, x, y);
+
+          if (is_transparent(pixel, settings))
+          {
+            output[x] = std::byte(*settings.transparent_index);
+            continue;
+          }
+
+          auto offset = int((float(bayer_matrix[y % 8][x % 8]) - 31.5f) / 64.0f * spread);
+          output[x] = std::byte(cache.find(clamp_channel(int(pixel.red) + offset), clamp_channel(int(pixel.green) + offset), clamp_channel(int(pixel.blue) + offset)));
+        }
+      };
+
+      if (settings.max_threads == 0)
+      {
+        std::vector<std::size_t> rows(pixels.height);
+        std::iota(rows.begin(), rows.end(), std::size_t(0));
+        std::for_each(std::execution::par, rows.begin(), rows.end(), process_row);
+        return;
+      }
+
+      const auto thread_count = std::min(settings.max_threads, pixels.height);
+
+      auto worker = [&](std::size_t first_row) {
+        for (auto y = first_row; y < pixels.height; y += thread_count)
+        {
+          process_row(y);
+        }
+      };
+
+      std::vector<std::jthread> threads;
+      threads.reserve(thread_count - 1);
+
+      for (auto i = 1u; i < thread_count; ++i)
+      {
+        threads.emplace_back(worker, i);
+      }
+
+      worker(0);
+    }
+
+    // Floyd-Steinberg sends error to the next pixel and the three below it, so a row can only get to a pixel once
+    // the row above is two pixels past it. Each worker takes every nth row in order and follows the row above it,
+    // which keeps all of the workers busy on a diagonal front instead of going one row at a time.
+    // Workers wait on each other, so they have to be real threads rather than tasks of a parallel algorithm.
+    void quantize_error_diffusion(const_pixel_view pixels, const nearest_colour_cache& cache, const quantize_settings& settings, std::size_t thread_count, pixel_buffer& result)
+    {
+      const auto width = pixels.width;
+      const auto height = pixels.height;
+      const auto strength = int(std::clamp(settings.strength, 0.0f, 1.0f) * 256.0f);
+      const auto palette = cache.get_colours();
+
+      // Error for the rows which are being worked on, in sixteenths.
+      // Each row clears its error as it reads it, so that the slot is ready for the row which comes after it in the ring.
+      std::vector<std::array<int, 3>> errors(error_ring_size * width);
+      std::vector<std::atomic_size_t> progress(height);
+
+      auto process_row = [&](std::size_t y) {
+        auto incoming = std::span(errors).subspan((y % error_ring_size) * width, width);
+        auto outgoing = std::span(errors).subspan(((y + 1) % error_ring_size) * width, width);
+        auto output = result.row(y);
+
+        std::size_t known_progress = y == 0 ? width : 0;
+        std::array<int, 3> carry{};
+
+        for (auto x = 0u; x < width; ++x)
+        {
+          const auto needed = std::min<std::size_t>(width, x + 2);
+
+          while (known_progress < needed)
+          {
+            known_progress = progress[y - 1].load(std::memory_order_acquire);
+
+            if (known_progress < needed)
+            {
+              std::this_thread::yield();
+            }
+          }
+
+          auto& pixel = *get_pixel(pixels, x, y);
+          auto& error = incoming[x];
+          std::array<int, 3> pending{ (carry[0] + error[0]) / 16, (carry[1] + error[1]) / 16, (carry[2] + error[2]) / 16 };
+          error = {};
+
+          if (is_transparent(pixel, settings))
+          {
+            output[x] = std::byte(*settings.transparent_index);
+            carry = {};
+          }
+          else
+          {
+            std::array<int, 3> value{ int(pixel.red) + pending[0], int(pixel.green) + pending[1], int(pixel.blue) + pending[2] };
+            auto index = cache.find(clamp_channel(value[0]), clamp_channel(value[1]), clamp_channel(value[2]));
+            output[x] = std::byte(index);
+
+            auto& chosen = palette[index];
+            std::array<int, 3> difference{ value[0] - int(chosen.red), value[1] - int(chosen.green), value[2] - int(chosen.blue) };
+
+            for (auto channel = 0u; channel < 3; ++channel)
+            {
+              auto amount = (std::clamp(difference[channel], -255, 255) * strength) / 256;
+              carry[channel] = amount * 7;
+              outgoing[x][channel] += amount * 5;
+
+              if (x > 0)
+              {
+                outgoing[x - 1][channel] += amount * 3;
+              }
+
+              if (x + 1 < width)
+              {
+                outgoing[x + 1][channel] += amount;
+              }
+            }
+          }
+
+          if ((x + 1) % progress_interval == 0)
+          {
+            progress[y].store(x + 1, std::memory_order_release);
+          }
+        }
+
+        progress[y].store(width, std::memory_order_release);
+      };
+
+      auto worker = [&](std::size_t first_row) {
+        for (auto y = first_row; y < height; y += thread_count)
+        {
+          process_row(y);
+        }
+      };
+
+      std::vector<std::jthread> threads;
+      threads.reserve(thread_count - 1);
+
+      for (auto i = 1u; i < thread_count; ++i)
+      {
+        threads.emplace_back(worker, i);
+      }
+
+      worker(0);
+    }
+  }// namespace
+
+  pixel_buffer quantize(const_pixel_view pixels, std::span<const colour> colours, const quantize_settings& settings)
+  {
+    return quantize(pixels, nearest_colour_cache(colours, settings.transparent_index), settings);
+  }
+
+  pixel_buffer quantize(const_pixel_view pixels, const nearest_colour_cache& cache, const quantize_settings& settings)
+  {
+    if (is_indexed(pixels.format) || pixels.format == pixel_format::unknown)
+    {
+      throw std::invalid_argument("Only true colour pixels can be quantized.");
+    }
+
+    pixel_buffer result(pixel_format::indexed_8, pixels.width, pixels.height);
+
+    if (pixels.width == 0 || pixels.height == 0)
+    {
+      return result;
+    }
+
+    pixel_buffer expanded;
+
+    if (pixels.format != pixel_format::rgba_8888)
+    {
+      expanded = pixel_buffer(pixel_format::rgba_8888, pixels.width, pixels.height);
+      convert_to_rgba(pixels, {}, expanded.bytes());
+      pixels = expanded;
+    }
+
+    if (settings.dither != dither_method::floyd_steinberg)
+    {
+      quantize_independent(pixels, cache, settings, result);
+      return result;
+    }
+
+    auto thread_count = settings.max_threads == 0 ? std::size_t(std::max(1u, std::thread::hardware_concurrency())) : settings.max_threads;
+    quantize_error_diffusion(pixels, cache, settings, std::min(thread_count, pixels.height), result);
+
+    return result;
+  }
+}// namespace siege::content::pal
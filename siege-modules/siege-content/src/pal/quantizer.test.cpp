@@ -0,0 +1,125 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <algorithm>
+#include <siege/content/pal/quantizer.hpp>
+#include "test_helpers.hpp"
+
+namespace pal = siege::content::pal;
+using namespace siege::platform::bitmap;
+using siege::content::test_helpers::make_palette;
+
+namespace
+{
+  pixel_buffer make_gradient(std::size_t width, std::size_t height)
+  {
+    pixel_buffer pixels(pixel_format::rgba_8888, width, height);
+
+    for (auto y = 0u; y < height; ++y)
+    {
+      auto row = reinterpret_cast<pal::colour*>(pixels.row(y).data());
+
+      for (auto x = 0u; x < width; ++x)
+      {
+        row[x] = pal::colour{ std::byte(x * 255 / width), std::byte(y * 255 / height), std::byte((x + y) % 256), std::byte{ 0xff } };
+      }
+    }
+
+    return pixels;
+  }
+}// namespace
+
+TEST_CASE("With no dithering, every pixel gets the same colour as a full search of the palette", "[pal.quantize]")
+{
+  auto colours = make_palette();
+  auto pixels = make_gradient(97, 41);
+
+  auto result = pal::quantize(pixels, colours, { .dither = pal::dither_method::none });
+
+  for (auto y = 0u; y < pixels.get_height(); ++y)
+  {
+    for (auto x = 0u; x < pixels.get_width(); ++x)
+    {
+      auto& pixel = reinterpret_cast<const pal::colour*>(pixels.row(y).data())[x];
+      auto expected = std::min_element(colours.begin(), colours.end(), [&](auto& a, auto& b) {
+        return pal::colour_distance(a, pixel) < pal::colour_distance(b, pixel);
+      });
+
+      REQUIRE(pal::colour_distance(colours[std::size_t(result.row(y)[x])], pixel) == pal::colour_distance(*expected, pixel));
+    }
+  }
+}
+
+TEST_CASE("With a black and white palette, dithering a grey image gives an even mix", "[pal.quantize]")
+{
+  std::vector<pal::colour> colours{ pal::colour{}, pal::colour{ std::byte{ 255 }, std::byte{ 255 }, std::byte{ 255 }, std::byte{} } };
+  pixel_buffer pixels(pixel_format::rgb_888, 64, 64);
+  std::fill(pixels.bytes().begin(), pixels.bytes().end(), std::byte{ 128 });
+
+  for (auto method : { pal::dither_method::floyd_steinberg, pal::dither_method::ordered })
+  {
+    auto result = pal::quantize(pixels, colours, { .dither = method });
+    auto white = std::count(result.bytes().begin(), result.bytes().end(), std::byte{ 1 });
+
+    REQUIRE(white > 64 * 64 * 4 / 10);
+    REQUIRE(white < 64 * 64 * 6 / 10);
+  }
+
+  auto flat = pal::quantize(pixels, colours, { .dither = pal::dither_method::none });
+  REQUIRE(std::count(flat.bytes().begin(), flat.bytes().end(), std::byte{ 1 }) == 64 * 64);
+}
+
+TEST_CASE("With error diffusion, the result does not depend on how many threads are used", "[pal.quantize]")
+{
+  auto colours = make_palette();
+  auto pixels = make_gradient(301, 157);
+
+  auto single = pal::quantize(pixels, colours, { .max_threads = 1 });
+  auto many = pal::quantize(pixels, colours, { .max_threads = 7 });
+
+  REQUIRE(std::ranges::equal(single.bytes(), many.bytes()));
+}
+
+TEST_CASE("Without error diffusion, the result does not depend on how many threads are used", "[pal.quantize]")
+{
+  auto colours = make_palette();
+  auto pixels = make_gradient(301, 157);
+
+  for (auto method : { pal::dither_method::none, pal::dither_method::ordered })
+  {
+    auto all = pal::quantize(pixels, colours, { .dither = method });
+    auto single = pal::quantize(pixels, colours, { .dither = method, .max_threads = 1 });
+    auto many = pal::quantize(pixels, colours, { .dither = method, .max_threads = 7 });
+
+    REQUIRE(std::ranges::equal(all.bytes(), single.bytes()));
+    REQUIRE(std::ranges::equal(all.bytes(), many.bytes()));
+  }
+}
+
+TEST_CASE("With a transparent index, clear pixels use it and nothing else does", "[pal.quantize]")
+{
+  auto colours = make_palette();
+  auto pixels = make_gradient(32, 32);
+  reinterpret_cast<pal::colour*>(pixels.row(5).data())[7].flags = std::byte{};
+
+  auto result = pal::quantize(pixels, colours, { .transparent_index = 0 });
+
+  REQUIRE(result.row(5)[7] == std::byte{ 0 });
+  REQUIRE(std::count(result.bytes().begin(), result.bytes().end(), std::byte{ 0 }) == 1);
+}
+
+TEST_CASE("Throughput of quantizing a 4K image", "[pal.quantize][!benchmark]")
+{
+  auto colours = make_palette();
+  auto pixels = make_gradient(3840, 2160);
+  pal::nearest_colour_cache cache(colours);
+
+  BENCHMARK("Floyd-Steinberg")
+  {
+    return pal::quantize(pixels, cache);
+  };
+
+  BENCHMARK("Ordered")
+  {
+    return pal::quantize(pixels, cache, { .dither = pal::dither_method::ordered });
+  };
+}
@@ -0,0 +1,348 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <execution>
+#include <numeric>
+#include <siege/platform/pixel_kernels.hpp>
+#include <siege/content/software_rasteriser.hpp>
+
+namespace siege::content
+{
+  namespace
+  {
+    constexpr float pi = 3.14159265358979f;
+
+    float dot(const vector3f& left, const vector3f& right)
+    {
+      return left.x * right.x + left.y * right.y + left.z * right.z;
+    }
+
+    vector3f cross(const vector3f& left, const vector3f& right)
+    {
+      return { left.y * right.z - left.z * right.y, left.z * right.x - left.x * right.z, left.x * right.y - left.y * right.x };
+    }
+
+    vector3f scale(const vector3f& value, float amount)
+    {
+      return { value.x * amount, value.y * amount, value.z * amount };
+    }
+
+    vector3f normalise(const vector3f& value)
+    {
+      auto length = std::sqrt(dot(value, value));
+      return length > 0 ? scale(value, 1 / length) : value;
+    }
+
+    struct camera_basis
+    {
+      vector3f eye;
+      vector3f right;
+      vector3f up;
+      vector3f forward;
+      // Pixels per unit at a depth of one.
+      float focal_length;
+    };
+
+    camera_basis make_basis(std::span<const mesh_batch> batches, const raster_camera& camera, std::size_t width, std::size_t height)
+    {
+      vector3f min{ INFINITY, INFINITY, INFINITY };
+      vector3f max{ -INFINITY, -INFINITY, -INFINITY };
+
+      for (const auto& batch : batches)
+      {
+        for (const auto& vertex : batch.vertices)
+        {
+          min = { std::min(min.x, vertex.position.x), std::min(min.y, vertex.position.y), std::min(min.z, vertex.position.z) };
+          max = { std::max(max.x, vertex.position.x), std::max(max.y, vertex.position.y), std::max(max.z, vertex.position.z) };
+        }
+      }
+
+      auto centre = min.x <= max.x ? scale(min + max, 0.5f) : vector3f{};
+      float radius = 0;
+
+      for (const auto& batch : batches)
+      {
+        for (const auto& vertex : batch.vertices)
+        {
+          auto offset = vertex.position - centre;
+          radius = std::max(radius, dot(offset, offset));
+        }
+      }
+
+      radius = std::max(std::sqrt(radius), 0.001f);
+
+      auto up = normalise(camera.up);
+      auto side = std::abs(up.x) < 0.9f ? vector3f{ 1, 0, 0 } : vector3f{ 0, 1, 0 };
+      auto across = normalise(cross(up, side));
+      auto along = cross(across, up);
+
+      const auto yaw = camera.yaw * pi / 180;
+      const auto pitch = camera.pitch * pi / 180;
+      const auto half_view = camera.field_of_view * pi / 360;
+
+      auto towards_eye = scale(along, std::cos(pitch) * std::cos(yaw)) + scale(across, std::cos(pitch) * std::sin(yaw)) + scale(up, std::sin(pitch));
+
+      camera_basis result{};
+      // Far enough away that the bounding sphere fits in view, with a little room around it.
+      result.eye = centre + scale(towards_eye, radius / std::sin(half_view) * 1.05f);
+      result.forward = scale(towards_eye, -1);
+      result.right = normalise(cross(result.forward, up));
+      result.up = cross(result.right, result.forward);
+      result.focal_length = float(std::min(width, height)) / 2 / std::tan(half_view);
+      return result;
+    }
+
+    struct screen_vertex
+    {
+      float x;
+      float y;
+      // Everything below is divided by depth, so that it can be interpolated across the screen.
+      float inverse_depth;
+      float u;
+      float v;
+      float light;
+    };
+
+    struct screen_triangle
+    {
+      std::array<screen_vertex, 3> vertices;
+      std::uint32_t material_index;
+      std::int32_t min_x;
+      std::int32_t min_y;
+      std::int32_t max_x;
+      std::int32_t max_y;
+    };
+
+    float edge(const screen_vertex& a, const screen_vertex& b, float x, float y)
+    {
+      return (b.x - a.x) * (y - a.y) - (b.y - a.y) * (x - a.x);
+    }
+
+    platform::palette::colour sample(const raster_texture& texture, float u, float v)
+    {
+      u -= std::floor(u);
+      v -= std::floor(v);
+
+      auto x = std::min(std::size_t(u * float(texture.width)), texture.width - 1);
+      auto y = std::min(std::size_t(v * float(texture.height)), texture.height - 1);
+      return texture.pixels[y * texture.width + x];
+    }
+
+    std::byte shade(std::byte value, float light)
+    {
+      return std::byte(std::clamp(int(float(value) * light + 0.5f), 0, 255));
+    }
+  }// namespace
+
+  raster_texture to_raster_texture(platform::bitmap::const_pixel_view pixels, std::span<const platform::palette::colour> colours)
+  {
+    raster_texture result{ pixels.width, pixels.height, std::vector<platform::palette::colour>(pixels.width * pixels.height) };
+
+    platform::bitmap::convert_to_rgba(pixels, colours, std::as_writable_bytes(std::span(result.pixels)), false, platform::bitmap::get_supported_instruction_set());
+    return result;
+  }
+
+  raster_material to_raster_material(const material& source)
+  {
+    raster_material result{};
+
+    if (auto rgb = source.metadata.find("rgbData"); rgb != source.metadata.end() && std::holds_alternative<rgb_data>(rgb->second))
+    {
+      const auto& value = std::get<rgb_data>(rgb->second);
+      result.colour = platform::palette::colour{ std::byte(value.red), std::byte(value.green), std::byte(value.blue), std::byte{ 0xff } };
+    }
+
+    return result;
+  }
+
+  software_rasteriser::software_rasteriser(std::size_t width, std::size_t height, std::size_t tile_size)
+    : width(width), height(height), tile_size(std::max<std::size_t>(tile_size, 1)), colours(width * height), depths(width * height)
+  {
+  }
+
+  void software_rasteriser::clear(platform::palette::colour background)
+  {
+    std::fill(colours.begin(), colours.end(), background);
+    std::fill(depths.begin(), depths.end(), 0.0f);
+  }
+
+  void software_rasteriser::draw(std::span<const mesh_batch> batches, std::span<const raster_material> materials, const raster_camera& camera)
+  {
+    if (width == 0 || height == 0)
+    {
+      return;
+    }
+
+    const auto basis = make_basis(batches, camera, width, height);
+    const auto centre_x = float(width) / 2;
+    const auto centre_y = float(height) / 2;
+    // Lit from above and to the left of the camera, with both sides of a triangle lit the same.
+    const auto light_direction = normalise(vector3f{ -0.3f, 0.5f, -1 });
+
+    std::vector<screen_triangle> triangles;
+    std::vector<screen_vertex> projected;
+
+    for (const auto& batch : batches)
+    {
+      projected.resize(batch.vertices.size());
+
+      std::transform(std::execution::par_unseq, batch.vertices.begin(), batch.vertices.end(), projected.begin(), [&](const mesh_vertex& vertex) {
+        auto offset = vertex.position - basis.eye;
+        auto depth = std::max(dot(offset, basis.forward), 0.0001f);
+        auto inverse_depth = 1 / depth;
+
+        vector3f normal{ dot(vertex.normal, basis.right), dot(vertex.normal, basis.up), dot(vertex.normal, basis.forward) };
+        auto light = 0.35f + 0.65f * std::abs(dot(normal, light_direction));
+
+        return screen_vertex{
+          centre_x + dot(offset, basis.right) * basis.focal_length * inverse_depth,
+          centre_y - dot(offset, basis.up) * basis.focal_length * inverse_depth,
+          inverse_depth,
+          vertex.texture_coordinate.x * inverse_depth,
+          vertex.texture_coordinate.y * inverse_depth,
+          light * inverse_depth
+        };
+      });
+
+      const auto index_count = batch.get_index_count();
+      triangles.reserve(triangles.size() + index_count / 3);
+
+      for (auto i = 0u; i + 2 < index_count; i += 3)
+      {
+        screen_triangle triangle{ { projected[batch.get_index(i)], projected[batch.get_index(i + 1)], projected[batch.get_index(i + 2)] }, std::uint32_t(batch.material_index) };
+
+        auto [min_x, max_x] = std::minmax({ triangle.vertices[0].x, triangle.vertices[1].x, triangle.vertices[2].x });
+        auto [min_y, max_y] = std::minmax({ triangle.vertices[0].y, triangle.vertices[1].y, triangle.vertices[2].y });
+
+        triangle.min_x = std::max(std::int32_t(std::floor(min_x)), 0);
+        triangle.min_y = std::max(std::int32_t(std::floor(min_y)), 0);
+        triangle.max_x = std::min(std::int32_t(std::ceil(max_x)), std::int32_t(width) - 1);
+        triangle.max_y = std::min(std::int32_t(std::ceil(max_y)), std::int32_t(height) - 1);
+
+        if (triangle.min_x > triangle.max_x || triangle.min_y > triangle.max_y)
+        {
+          continue;
+        }
+
+        // One winding for every triangle, so that the inside is where all of the edges are positive.
+        if (edge(triangle.vertices[0], triangle.vertices[1], triangle.vertices[2].x, triangle.vertices[2].y) < 0)
+        {
+          std::swap(triangle.vertices[1], triangle.vertices[2]);
+        }
+
+        triangles.emplace_back(triangle);
+      }
+    }
+
+    const auto tiles_x = (width + tile_size - 1) / tile_size;
+    const auto tiles_y = (height + tile_size - 1) / tile_size;
+
+    // Triangles keep the order they were drawn in within each tile, so ties in depth always go the same way.
+    std::vector<std::vector<std::uint32_t>> tiles(tiles_x * tiles_y);
+
+    for (auto i = 0u; i < triangles.size(); ++i)
+    {
+      const auto& triangle = triangles[i];
+
+      for (auto y = std::size_t(triangle.min_y) / tile_size; y <= std::size_t(triangle.max_y) / tile_size; ++y)
+      {
+        for (auto x = std::size_t(triangle.min_x) / tile_size; x <= std::size_t(triangle.max_x) / tile_size; ++x)
+        {
+          tiles[y * tiles_x + x].emplace_back(i);
+        }
+      }
+    }
+
+    std::vector<std::size_t> tile_indexes(tiles.size());
+    std::iota(tile_indexes.begin(), tile_indexes.end(), 0);
+
+    std::for_each(std::execution::par, tile_indexes.begin(), tile_indexes.end(), [&](std::size_t tile_index) {
+      const auto tile_x = std::int32_t((tile_index % tiles_x) * tile_size);
+      const auto tile_y = std::int32_t((tile_index / tiles_x) * tile_size);
+      const auto tile_right = std::min(tile_x + std::int32_t(tile_size), std::int32_t(width)) - 1;
+      const auto tile_bottom = std::min(tile_y + std::int32_t(tile_size), std::int32_t(height)) - 1;
+
+      for (auto triangle_index : tiles[tile_index])
+      {
+        const auto& triangle = triangles[triangle_index];
+        const auto& [a, b, c] = triangle.vertices;
+
+        const auto area = edge(a, b, c.x, c.y);
+
+        if (area <= 0)
+        {
+          continue;
+        }
+
+        const raster_material* material = triangle.material_index < materials.size() ? &materials[triangle.material_index] : nullptr;
+        const auto* texture = material && material->texture && !material->texture->pixels.empty() ? material->texture.get() : nullptr;
+        const auto flat_colour = material ? material->colour : raster_material{}.colour;
+
+        for (auto y = std::max(triangle.min_y, tile_y); y <= std::min(triangle.max_y, tile_bottom); ++y)
+        {
+          const auto pixel_y = float(y) + 0.5f;
+
+          for (auto x = std::max(triangle.min_x, tile_x); x <= std::min(triangle.max_x, tile_right); ++x)
+          {
+            const auto pixel_x = float(x) + 0.5f;
+
+            const auto weight_a = edge(b, c, pixel_x, pixel_y);
+            const auto weight_b = edge(c, a, pixel_x, pixel_y);
+            const auto weight_c = edge(a, b, pixel_x, pixel_y);
+
+            if (weight_a < 0 || weight_b < 0 || weight_c < 0)
+            {
+              continue;
+            }
+
+            const auto inverse_depth = (weight_a * a.inverse_depth + weight_b * b.inverse_depth + weight_c * c.inverse_depth) / area;
+            const auto pixel_index = std::size_t(y) * width + std::size_t(x);
+
+            if (inverse_depth <= depths[pixel_index])
+            {
+              continue;
+            }
+
+            depths[pixel_index] = inverse_depth;
+
+            const auto to_surface = 1 / (inverse_depth * area);
+            const auto light = (weight_a * a.light + weight_b * b.light + weight_c * c.light) * to_surface;
+
+            auto colour = flat_colour;
+
+            if (texture)
+            {
+              colour = sample(*texture,
+                (weight_a * a.u + weight_b * b.u + weight_c * c.u) * to_surface,
+                (weight_a * a.v + weight_b * b.v + weight_c * c.v) * to_surface);
+            }
+
+            colours[pixel_index] = platform::palette::colour{ shade(colour.red, light), shade(colour.green, light), shade(colour.blue, light), std::byte{ 0xff } };
+          }
+        }
+      }
+    });
+  }
+
+  platform::bitmap::pixel_buffer software_rasteriser::get_pixels() const
+  {
+    std::vector<std::byte> bytes(colours.size() * sizeof(platform::palette::colour));
+    std::memcpy(bytes.data(), colours.data(), bytes.size());
+    return platform::bitmap::pixel_buffer(platform::bitmap::pixel_format::rgba_8888, width, height, std::move(bytes));
+  }
+
+  platform::bitmap::pixel_buffer render_thumbnail(const renderable_shape& shape, std::span<const raster_material> materials, std::size_t size, const raster_camera& camera)
+  {
+    software_rasteriser rasteriser(size, size);
+    rasteriser.clear(platform::palette::colour{});
+
+    if (!shape.get_detail_levels().empty())
+    {
+      std::vector<std::size_t> details{ 0 };
+      auto batches = shape.get_mesh_batches(details, shape.get_sequences(details));
+      rasteriser.draw(batches, materials, camera);
+    }
+
+    return rasteriser.get_pixels();
+  }
+}// namespace siege::content
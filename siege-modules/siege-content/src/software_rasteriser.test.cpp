@@ -0,0 +1,125 @@
+#include <cstring>
+#include <catch2/catch_test_macros.hpp>
+#include <siege/content/software_rasteriser.hpp>
+
+using namespace siege::content;
+using siege::platform::palette::colour;
+
+namespace
+{
+  // A square facing along x, from -1 to 1 on y and z, with its texture across y.
+  mesh_batch make_square(float x, std::int32_t material_index)
+  {
+    mesh_batch batch{};
+    batch.material_index = material_index;
+    batch.vertices = {
+      { { x, -1, -1 }, { 0, 1 }, { 1, 0, 0 } },
+      { { x, 1, -1 }, { 1, 1 }, { 1, 0, 0 } },
+      { { x, 1, 1 }, { 1, 0 }, { 1, 0, 0 } },
+      { { x, -1, 1 }, { 0, 0 }, { 1, 0, 0 } },
+    };
+    batch.indexes = std::vector<std::uint16_t>{ 0, 1, 2, 0, 2, 3 };
+    return batch;
+  }
+
+  raster_material make_colour(std::uint8_t red, std::uint8_t green, std::uint8_t blue)
+  {
+    return raster_material{ colour{ std::byte(red), std::byte(green), std::byte(blue), std::byte{ 0xff } } };
+  }
+
+  colour get_pixel(const siege::platform::bitmap::pixel_buffer& pixels, std::size_t x, std::size_t y)
+  {
+    colour result;
+    std::memcpy(&result, pixels.row(y).data() + x * sizeof(colour), sizeof(colour));
+    return result;
+  }
+
+  // Looking straight down the x axis, so that y runs from left to right and z from bottom to top.
+  constexpr raster_camera front_camera{ 0, 0, 45, { 0, 0, 1 } };
+}// namespace
+
+TEST_CASE("Triangles cover the middle of the image and leave the corners clear", "[rasteriser]")
+{
+  std::vector<mesh_batch> batches{ make_square(0, 0) };
+  std::vector<raster_material> materials{ make_colour(255, 0, 0) };
+
+  software_rasteriser rasteriser(64, 48, 16);
+  rasteriser.clear(colour{});
+  rasteriser.draw(batches, materials, front_camera);
+
+  auto pixels = rasteriser.get_pixels();
+  REQUIRE(pixels.get_format() == siege::platform::bitmap::pixel_format::rgba_8888);
+  REQUIRE(pixels.get_width() == 64);
+  REQUIRE(pixels.get_height() == 48);
+
+  auto middle = get_pixel(pixels, 32, 24);
+  REQUIRE(middle.red > std::byte{ 200 });
+  REQUIRE(middle.green == std::byte{ 0 });
+  REQUIRE(middle.flags == std::byte{ 0xff });
+
+  REQUIRE(get_pixel(pixels, 0, 0).flags == std::byte{ 0 });
+  REQUIRE(get_pixel(pixels, 63, 47).flags == std::byte{ 0 });
+}
+
+TEST_CASE("The nearest triangle wins whichever order they are drawn in", "[rasteriser]")
+{
+  std::vector<raster_material> materials{ make_colour(255, 0, 0), make_colour(0, 0, 255) };
+
+  for (auto near_first : { true, false })
+  {
+    // The camera is out along x, so the square at 0.5 is in front.
+    std::vector<mesh_batch> batches{ make_square(0.5f, 0), make_square(-0.5f, 1) };
+
+    if (!near_first)
+    {
+      std::swap(batches[0], batches[1]);
+    }
+
+    software_rasteriser rasteriser(32, 32, 8);
+    rasteriser.clear(colour{});
+    rasteriser.draw(batches, materials, front_camera);
+
+    auto middle = get_pixel(rasteriser.get_pixels(), 16, 16);
+    REQUIRE(middle.red > std::byte{ 200 });
+    REQUIRE(middle.blue == std::byte{ 0 });
+  }
+}
+
+TEST_CASE("Textures are sampled with their palette resolved", "[rasteriser]")
+{
+  // Two pixels: the left one red and the right one green, through a palette.
+  siege::platform::bitmap::pixel_buffer indexed(siege::platform::bitmap::pixel_format::indexed_8, 2, 1, { std::byte{ 1 }, std::byte{ 2 } });
+  std::vector<colour> palette(3);
+  palette[1] = colour{ std::byte{ 255 }, std::byte{ 0 }, std::byte{ 0 }, std::byte{ 0xff } };
+  palette[2] = colour{ std::byte{ 0 }, std::byte{ 255 }, std::byte{ 0 }, std::byte{ 0xff } };
+
+  auto texture = to_raster_texture(indexed, palette);
+  REQUIRE(texture.width == 2);
+  REQUIRE(texture.pixels[1].green == std::byte{ 255 });
+
+  std::vector<mesh_batch> batches{ make_square(0, 0) };
+  std::vector<raster_material> materials{ raster_material{ colour{}, std::make_shared<raster_texture>(std::move(texture)) } };
+
+  software_rasteriser rasteriser(64, 64);
+  rasteriser.clear(colour{});
+  rasteriser.draw(batches, materials, front_camera);
+  auto pixels = rasteriser.get_pixels();
+
+  auto left = get_pixel(pixels, 24, 32);
+  auto right = get_pixel(pixels, 40, 32);
+  REQUIRE(left.red > std::byte{ 200 });
+  REQUIRE(left.green == std::byte{ 0 });
+  REQUIRE(right.green > std::byte{ 200 });
+  REQUIRE(right.red == std::byte{ 0 });
+}
+
+TEST_CASE("Materials take their colour from rgbData", "[rasteriser]")
+{
+  material source{};
+  source.metadata.emplace("rgbData", rgb_data{ 10, 20, 30, 0 });
+
+  auto result = to_raster_material(source);
+  REQUIRE(result.colour.red == std::byte{ 10 });
+  REQUIRE(result.colour.blue == std::byte{ 30 });
+  REQUIRE(result.texture == nullptr);
+}
@@ -0,0 +1,39 @@
+#ifndef SIEGE_CONTENT_TEST_HELPERS_HPP
+#define SIEGE_CONTENT_TEST_HELPERS_HPP
+
+#include <cmath>
+#include <cstddef>
+#include <vector>
+#include <siege/platform/palette.hpp>
+
+// Fixtures shared by the tests of siege-content.
+namespace siege::content::test_helpers
+{
+  inline bool is_near(float value, float expected)
+  {
+    return std::abs(value - expected) < 0.0001f;
+  }
+
+  // Appends the bytes of value, as they are in memory, to a string or vector of bytes.
+  template<typename T, typename Container>
+  void append(Container& data, const T& value)
+  {
+    auto* bytes = reinterpret_cast<const typename Container::value_type*>(&value);
+    data.insert(data.end(), bytes, bytes + sizeof(value));
+  }
+
+  // Every colour is different, as long as there are no more than 256 of them.
+  inline std::vector<siege::platform::palette::colour> make_palette(std::size_t count = 256, std::byte alpha = std::byte{})
+  {
+    std::vector<siege::platform::palette::colour> colours(count);
+
+    for (auto i = 0u; i < count; ++i)
+    {
+      colours[i] = siege::platform::palette::colour{ std::byte((i * 37) % 256), std::byte((i * 101) % 256), std::byte((i * 199) % 256), alpha };
+    }
+
+    return colours;
+  }
+}// namespace siege::content::test_helpers
+
+#endif// SIEGE_CONTENT_TEST_HELPERS_HPP
@@ -5,7 +5,9 @@
 #include <array>
 #include <fstream>
 #include <optional>
+#include <span>
 #include <siege/platform/palette.hpp>
+#include <siege/platform/pixel_buffer.hpp>
 #include <siege/platform/endian_arithmetic.hpp>
 
 namespace siege::platform::bitmap
@@ -40,36 +42,29 @@ namespace siege::platform::bitmap
   {
     windows_bmp_header header;
     windows_bmp_info info;
+    // The palette of indexed images.
     std::vector<palette::colour> colours;
-    std::vector<std::int32_t> indexes;
+    pixel_buffer pixels;
   };
 
-  template<typename UnitType>
-  inline void invert(std::vector<UnitType>& pixels)
-  {
-    std::reverse(pixels.begin(), pixels.end());
-  }
+  bool is_microsoft_bmp(std::istream& raw_data);
 
-  template<typename UnitType>
-  inline void horizontal_flip(std::vector<UnitType>& pixels, int width)
-  {
-    for (auto r = pixels.begin(); r != pixels.end(); r += width)
-    {
-      std::reverse(r, r + width);
-    }
-  }
+  // The pixel format used for a BMP bit depth, or unknown if the bit depth is not supported.
+  pixel_format get_bmp_pixel_format(std::uint16_t bit_depth);
 
-  template<typename UnitType>
-  inline void vertical_flip(std::vector<UnitType>& pixels, int width)
-  {
-    invert(pixels);
-    horizontal_flip(pixels, width);
-  }
+  // Reads everything up to the pixels, leaving the stream at the start of the pixel data.
+  windows_bmp_data read_bmp_header(std::istream& raw_data);
 
-  bool is_microsoft_bmp(std::istream& raw_data);
+  // Reads the pixels into a caller provided buffer in a single pass, which must match the size and format given by info.
+  // With auto_flip, bottom up images are turned top down by the order in which rows are written.
+  void read_bmp_pixels(std::istream& raw_data, const windows_bmp_info& info, pixel_view destination, bool auto_flip = true);
 
   windows_bmp_data get_bmp_data(std::istream& raw_data, bool auto_flip = true);
 
+  // Writes every pixel as a palette::colour, looking up indexed pixels in colours.
+  // Uses the fastest kernel the CPU supports, see pixel_kernels.hpp.
+  void convert_to_rgba(const_pixel_view pixels, std::span<const palette::colour> colours, std::span<std::byte> destination, bool flip_rows = false);
+
   struct bitmap_settings
   {
     std::vector<palette::colour> colours;
@@ -84,7 +79,9 @@ namespace siege::platform::bitmap
     std::size_t offset;
   };
 
-  void write_bmp_data(std::ostream& raw_data, std::vector<palette::colour> colours, std::vector<std::byte> pixels, std::int32_t width, std::int32_t height, std::int32_t bit_depth, bool auto_flip = true);
+  // Writes the pixels in a single pass, with colours used as the palette of indexed images.
+  // With auto_flip, top down pixels are written bottom up, as BMP files expect.
+  void write_bmp_data(std::ostream& raw_data, std::span<const palette::colour> colours, const_pixel_view pixels, bool auto_flip = true);
 }// namespace siege::platform::bitmap
 
 #endif// SIEGE_PLATFORM_BITMAP_HPP
@@ -7,6 +7,9 @@
 #include <iostream>
 #include <iomanip>
 #include <cmath>
+#include <span>
+#include <memory>
+#include <cstdint>
 #include <siege/platform/endian_arithmetic.hpp>
 #include <siege/platform/shared.hpp>
 
@@ -54,6 +57,23 @@ namespace siege::platform::palette
     return std::sqrt((((512 + rmean) * r * r) >> 8) + 4 * g * g + (((767 - rmean) * b * b) >> 8));
   }
 
+  // Maps every colour of the original palette to the index of the closest colour in the other palette.
+  // Exact matches are always used. With only_unique, the closest colour which has not been used yet is preferred.
+  // A k-d tree over the other palette keeps this to a handful of distance checks per colour.
+  std::vector<std::size_t> make_remap_table(std::span<const colour> original_colours,
+    std::span<const colour> other_colours,
+    bool only_unique = false);
+
+  // Same as make_remap_table, but tables are kept around per palette pair,
+  // so that switching back and forth between palettes only builds each table once.
+  std::shared_ptr<const std::vector<std::size_t>> get_remap_table(std::span<const colour> original_colours,
+    std::span<const colour> other_colours,
+    bool only_unique = false);
+
+  // Pixels outside of the table are mapped to the first colour.
+  void apply_remap_table(std::span<const std::size_t> table, std::span<const std::byte> pixels, std::span<std::byte> output);
+  void apply_remap_table(std::span<const std::size_t> table, std::span<const std::int32_t> pixels, std::span<std::int32_t> output);
+
   bool is_microsoft_pal(std::istream& raw_data);
   std::vector<colour> get_pal_data(std::istream& raw_data);
   std::int32_t write_pal_data(std::ostream& raw_data, const std::vector<colour>& colours);
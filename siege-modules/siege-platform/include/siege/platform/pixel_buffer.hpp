@@ -0,0 +1,196 @@
+#ifndef SIEGE_PLATFORM_PIXEL_BUFFER_HPP
+#define SIEGE_PLATFORM_PIXEL_BUFFER_HPP
+
+#include <vector>
+#include <span>
+#include <cstdint>
+#include <cstddef>
+#include <stdexcept>
+#include <algorithm>
+
+namespace siege::platform::bitmap
+{
+  enum class pixel_format : std::uint8_t
+  {
+    unknown,
+    indexed_1,
+    // The high nibble is the first pixel, the same as BMP files.
+    indexed_4,
+    indexed_8,
+    // Little endian, with the top bit as the alpha flag, followed by red, green and blue.
+    rgb_1555,
+    // Red, green then blue.
+    rgb_888,
+    // The same layout as palette::colour.
+    rgba_8888
+  };
+
+  constexpr std::size_t get_bits_per_pixel(pixel_format format)
+  {
+    switch (format)
+    {
+    case pixel_format::indexed_1:
+      return 1;
+    case pixel_format::indexed_4:
+      return 4;
+    case pixel_format::indexed_8:
+      return 8;
+    case pixel_format::rgb_1555:
+      return 16;
+    case pixel_format::rgb_888:
+      return 24;
+    case pixel_format::rgba_8888:
+      return 32;
+    default:
+      return 0;
+    }
+  }
+
+  constexpr bool is_indexed(pixel_format format)
+  {
+    return format == pixel_format::indexed_1 || format == pixel_format::indexed_4 || format == pixel_format::indexed_8;
+  }
+
+  // The number of bytes needed for one row of pixels, without any padding.
+  constexpr std::size_t get_row_size(pixel_format format, std::size_t width)
+  {
+    return (width * get_bits_per_pixel(format) + 7) / 8;
+  }
+
+  template<typename ByteType>
+  struct basic_pixel_view
+  {
+    pixel_format format = pixel_format::unknown;
+    std::size_t width = 0;
+    std::size_t height = 0;
+    std::size_t stride = 0;
+    std::span<ByteType> data;
+
+    std::span<ByteType> row(std::size_t y) const
+    {
+      return data.subspan(y * stride, get_row_size(format, width));
+    }
+
+    std::size_t get_index(std::size_t x, std::size_t y) const
+    {
+      auto value = std::size_t(data[y * stride + x * get_bits_per_pixel(format) / 8]);
+
+      switch (format)
+      {
+      case pixel_format::indexed_1:
+        return (value >> (7 - x % 8)) & 0x01;
+      case pixel_format::indexed_4:
+        return x % 2 == 0 ? value >> 4 : value & 0x0f;
+      case pixel_format::indexed_8:
+        return value;
+      default:
+        throw std::invalid_argument("Only indexed pixels have a palette index");
+      }
+    }
+  };
+
+  using pixel_view = basic_pixel_view<std::byte>;
+  using const_pixel_view = basic_pixel_view<const std::byte>;
+
+  // Tightly packed rows of pixels in their original format, so that an 8-bit image takes one byte per pixel.
+  class pixel_buffer
+  {
+  public:
+    pixel_buffer() = default;
+
+    pixel_buffer(pixel_format format, std::size_t width, std::size_t height)
+      : format(format), width(width), height(height), stride(get_row_size(format, width)), data(stride * height)
+    {
+    }
+
+    // Takes over pixel data which is already in the right format, which is resized if it does not match the size of the image.
+    pixel_buffer(pixel_format format, std::size_t width, std::size_t height, std::vector<std::byte> data)
+      : format(format), width(width), height(height), stride(get_row_size(format, width)), data(std::move(data))
+    {
+      this->data.resize(stride * height);
+    }
+
+    pixel_format get_format() const
+    {
+      return format;
+    }
+
+    std::size_t get_width() const
+    {
+      return width;
+    }
+
+    std::size_t get_height() const
+    {
+      return height;
+    }
+
+    std::size_t get_stride() const
+    {
+      return stride;
+    }
+
+    bool empty() const
+    {
+      return data.empty();
+    }
+
+    std::span<std::byte> bytes()
+    {
+      return data;
+    }
+
+    std::span<const std::byte> bytes() const
+    {
+      return data;
+    }
+
+    std::span<std::byte> row(std::size_t y)
+    {
+      return std::span(data).subspan(y * stride, stride);
+    }
+
+    std::span<const std::byte> row(std::size_t y) const
+    {
+      return std::span(data).subspan(y * stride, stride);
+    }
+
+    pixel_view view()
+    {
+      return pixel_view{ format, width, height, stride, data };
+    }
+
+    const_pixel_view view() const
+    {
+      return const_pixel_view{ format, width, height, stride, data };
+    }
+
+    operator const_pixel_view() const
+    {
+      return view();
+    }
+
+    // Turns a bottom up image into a top down one, or the other way around.
+    void flip_rows()
+    {
+      if (height < 2)
+      {
+        return;
+      }
+
+      for (auto top = 0u, bottom = unsigned(height) - 1; top < bottom; ++top, --bottom)
+      {
+        std::swap_ranges(row(top).begin(), row(top).end(), row(bottom).begin());
+      }
+    }
+
+  private:
+    pixel_format format = pixel_format::unknown;
+    std::size_t width = 0;
+    std::size_t height = 0;
+    std::size_t stride = 0;
+    std::vector<std::byte> data;
+  };
+}// namespace siege::platform::bitmap
+
+#endif// SIEGE_PLATFORM_PIXEL_BUFFER_HPP
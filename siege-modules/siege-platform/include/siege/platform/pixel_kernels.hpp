@@ -0,0 +1,33 @@
+#ifndef SIEGE_PLATFORM_PIXEL_KERNELS_HPP
+#define SIEGE_PLATFORM_PIXEL_KERNELS_HPP
+
+#include <cstdint>
+#include <span>
+#include <siege/platform/palette.hpp>
+#include <siege/platform/pixel_buffer.hpp>
+
+namespace siege::platform::bitmap
+{
+  enum class instruction_set : std::uint8_t
+  {
+    scalar,
+    sse2,
+    avx2
+  };
+
+  // The widest instruction set which the current CPU supports and the kernels have a path for.
+  instruction_set get_supported_instruction_set();
+
+  // Writes every pixel as a palette::colour, looking up indexed pixels in colours.
+  // Indexes without a matching colour become transparent black.
+  // Rows are read using the stride of the view, so padded rows are skipped over,
+  // and are written bottom up when flip_rows is set.
+  // Asking for an instruction set the CPU does not support falls back to the best one that it does.
+  void convert_to_rgba(const_pixel_view pixels,
+    std::span<const palette::colour> colours,
+    std::span<std::byte> destination,
+    bool flip_rows,
+    instruction_set instructions);
+}// namespace siege::platform::bitmap
+
+#endif// SIEGE_PLATFORM_PIXEL_KERNELS_HPP
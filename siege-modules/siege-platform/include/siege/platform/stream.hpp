@@ -8,6 +8,11 @@
 #include <vector>
 #include <filesystem>
 #include <spanstream>
+#include <sstream>
+#include <span>
+#include <cstdint>
+#include <functional>
+#include <siege/platform/resource.hpp>
 
 #if WIN32
 #include <siege/platform/win/core/file.hpp>
@@ -221,6 +226,31 @@ namespace siege::platform
     return std::make_unique<std::istringstream>();
   }
 
+  struct batch_read_request
+  {
+    std::uint64_t offset;
+    std::span<std::byte> buffer;
+    std::size_t bytes_read = 0;
+  };
+
+  // Reads every request from the file at the given path, with many reads in flight at once.
+  // On Linux, io_uring is used when siege-platform was built with it, otherwise each read is a
+  // pread (or ReadFile on Windows) spread over the standard library's thread pool.
+  // Requests may complete in any order. Short reads are continued until each buffer is full,
+  // and std::runtime_error is thrown if any request could not be read completely.
+  void read_batch(const std::filesystem::path& path, std::span<batch_read_request> requests, std::size_t queue_depth = 64);
+
+  // Reads the contents of many files of one archive, for extraction or verification.
+  // Stored entries are read with read_batch, in batches of up to max_batch_size bytes,
+  // while compressed entries (or entries the reader cannot position a stream for) go through the reader.
+  // on_contents is called once per file from the calling thread, in no particular order,
+  // and only with complete contents: a stored entry which cannot be read throws std::runtime_error.
+  void read_file_contents_batch(const std::filesystem::path& archive_path,
+    const resource_reader& reader,
+    std::span<const file_info> files,
+    const std::function<void(const file_info&, std::span<const std::byte>)>& on_contents,
+    std::size_t max_batch_size = 64 * 1024 * 1024);
+
 }// namespace siege::platform
 
 #endif// OPEN_SIEGE_STREAM_HPP
@@ -1,6 +1,7 @@
 #include <set>
 #include <map>
 #include <cmath>
+#include <algorithm>
 #include <siege/platform/bitmap.hpp>
 #include <siege/platform/tagged_data.hpp>
 #include <siege/platform/stream.hpp>
@@ -25,41 +26,65 @@ namespace siege::platform::bitmap
     return header != bmp_alt1_tag && header != bmp_alt2_tag && header[0] == windows_bmp_tag[0] && header[1] == windows_bmp_tag[1];
   }
 
-  template<typename AlignmentType, typename PixelType>
-  [[maybe_unused]] std::size_t read_pixel_data(std::istream& raw_data, std::vector<PixelType>& raw_pixels, std::int32_t width, std::int32_t height, std::int32_t bit_depth)
+  pixel_format get_bmp_pixel_format(std::uint16_t bit_depth)
   {
-    const auto x_stride = width * bit_depth / 8;
-    const auto padding = platform::get_padding_size(x_stride, sizeof(AlignmentType));
-
-    if (padding == 0)
+    switch (bit_depth)
     {
-      platform::read(raw_data, reinterpret_cast<char*>(raw_pixels.data()), raw_pixels.size() * sizeof(PixelType));
-      return raw_pixels.size();
+    case 1:
+      return pixel_format::indexed_1;
+    case 4:
+      return pixel_format::indexed_4;
+    case 8:
+      return pixel_format::indexed_8;
+    case 16:
+      return pixel_format::rgb_1555;
+    case 24:
+      return pixel_format::rgb_888;
+    case 32:
+      return pixel_format::rgba_8888;
+    default:
+      return pixel_format::unknown;
     }
-    else
-    {
-      std::vector<std::byte> padding_bytes(padding);
+  }
+
+  // Each row of a BMP file is padded to a multiple of 4 bytes.
+  static std::size_t get_bmp_padding(pixel_format format, std::size_t width)
+  {
+    return platform::get_padding_size(get_row_size(format, width), sizeof(std::int32_t));
+  }
 
-      auto pos = 0u;
+  // BMP files store colours as BGR(A) and 16-bit pixels without an alpha bit,
+  // so rows are converted to or from the pixel_format layout while they are still in cache.
+  static void swap_bmp_row(pixel_format format, std::span<std::byte> row, bool is_reading)
+  {
+    switch (format)
+    {
+    case pixel_format::rgb_888:
+    case pixel_format::rgba_8888:
+    {
+      const auto pixel_size = get_bits_per_pixel(format) / 8;
 
-      auto start = raw_data.tellg();
-      for (auto i = 0; i < height; ++i)
+      for (auto x = 0u; x + pixel_size <= row.size(); x += pixel_size)
       {
-        if (pos > raw_pixels.size())
+        std::swap(row[x], row[x + 2]);
+      }
+      break;
+    }
+    case pixel_format::rgb_1555:
+      if (is_reading)
+      {
+        for (auto x = 1u; x < row.size(); x += 2)
         {
-          break;
+          row[x] |= std::byte{ 0x80 };
         }
-
-        platform::read(raw_data, reinterpret_cast<char*>(raw_pixels.data()) + pos, x_stride);
-        platform::read(raw_data, padding_bytes.data(), padding_bytes.size());
-        pos += x_stride;
       }
-
-      return raw_data.tellg() - start;
+      break;
+    default:
+      break;
     }
   }
 
-  windows_bmp_data get_bmp_data(std::istream& raw_data, bool auto_flip)
+  windows_bmp_data read_bmp_header(std::istream& raw_data)
   {
     windows_bmp_header header{};
     platform::read(raw_data, reinterpret_cast<char*>(&header), sizeof(header));
@@ -73,14 +98,25 @@ namespace siege::platform::bitmap
 
     platform::read(raw_data, reinterpret_cast<char*>(&info), sizeof(info));
 
+    // Newer versions of the info header have extra fields after the ones which are used here.
+    if (info.info_size > sizeof(info))
+    {
+      raw_data.ignore(info.info_size - sizeof(info));
+    }
+
+    std::size_t bytes_read = sizeof(header) + std::max<std::size_t>(info.info_size, sizeof(info));
+
     std::vector<palette::colour> colours;
 
-    const auto num_pixels = info.width.value() * info.height;
-    std::vector<std::int32_t> indexes;
     if (info.bit_depth <= 8)
     {
-      indexes.reserve(num_pixels);
       int num_colours = static_cast<int>(std::pow(float(2), info.bit_depth));
+
+      if (info.num_colours_used != 0 && info.num_colours_used < std::uint32_t(num_colours))
+      {
+        num_colours = int(info.num_colours_used);
+      }
+
       colours.reserve(num_colours);
 
       for (auto i = 0; i < num_colours; ++i)
@@ -90,65 +126,94 @@ namespace siege::platform::bitmap
         colours.emplace_back(palette::colour{ quad[2], quad[1], quad[0], std::byte{ 255 } });
       }
 
-      std::vector<std::byte> raw_pixels(num_pixels, std::byte{});
+      bytes_read += colours.size() * sizeof(palette::colour);
+    }
 
-      read_pixel_data<std::int32_t>(raw_data, raw_pixels, info.width, info.height, info.bit_depth);
+    if (header.offset > bytes_read)
+    {
+      raw_data.ignore(header.offset - bytes_read);
+    }
 
-      std::transform(raw_pixels.begin(), raw_pixels.end(), std::back_inserter(indexes), [](auto value) {
-        return static_cast<std::int32_t>(value);
-      });
+    return {
+      header,
+      info,
+      std::move(colours),
+      pixel_buffer{}
+    };
+  }
+
+  void read_bmp_pixels(std::istream& raw_data, const windows_bmp_info& info, pixel_view destination, bool auto_flip)
+  {
+    const auto format = get_bmp_pixel_format(info.bit_depth);
+    const auto width = std::size_t(std::abs(info.width.value()));
+    const auto height = std::size_t(std::abs(info.height.value()));
+
+    if (format == pixel_format::unknown || (format == pixel_format::rgb_1555 && info.compression != 0))
+    {
+      throw std::invalid_argument("The BMP pixel format is not supported.");
+    }
+
+    if (destination.format != format || destination.width != width || destination.height != height || destination.stride < get_row_size(format, width) || destination.data.size() < destination.stride * height)
+    {
+      throw std::invalid_argument("The destination does not match the size or format of the BMP.");
     }
-    else if (info.bit_depth == 24)
+
+    const auto padding = get_bmp_padding(format, width);
+
+    // Rows are stored bottom up unless the height is negative, which is
+    // handled by choosing where each row goes rather than flipping afterwards.
+    const bool is_bottom_up = info.height.value() > 0;
+
+    for (auto y = 0u; y < height; ++y)
     {
-      colours.reserve(num_pixels);
-      std::vector<std::array<std::byte, 3>> image_colours(num_pixels);
-      read_pixel_data<std::int32_t>(raw_data, image_colours, info.width, info.height, info.bit_depth);
+      auto row = destination.row(auto_flip && is_bottom_up ? height - 1 - y : y);
+      platform::read(raw_data, row.data(), row.size());
+      raw_data.ignore(padding);
 
-      std::transform(image_colours.begin(), image_colours.end(), std::back_inserter(colours), [](auto& colour) {
-        return palette::colour{ colour[2], colour[1], colour[0], std::byte(0xFF) };
-      });
+      swap_bmp_row(format, row, true);
     }
+  }
+
+  windows_bmp_data get_bmp_data(std::istream& raw_data, bool auto_flip)
+  {
+    auto result = read_bmp_header(raw_data);
+
+    auto format = get_bmp_pixel_format(result.info.bit_depth);
 
-    if (auto_flip)
+    if (format == pixel_format::unknown || (format == pixel_format::rgb_1555 && result.info.compression != 0))
     {
-      if (indexes.empty() && !colours.empty())
-      {
-        vertical_flip(colours, info.width);
-      }
-      else if (!indexes.empty())
-      {
-        vertical_flip(indexes, info.width);
-      }
+      return result;
     }
 
-    return {
-      header,
-      info,
-      colours,
-      indexes
-    };
+    result.pixels = pixel_buffer(format, std::size_t(std::abs(result.info.width.value())), std::size_t(std::abs(result.info.height.value())));
+    read_bmp_pixels(raw_data, result.info, result.pixels.view(), auto_flip);
+
+    return result;
   }
 
-  void write_bmp_data(std::ostream& raw_data, std::vector<palette::colour> colours, std::vector<std::byte> pixels, std::int32_t width, std::int32_t height, std::int32_t bit_depth, bool auto_flip)
+  void write_bmp_data(std::ostream& raw_data, std::span<const palette::colour> colours, const_pixel_view pixels, bool auto_flip)
   {
-    if (auto_flip)
+    const auto bit_depth = get_bits_per_pixel(pixels.format);
+
+    if (bit_depth == 0)
     {
-      if (pixels.empty() && !colours.empty())
-      {
-        vertical_flip(colours, width);
-      }
-      else if (!pixels.empty())
-      {
-        vertical_flip(pixels, width);
-      }
+      throw std::invalid_argument("The pixel format cannot be written to a BMP file.");
+    }
+
+    if (pixels.height > 0 && pixels.data.size() < (pixels.height - 1) * pixels.stride + get_row_size(pixels.format, pixels.width))
+    {
+      throw std::invalid_argument("The pixel view is smaller than its dimensions");
     }
 
+    const auto row_size = get_row_size(pixels.format, pixels.width);
+    const auto padding = get_bmp_padding(pixels.format, pixels.width);
+
     windows_bmp_header header{};
     header.tag = windows_bmp_tag;
     header.reserved1 = 0;
     header.reserved2 = 0;
 
-    if (bit_depth <= 8)
+    if (is_indexed(pixels.format))
     {
       header.offset = sizeof(header) + sizeof(windows_bmp_info) + int(colours.size()) * sizeof(palette::colour);
     }
@@ -159,65 +224,46 @@ namespace siege::platform::bitmap
 
     windows_bmp_info info{ 0 };
     info.info_size = sizeof(info);
-    info.width = width;
-    info.height = height;
+    info.width = std::int32_t(pixels.width);
+    info.height = std::int32_t(pixels.height);
     info.planes = 1;
-    info.bit_depth = bit_depth;
+    info.bit_depth = std::uint16_t(bit_depth);
     info.compression = 0;
-    info.image_size = width * height;
-
-    using AlignmentType = std::int32_t;
-    const auto x_stride = width * bit_depth / 8;
-    const auto padding = platform::get_padding_size(x_stride, sizeof(AlignmentType));
-
-    const auto num_pixels = info.width.value() * info.height * (info.bit_depth / 8);
+    info.image_size = std::uint32_t((row_size + padding) * pixels.height);
+    info.num_colours_used = is_indexed(pixels.format) ? std::uint32_t(colours.size()) : 0;
 
-
-    if (info.bit_depth <= 8 && pixels.size() != num_pixels)
-    {
-      throw std::invalid_argument("The pixels vector does not have the correct number of pixels.");
-    }
-    else if (info.bit_depth > 8 && colours.size() != (info.width.value() * info.height))
-    {
-      throw std::invalid_argument("The colours vector does not have the correct number of pixels.");
-    }
-
-    header.file_size = header.offset + num_pixels;
+    header.file_size = header.offset + info.image_size;
 
     platform::write(raw_data, reinterpret_cast<const char*>(&header), sizeof(header));
     platform::write(raw_data, reinterpret_cast<const char*>(&info), sizeof(info));
 
-    for (auto& colour : colours)
+    if (is_indexed(pixels.format))
     {
-      std::array<std::byte, 4> quad{ colour.blue, colour.green, colour.red, std::byte{ 0 } };
-      platform::write(raw_data, quad.data(), sizeof(quad));
+      for (auto& colour : colours)
+      {
+        std::array<std::byte, 4> quad{ colour.blue, colour.green, colour.red, std::byte{ 0 } };
+        platform::write(raw_data, quad.data(), sizeof(quad));
+      }
     }
 
-    if (pixels.empty())
-    {
-      return;
-    }
+    // Rows which need converting go through one scratch row, which also holds the padding.
+    const bool needs_conversion = pixels.format == pixel_format::rgb_888 || pixels.format == pixel_format::rgba_8888;
+    std::vector<std::byte> scratch(needs_conversion ? row_size + padding : padding);
 
-    if (padding == 0)
+    for (auto y = 0u; y < pixels.height; ++y)
     {
-      platform::write(raw_data, pixels.data(), pixels.size());
-    }
-    else
-    {
-      std::vector<std::byte> padding_bytes(padding, std::byte{ 0 });
-
-      auto pos = 0u;
+      auto row = pixels.row(auto_flip ? pixels.height - 1 - y : y);
 
-      for (auto i = 0; i < height; ++i)
+      if (needs_conversion)
       {
-        if (pos > pixels.size())
-        {
-          break;
-        }
-
-        platform::write(raw_data, pixels.data() + pos, x_stride);
-        platform::write(raw_data, padding_bytes.data(), padding_bytes.size());
-        pos += x_stride;
+        std::copy(row.begin(), row.end(), scratch.begin());
+        swap_bmp_row(pixels.format, std::span(scratch).first(row_size), false);
+        platform::write(raw_data, scratch.data(), scratch.size());
+      }
+      else
+      {
+        platform::write(raw_data, row.data(), row.size());
+        platform::write(raw_data, scratch.data(), scratch.size());
       }
     }
   }
@@ -238,64 +284,10 @@ namespace siege::platform::bitmap
       return pixels;
     }
 
-    std::vector<IndexType> results;
-    results.reserve(pixels.size());
-    std::map<std::size_t, std::size_t> palette_map;
-
-    for (auto x = 0u; x < original_colours.size(); x++)
-    {
-      auto& colour = original_colours[x];
-      auto result = std::find_if(other_colours.begin(), other_colours.end(), [&](auto& other) {
-        return other.red == colour.red && other.green == colour.green && other.blue == colour.blue;
-      });
-
-      if (result != other_colours.end())
-      {
-        auto other_index = std::distance(other_colours.begin(), result);
-        palette_map[x] = other_index;
-      }
-      else
-      {
-        std::map<double, std::size_t> distances;
-        for (auto y = 0u; y < other_colours.size(); y++)
-        {
-          auto& other = other_colours[y];
-          auto distance = palette::colour_distance(colour, other);
-          distances[distance] = y;
-        }
-
-        if (only_unique)
-        {
-          for (auto distance : distances)
-          {
-            auto already_exists = std::find_if(palette_map.begin(), palette_map.end(), [&](auto& elem) {
-              return elem.second == distance.second;
-            });
-
-            if (already_exists == palette_map.end())
-            {
-              palette_map[x] = distance.second;
-              break;
-            }
-          }
-
-          if (auto inserted = palette_map.find(x); inserted == palette_map.end())
-          {
-            palette_map[x] = distances.begin()->second;
-          }
-        }
-        else
-        {
-          palette_map[x] = distances.begin()->second;
-        }
-      }
-    }
+    auto table = palette::get_remap_table(original_colours, other_colours, only_unique);
 
-    for (auto pixel : pixels)
-    {
-      auto new_index = palette_map[std::size_t(pixel)];
-      results.emplace_back(IndexType(new_index));
-    }
+    std::vector<IndexType> results(pixels.size());
+    palette::apply_remap_table(*table, pixels, results);
 
     return results;
   }
@@ -1,4 +1,11 @@
 #include <optional>
+#include <map>
+#include <unordered_map>
+#include <mutex>
+#include <string>
+#include <algorithm>
+#include <execution>
+#include <stdexcept>
 #include <siege/platform/palette.hpp>
 #include <siege/platform/stream.hpp>
 
@@ -126,4 +133,238 @@ namespace siege::platform::palette
 
     return sizeof(riff_tag) + sizeof(file_size) + file_size;
   }
+
+  // The squared form of colour_distance, which orders colours the same way without the square root.
+  inline long colour_distance_squared(const std::array<long, 3>& e1, const std::array<long, 3>& e2)
+  {
+    long rmean = (e1[0] + e2[0]) / 2;
+    long r = e1[0] - e2[0];
+    long g = e1[1] - e2[1];
+    long b = e1[2] - e2[2];
+    return (((512 + rmean) * r * r) >> 8) + 4 * g * g + (((767 - rmean) * b * b) >> 8);
+  }
+
+  class colour_tree
+  {
+  public:
+    explicit colour_tree(std::span<const colour> colours)
+    {
+      nodes.reserve(colours.size());
+
+      for (auto i = 0u; i < colours.size(); ++i)
+      {
+        nodes.emplace_back(node{ { long(colours[i].red), long(colours[i].green), long(colours[i].blue) }, i, 0 });
+      }
+
+      build(0, nodes.size(), 0);
+    }
+
+    // Ties go to the later colour, which is what remapping has always done.
+    std::optional<std::size_t> find_nearest(const colour& value, const std::vector<bool>& excluded) const
+    {
+      search_state state{ { long(value.red), long(value.green), long(value.blue) }, excluded };
+      search(0, nodes.size(), state);
+      return state.best_index;
+    }
+
+  private:
+    struct node
+    {
+      std::array<long, 3> rgb;
+      std::size_t index;
+      std::uint8_t axis;
+    };
+
+    struct search_state
+    {
+      std::array<long, 3> rgb;
+      const std::vector<bool>& excluded;
+      std::optional<std::size_t> best_index = std::nullopt;
+      long best_distance = std::numeric_limits<long>::max();
+    };
+
+    // The smallest weight redmean can give each channel, so that the distance to a
+    // splitting plane never overestimates the distance to anything behind it.
+    static constexpr std::array<long, 3> minimum_weights = { 2, 4, 2 };
+
+    void build(std::size_t begin, std::size_t end, std::uint8_t axis)
+    {
+      if (end - begin <= 1)
+      {
+        if (begin < end)
+        {
+          nodes[begin].axis = axis;
+        }
+        return;
+      }
+
+      auto middle = begin + (end - begin) / 2;
+      std::nth_element(nodes.begin() + begin, nodes.begin() + middle, nodes.begin() + end, [axis](auto& left, auto& right) {
+        return left.rgb[axis] < right.rgb[axis];
+      });
+      nodes[middle].axis = axis;
+
+      auto next_axis = std::uint8_t((axis + 1) % 3);
+      build(begin, middle, next_axis);
+      build(middle + 1, end, next_axis);
+    }
+
+    void search(std::size_t begin, std::size_t end, search_state& state) const
+    {
+      if (begin >= end)
+      {
+        return;
+      }
+
+      auto middle = begin + (end - begin) / 2;
+      auto& current = nodes[middle];
+
+      if (!(current.index < state.excluded.size() && state.excluded[current.index]))
+      {
+        auto distance = colour_distance_squared(current.rgb, state.rgb);
+
+        if (distance < state.best_distance || (distance == state.best_distance && current.index > *state.best_index))
+        {
+          state.best_distance = distance;
+          state.best_index = current.index;
+        }
+      }
+
+      auto difference = state.rgb[current.axis] - current.rgb[current.axis];
+      auto near_side = difference < 0 ? std::make_pair(begin, middle) : std::make_pair(middle + 1, end);
+      auto far_side = difference < 0 ? std::make_pair(middle + 1, end) : std::make_pair(begin, middle);
+
+      search(near_side.first, near_side.second, state);
+
+      if (minimum_weights[current.axis] * difference * difference <= state.best_distance)
+      {
+        search(far_side.first, far_side.second, state);
+      }
+    }
+
+    std::vector<node> nodes;
+  };
+
+  std::vector<std::size_t> make_remap_table(std::span<const colour> original_colours,
+    std::span<const colour> other_colours,
+    bool only_unique)
+  {
+    std::vector<std::size_t> results(original_colours.size(), 0);
+
+    if (other_colours.empty())
+    {
+      return results;
+    }
+
+    std::map<std::array<std::byte, 3>, std::size_t> exact_matches;
+
+    for (auto i = 0u; i < other_colours.size(); ++i)
+    {
+      exact_matches.emplace(std::array<std::byte, 3>{ other_colours[i].red, other_colours[i].green, other_colours[i].blue }, i);
+    }
+
+    colour_tree tree(other_colours);
+    const std::vector<bool> nothing_excluded;
+    std::vector<bool> used(only_unique ? other_colours.size() : 0, false);
+
+    for (auto x = 0u; x < original_colours.size(); ++x)
+    {
+      auto& colour = original_colours[x];
+
+      if (auto match = exact_matches.find(std::array<std::byte, 3>{ colour.red, colour.green, colour.blue }); match != exact_matches.end())
+      {
+        results[x] = match->second;
+      }
+      else if (only_unique)
+      {
+        auto nearest = tree.find_nearest(colour, used);
+        results[x] = nearest.has_value() ? *nearest : *tree.find_nearest(colour, nothing_excluded);
+      }
+      else
+      {
+        results[x] = *tree.find_nearest(colour, nothing_excluded);
+      }
+
+      if (only_unique)
+      {
+        used[results[x]] = true;
+      }
+    }
+
+    return results;
+  }
+
+  std::shared_ptr<const std::vector<std::size_t>> get_remap_table(std::span<const colour> original_colours,
+    std::span<const colour> other_colours,
+    bool only_unique)
+  {
+    // Palettes are small enough that the raw bytes of both make a good key.
+    constexpr static auto max_cached_tables = 1024;
+    static std::mutex cache_mutex;
+    static std::unordered_map<std::string, std::shared_ptr<const std::vector<std::size_t>>> cache;
+
+    std::string key;
+    key.reserve(sizeof(colour) * (original_colours.size() + other_colours.size()) + sizeof(std::size_t) + 1);
+    auto original_size = original_colours.size();
+    key.append(reinterpret_cast<const char*>(&original_size), sizeof(original_size));
+    key.append(reinterpret_cast<const char*>(original_colours.data()), original_colours.size_bytes());
+    key.append(reinterpret_cast<const char*>(other_colours.data()), other_colours.size_bytes());
+    key.push_back(only_unique ? 1 : 0);
+
+    {
+      std::lock_guard<std::mutex> guard(cache_mutex);
+
+      if (auto existing = cache.find(key); existing != cache.end())
+      {
+        return existing->second;
+      }
+    }
+
+    auto table = std::make_shared<const std::vector<std::size_t>>(make_remap_table(original_colours, other_colours, only_unique));
+
+    std::lock_guard<std::mutex> guard(cache_mutex);
+
+    if (cache.size() >= max_cached_tables)
+    {
+      cache.clear();
+    }
+
+    cache.emplace(std::move(key), table);
+
+    return table;
+  }
+
+  void apply_remap_table(std::span<const std::size_t> table, std::span<const std::byte> pixels, std::span<std::byte> output)
+  {
+    if (output.size() < pixels.size())
+    {
+      throw std::invalid_argument("The output is smaller than the pixels being remapped");
+    }
+
+    // Every possible byte gets an entry, which leaves the per pixel work as a single lookup with no bounds check.
+    std::array<std::byte, 256> lookup{};
+
+    for (auto i = 0u; i < lookup.size() && i < table.size(); ++i)
+    {
+      lookup[i] = std::byte(table[i]);
+    }
+
+    std::transform(std::execution::par_unseq, pixels.begin(), pixels.end(), output.begin(), [&lookup](std::byte pixel) {
+      return lookup[std::size_t(pixel)];
+    });
+  }
+
+  void apply_remap_table(std::span<const std::size_t> table, std::span<const std::int32_t> pixels, std::span<std::int32_t> output)
+  {
+    if (output.size() < pixels.size())
+    {
+      throw std::invalid_argument("The output is smaller than the pixels being remapped");
+    }
+
+    std::vector<std::int32_t> lookup(table.begin(), table.end());
+
+    std::transform(std::execution::par_unseq, pixels.begin(), pixels.end(), output.begin(), [&lookup](std::int32_t pixel) {
+      return std::size_t(pixel) < lookup.size() ? lookup[std::size_t(pixel)] : 0;
+    });
+  }
 }// namespace siege::content::pal
@@ -0,0 +1,311 @@
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <stdexcept>
+#include <siege/platform/bitmap.hpp>
+#include <siege/platform/pixel_kernels.hpp>
+
+#if defined(_M_X64) || defined(__x86_64__) || defined(_M_IX86) || defined(__i386__)
+#define SIEGE_HAS_X86_KERNELS 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+#if defined(SIEGE_HAS_X86_KERNELS) && (defined(__GNUC__) || defined(__clang__))
+#define SIEGE_TARGET_SSE2 __attribute__((target("sse2")))
+#define SIEGE_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define SIEGE_TARGET_SSE2
+#define SIEGE_TARGET_AVX2
+#endif
+
+namespace siege::platform::bitmap
+{
+  // Palette colours as 32-bit values, so that a lookup is a single load.
+  // Every possible index has an entry, which removes the bounds check from the inner loops.
+  using colour_table = std::array<std::uint32_t, 256>;
+
+  static colour_table make_colour_table(std::span<const palette::colour> colours)
+  {
+    colour_table table{};
+    std::memcpy(table.data(), colours.data(), std::min(colours.size(), table.size()) * sizeof(palette::colour));
+    return table;
+  }
+
+  static std::byte expand_5_bits(std::uint32_t value)
+  {
+    return std::byte((value << 3) | (value >> 2));
+  }
+
+  // The scalar kernels start at first_x so that the SIMD kernels can hand them the tail of a row.
+  static void expand_row_scalar(const_pixel_view pixels, const colour_table& table, std::size_t y, std::size_t first_x, palette::colour* output)
+  {
+    auto row = pixels.row(y);
+
+    for (auto x = first_x; x < pixels.width; ++x)
+    {
+      switch (pixels.format)
+      {
+      case pixel_format::indexed_1:
+        std::memcpy(&output[x], &table[(std::size_t(row[x / 8]) >> (7 - x % 8)) & 0x01], sizeof(palette::colour));
+        break;
+      case pixel_format::indexed_4:
+      {
+        auto value = std::size_t(row[x / 2]);
+        std::memcpy(&output[x], &table[x % 2 == 0 ? value >> 4 : value & 0x0f], sizeof(palette::colour));
+        break;
+      }
+      case pixel_format::indexed_8:
+        std::memcpy(&output[x], &table[std::size_t(row[x])], sizeof(palette::colour));
+        break;
+      case pixel_format::rgb_1555:
+      {
+        auto value = std::uint32_t(row[x * 2]) | (std::uint32_t(row[x * 2 + 1]) << 8);
+        output[x] = palette::colour{ expand_5_bits((value >> 10) & 0x1f), expand_5_bits((value >> 5) & 0x1f), expand_5_bits(value & 0x1f), (value & 0x8000) ? std::byte{ 0xff } : std::byte{} };
+        break;
+      }
+      case pixel_format::rgb_888:
+        output[x] = palette::colour{ row[x * 3], row[x * 3 + 1], row[x * 3 + 2], std::byte{ 0xff } };
+        break;
+      case pixel_format::rgba_8888:
+        std::memcpy(&output[x], &row[x * 4], sizeof(palette::colour));
+        break;
+      default:
+        output[x] = palette::colour{};
+        break;
+      }
+    }
+  }
+
+#if defined(SIEGE_HAS_X86_KERNELS)
+  // Splits 8 bytes of 4-bit pixels into 16 bytes of indexes, with the high nibble first.
+  SIEGE_TARGET_SSE2 static __m128i unpack_nibbles(const std::byte* source)
+  {
+    const auto mask = _mm_set1_epi8(0x0f);
+    auto packed = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(source));
+    auto high = _mm_and_si128(_mm_srli_epi16(packed, 4), mask);
+    auto low = _mm_and_si128(packed, mask);
+    return _mm_unpacklo_epi8(high, low);
+  }
+
+  // SSE2 has no gather, so indexes are looked up one at a time but stored four at a time.
+  SIEGE_TARGET_SSE2 static void lookup_16_sse2(const colour_table& table, __m128i indexes, palette::colour* output)
+  {
+    alignas(16) std::array<std::uint8_t, 16> values;
+    _mm_store_si128(reinterpret_cast<__m128i*>(values.data()), indexes);
+
+    for (auto i = 0u; i < values.size(); i += 4)
+    {
+      auto colours = _mm_setr_epi32(int(table[values[i]]), int(table[values[i + 1]]), int(table[values[i + 2]]), int(table[values[i + 3]]));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(output + i), colours);
+    }
+  }
+
+  SIEGE_TARGET_SSE2 static __m128i expand_5_bits_sse2(__m128i channel)
+  {
+    return _mm_or_si128(_mm_slli_epi16(channel, 3), _mm_srli_epi16(channel, 2));
+  }
+
+  // Converts 8 pixels of 1555 into RGBA.
+  SIEGE_TARGET_SSE2 static void expand_1555_sse2(__m128i value, palette::colour* output)
+  {
+    const auto mask = _mm_set1_epi16(0x1f);
+
+    auto red = expand_5_bits_sse2(_mm_and_si128(_mm_srli_epi16(value, 10), mask));
+    auto green = expand_5_bits_sse2(_mm_and_si128(_mm_srli_epi16(value, 5), mask));
+    auto blue = expand_5_bits_sse2(_mm_and_si128(value, mask));
+    auto alpha = _mm_srli_epi16(_mm_srai_epi16(value, 15), 8);
+
+    auto red_green = _mm_or_si128(red, _mm_slli_epi16(green, 8));
+    auto blue_alpha = _mm_or_si128(blue, _mm_slli_epi16(alpha, 8));
+
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(output), _mm_unpacklo_epi16(red_green, blue_alpha));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(output + 4), _mm_unpackhi_epi16(red_green, blue_alpha));
+  }
+
+  SIEGE_TARGET_SSE2 static void expand_row_sse2(const_pixel_view pixels, const colour_table& table, std::size_t y, palette::colour* output)
+  {
+    auto row = pixels.row(y).data();
+    std::size_t x = 0;
+
+    switch (pixels.format)
+    {
+    case pixel_format::indexed_4:
+      for (; x + 16 <= pixels.width; x += 16)
+      {
+        lookup_16_sse2(table, unpack_nibbles(row + x / 2), output + x);
+      }
+      break;
+    case pixel_format::indexed_8:
+      for (; x + 16 <= pixels.width; x += 16)
+      {
+        lookup_16_sse2(table, _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + x)), output + x);
+      }
+      break;
+    case pixel_format::rgb_1555:
+      for (; x + 8 <= pixels.width; x += 8)
+      {
+        expand_1555_sse2(_mm_loadu_si128(reinterpret_cast<const __m128i*>(row + x * 2)), output + x);
+      }
+      break;
+    default:
+      break;
+    }
+
+    expand_row_scalar(pixels, table, y, x, output);
+  }
+
+  SIEGE_TARGET_AVX2 static __m256i expand_5_bits_avx2(__m256i channel)
+  {
+    return _mm256_or_si256(_mm256_slli_epi16(channel, 3), _mm256_srli_epi16(channel, 2));
+  }
+
+  // Looks up 16 indexes with two 8-wide gathers.
+  SIEGE_TARGET_AVX2 static void lookup_16_avx2(const colour_table& table, __m128i indexes, palette::colour* output)
+  {
+    auto* base = reinterpret_cast<const int*>(table.data());
+    auto first = _mm256_i32gather_epi32(base, _mm256_cvtepu8_epi32(indexes), 4);
+    auto second = _mm256_i32gather_epi32(base, _mm256_cvtepu8_epi32(_mm_srli_si128(indexes, 8)), 4);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(output), first);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(output + 8), second);
+  }
+
+  SIEGE_TARGET_AVX2 static void expand_row_avx2(const_pixel_view pixels, const colour_table& table, std::size_t y, palette::colour* output)
+  {
+    auto row = pixels.row(y).data();
+    std::size_t x = 0;
+
+    switch (pixels.format)
+    {
+    case pixel_format::indexed_4:
+      for (; x + 16 <= pixels.width; x += 16)
+      {
+        lookup_16_avx2(table, unpack_nibbles(row + x / 2), output + x);
+      }
+      break;
+    case pixel_format::indexed_8:
+      for (; x + 16 <= pixels.width; x += 16)
+      {
+        lookup_16_avx2(table, _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + x)), output + x);
+      }
+      break;
+    case pixel_format::rgb_1555:
+    {
+      const auto mask = _mm256_set1_epi16(0x1f);
+
+      for (; x + 16 <= pixels.width; x += 16)
+      {
+        auto value = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + x * 2));
+        auto red = expand_5_bits_avx2(_mm256_and_si256(_mm256_srli_epi16(value, 10), mask));
+        auto green = expand_5_bits_avx2(_mm256_and_si256(_mm256_srli_epi16(value, 5), mask));
+        auto blue = expand_5_bits_avx2(_mm256_and_si256(value, mask));
+        auto alpha = _mm256_srli_epi16(_mm256_srai_epi16(value, 15), 8);
+
+        auto red_green = _mm256_or_si256(red, _mm256_slli_epi16(green, 8));
+        auto blue_alpha = _mm256_or_si256(blue, _mm256_slli_epi16(alpha, 8));
+
+        // Unpacking works within each 128-bit lane, so the halves are put back in order afterwards.
+        auto low = _mm256_unpacklo_epi16(red_green, blue_alpha);
+        auto high = _mm256_unpackhi_epi16(red_green, blue_alpha);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(output + x), _mm256_permute2x128_si256(low, high, 0x20));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(output + x + 8), _mm256_permute2x128_si256(low, high, 0x31));
+      }
+      break;
+    }
+    default:
+      break;
+    }
+
+    expand_row_scalar(pixels, table, y, x, output);
+  }
+#endif
+
+  instruction_set get_supported_instruction_set()
+  {
+#if defined(SIEGE_HAS_X86_KERNELS)
+    static const auto supported = [] {
+#if defined(_MSC_VER) && !defined(__clang__)
+      std::array<int, 4> info{};
+      __cpuid(info.data(), 0);
+      const auto max_leaf = info[0];
+
+      __cpuid(info.data(), 1);
+      const bool has_sse2 = (info[3] & (1 << 26)) != 0;
+      const bool has_os_avx = (info[2] & (1 << 27)) != 0 && (info[2] & (1 << 28)) != 0 && (_xgetbv(0) & 0x06) == 0x06;
+
+      bool has_avx2 = false;
+
+      if (has_os_avx && max_leaf >= 7)
+      {
+        __cpuidex(info.data(), 7, 0);
+        has_avx2 = (info[1] & (1 << 5)) != 0;
+      }
+#else
+      __builtin_cpu_init();
+      const bool has_sse2 = __builtin_cpu_supports("sse2");
+      const bool has_avx2 = __builtin_cpu_supports("avx2");
+#endif
+
+      if (has_avx2)
+      {
+        return instruction_set::avx2;
+      }
+
+      return has_sse2 ? instruction_set::sse2 : instruction_set::scalar;
+    }();
+
+    return supported;
+#else
+    return instruction_set::scalar;
+#endif
+  }
+
+  void convert_to_rgba(const_pixel_view pixels,
+    std::span<const palette::colour> colours,
+    std::span<std::byte> destination,
+    bool flip_rows,
+    instruction_set instructions)
+  {
+    if (destination.size() < pixels.width * pixels.height * sizeof(palette::colour))
+    {
+      throw std::invalid_argument("The destination is too small for the pixels being converted");
+    }
+
+    if (pixels.height > 0 && pixels.data.size() < (pixels.height - 1) * pixels.stride + get_row_size(pixels.format, pixels.width))
+    {
+      throw std::invalid_argument("The pixel view is smaller than its dimensions");
+    }
+
+    instructions = std::min(instructions, get_supported_instruction_set());
+
+    const auto table = is_indexed(pixels.format) ? make_colour_table(colours) : colour_table{};
+    auto* output = reinterpret_cast<palette::colour*>(destination.data());
+
+    for (auto y = 0u; y < pixels.height; ++y)
+    {
+      auto* output_row = output + (flip_rows ? pixels.height - 1 - y : y) * pixels.width;
+
+      switch (instructions)
+      {
+#if defined(SIEGE_HAS_X86_KERNELS)
+      case instruction_set::avx2:
+        expand_row_avx2(pixels, table, y, output_row);
+        break;
+      case instruction_set::sse2:
+        expand_row_sse2(pixels, table, y, output_row);
+        break;
+#endif
+      default:
+        expand_row_scalar(pixels, table, y, 0, output_row);
+        break;
+      }
+    }
+  }
+
+  void convert_to_rgba(const_pixel_view pixels, std::span<const palette::colour> colours, std::span<std::byte> destination, bool flip_rows)
+  {
+    convert_to_rgba(pixels, colours, destination, flip_rows, get_supported_instruction_set());
+  }
+}// namespace siege::platform::bitmap
@@ -32,21 +32,6 @@ namespace siege::platform::bitmap
         return *factory;
     }
 
-    void apply_palette(windows_bmp_data& bitmap)
-    {
-        if (!bitmap.indexes.empty() && !bitmap.colours.empty())
-        {
-          std::vector<platform::palette::colour> colours(bitmap.indexes.size());
-
-            std::transform(bitmap.indexes.begin(), bitmap.indexes.end(), colours.begin(), [&](auto index) {
-                return bitmap.colours.at(index);
-            });
-
-            bitmap.colours = colours;
-            bitmap.indexes.clear();
-        }
-    }
-
     std::vector<std::any> load(std::filesystem::path filename)
     {
         win32::com::com_ptr<IWICBitmapDecoder> decoder;
@@ -85,15 +70,12 @@ namespace siege::platform::bitmap
         frames.reserve(bitmaps.size());
 
         std::transform(bitmaps.begin(), bitmaps.end(), std::back_inserter(frames), [&](auto& value) {
-            apply_palette(value);
             return std::move(value);    
         });
     }
 
     platform_image::platform_image(windows_bmp_data bitmap)
     {
-        apply_palette(bitmap);
-
         frames.emplace_back(std::move(bitmap));
     }
 
@@ -192,30 +174,42 @@ namespace siege::platform::bitmap
         else if (item.type().hash_code() == typeid(windows_bmp_data).hash_code())
         {
             const auto& bitmap = std::any_cast<const windows_bmp_data&>(item);
-            
-            if (bitmap.indexes.empty() && !bitmap.colours.empty() && 
-                bitmap.info.bit_depth == bits && 
-                bitmap.info.width == size.first &&
-                bitmap.info.height == size.second)
+
+            if (bitmap.pixels.empty())
             {
-                std::memcpy(pixels.data(), bitmap.colours.data(), sizeof(platform::palette::colour) * bitmap.colours.size());
-              return sizeof(platform::palette::colour) * bitmap.colours.size();
+                return 0;
             }
-            else if (bitmap.indexes.empty() && !bitmap.colours.empty())
+
+            try
             {
+                // The pixels are only expanded to 32 bits when they are being displayed,
+                // and straight into the destination when no scaling is needed.
+                if (bitmap.pixels.get_width() == std::size_t(size.first) && bitmap.pixels.get_height() == std::size_t(size.second))
+                {
+                    convert_to_rgba(bitmap.pixels, bitmap.colours, pixels);
+                    return final_result;
+                }
+
+                std::vector<platform::palette::colour> colours(bitmap.pixels.get_width() * bitmap.pixels.get_height());
+                convert_to_rgba(bitmap.pixels, bitmap.colours, std::as_writable_bytes(std::span(colours)));
+
                 win32::com::com_ptr<IWICBitmap> wic_bitmap;
 
-                assert(bitmap_factory().CreateBitmapFromMemory(bitmap.info.width, 
-                            bitmap.info.height, 
+                assert(bitmap_factory().CreateBitmapFromMemory(UINT(bitmap.pixels.get_width()), 
+                            UINT(bitmap.pixels.get_height()), 
                             GUID_WICPixelFormat32bppRGB, 
-                            bitmap.info.width * 4,
-                            bitmap.info.width * 4 * bitmap.info.height,
-                         reinterpret_cast<BYTE*>(const_cast<platform::palette::colour*>(bitmap.colours.data())),
+                            UINT(bitmap.pixels.get_width() * 4),
+                            UINT(colours.size() * 4),
+                            reinterpret_cast<BYTE*>(colours.data()),
                             wic_bitmap.put()
                     ) == S_OK);
             
                 return scale_bitmap(wic_bitmap.as<IWICBitmapSource>());
-            }    
+            }
+            catch (...)
+            {
+                return 0;
+            }
         }
 
         return 0;                
@@ -0,0 +1,281 @@
+#include <algorithm>
+#include <execution>
+#include <stdexcept>
+#include <string>
+#include <siege/platform/stream.hpp>
+
+#if !WIN32
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#if SIEGE_HAS_IO_URING
+#include <liburing.h>
+#endif
+
+namespace siege::platform
+{
+  // io_uring and ReadFile take 32-bit sizes, so larger buffers are read in several pieces.
+  constexpr std::size_t max_read_size = 0x40000000;
+
+#if WIN32
+  static void read_batch_request(HANDLE file, batch_read_request& request)
+  {
+    while (request.bytes_read < request.buffer.size())
+    {
+      auto offset = request.offset + request.bytes_read;
+      OVERLAPPED position{};
+      position.Offset = DWORD(offset & 0xFFFFFFFF);
+      position.OffsetHigh = DWORD(offset >> 32);
+      DWORD amount_read = 0;
+      auto amount_to_read = DWORD(std::min<std::size_t>(request.buffer.size() - request.bytes_read, max_read_size));
+
+      if (!::ReadFile(file, request.buffer.data() + request.bytes_read, amount_to_read, &amount_read, &position) || amount_read == 0)
+      {
+        break;
+      }
+
+      request.bytes_read += amount_read;
+    }
+  }
+#else
+  static void read_batch_request(int file, batch_read_request& request)
+  {
+    while (request.bytes_read < request.buffer.size())
+    {
+      auto amount_read = ::pread(file, request.buffer.data() + request.bytes_read, request.buffer.size() - request.bytes_read, off_t(request.offset + request.bytes_read));
+
+      if (amount_read < 0 && errno == EINTR)
+      {
+        continue;
+      }
+
+      if (amount_read <= 0)
+      {
+        break;
+      }
+
+      request.bytes_read += std::size_t(amount_read);
+    }
+  }
+#endif
+
+#if SIEGE_HAS_IO_URING
+  // Returns false if io_uring is not usable (such as when it is disabled by the kernel or a container),
+  // in which case nothing has been read.
+  // Short reads are submitted again for the rest of their buffer. Reads which fail are left unfinished,
+  // for read_batch to retry with pread.
+  static bool read_batch_io_uring(int file, std::span<batch_read_request> requests, std::size_t queue_depth)
+  {
+    io_uring ring{};
+
+    if (io_uring_queue_init(unsigned(queue_depth), &ring, 0) < 0)
+    {
+      return false;
+    }
+
+    std::size_t next = 0;
+    std::size_t in_flight = 0;
+    std::vector<std::size_t> short_reads;
+
+    while (next < requests.size() || !short_reads.empty() || in_flight > 0)
+    {
+      while ((next < requests.size() || !short_reads.empty()) && in_flight < queue_depth)
+      {
+        auto* entry = io_uring_get_sqe(&ring);
+
+        if (!entry)
+        {
+          break;
+        }
+
+        std::size_t index = next;
+
+        if (!short_reads.empty())
+        {
+          index = short_reads.back();
+          short_reads.pop_back();
+        }
+        else
+        {
+          next++;
+        }
+
+        auto& request = requests[index];
+        auto remaining = request.buffer.size() - request.bytes_read;
+        io_uring_prep_read(entry, file, request.buffer.data() + request.bytes_read, unsigned(std::min(remaining, max_read_size)), request.offset + request.bytes_read);
+        io_uring_sqe_set_data64(entry, index);
+        in_flight++;
+      }
+
+      io_uring_submit_and_wait(&ring, 1);
+
+      io_uring_cqe* completion = nullptr;
+      unsigned head = 0;
+      unsigned count = 0;
+
+      io_uring_for_each_cqe(&ring, head, completion)
+      {
+        auto index = std::size_t(io_uring_cqe_get_data64(completion));
+        auto& request = requests[index];
+
+        if (completion->res > 0)
+        {
+          request.bytes_read += std::size_t(completion->res);
+
+          if (request.bytes_read < request.buffer.size())
+          {
+            short_reads.emplace_back(index);
+          }
+        }
+
+        count++;
+        in_flight--;
+      }
+
+      io_uring_cq_advance(&ring, count);
+    }
+
+    io_uring_queue_exit(&ring);
+
+    return true;
+  }
+#endif
+
+  static void throw_if_incomplete(const std::filesystem::path& path, std::span<const batch_read_request> requests)
+  {
+    auto incomplete = std::find_if(requests.begin(), requests.end(), [](const auto& request) {
+      return request.bytes_read != request.buffer.size();
+    });
+
+    if (incomplete != requests.end())
+    {
+      throw std::runtime_error("Could only read " + std::to_string(incomplete->bytes_read) + " of " + std::to_string(incomplete->buffer.size()) + " bytes at offset " + std::to_string(incomplete->offset) + " of " + path.string() + ".");
+    }
+  }
+
+  void read_batch(const std::filesystem::path& path, std::span<batch_read_request> requests, std::size_t queue_depth)
+  {
+    if (requests.empty())
+    {
+      return;
+    }
+
+    queue_depth = std::clamp<std::size_t>(queue_depth, 1, 4096);
+
+#if WIN32
+    auto file = ::CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_RANDOM_ACCESS, nullptr);
+
+    if (file == INVALID_HANDLE_VALUE)
+    {
+      throw std::runtime_error("Could not open " + path.string() + " for reading.");
+    }
+
+    std::for_each(std::execution::par, requests.begin(), requests.end(), [file](auto& request) {
+      read_batch_request(file, request);
+    });
+
+    ::CloseHandle(file);
+#else
+    auto file = ::open(path.c_str(), O_RDONLY);
+
+    if (file == -1)
+    {
+      throw std::runtime_error("Could not open " + path.string() + " for reading.");
+    }
+
+#if SIEGE_HAS_IO_URING
+    if (read_batch_io_uring(file, requests, queue_depth))
+    {
+      // Anything io_uring could not finish gets one more try with pread.
+      for (auto& request : requests)
+      {
+        if (request.bytes_read < request.buffer.size())
+        {
+          read_batch_request(file, request);
+        }
+      }
+
+      ::close(file);
+      throw_if_incomplete(path, requests);
+      return;
+    }
+#endif
+
+    std::for_each(std::execution::par, requests.begin(), requests.end(), [file](auto& request) {
+      read_batch_request(file, request);
+    });
+
+    ::close(file);
+#endif
+
+    throw_if_incomplete(path, requests);
+  }
+
+  void read_file_contents_batch(const std::filesystem::path& archive_path,
+    const resource_reader& reader,
+    std::span<const file_info> files,
+    const std::function<void(const file_info&, std::span<const std::byte>)>& on_contents,
+    std::size_t max_batch_size)
+  {
+    std::any cache;
+    std::ifstream archive(archive_path, std::ios::binary);
+    archive.seekg(0, std::ios::end);
+    const auto archive_size = std::size_t(archive.tellg());
+
+    std::vector<const file_info*> pending_files;
+    std::vector<std::vector<std::byte>> pending_buffers;
+    std::vector<batch_read_request> requests;
+    std::size_t pending_size = 0;
+
+    auto flush = [&]() {
+      // Throws rather than handing over a partly filled buffer.
+      read_batch(archive_path, requests);
+
+      for (auto i = 0u; i < requests.size(); ++i)
+      {
+        on_contents(*pending_files[i], requests[i].buffer);
+      }
+
+      pending_files.clear();
+      pending_buffers.clear();
+      requests.clear();
+      pending_size = 0;
+    };
+
+    for (const auto& file : files)
+    {
+      if (file.compression_type == compression_type::none && file.size > 0)
+      {
+        // Readers which cannot seek to an entry leave the stream where it was.
+        archive.clear();
+        archive.seekg(0, std::ios::end);
+        reader.set_stream_position(archive, file);
+        auto position = archive.tellg();
+
+        if (position != std::istream::pos_type(-1) && std::size_t(position) != archive_size && std::size_t(position) + file.size <= archive_size)
+        {
+          pending_files.emplace_back(&file);
+          auto& buffer = pending_buffers.emplace_back(file.size);
+          requests.emplace_back(batch_read_request{ .offset = std::uint64_t(position), .buffer = buffer });
+          pending_size += file.size;
+
+          if (pending_size >= max_batch_size)
+          {
+            flush();
+          }
+          continue;
+        }
+      }
+
+      archive.clear();
+      std::ostringstream output(std::ios::binary);
+      reader.extract_file_contents(cache, archive, file, output);
+      auto contents = output.view();
+      on_contents(file, std::span<const std::byte>(reinterpret_cast<const std::byte*>(contents.data()), contents.size()));
+    }
+
+    flush();
+  }
+}// namespace siege::platform
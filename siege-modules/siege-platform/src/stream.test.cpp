@@ -0,0 +1,34 @@
+#include <catch2/catch_test_macros.hpp>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <siege/platform/stream.hpp>
+
+TEST_CASE("Batches of reads fill every buffer, and reads past the end of the file are errors", "[stream.batch]")
+{
+  auto path = std::filesystem::temp_directory_path() / "siege-read-batch-test.bin";
+
+  {
+    std::ofstream output(path, std::ios::binary | std::ios::trunc);
+    output << "Hello Darkness, my old friend...";
+  }
+
+  std::vector<std::byte> first(5);
+  std::vector<std::byte> second(6);
+  std::vector<siege::platform::batch_read_request> requests{ { .offset = 16, .buffer = second }, { .offset = 0, .buffer = first } };
+  siege::platform::read_batch(path, requests);
+
+  REQUIRE(std::string(reinterpret_cast<const char*>(first.data()), first.size()) == "Hello");
+  REQUIRE(std::string(reinterpret_cast<const char*>(second.data()), second.size()) == "my old");
+  REQUIRE(requests[0].bytes_read == 6);
+  REQUIRE(requests[1].bytes_read == 5);
+
+  std::vector<std::byte> buffer(64);
+  std::vector<siege::platform::batch_read_request> past_end{ { .offset = std::filesystem::file_size(path) - 8, .buffer = buffer } };
+  REQUIRE_THROWS_AS(siege::platform::read_batch(path, past_end), std::runtime_error);
+  REQUIRE(past_end[0].bytes_read == 8);
+
+  std::filesystem::remove(path);
+}
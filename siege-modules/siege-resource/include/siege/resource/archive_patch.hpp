@@ -0,0 +1,66 @@
+#ifndef SIEGE_RESOURCE_ARCHIVE_PATCH_HPP
+#define SIEGE_RESOURCE_ARCHIVE_PATCH_HPP
+
+#include <cstdint>
+#include <filesystem>
+#include <istream>
+#include <optional>
+#include <ostream>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace siege::resource
+{
+  // The archive formats which can be rebuilt when applying a patch.
+  enum class archive_format : std::uint8_t
+  {
+    darkstar_vol,
+    quake_pak,
+    daikatana_pak,
+    anachronox_dat,
+    zip
+  };
+
+  enum class entry_change_type : std::uint8_t
+  {
+    unchanged,
+    added,
+    removed,
+    modified
+  };
+
+  struct entry_change
+  {
+    std::string path;
+    entry_change_type type;
+    std::uint32_t old_checksum;
+    std::uint32_t new_checksum;
+    std::size_t new_size;
+    // How many bytes the entry takes up in the patch itself.
+    std::size_t payload_size;
+  };
+
+  // Encodes target as a series of copies from source and literal bytes.
+  std::vector<std::byte> create_delta(std::span<const std::byte> source, std::span<const std::byte> target);
+
+  // Returns nothing if the delta is corrupt or was not made from source.
+  std::optional<std::vector<std::byte>> apply_delta(std::span<const std::byte> source, std::span<const std::byte> delta);
+
+  // Compares every entry of both archives and writes the differences to output.
+  // Entries are processed in batches, with the deltas of each batch computed in parallel,
+  // so that neither archive needs to be fully loaded at once.
+  std::vector<entry_change> create_archive_patch(const std::filesystem::path& old_archive,
+    const std::filesystem::path& new_archive,
+    std::ostream& output);
+
+  // Rebuilds the new archive from the old one and a patch made by create_archive_patch.
+  // Entries are verified against the checksums stored in the patch and written as each batch is rebuilt,
+  // into a temporary file which only replaces new_archive once every entry has been written.
+  // Entries of a VOL file are patched as they are stored, so that their compression is kept.
+  std::vector<entry_change> apply_archive_patch(const std::filesystem::path& old_archive,
+    std::istream& patch,
+    const std::filesystem::path& new_archive);
+}// namespace siege::resource
+
+#endif// SIEGE_RESOURCE_ARCHIVE_PATCH_HPP
@@ -31,6 +31,34 @@ namespace siege::resource::vol::darkstar
 
   void create_vol_file(std::ostream& output, const std::vector<volume_file_info>& files);
 
+  // Writes a VOL file one entry at a time, so that the contents of every entry never have to be in memory at once.
+  // The output must be seekable, as the size in the header is only filled in by finish.
+  class vol_writer
+  {
+  public:
+    explicit vol_writer(std::ostream& output);
+
+    vol_writer(const vol_writer&) = delete;
+    vol_writer& operator=(const vol_writer&) = delete;
+
+    // Entries with a compressed_size are copied as they are, already compressed with their compression_type.
+    void add(const volume_file_info& file);
+    void finish();
+
+  private:
+    struct written_entry
+    {
+      std::string filename;
+      std::uint32_t offset;
+      std::int32_t size;
+      darkstar::compression_type compression_type;
+    };
+
+    std::ostream& output;
+    std::size_t start;
+    std::vector<written_entry> entries;
+  };
+
   struct vol_resource_reader final : siege::platform::resource_reader
   {
     static bool is_supported(std::istream& stream);
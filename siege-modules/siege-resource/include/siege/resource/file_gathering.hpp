@@ -0,0 +1,101 @@
+#ifndef SIEGE_RESOURCE_FILE_GATHERING_HPP
+#define SIEGE_RESOURCE_FILE_GATHERING_HPP
+
+#include <filesystem>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <siege/platform/resource.hpp>
+#include <siege/resource/resource_explorer.hpp>
+
+namespace siege::resource
+{
+  // An explorer which can look inside of every archive which the conversion tools read textures, palettes and shapes from.
+  resource_explorer make_resource_explorer();
+
+  struct gathered_file
+  {
+    siege::platform::file_info info;
+    // Where the input was found, so that the output keeps the same folder structure.
+    std::filesystem::path input_root;
+  };
+
+  // Finds every file with one of the extensions under each input, including the ones inside of archives.
+  // Inputs which are files are taken as they are, and inputs which do not exist are passed to on_missing.
+  std::vector<gathered_file> gather_files(const resource_explorer& explorer,
+    std::span<const std::filesystem::path> inputs,
+    const std::vector<std::string_view>& extensions,
+    const std::function<void(const std::filesystem::path&)>& on_missing = {});
+
+  // Finds every file with one of the extensions under the inputs which the files were gathered from, such as the textures of shapes.
+  std::vector<siege::platform::file_info> find_beside(const resource_explorer& explorer,
+    std::span<const gathered_file> files,
+    const std::vector<std::string_view>& extensions);
+
+  // Where the output for a gathered file goes, in the same folder under output_folder as the file was under its input.
+  std::filesystem::path get_output_path(const std::filesystem::path& output_folder, const gathered_file& file, const std::filesystem::path& new_filename);
+
+  // Archive readers are not safe to share, so every read goes through one lock. Everything else can run in parallel.
+  class shared_reader
+  {
+  public:
+    explicit shared_reader(const resource_explorer& explorer);
+
+    std::vector<char> read(const siege::platform::file_info& info) const;
+
+  private:
+    const resource_explorer& explorer;
+    mutable std::mutex mutex;
+  };
+
+  // Finds files of the given types inside of archives, and reads them back by their path,
+  // such as for palette_registry::scan to find the palettes which archives contain.
+  class embedded_files
+  {
+  public:
+    embedded_files(const resource_explorer& explorer, const shared_reader& reader, std::vector<std::string_view> extensions);
+
+    // Nothing is returned for paths which are not archives.
+    std::set<std::filesystem::path> find(const std::filesystem::path& archive_path);
+
+    // Files which find has not returned are read as empty.
+    std::vector<char> read(const std::filesystem::path& path) const;
+
+  private:
+    const resource_explorer& explorer;
+    const shared_reader& reader;
+    std::vector<std::string_view> extensions;
+    std::map<std::filesystem::path, siege::platform::file_info> files;
+  };
+
+  // The files of an archive by their file ID, for formats such as BWD which refer to other files of their PRJ archive that way.
+  // The archive is listed up front, so that lookups can be made from several threads at once.
+  class files_by_id
+  {
+  public:
+    files_by_id(const resource_explorer& explorer, const shared_reader& reader, const std::filesystem::path& archive_path);
+
+    std::optional<std::string> get_filename(std::uint16_t file_id) const;
+
+    // Unknown IDs are read as empty.
+    std::vector<char> read(std::uint16_t file_id) const;
+
+  private:
+    const shared_reader& reader;
+    std::map<std::uint16_t, siege::platform::file_info> files;
+  };
+
+  // Lists the archive of every file with the given extension by file ID, keyed by the path of the archive.
+  std::map<std::filesystem::path, files_by_id> get_files_by_id(const resource_explorer& explorer,
+    const shared_reader& reader,
+    std::span<const gathered_file> files,
+    std::string_view extension);
+}// namespace siege::resource
+
+#endif// SIEGE_RESOURCE_FILE_GATHERING_HPP
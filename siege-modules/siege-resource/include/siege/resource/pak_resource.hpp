@@ -7,12 +7,72 @@
 #include <fstream>
 #include <optional>
 #include <utility>
+#include <memory>
+#include <span>
+#include <string>
 
 #include <siege/platform/resource.hpp>
 #include <siege/platform/endian_arithmetic.hpp>
 
 namespace siege::resource::pak
 {
+  enum class pak_version
+  {
+    quake,
+    daikatana,
+    anachronox
+  };
+
+  struct pak_file_info
+  {
+    std::string filename;
+    std::size_t size;
+    std::unique_ptr<std::istream> stream;
+  };
+
+  struct pak_write_settings
+  {
+    pak_version version = pak_version::quake;
+    // Only used for Daikatana (code_rle) and Anachronox (lz77_huffman, aka zlib) files.
+    siege::platform::compression_type compression_type = siege::platform::compression_type::none;
+    // Entry data is padded so that every entry starts on a multiple of this value.
+    // 2048 lines entries up with CD sectors, 4096 with most disk pages.
+    std::size_t alignment = 1;
+  };
+
+  // The directory is sorted by lower case path, so that readers can binary search it,
+  // and entry data is written in the same order so that output is deterministic.
+  // Compression of entries is done in parallel before anything is written.
+  void create_pak_file(std::ostream& output, std::vector<pak_file_info>& files, const pak_write_settings& settings = {});
+
+  struct prepared_entry;
+
+  // Writes a PAK file a batch of entries at a time, so that the whole archive never has to be in memory.
+  // Entry data is written in the order it is added, and the directory is sorted the same way as create_pak_file.
+  // The output must be seekable, as the header is only filled in by finish.
+  class pak_writer
+  {
+  public:
+    explicit pak_writer(std::ostream& output, const pak_write_settings& settings = {});
+    ~pak_writer();
+
+    pak_writer(const pak_writer&) = delete;
+    pak_writer& operator=(const pak_writer&) = delete;
+
+    // The files of each batch are compressed in parallel before they are written.
+    void add(std::vector<pak_file_info>& files);
+    void finish();
+
+  private:
+    std::ostream& output;
+    pak_write_settings settings;
+    std::size_t start;
+    std::size_t position;
+    std::vector<prepared_entry> entries;
+  };
+
+  std::vector<std::byte> code_rle_compress(std::span<const std::byte> input);
+
   struct pak_resource_reader final : siege::platform::resource_reader
   {
     static bool is_supported(std::istream& stream);
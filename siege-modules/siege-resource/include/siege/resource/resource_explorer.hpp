@@ -9,7 +9,11 @@
 #include <fstream>
 #include <optional>
 #include <span>
+#include <functional>
+#include <mutex>
+#include <thread>
 #include <siege/platform/resource.hpp>
+#include <siege/resource/resource_watcher.hpp>
 
 namespace siege::resource
 {
@@ -46,15 +50,56 @@ namespace siege::resource
       std::filesystem::path destination,
       const siege::platform::file_info& info,
       std::optional<std::reference_wrapper<platform::batch_storage>> = std::nullopt) const;
+
+    // Extracts many files of one archive to the same place as the single file version would,
+    // but keeps many reads in flight at once for stored entries.
+    void extract_file_contents(const std::filesystem::path& archive_path,
+      const std::filesystem::path& destination,
+      std::span<const siege::platform::file_info> files) const;
+
     std::vector<std::variant<siege::platform::folder_info, siege::platform::file_info>> get_content_listing(const std::filesystem::path& folder_path) const;
+
+    // Folders are read and classified in parallel batches, with each batch passed along as soon as it is ready.
+    // Archives are listed by their reader in one go.
+    void get_content_listing(const std::filesystem::path& folder_path,
+      const std::function<void(std::span<std::variant<siege::platform::folder_info, siege::platform::file_info>>)>& on_content,
+      std::size_t batch_size = 256) const;
+
+    // Watch mode keeps the results of find_files current for long running sessions.
+    // Only the files, folders and archives which changed under the search path are re-indexed.
+    // The explorer must not be moved while it is watching.
+    void start_watching(bool force_polling = false);
+    void stop_watching();
+    bool is_watching() const;
+
+    // Patches the cached find_files results for the given paths, without rescanning anything else.
+    // The changed paths are rescanned before the cache is locked, so find_files is only blocked while the results are swapped in.
+    void apply_changes(std::span<const path_change> changes) const;
+
   private:
+    struct cached_files
+    {
+      std::filesystem::path search_path;
+      std::vector<std::string> extensions;
+      std::vector<siege::platform::file_info> files;
+    };
+
+    std::filesystem::path get_extract_destination(std::filesystem::path destination, const std::filesystem::path& archive_path, const siege::platform::file_info& info) const;
+    std::optional<std::variant<siege::platform::folder_info, siege::platform::file_info>> get_content_info(const std::filesystem::directory_entry& entry) const;
+    void collect_files(const std::variant<siege::platform::folder_info, siege::platform::file_info>& item,
+      const std::vector<std::string_view>& extensions,
+      std::vector<siege::platform::file_info>& results) const;
+
     std::locale default_locale;
 
     std::map<std::string, std::span<std::string_view>> archive_explicit_extensions;
 
     std::multimap<std::string, std::unique_ptr<siege::platform::resource_reader>> archive_types;
 
-    mutable std::map<std::string, std::vector<siege::platform::file_info>> info_cache;
+    mutable std::map<std::string, cached_files> info_cache;
+    mutable std::unique_ptr<std::mutex> info_cache_mutex = std::make_unique<std::mutex>();
+
+    std::jthread watch_thread;
   };
 }// namespace siege::resource
 
@@ -0,0 +1,59 @@
+#ifndef SIEGE_RESOURCE_WATCHER_HPP
+#define SIEGE_RESOURCE_WATCHER_HPP
+
+#include <filesystem>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <chrono>
+#include <stop_token>
+
+namespace siege::resource
+{
+  enum class path_change_type
+  {
+    created,
+    modified,
+    removed
+  };
+
+  struct path_change
+  {
+    std::filesystem::path path;
+    path_change_type type;
+  };
+
+  // Reports files and folders which are created, modified or removed under a folder.
+  // Uses inotify on Linux and falls back to comparing directory snapshots everywhere else.
+  class resource_watcher
+  {
+  public:
+    explicit resource_watcher(std::filesystem::path root, bool force_polling = false);
+    ~resource_watcher();
+
+    resource_watcher(const resource_watcher&) = delete;
+    resource_watcher(resource_watcher&&) = delete;
+
+    // Waits up to the timeout for changes and returns them in the order they happened.
+    // If too many changes happened at once to be tracked individually, the root itself is reported as modified.
+    // A stop request on token ends the wait straight away, with nothing returned.
+    std::vector<path_change> get_changes(std::chrono::milliseconds timeout, std::stop_token token = {});
+
+    bool is_polling() const;
+
+  private:
+    using snapshot_type = std::map<std::filesystem::path, std::pair<std::filesystem::file_time_type, std::uintmax_t>>;
+
+    void add_watches(const std::filesystem::path& folder);
+    snapshot_type take_snapshot() const;
+    std::vector<path_change> get_polled_changes(std::chrono::milliseconds timeout, std::stop_token token);
+    std::vector<path_change> get_notified_changes(std::chrono::milliseconds timeout, std::stop_token token);
+
+    std::filesystem::path root;
+    int notify_handle = -1;
+    std::unordered_map<int, std::filesystem::path> watched_folders;
+    snapshot_type snapshot;
+  };
+}// namespace siege::resource
+
+#endif// SIEGE_RESOURCE_WATCHER_HPP
@@ -7,12 +7,28 @@
 #include <fstream>
 #include <optional>
 #include <utility>
+#include <memory>
+#include <string>
 
 #include <siege/platform/resource.hpp>
 #include <siege/platform/endian_arithmetic.hpp>
 
 namespace siege::resource::wad
 {
+  struct pod_file_info
+  {
+    std::string filename;
+    // 0x1 for raw data, 0x2 for palettes and 0x32 for the start/end markers of a group.
+    std::uint32_t type;
+    std::size_t size;
+    std::unique_ptr<std::istream> stream;
+  };
+
+  // Unlike PAK files, the order of a POD directory is meaningful
+  // (groups and the palettes inside of them apply to the entries which follow),
+  // so entries are written in the order given.
+  void create_pod_file(std::ostream& output, std::vector<pod_file_info>& files, std::size_t alignment = 1);
+
   struct wad_resource_reader final : siege::platform::resource_reader
   {
     static bool is_supported(std::istream& stream);
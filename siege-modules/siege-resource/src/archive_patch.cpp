@@ -0,0 +1,1015 @@
+#include <fstream>
+#include <filesystem>
+#include <vector>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <algorithm>
+#include <numeric>
+#include <execution>
+#include <spanstream>
+#include <stdexcept>
+#include <limits>
+#include <bit>
+#include <zlib.h>
+#include <zip.h>
+
+#include <siege/resource/archive_patch.hpp>
+#include <siege/resource/resource_maker.hpp>
+#include <siege/resource/darkstar_resource.hpp>
+#include <siege/resource/pak_resource.hpp>
+#include <siege/resource/zip_resource.hpp>
+#include <siege/platform/stream.hpp>
+
+namespace fs = std::filesystem;
+
+namespace siege::resource
+{
+  namespace endian = siege::platform;
+  using file_info = siege::platform::file_info;
+
+  constexpr auto patch_tag = platform::to_tag<4>({ 'S', 'P', 'A', 'T' });
+  constexpr auto anox_tag = platform::to_tag<4>({ 'A', 'D', 'A', 'T' });
+  constexpr auto quake_tag = platform::to_tag<4>({ 'P', 'A', 'C', 'K' });
+
+  constexpr std::uint32_t patch_version = 2;
+
+  // Matches smaller than this are not worth the bytes needed to encode a copy.
+  constexpr std::size_t block_size = 16;
+  constexpr std::size_t max_batch_size = 64 * 1024 * 1024;
+  constexpr auto no_position = std::numeric_limits<std::size_t>::max();
+
+  enum class payload_encoding : std::uint8_t
+  {
+    none,
+    zlib
+  };
+
+  struct patch_header
+  {
+    std::array<std::byte, 4> tag;
+    endian::little_uint32_t version;
+    archive_format format;
+    std::uint8_t compression_type;
+    endian::little_uint16_t reserved;
+    endian::little_uint32_t entry_count;
+  };
+
+  struct record_header
+  {
+    entry_change_type type;
+    payload_encoding encoding;
+    endian::little_uint16_t path_size;
+    endian::little_uint32_t old_checksum;
+    endian::little_uint32_t new_checksum;
+    endian::little_uint64_t new_size;
+    endian::little_uint64_t raw_payload_size;
+    endian::little_uint64_t payload_size;
+    // How the entry is stored in the new archive.
+    // VOL entries are patched as they are stored, still compressed, and extracted_size is their size once extracted.
+    std::uint8_t compression_type;
+    std::array<std::byte, 3> reserved;
+    endian::little_uint64_t extracted_size;
+  };
+
+  struct stored_entry
+  {
+    platform::compression_type compression_type;
+    std::size_t extracted_size;
+  };
+
+  struct archive_listing
+  {
+    std::unique_ptr<siege::platform::resource_reader> reader;
+    std::vector<file_info> files;
+    std::vector<std::string> paths;
+    std::vector<stored_entry> storage;
+  };
+
+  struct patched_entry
+  {
+    std::string path;
+    std::vector<std::byte> data;
+    platform::compression_type compression_type;
+    std::size_t extracted_size;
+  };
+
+  struct encoded_payload
+  {
+    payload_encoding encoding = payload_encoding::none;
+    std::size_t raw_size = 0;
+    std::vector<std::byte> data;
+  };
+
+  struct pending_record
+  {
+    record_header header;
+    std::string path;
+    std::vector<std::byte> payload;
+  };
+
+  static void write_varint(std::vector<std::byte>& output, std::size_t value)
+  {
+    while (value >= 0x80)
+    {
+      output.emplace_back(std::byte((value & 0x7f) | 0x80));
+      value >>= 7;
+    }
+
+    output.emplace_back(std::byte(value));
+  }
+
+  static bool read_varint(std::span<const std::byte>& input, std::size_t& value)
+  {
+    value = 0;
+
+    for (auto shift = 0; shift < 64 && !input.empty(); shift += 7)
+    {
+      auto next = std::size_t(input.front());
+      input = input.subspan(1);
+      value |= (next & 0x7f) << shift;
+
+      if ((next & 0x80) == 0)
+      {
+        return true;
+      }
+    }
+
+    return false;
+  }
+
+  static std::uint32_t get_checksum(std::span<const std::byte> data)
+  {
+    return std::uint32_t(crc32_z(0, reinterpret_cast<const Bytef*>(data.data()), data.size()));
+  }
+
+  std::vector<std::byte> create_delta(std::span<const std::byte> source, std::span<const std::byte> target)
+  {
+    constexpr std::uint32_t base = 257;
+    constexpr auto base_power = [] {
+      std::uint32_t result = 1;
+      for (auto i = 1u; i < block_size; ++i)
+      {
+        result *= base;
+      }
+      return result;
+    }();
+
+    auto hash_block = [](std::span<const std::byte> block) {
+      return std::accumulate(block.begin(), block.end(), std::uint32_t(0), [](std::uint32_t hash, std::byte value) {
+        return hash * base + std::uint32_t(value);
+      });
+    };
+
+    std::vector<std::byte> result;
+    result.reserve(target.size() / 8 + 16);
+    write_varint(result, target.size());
+
+    std::size_t literal_start = 0;
+
+    auto write_literal = [&](std::size_t end) {
+      if (end > literal_start)
+      {
+        write_varint(result, (end - literal_start) << 1);
+        result.insert(result.end(), target.begin() + literal_start, target.begin() + end);
+      }
+    };
+
+    if (source.size() >= block_size && target.size() >= block_size)
+    {
+      // Only every block of the source is indexed, which keeps the table small,
+      // while every position of the target is checked with a rolling hash.
+      auto table_size = std::bit_ceil(std::max<std::size_t>(2, source.size() / block_size * 2));
+      auto table_bits = std::countr_zero(table_size);
+      std::vector<std::size_t> table(table_size, no_position);
+
+      auto get_slot = [&](std::uint32_t hash) {
+        return std::size_t(std::uint64_t(hash) * 0x9E3779B97F4A7C15ull >> (64 - table_bits));
+      };
+
+      for (std::size_t position = 0; position + block_size <= source.size(); position += block_size)
+      {
+        table[get_slot(hash_block(source.subspan(position, block_size)))] = position;
+      }
+
+      std::size_t position = 0;
+      auto hash = hash_block(target.first(block_size));
+
+      while (position + block_size <= target.size())
+      {
+        auto candidate = table[get_slot(hash)];
+
+        if (candidate != no_position && std::equal(source.begin() + candidate, source.begin() + candidate + block_size, target.begin() + position))
+        {
+          auto source_start = candidate;
+          auto target_start = position;
+
+          while (target_start > literal_start && source_start > 0 && source[source_start - 1] == target[target_start - 1])
+          {
+            --source_start;
+            --target_start;
+          }
+
+          auto source_end = candidate + block_size;
+          auto target_end = position + block_size;
+
+          while (source_end < source.size() && target_end < target.size() && source[source_end] == target[target_end])
+          {
+            ++source_end;
+            ++target_end;
+          }
+
+          write_literal(target_start);
+          write_varint(result, ((target_end - target_start) << 1) | 1);
+          write_varint(result, source_start);
+
+          literal_start = position = target_end;
+
+          if (position + block_size <= target.size())
+          {
+            hash = hash_block(target.subspan(position, block_size));
+          }
+          continue;
+        }
+
+        if (position + block_size < target.size())
+        {
+          hash = (hash - std::uint32_t(target[position]) * base_power) * base + std::uint32_t(target[position + block_size]);
+        }
+
+        ++position;
+      }
+    }
+
+    write_literal(target.size());
+
+    return result;
+  }
+
+  std::optional<std::vector<std::byte>> apply_delta(std::span<const std::byte> source, std::span<const std::byte> delta)
+  {
+    std::size_t target_size = 0;
+
+    if (!read_varint(delta, target_size))
+    {
+      return std::nullopt;
+    }
+
+    std::vector<std::byte> result;
+    result.reserve(std::min(target_size, source.size() + delta.size() * 2));
+
+    while (!delta.empty())
+    {
+      std::size_t op = 0;
+
+      if (!read_varint(delta, op))
+      {
+        return std::nullopt;
+      }
+
+      auto length = op >> 1;
+
+      if (length > target_size - result.size())
+      {
+        return std::nullopt;
+      }
+
+      if (op & 1)
+      {
+        std::size_t offset = 0;
+
+        if (!read_varint(delta, offset) || offset > source.size() || length > source.size() - offset)
+        {
+          return std::nullopt;
+        }
+
+        result.insert(result.end(), source.begin() + offset, source.begin() + offset + length);
+      }
+      else
+      {
+        if (length > delta.size())
+        {
+          return std::nullopt;
+        }
+
+        result.insert(result.end(), delta.begin(), delta.begin() + length);
+        delta = delta.subspan(length);
+      }
+    }
+
+    if (result.size() != target_size)
+    {
+      return std::nullopt;
+    }
+
+    return result;
+  }
+
+  static encoded_payload encode_payload(std::vector<std::byte> raw)
+  {
+    encoded_payload result{ .raw_size = raw.size() };
+
+    if (!raw.empty())
+    {
+      std::vector<std::byte> compressed(compressBound(uLong(raw.size())));
+      uLongf compressed_size = uLongf(compressed.size());
+
+      if (compress2(reinterpret_cast<Bytef*>(compressed.data()), &compressed_size, reinterpret_cast<const Bytef*>(raw.data()), uLong(raw.size()), Z_BEST_COMPRESSION) == Z_OK && compressed_size < raw.size())
+      {
+        compressed.resize(compressed_size);
+        result.encoding = payload_encoding::zlib;
+        result.data = std::move(compressed);
+        return result;
+      }
+    }
+
+    result.data = std::move(raw);
+    return result;
+  }
+
+  // The largest delta which create_delta makes for a target of this size.
+  // Every copy covers at least block_size bytes of the target and is followed by at most one literal,
+  // and every number in the delta takes at most one varint of 10 bytes.
+  static std::size_t get_max_delta_size(std::size_t target_size)
+  {
+    constexpr std::size_t max_varint_size = 10;
+    return target_size + max_varint_size * (1 + 3 * (target_size / block_size + 1));
+  }
+
+  static std::optional<std::vector<std::byte>> decode_payload(const record_header& header, std::vector<std::byte> payload)
+  {
+    if (header.encoding == payload_encoding::none)
+    {
+      return payload;
+    }
+
+    if (header.encoding != payload_encoding::zlib)
+    {
+      return std::nullopt;
+    }
+
+    std::vector<std::byte> result(header.raw_payload_size);
+    uLongf result_size = uLongf(result.size());
+
+    if (uncompress(reinterpret_cast<Bytef*>(result.data()), &result_size, reinterpret_cast<const Bytef*>(payload.data()), uLong(payload.size())) != Z_OK || result_size != result.size())
+    {
+      return std::nullopt;
+    }
+
+    return result;
+  }
+
+  static archive_listing get_archive_listing(const fs::path& archive_path)
+  {
+    std::ifstream stream(archive_path, std::ios::binary);
+
+    if (!stream)
+    {
+      throw std::invalid_argument("Could not open " + archive_path.string());
+    }
+
+    const auto is_vol = vol::darkstar::vol_resource_reader::is_supported(stream);
+
+    archive_listing result{ .reader = make_resource_reader(stream) };
+    result.files = platform::get_all_content_of_type<file_info>(archive_path, stream, *result.reader);
+    result.paths.reserve(result.files.size());
+    result.storage.reserve(result.files.size());
+
+    for (auto& file : result.files)
+    {
+      result.paths.emplace_back((file.folder_path / file.filename).lexically_relative(archive_path).generic_string());
+      result.storage.emplace_back(stored_entry{ file.compression_type, file.size });
+
+      // There is nothing to compress VOL entries with again, so compressed entries are read as they are stored.
+      // Each entry starts with a block header which holds the stored size in its last 4 bytes, as 24 bits and a flag.
+      if (is_vol && file.compression_type != platform::compression_type::none)
+      {
+        std::array<std::byte, 8> block_header{};
+        stream.clear();
+        stream.seekg(std::streamoff(file.offset), std::ios::beg);
+
+        if (!platform::read(stream, block_header.data(), block_header.size()))
+        {
+          throw std::invalid_argument("Could not read " + result.paths.back() + " from " + archive_path.string());
+        }
+
+        file.size = std::size_t(block_header[4]) | std::size_t(block_header[5]) << 8 | std::size_t(block_header[6]) << 16;
+        file.compression_type = platform::compression_type::none;
+      }
+    }
+
+    return result;
+  }
+
+  static std::pair<archive_format, platform::compression_type> get_archive_format(const fs::path& archive_path, const std::vector<file_info>& files)
+  {
+    std::ifstream stream(archive_path, std::ios::binary);
+
+    auto has_compression = [&](platform::compression_type type) {
+      return std::any_of(files.begin(), files.end(), [&](auto& file) { return file.compression_type == type; });
+    };
+
+    if (vol::darkstar::vol_resource_reader::is_supported(stream))
+    {
+      return { archive_format::darkstar_vol, platform::compression_type::none };
+    }
+
+    if (pak::pak_resource_reader::is_supported(stream))
+    {
+      std::array<std::byte, 4> tag{};
+      platform::read(stream, tag.data(), tag.size());
+
+      if (tag == anox_tag)
+      {
+        return { archive_format::anachronox_dat, has_compression(platform::compression_type::lz77_huffman) ? platform::compression_type::lz77_huffman : platform::compression_type::none };
+      }
+
+      // Only Daikatana entries have a compressed size, even when they are stored as is.
+      if (tag == quake_tag && std::any_of(files.begin(), files.end(), [](auto& file) { return file.compressed_size.has_value(); }))
+      {
+        return { archive_format::daikatana_pak, has_compression(platform::compression_type::code_rle) ? platform::compression_type::code_rle : platform::compression_type::none };
+      }
+
+      if (tag == quake_tag)
+      {
+        return { archive_format::quake_pak, platform::compression_type::none };
+      }
+    }
+
+    if (zip::zip_resource_reader::is_supported(stream))
+    {
+      return { archive_format::zip, platform::compression_type::none };
+    }
+
+    throw std::invalid_argument("Only Darkstar VOL, PAK, DAT and ZIP archives can be patched");
+  }
+
+  // Reads the given entries into memory, in the same order as they were provided.
+  static std::vector<std::vector<std::byte>> read_entries(const fs::path& archive_path, const archive_listing& listing, std::span<const file_info> files)
+  {
+    std::vector<std::vector<std::byte>> results(files.size());
+
+    platform::read_file_contents_batch(archive_path, *listing.reader, files, [&](const auto& info, auto contents) {
+      results[std::size_t(&info - files.data())].assign(contents.begin(), contents.end());
+    });
+
+    return results;
+  }
+
+  static void write_record(std::ostream& output, const record_header& header, const std::string& path, std::span<const std::byte> payload)
+  {
+    platform::write(output, reinterpret_cast<const char*>(&header), sizeof(header));
+    platform::write(output, path.data(), path.size());
+    platform::write(output, payload.data(), payload.size());
+  }
+
+  static std::unique_ptr<std::ispanstream> make_stream(std::vector<std::byte>& data)
+  {
+    return std::make_unique<std::ispanstream>(std::span<char>(reinterpret_cast<char*>(data.data()), data.size()));
+  }
+
+  // Receives the entries of the new archive a batch at a time, as soon as they have been verified,
+  // so that the rebuilt archive is written as the patch is applied.
+  class archive_writer
+  {
+  public:
+    virtual ~archive_writer() = default;
+    virtual void add(std::vector<patched_entry>& entries) = 0;
+    virtual void finish() = 0;
+  };
+
+  class vol_archive_writer final : public archive_writer
+  {
+  public:
+    explicit vol_archive_writer(const fs::path& archive_path)
+      : output(archive_path, std::ios::binary | std::ios::trunc), writer(output)
+    {
+    }
+
+    void add(std::vector<patched_entry>& entries) override
+    {
+      for (auto& entry : entries)
+      {
+        // The sizes are narrowed to fit volume_file_info, which then checks them against what VOL files can hold.
+        if (entry.extracted_size > std::size_t(std::numeric_limits<std::int32_t>::max()) || entry.data.size() > std::size_t(std::numeric_limits<std::int32_t>::max()))
+        {
+          throw std::invalid_argument("VOL files cannot hold " + entry.path + ", which is too large.");
+        }
+
+        vol::darkstar::volume_file_info info{
+          .filename = entry.path,
+          .size = std::int32_t(entry.extracted_size),
+          .compression_type = to_vol_compression(entry.compression_type),
+          .stream = make_stream(entry.data)
+        };
+
+        // Compressed entries were patched as they are stored, so they are written back as they are.
+        if (info.compression_type != vol::darkstar::compression_type::none)
+        {
+          info.compressed_size = std::int32_t(entry.data.size());
+        }
+
+        writer.add(info);
+      }
+    }
+
+    void finish() override
+    {
+      writer.finish();
+    }
+
+  private:
+    static vol::darkstar::compression_type to_vol_compression(platform::compression_type type)
+    {
+      switch (type)
+      {
+      case platform::compression_type::code_rle:
+        return vol::darkstar::compression_type::rle;
+      case platform::compression_type::lz77:
+        return vol::darkstar::compression_type::lz;
+      case platform::compression_type::lzss_huffman:
+        return vol::darkstar::compression_type::lzh;
+      default:
+        return vol::darkstar::compression_type::none;
+      }
+    }
+
+    std::ofstream output;
+    vol::darkstar::vol_writer writer;
+  };
+
+  class pak_archive_writer final : public archive_writer
+  {
+  public:
+    pak_archive_writer(const fs::path& archive_path, const pak::pak_write_settings& settings)
+      : output(archive_path, std::ios::binary | std::ios::trunc), writer(output, settings)
+    {
+    }
+
+    void add(std::vector<patched_entry>& entries) override
+    {
+      std::vector<pak::pak_file_info> files;
+      files.reserve(entries.size());
+
+      for (auto& entry : entries)
+      {
+        files.emplace_back(pak::pak_file_info{ .filename = entry.path, .size = entry.data.size(), .stream = make_stream(entry.data) });
+      }
+
+      writer.add(files);
+    }
+
+    void finish() override
+    {
+      writer.finish();
+    }
+
+  private:
+    std::ofstream output;
+    pak::pak_writer writer;
+  };
+
+  // libzip only reads entry data when the archive is closed. Rather than keeping every entry in memory until then,
+  // entries are spooled to a file next to the archive and added as ranges of that file.
+  class zip_archive_writer final : public archive_writer
+  {
+  public:
+    explicit zip_archive_writer(const fs::path& archive_path)
+      : archive_path(archive_path), spool_path(archive_path.string() + ".spool"), spool(spool_path, std::ios::binary | std::ios::trunc)
+    {
+      int error = 0;
+      archive = zip_open(archive_path.string().c_str(), ZIP_CREATE | ZIP_TRUNCATE, &error);
+
+      if (!archive || !spool)
+      {
+        throw std::runtime_error("Could not create " + archive_path.string());
+      }
+    }
+
+    ~zip_archive_writer() override
+    {
+      if (archive)
+      {
+        zip_discard(archive);
+      }
+
+      spool.close();
+      std::error_code unused;
+      fs::remove(spool_path, unused);
+    }
+
+    void add(std::vector<patched_entry>& entries) override
+    {
+      for (auto& entry : entries)
+      {
+        spooled_entries.emplace_back(spooled_entry{ std::move(entry.path), spool_size, entry.data.size(), entry.compression_type });
+        platform::write(spool, entry.data.data(), entry.data.size());
+        spool_size += entry.data.size();
+      }
+    }
+
+    void finish() override
+    {
+      spool.close();
+
+      for (auto& entry : spooled_entries)
+      {
+        // A length of 0 means the rest of the file to libzip, so empty entries get an empty buffer instead.
+        auto* source = entry.size == 0 ? zip_source_buffer(archive, nullptr, 0, 0) : zip_source_file(archive, spool_path.string().c_str(), zip_uint64_t(entry.offset), zip_int64_t(entry.size));
+        auto index = source ? zip_file_add(archive, entry.path.c_str(), source, ZIP_FL_OVERWRITE | ZIP_FL_ENC_UTF_8) : -1;
+
+        if (index < 0)
+        {
+          zip_source_free(source);
+          throw std::runtime_error("Could not add " + entry.path + " to " + archive_path.string());
+        }
+
+        if (entry.compression_type == platform::compression_type::none)
+        {
+          zip_set_file_compression(archive, zip_uint64_t(index), ZIP_CM_STORE, 0);
+        }
+      }
+
+      if (zip_close(archive) < 0)
+      {
+        throw std::runtime_error("Could not write " + archive_path.string());
+      }
+
+      archive = nullptr;
+    }
+
+  private:
+    struct spooled_entry
+    {
+      std::string path;
+      std::size_t offset;
+      std::size_t size;
+      platform::compression_type compression_type;
+    };
+
+    fs::path archive_path;
+    fs::path spool_path;
+    std::ofstream spool;
+    std::size_t spool_size = 0;
+    std::vector<spooled_entry> spooled_entries;
+    zip_t* archive = nullptr;
+  };
+
+  static std::unique_ptr<archive_writer> make_archive_writer(const fs::path& archive_path, archive_format format, platform::compression_type compression_type)
+  {
+    if (format == archive_format::darkstar_vol)
+    {
+      return std::make_unique<vol_archive_writer>(archive_path);
+    }
+
+    if (format == archive_format::zip)
+    {
+      return std::make_unique<zip_archive_writer>(archive_path);
+    }
+
+    pak::pak_write_settings settings{ .compression_type = compression_type };
+    settings.version = format == archive_format::anachronox_dat ? pak::pak_version::anachronox : format == archive_format::daikatana_pak ? pak::pak_version::daikatana
+                                                                                                                                             : pak::pak_version::quake;
+
+    return std::make_unique<pak_archive_writer>(archive_path, settings);
+  }
+
+  std::vector<entry_change> create_archive_patch(const fs::path& old_archive, const fs::path& new_archive, std::ostream& output)
+  {
+    static_assert(sizeof(patch_header) == 16);
+    static_assert(sizeof(record_header) == 48);
+
+    auto old_listing = get_archive_listing(old_archive);
+    auto new_listing = get_archive_listing(new_archive);
+    auto [format, compression_type] = get_archive_format(new_archive, new_listing.files);
+
+    std::unordered_map<std::string_view, std::size_t> old_indexes;
+    old_indexes.reserve(old_listing.paths.size());
+
+    for (auto i = 0u; i < old_listing.paths.size(); ++i)
+    {
+      old_indexes[old_listing.paths[i]] = i;
+    }
+
+    std::unordered_set<std::string_view> new_paths(new_listing.paths.begin(), new_listing.paths.end());
+    std::vector<std::size_t> removed;
+
+    for (auto i = 0u; i < old_listing.paths.size(); ++i)
+    {
+      if (!new_paths.contains(old_listing.paths[i]))
+      {
+        removed.emplace_back(i);
+      }
+    }
+
+    for (auto& path : new_listing.paths)
+    {
+      if (path.size() > std::numeric_limits<std::uint16_t>::max())
+      {
+        throw std::invalid_argument("Entry path is too long to be patched: " + path);
+      }
+    }
+
+    patch_header header{
+      .tag = patch_tag,
+      .version = patch_version,
+      .format = format,
+      .compression_type = std::uint8_t(compression_type),
+      .entry_count = std::uint32_t(new_listing.files.size() + removed.size())
+    };
+    platform::write(output, reinterpret_cast<const char*>(&header), sizeof(header));
+
+    std::vector<entry_change> changes;
+    changes.reserve(header.entry_count);
+
+    auto new_files = std::span<const file_info>(new_listing.files);
+
+    for (std::size_t start = 0; start < new_files.size();)
+    {
+      std::size_t end = start;
+      std::size_t batch_size = 0;
+
+      while (end < new_files.size() && (end == start || batch_size < max_batch_size))
+      {
+        batch_size += new_files[end].size;
+        ++end;
+      }
+
+      auto batch = new_files.subspan(start, end - start);
+
+      std::vector<file_info> old_batch;
+      std::vector<std::size_t> old_positions(batch.size(), no_position);
+
+      for (auto i = 0u; i < batch.size(); ++i)
+      {
+        if (auto existing = old_indexes.find(new_listing.paths[start + i]); existing != old_indexes.end())
+        {
+          old_positions[i] = old_batch.size();
+          old_batch.emplace_back(old_listing.files[existing->second]);
+        }
+      }
+
+      auto new_contents = read_entries(new_archive, new_listing, batch);
+      auto old_contents = read_entries(old_archive, old_listing, old_batch);
+
+      std::vector<std::size_t> indexes(batch.size());
+      std::iota(indexes.begin(), indexes.end(), std::size_t(0));
+
+      std::vector<std::pair<record_header, encoded_payload>> records(batch.size());
+
+      std::transform(std::execution::par, indexes.begin(), indexes.end(), records.begin(), [&](std::size_t i) {
+        auto& contents = new_contents[i];
+
+        record_header record{
+          .type = entry_change_type::added,
+          .new_checksum = get_checksum(contents),
+          .new_size = contents.size()
+        };
+
+        encoded_payload payload{};
+
+        if (old_positions[i] == no_position)
+        {
+          payload = encode_payload(contents);
+        }
+        else
+        {
+          auto& old_contents_item = old_contents[old_positions[i]];
+          record.old_checksum = get_checksum(old_contents_item);
+
+          if (record.old_checksum == record.new_checksum && std::ranges::equal(old_contents_item, contents))
+          {
+            record.type = entry_change_type::unchanged;
+          }
+          else
+          {
+            record.type = entry_change_type::modified;
+            payload = encode_payload(create_delta(old_contents_item, contents));
+          }
+        }
+
+        record.encoding = payload.encoding;
+        record.raw_payload_size = payload.raw_size;
+        record.payload_size = payload.data.size();
+        record.compression_type = std::uint8_t(new_listing.storage[start + i].compression_type);
+        record.extracted_size = new_listing.storage[start + i].extracted_size;
+
+        return std::make_pair(record, std::move(payload));
+      });
+
+      for (auto i = 0u; i < records.size(); ++i)
+      {
+        auto& [record, payload] = records[i];
+        auto& path = new_listing.paths[start + i];
+        record.path_size = std::uint16_t(path.size());
+
+        write_record(output, record, path, payload.data);
+        changes.emplace_back(entry_change{ path, record.type, record.old_checksum, record.new_checksum, record.new_size, payload.data.size() });
+      }
+
+      start = end;
+    }
+
+    for (auto index : removed)
+    {
+      auto& path = old_listing.paths[index];
+
+      record_header record{
+        .type = entry_change_type::removed,
+        .path_size = std::uint16_t(path.size())
+      };
+
+      write_record(output, record, path, {});
+      changes.emplace_back(entry_change{ path, record.type, 0, 0, 0, 0 });
+    }
+
+    return changes;
+  }
+
+  std::vector<entry_change> apply_archive_patch(const fs::path& old_archive, std::istream& patch, const fs::path& new_archive)
+  {
+    patch_header header{};
+
+    if (!platform::read(patch, reinterpret_cast<char*>(&header), sizeof(header)) || header.tag != patch_tag)
+    {
+      throw std::invalid_argument("Stream provided is not an archive patch");
+    }
+
+    if (header.version != patch_version)
+    {
+      throw std::invalid_argument("Archive patch version is not supported");
+    }
+
+    const auto patch_size = platform::get_stream_size(patch);
+    auto old_listing = get_archive_listing(old_archive);
+
+    std::unordered_map<std::string_view, std::size_t> old_indexes;
+    old_indexes.reserve(old_listing.paths.size());
+
+    for (auto i = 0u; i < old_listing.paths.size(); ++i)
+    {
+      old_indexes[old_listing.paths[i]] = i;
+    }
+
+    // The new archive is written next to where it belongs and only moved there once every entry has been verified,
+    // which also allows the old archive to be patched in place.
+    auto temp_path = fs::path(new_archive.string() + ".tmp");
+    auto writer = make_archive_writer(temp_path, header.format, platform::compression_type(header.compression_type));
+
+    std::vector<entry_change> changes;
+    changes.reserve(header.entry_count);
+
+    std::vector<pending_record> batch;
+    std::size_t batch_size = 0;
+
+    auto apply_batch = [&]() {
+      std::vector<file_info> old_batch;
+      std::vector<std::size_t> old_positions(batch.size(), no_position);
+
+      for (auto i = 0u; i < batch.size(); ++i)
+      {
+        if (batch[i].header.type == entry_change_type::added)
+        {
+          continue;
+        }
+
+        auto existing = old_indexes.find(batch[i].path);
+
+        if (existing == old_indexes.end())
+        {
+          throw std::runtime_error("Could not find " + batch[i].path + " in " + old_archive.string());
+        }
+
+        old_positions[i] = old_batch.size();
+        old_batch.emplace_back(old_listing.files[existing->second]);
+      }
+
+      auto old_contents = read_entries(old_archive, old_listing, old_batch);
+
+      std::vector<std::size_t> indexes(batch.size());
+      std::iota(indexes.begin(), indexes.end(), std::size_t(0));
+
+      std::vector<std::optional<std::vector<std::byte>>> results(batch.size());
+
+      std::transform(std::execution::par, indexes.begin(), indexes.end(), results.begin(), [&](std::size_t i) -> std::optional<std::vector<std::byte>> {
+        auto& record = batch[i];
+        std::optional<std::vector<std::byte>> result;
+
+        if (old_positions[i] != no_position && get_checksum(old_contents[old_positions[i]]) != record.header.old_checksum)
+        {
+          return std::nullopt;
+        }
+
+        if (record.header.type == entry_change_type::unchanged)
+        {
+          result = old_contents[old_positions[i]];
+        }
+        else if (auto payload = decode_payload(record.header, std::move(record.payload)); payload.has_value())
+        {
+          result = record.header.type == entry_change_type::added ? std::move(payload) : apply_delta(old_contents[old_positions[i]], *payload);
+        }
+
+        if (!result || result->size() != record.header.new_size || get_checksum(*result) != record.header.new_checksum)
+        {
+          return std::nullopt;
+        }
+
+        return result;
+      });
+
+      std::vector<patched_entry> entries;
+      entries.reserve(batch.size());
+
+      for (auto i = 0u; i < batch.size(); ++i)
+      {
+        if (!results[i].has_value())
+        {
+          throw std::runtime_error("Could not patch " + batch[i].path + ", the patch was not made for " + old_archive.string());
+        }
+
+        entries.emplace_back(patched_entry{ std::move(batch[i].path), std::move(*results[i]), platform::compression_type(batch[i].header.compression_type), std::size_t(batch[i].header.extracted_size) });
+      }
+
+      writer->add(entries);
+
+      batch.clear();
+      batch_size = 0;
+    };
+
+    try
+    {
+      for (auto i = 0u; i < header.entry_count; ++i)
+      {
+        pending_record record{};
+
+        if (!platform::read(patch, reinterpret_cast<char*>(&record.header), sizeof(record.header)))
+        {
+          throw std::invalid_argument("Archive patch is truncated");
+        }
+
+        // A damaged patch could ask for far more memory than it has data, so sizes are checked against what is left of it.
+        auto position = patch.tellg();
+        auto bytes_left = position < 0 || std::size_t(position) > patch_size ? patch_size : patch_size - std::size_t(position);
+
+        if (record.header.path_size > bytes_left || record.header.payload_size > bytes_left - record.header.path_size)
+        {
+          throw std::invalid_argument("Archive patch has an entry which is larger than the patch");
+        }
+
+        // Payloads are only unpacked later, so their unpacked size is checked here, before anything is allocated for it.
+        // zlib never makes data more than 1032 times smaller.
+        auto max_raw_size = record.header.type == entry_change_type::added ? std::size_t(record.header.new_size) : get_max_delta_size(record.header.new_size);
+
+        if (record.header.raw_payload_size > max_raw_size || (record.header.encoding == payload_encoding::zlib && record.header.raw_payload_size > record.header.payload_size * 1032))
+        {
+          throw std::invalid_argument("Archive patch has a payload which is larger than its entry");
+        }
+
+        record.path.resize(record.header.path_size);
+        record.payload.resize(record.header.payload_size);
+
+        if (!platform::read(patch, record.path.data(), record.path.size()) || !platform::read(patch, record.payload.data(), record.payload.size()))
+        {
+          throw std::invalid_argument("Archive patch is truncated");
+        }
+
+        changes.emplace_back(entry_change{ record.path, record.header.type, record.header.old_checksum, record.header.new_checksum, record.header.new_size, record.payload.size() });
+
+        if (record.header.type == entry_change_type::removed)
+        {
+          continue;
+        }
+
+        if (record.header.type != entry_change_type::unchanged && record.header.type != entry_change_type::added && record.header.type != entry_change_type::modified)
+        {
+          throw std::invalid_argument("Archive patch contains an unknown change");
+        }
+
+        batch_size += record.header.new_size + record.payload.size();
+        batch.emplace_back(std::move(record));
+
+        if (batch_size >= max_batch_size)
+        {
+          apply_batch();
+        }
+      }
+
+      apply_batch();
+
+      writer->finish();
+      writer.reset();
+    }
+    catch (...)
+    {
+      writer.reset();
+      std::error_code unused;
+      fs::remove(temp_path, unused);
+      throw;
+    }
+
+    fs::rename(temp_path, new_archive);
+
+    return changes;
+  }
+}// namespace siege::resource
@@ -0,0 +1,238 @@
+#include <catch2/catch_test_macros.hpp>
+#include <cstring>
+#include <sstream>
+#include <fstream>
+#include <map>
+#include <siege/resource/archive_patch.hpp>
+#include <siege/resource/pak_resource.hpp>
+#include <siege/resource/darkstar_resource.hpp>
+#include <siege/platform/resource.hpp>
+#include <siege/platform/stream.hpp>
+#include <tuple>
+#include <optional>
+
+namespace pak = siege::resource::pak;
+namespace darkstar = siege::resource::vol::darkstar;
+
+namespace
+{
+  std::vector<std::byte> to_bytes(std::string_view value)
+  {
+    auto* data = reinterpret_cast<const std::byte*>(value.data());
+    return std::vector<std::byte>(data, data + value.size());
+  }
+
+  void create_pak(const std::filesystem::path& path, std::vector<std::pair<std::string, std::string>> entries)
+  {
+    std::vector<pak::pak_file_info> files;
+
+    for (auto& [filename, content] : entries)
+    {
+      auto size = content.size();
+      files.emplace_back(pak::pak_file_info{ filename, size, std::make_unique<std::stringstream>(content) });
+    }
+
+    std::ofstream output(path, std::ios::binary | std::ios::trunc);
+    pak::create_pak_file(output, files);
+  }
+
+  std::map<std::string, std::string> read_pak(const std::filesystem::path& path)
+  {
+    std::ifstream stream(path, std::ios::binary);
+    pak::pak_resource_reader reader;
+    std::map<std::string, std::string> results;
+
+    for (auto& info : siege::platform::get_all_content_of_type<siege::platform::file_info>(path, stream, reader))
+    {
+      std::any cache;
+      std::stringstream output;
+      reader.extract_file_contents(cache, stream, info, output);
+      results.emplace((info.folder_path / info.filename).lexically_relative(path).generic_string(), output.str());
+    }
+
+    return results;
+  }
+
+  // Compressed entries are given as the bytes they are stored as, since nothing here is able to compress them.
+  void create_vol(const std::filesystem::path& path, std::vector<std::tuple<std::string, std::string, darkstar::compression_type, std::int32_t>> entries)
+  {
+    std::vector<darkstar::volume_file_info> files;
+
+    for (auto& [filename, content, compression_type, size] : entries)
+    {
+      auto stored_size = std::int32_t(content.size());
+      files.emplace_back(darkstar::volume_file_info{
+        .filename = filename,
+        .size = size,
+        .compressed_size = compression_type == darkstar::compression_type::none ? std::nullopt : std::optional(stored_size),
+        .compression_type = compression_type,
+        .stream = std::make_unique<std::stringstream>(content) });
+    }
+
+    std::ofstream output(path, std::ios::binary | std::ios::trunc);
+    darkstar::create_vol_file(output, files);
+  }
+
+  std::string read_file(const std::filesystem::path& path)
+  {
+    std::ifstream stream(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+  }
+}// namespace
+
+TEST_CASE("With a small edit in a large buffer, the delta only contains the edit", "[archive_patch.delta]")
+{
+  std::string source;
+
+  for (auto i = 0; i < 4096; ++i)
+  {
+    source.append(std::to_string(i * 7919));
+  }
+
+  auto target = source;
+  target.replace(1000, 5, "Hello");
+  target.insert(9000, "World");
+
+  auto delta = siege::resource::create_delta(to_bytes(source), to_bytes(target));
+  REQUIRE(delta.size() < 64);
+
+  auto result = siege::resource::apply_delta(to_bytes(source), delta);
+  REQUIRE(result.has_value());
+  REQUIRE(*result == to_bytes(target));
+
+  REQUIRE(siege::resource::apply_delta(to_bytes(source.substr(0, 100)), delta).has_value() == false);
+}
+
+TEST_CASE("With an added, removed and modified entry, patches a PAK file", "[archive_patch.pak]")
+{
+  auto folder = std::filesystem::temp_directory_path();
+  auto old_path = folder / "archive_patch_old.pak";
+  auto new_path = folder / "archive_patch_new.pak";
+  auto patched_path = folder / "archive_patch_patched.pak";
+
+  std::string map(8192, 'a');
+  auto new_map = map;
+  new_map.replace(4000, 5, "e1m1!");
+
+  create_pak(old_path, { { "maps/e1m1.bsp", map }, { "sound/beep.wav", "Beep, beep, beep" }, { "progs.dat", "Hey, hey, hey" } });
+  create_pak(new_path, { { "maps/e1m1.bsp", new_map }, { "sound/beep.wav", "Beep, beep, beep" }, { "gfx/conback.lmp", "Hello Darkness, my old friend..." } });
+
+  std::stringstream patch;
+  auto changes = siege::resource::create_archive_patch(old_path, new_path, patch);
+
+  REQUIRE(changes.size() == 4);
+
+  auto count = [&](siege::resource::entry_change_type type) {
+    return std::count_if(changes.begin(), changes.end(), [&](auto& change) { return change.type == type; });
+  };
+
+  REQUIRE(count(siege::resource::entry_change_type::unchanged) == 1);
+  REQUIRE(count(siege::resource::entry_change_type::added) == 1);
+  REQUIRE(count(siege::resource::entry_change_type::removed) == 1);
+  REQUIRE(count(siege::resource::entry_change_type::modified) == 1);
+  REQUIRE(patch.str().size() < std::filesystem::file_size(new_path) / 10);
+
+  siege::resource::apply_archive_patch(old_path, patch, patched_path);
+
+  REQUIRE(read_pak(patched_path) == read_pak(new_path));
+
+  std::stringstream wrong_patch;
+  siege::resource::create_archive_patch(new_path, old_path, wrong_patch);
+  REQUIRE_THROWS(siege::resource::apply_archive_patch(old_path, wrong_patch, patched_path));
+
+  std::filesystem::remove(old_path);
+  std::filesystem::remove(new_path);
+  std::filesystem::remove(patched_path);
+}
+
+TEST_CASE("With compressed entries, patches a VOL file without losing their compression", "[archive_patch.vol]")
+{
+  auto folder = std::filesystem::temp_directory_path();
+  auto old_path = folder / "archive_patch_old.vol";
+  auto new_path = folder / "archive_patch_new.vol";
+  auto patched_path = folder / "archive_patch_patched.vol";
+
+  std::string text(4096, 'a');
+  auto new_text = text;
+  new_text.replace(2000, 5, "vol!!");
+
+  create_vol(old_path, { { "readme.txt", text, darkstar::compression_type::none, 4096 }, { "shape.dts", "lzh compressed shape", darkstar::compression_type::lzh, 100 } });
+  create_vol(new_path, { { "readme.txt", new_text, darkstar::compression_type::none, 4096 }, { "shape.dts", "lzh compressed shape", darkstar::compression_type::lzh, 100 }, { "sound.wav", "rle compressed sound", darkstar::compression_type::rle, 50 } });
+
+  std::stringstream patch;
+  auto changes = siege::resource::create_archive_patch(old_path, new_path, patch);
+  REQUIRE(changes.size() == 3);
+
+  siege::resource::apply_archive_patch(old_path, patch, patched_path);
+
+  // Entries are written in the same order and stored the same way, so the whole file is the same.
+  REQUIRE(read_file(patched_path) == read_file(new_path));
+  REQUIRE(std::filesystem::exists(patched_path.string() + ".tmp") == false);
+
+  std::filesystem::remove(old_path);
+  std::filesystem::remove(new_path);
+  std::filesystem::remove(patched_path);
+}
+
+TEST_CASE("When a patch fails part way through, nothing is left behind", "[archive_patch.pak]")
+{
+  auto folder = std::filesystem::temp_directory_path();
+  auto old_path = folder / "archive_patch_fail_old.pak";
+  auto new_path = folder / "archive_patch_fail_new.pak";
+  auto patched_path = folder / "archive_patch_fail_patched.pak";
+
+  create_pak(old_path, { { "a.txt", "first" }, { "b.txt", "second" } });
+  create_pak(new_path, { { "a.txt", "first" }, { "b.txt", "second, but changed" } });
+
+  std::stringstream patch;
+  siege::resource::create_archive_patch(old_path, new_path, patch);
+
+  // The patch no longer matches, as b.txt is different.
+  create_pak(old_path, { { "a.txt", "first" }, { "b.txt", "something else" } });
+  REQUIRE_THROWS(siege::resource::apply_archive_patch(old_path, patch, patched_path));
+
+  REQUIRE(std::filesystem::exists(patched_path) == false);
+  REQUIRE(std::filesystem::exists(patched_path.string() + ".tmp") == false);
+
+  std::filesystem::remove(old_path);
+  std::filesystem::remove(new_path);
+}
+
+TEST_CASE("When a patch asks for more than it holds, it is rejected before anything is allocated", "[archive_patch.pak]")
+{
+  auto folder = std::filesystem::temp_directory_path();
+  auto old_path = folder / "archive_patch_size_old.pak";
+  auto new_path = folder / "archive_patch_size_new.pak";
+  auto patched_path = folder / "archive_patch_size_patched.pak";
+  std::filesystem::remove(patched_path);
+
+  create_pak(old_path, { { "a.txt", "first" } });
+  create_pak(new_path, { { "a.txt", "first, but changed" } });
+
+  std::stringstream patch;
+  siege::resource::create_archive_patch(old_path, new_path, patch);
+  const auto original = patch.str();
+
+  // The first record follows the 16 byte header of the patch.
+  constexpr auto raw_payload_size_offset = 16 + 20;
+  constexpr auto payload_size_offset = 16 + 28;
+
+  auto set_size = [&](std::size_t offset) {
+    auto text = original;
+    siege::platform::little_uint64_t huge = std::uint64_t(1) << 40;
+    std::memcpy(text.data() + offset, &huge, sizeof(huge));
+    return std::stringstream(text);
+  };
+
+  auto huge_payload = set_size(payload_size_offset);
+  REQUIRE_THROWS_AS(siege::resource::apply_archive_patch(old_path, huge_payload, patched_path), std::invalid_argument);
+
+  auto huge_raw_payload = set_size(raw_payload_size_offset);
+  REQUIRE_THROWS_AS(siege::resource::apply_archive_patch(old_path, huge_raw_payload, patched_path), std::invalid_argument);
+
+  REQUIRE(std::filesystem::exists(patched_path) == false);
+  REQUIRE(std::filesystem::exists(patched_path.string() + ".tmp") == false);
+
+  std::filesystem::remove(old_path);
+  std::filesystem::remove(new_path);
+}
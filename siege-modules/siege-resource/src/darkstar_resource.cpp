@@ -6,6 +6,8 @@
 #include <utility>
 #include <string>
 #include <cstdlib>
+#include <limits>
+#include <stdexcept>
 #include <siege/resource/darkstar_resource.hpp>
 #include <siege/platform/stream.hpp>
 
@@ -131,51 +133,80 @@ namespace siege::resource::vol::darkstar
 
   void create_vol_file(std::ostream& output, const std::vector<volume_file_info>& files)
   {
-    auto start = std::size_t(output.tellp());
+    vol_writer writer(output);
 
+    for (auto& file : files)
+    {
+      writer.add(file);
+    }
+
+    writer.finish();
+  }
+
+  vol_writer::vol_writer(std::ostream& output) : output(output), start(0)
+  {
+    if (output.tellp() == std::ostream::pos_type(-1))
+    {
+      throw std::invalid_argument("VOL files can only be written to a seekable stream.");
+    }
+
+    start = std::size_t(output.tellp());
+
+    // The size is filled in by finish, once it is known.
     endian::little_uint32_t size = 0;
     platform::write(output, alt_vol_file_tag.data(), alt_vol_file_tag.size());
-
     platform::write(output, reinterpret_cast<const char*>(&size), sizeof(size));
+  }
 
-    std::map<std::string_view, endian::little_uint32_t> file_locations;
+  void vol_writer::add(const volume_file_info& file)
+  {
+    // Offsets are relative to the start of the volume, wherever it begins in the output.
+    auto offset = std::size_t(output.tellp()) - start;
+    auto stored_size = file.compressed_size.has_value() ? file.compressed_size.value() : file.size;
 
-    for (auto& file : files)
+    // Each block stores its size in 24 bits, and the index stores offsets and sizes in 32 bits.
+    if (stored_size < 0 || stored_size > 0xffffff || file.size < 0 || offset > std::numeric_limits<std::uint32_t>::max())
     {
-      file_locations.emplace(file.filename, endian::little_uint32_t(int(output.tellp())));
-      platform::write(output, block_tag.data(), block_tag.size());
-      endian::little_uint24_t narrowed_size = file.compressed_size.has_value() ? file.compressed_size.value() : file.size;
-      platform::write(output, reinterpret_cast<const char*>(&narrowed_size), sizeof(narrowed_size));
-      auto tag = std::byte(0x80);
-      platform::write(output, &tag, 1);
-
-      std::copy_n(std::istreambuf_iterator(*file.stream),
-        narrowed_size.value(),
-        std::ostreambuf_iterator(output));
+      throw std::invalid_argument("VOL files cannot hold " + file.filename + ", which is either too large or starts beyond 4 GB.");
+    }
 
-      auto size_for_padding = int(output.tellp());
-      while (size_for_padding % 4 != 0)
-      {
-        std::byte padding{ 0x00 };
-        platform::write(output, &padding, 1);
-        size_for_padding++;
-      }
+    entries.emplace_back(written_entry{ file.filename, std::uint32_t(offset), file.size, file.compression_type });
+
+    platform::write(output, block_tag.data(), block_tag.size());
+    endian::little_uint24_t narrowed_size = stored_size;
+    platform::write(output, reinterpret_cast<const char*>(&narrowed_size), sizeof(narrowed_size));
+    auto tag = std::byte(0x80);
+    platform::write(output, &tag, 1);
+
+    std::copy_n(std::istreambuf_iterator(*file.stream),
+      narrowed_size.value(),
+      std::ostreambuf_iterator(output));
+
+    auto size_for_padding = std::size_t(output.tellp()) - start;
+    while (size_for_padding % 4 != 0)
+    {
+      std::byte padding{ 0x00 };
+      platform::write(output, &padding, 1);
+      size_for_padding++;
     }
+  }
 
+  void vol_writer::finish()
+  {
     auto current_position = std::size_t(output.tellp());
 
     output.seekp(std::size_t(start) + alt_vol_file_tag.size(), std::ios_base::beg);
-    size = std::int32_t(current_position - start);
+    endian::little_uint32_t size = std::int32_t(current_position - start);
     platform::write(output, reinterpret_cast<const char*>(&size), sizeof(size));
 
     output.seekp(current_position, std::ios_base::beg);
 
     std::string filenames;
-    filenames.reserve(10 * filenames.size());
+    filenames.reserve(10 * entries.size());
 
-    for (auto& file : files)
+    for (auto& entry : entries)
     {
-      filenames.append(file.filename);
+      filenames.append(entry.filename);
       filenames.push_back('\0');
     }
 
@@ -193,20 +224,22 @@ namespace siege::resource::vol::darkstar
       size_for_padding++;
     }
 
-    string_size = std::int32_t(files.size() * sizeof(file_header));
+    string_size = std::int32_t(entries.size() * sizeof(file_header));
     platform::write(output, vol_index_tag.data(), vol_index_tag.size());
     platform::write(output, reinterpret_cast<const char*>(&string_size), sizeof(string_size));
 
-    for (auto& file : files)
+    for (auto& entry : entries)
     {
       endian::little_uint32_t value = 0;
       platform::write(output, reinterpret_cast<const char*>(&value), sizeof(value));
       platform::write(output, reinterpret_cast<const char*>(&value), sizeof(value));
-      platform::write(output, reinterpret_cast<const char*>(&file_locations[file.filename]), sizeof(value));
 
-      value = file.size;
+      value = entry.offset;
+      platform::write(output, reinterpret_cast<const char*>(&value), sizeof(value));
+
+      value = entry.size;
       platform::write(output, reinterpret_cast<const char*>(&value), sizeof(value));
-      platform::write(output, reinterpret_cast<const char*>(&file.compression_type), 1);
+      platform::write(output, reinterpret_cast<const char*>(&entry.compression_type), 1);
     }
   }
 
@@ -217,3 +217,14 @@ TEST_CASE("With one text file, creates a Darkstar Volume file with the correct b
       parsed_files.at(2));
   }
 }
+
+TEST_CASE("With an entry too large for the 24 bit size of a block, the VOL writer throws before writing it", "[vol.darkstar]")
+{
+  std::stringstream mem_buffer;
+  darkstar::vol_writer writer(mem_buffer);
+  auto written = mem_buffer.str().size();
+
+  darkstar::volume_file_info file{ "huge.bin", 0x1000000, std::nullopt, darkstar::compression_type::none, std::make_unique<std::stringstream>() };
+  REQUIRE_THROWS_AS(writer.add(file), std::invalid_argument);
+  REQUIRE(mem_buffer.str().size() == written);
+}
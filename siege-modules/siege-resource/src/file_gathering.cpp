@@ -0,0 +1,211 @@
+#include <algorithm>
+#include <iterator>
+#include <siege/resource/file_gathering.hpp>
+#include <siege/resource/darkstar_resource.hpp>
+#include <siege/resource/three_space_resource.hpp>
+#include <siege/resource/trophy_bass_resource.hpp>
+#include <siege/resource/zip_resource.hpp>
+#include <siege/resource/cyclone_resource.hpp>
+#include <siege/resource/sword_resource.hpp>
+#include <siege/resource/prj_resource.hpp>
+
+namespace fs = std::filesystem;
+
+namespace siege::resource
+{
+  resource_explorer make_resource_explorer()
+  {
+    resource_explorer archive;
+
+    archive.add_archive_type(".tbv", std::make_unique<vol::trophy_bass::tbv_resource_reader>());
+    archive.add_archive_type(".rbx", std::make_unique<vol::trophy_bass::rbx_resource_reader>());
+    archive.add_archive_type(".rmf", std::make_unique<vol::three_space::rmf_resource_reader>());
+    archive.add_archive_type(".map", std::make_unique<vol::three_space::rmf_resource_reader>());
+    archive.add_archive_type(".vga", std::make_unique<vol::three_space::rmf_resource_reader>());
+    archive.add_archive_type(".zip", std::make_unique<zip::zip_resource_reader>());
+    archive.add_archive_type(".vl2", std::make_unique<zip::zip_resource_reader>());
+    archive.add_archive_type(".pk3", std::make_unique<zip::zip_resource_reader>());
+    archive.add_archive_type(".dyn", std::make_unique<vol::three_space::dyn_resource_reader>());
+    archive.add_archive_type(".vol", std::make_unique<vol::three_space::vol_resource_reader>());
+    archive.add_archive_type(".vol", std::make_unique<vol::darkstar::vol_resource_reader>());
+    archive.add_archive_type(".cln", std::make_unique<cln::cln_resource_reader>());
+    archive.add_archive_type(".atd", std::make_unique<atd::atd_resource_reader>());
+    archive.add_archive_type(".prj", std::make_unique<prj::prj_resource_reader>());
+
+    return archive;
+  }
+
+  std::vector<gathered_file> gather_files(const resource_explorer& explorer,
+    std::span<const fs::path> inputs,
+    const std::vector<std::string_view>& extensions,
+    const std::function<void(const fs::path&)>& on_missing)
+  {
+    std::vector<gathered_file> results;
+
+    for (auto& input : inputs)
+    {
+      std::error_code last_error;
+
+      if (fs::is_directory(input, last_error) || explorer.get_archive_type(input).has_value())
+      {
+        for (auto& info : explorer.find_files(input, extensions))
+        {
+          results.emplace_back(gathered_file{ std::move(info), input });
+        }
+      }
+      else if (fs::is_regular_file(input, last_error))
+      {
+        siege::platform::file_info info{};
+        info.filename = input.filename();
+        info.folder_path = input.parent_path().empty() ? fs::current_path() : input.parent_path();
+        info.size = std::size_t(fs::file_size(input, last_error));
+        auto input_root = info.folder_path;
+        results.emplace_back(gathered_file{ std::move(info), std::move(input_root) });
+      }
+      else if (on_missing)
+      {
+        on_missing(input);
+      }
+    }
+
+    return results;
+  }
+
+  std::vector<siege::platform::file_info> find_beside(const resource_explorer& explorer,
+    std::span<const gathered_file> files,
+    const std::vector<std::string_view>& extensions)
+  {
+    std::set<fs::path> roots;
+
+    for (auto& file : files)
+    {
+      roots.emplace(file.input_root);
+    }
+
+    std::vector<siege::platform::file_info> results;
+    std::optional<fs::path> last_root;
+
+    // Roots come before the folders under them, which are left out so that nothing is found twice.
+    for (auto& root : roots)
+    {
+      if (last_root && std::mismatch(last_root->begin(), last_root->end(), root.begin(), root.end()).first == last_root->end())
+      {
+        continue;
+      }
+
+      last_root = root;
+      auto found = explorer.find_files(root, extensions);
+      std::move(found.begin(), found.end(), std::back_inserter(results));
+    }
+
+    return results;
+  }
+
+  fs::path get_output_path(const fs::path& output_folder, const gathered_file& file, const fs::path& new_filename)
+  {
+    auto relative = file.info.folder_path.lexically_relative(file.input_root);
+
+    if (relative.empty() || relative == "." || *relative.begin() == "..")
+    {
+      relative = fs::path{};
+    }
+
+    return output_folder / relative / new_filename;
+  }
+
+  shared_reader::shared_reader(const resource_explorer& explorer)
+    : explorer(explorer)
+  {
+  }
+
+  std::vector<char> shared_reader::read(const siege::platform::file_info& info) const
+  {
+    std::lock_guard<std::mutex> guard(mutex);
+    auto [_, stream] = explorer.load_file(info);
+
+    auto size = info.size;
+
+    if (info.compression_type == siege::platform::compression_type::none && fs::is_directory(info.folder_path))
+    {
+      size = std::size_t(fs::file_size(info.folder_path / info.filename));
+    }
+
+    std::vector<char> contents(size);
+    stream->read(contents.data(), std::streamsize(contents.size()));
+    contents.resize(std::size_t(stream->gcount()));
+    return contents;
+  }
+
+  embedded_files::embedded_files(const resource_explorer& explorer, const shared_reader& reader, std::vector<std::string_view> extensions)
+    : explorer(explorer), reader(reader), extensions(std::move(extensions))
+  {
+  }
+
+  std::set<fs::path> embedded_files::find(const fs::path& archive_path)
+  {
+    std::set<fs::path> results;
+
+    if (!explorer.get_archive_type(archive_path).has_value())
+    {
+      return results;
+    }
+
+    for (auto& info : explorer.find_files(archive_path, extensions))
+    {
+      auto full_path = info.folder_path / info.filename;
+      results.emplace(full_path);
+      files.insert_or_assign(std::move(full_path), std::move(info));
+    }
+
+    return results;
+  }
+
+  std::vector<char> embedded_files::read(const fs::path& path) const
+  {
+    auto existing = files.find(path);
+    return existing == files.end() ? std::vector<char>{} : reader.read(existing->second);
+  }
+
+  files_by_id::files_by_id(const resource_explorer& explorer, const shared_reader& reader, const fs::path& archive_path)
+    : reader(reader)
+  {
+    for (auto& info : explorer.find_files(archive_path, { "ALL" }))
+    {
+      if (info.metadata.has_value() && info.metadata.type() == typeid(std::uint16_t))
+      {
+        auto file_id = std::any_cast<std::uint16_t>(info.metadata);
+        files.insert_or_assign(file_id, std::move(info));
+      }
+    }
+  }
+
+  std::optional<std::string> files_by_id::get_filename(std::uint16_t file_id) const
+  {
+    auto existing = files.find(file_id);
+    return existing == files.end() ? std::nullopt : std::make_optional(existing->second.filename.string());
+  }
+
+  std::vector<char> files_by_id::read(std::uint16_t file_id) const
+  {
+    auto existing = files.find(file_id);
+    return existing == files.end() ? std::vector<char>{} : reader.read(existing->second);
+  }
+
+  std::map<fs::path, files_by_id> get_files_by_id(const resource_explorer& explorer,
+    const shared_reader& reader,
+    std::span<const gathered_file> files,
+    std::string_view extension)
+  {
+    std::map<fs::path, files_by_id> results;
+
+    for (auto& file : files)
+    {
+      if (!file.info.archive_path.empty() && siege::platform::to_lower(file.info.filename.extension().string()) == extension)
+      {
+        results.try_emplace(file.info.archive_path, explorer, reader, file.info.archive_path);
+      }
+    }
+
+    return results;
+  }
+}// namespace siege::resource
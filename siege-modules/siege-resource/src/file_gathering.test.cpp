@@ -0,0 +1,70 @@
+#include <catch2/catch_test_macros.hpp>
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <string>
+#include <siege/resource/file_gathering.hpp>
+
+namespace fs = std::filesystem;
+namespace resource = siege::resource;
+
+namespace
+{
+  struct temp_folder
+  {
+    fs::path path = fs::temp_directory_path() / ("siege-gathering-test-" + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count()));
+
+    temp_folder()
+    {
+      fs::create_directories(path);
+    }
+
+    ~temp_folder()
+    {
+      std::error_code unused;
+      fs::remove_all(path, unused);
+    }
+  };
+
+  void write_file(const fs::path& path, std::string_view content)
+  {
+    std::ofstream output(path, std::ios::binary | std::ios::trunc);
+    output << content;
+  }
+}// namespace
+
+TEST_CASE("gather_files finds files by extension and keeps their folders under the output", "[resource.gathering]")
+{
+  temp_folder folder;
+  fs::create_directories(folder.path / "textures");
+  write_file(folder.path / "textures" / "grass.bmp", "grass");
+  write_file(folder.path / "textures" / "notes.txt", "notes");
+  write_file(folder.path / "sky.bmp", "sky");
+
+  auto explorer = resource::make_resource_explorer();
+  std::vector<fs::path> missing;
+  std::vector<fs::path> inputs{ folder.path, folder.path / "textures" / "grass.bmp", folder.path / "nothing-here" };
+
+  auto files = resource::gather_files(explorer, inputs, { ".bmp" }, [&](const fs::path& input) { missing.emplace_back(input); });
+
+  REQUIRE(missing == std::vector<fs::path>{ folder.path / "nothing-here" });
+  REQUIRE(files.size() == 3);
+
+  auto grass = std::find_if(files.begin(), files.end(), [&](const auto& file) {
+    return file.info.filename == "grass.bmp" && file.input_root == folder.path;
+  });
+  REQUIRE(grass != files.end());
+  REQUIRE(resource::get_output_path("out", *grass, "grass.png") == fs::path("out") / "textures" / "grass.png");
+
+  // A file given on its own has no folder structure to keep.
+  REQUIRE(resource::get_output_path("out", files.back(), "grass.png") == fs::path("out") / "grass.png");
+
+  // The folder of the file given on its own is under the other input, so its files are only found once.
+  auto beside = resource::find_beside(explorer, files, { ".txt" });
+  REQUIRE(beside.size() == 1);
+  REQUIRE(beside[0].filename == "notes.txt");
+
+  resource::shared_reader reader(explorer);
+  auto contents = reader.read(grass->info);
+  REQUIRE(std::string(contents.begin(), contents.end()) == "grass");
+}
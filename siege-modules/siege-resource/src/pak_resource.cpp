@@ -1,6 +1,7 @@
 #include <fstream>
 #include <filesystem>
 #include <vector>
+#include <limits>
 #include <list>
 #include <string>
 #include <unordered_map>
@@ -8,9 +9,10 @@
 #include <utility>
 #include <cstdlib>
 #include <sstream>
+#include <stdexcept>
 #include <algorithm>
 #include <iostream>
-#include <unordered_map>
+#include <execution>
 #include <zlib.h>
 
 #include <siege/resource/pak_resource.hpp>
@@ -124,6 +126,24 @@ namespace siege::resource::pak
         entry_type = typeid(dat_file_entry).hash_code();
         file_count = file_buffer_size / sizeof(dat_file_entry);
       }
+      else if ((file_buffer_size % sizeof(pak_file_entry)) == 0 && (file_buffer_size % sizeof(daikatana_pak_file_entry)) == 0)
+      {
+        // Both entry sizes divide the directory, so look at the first entry to tell them apart.
+        // For a Quake PAK, the extra Daikatana fields would contain the characters of the second path.
+        daikatana_pak_file_entry first_entry{};
+        stream.seekg(current_offset + offset, std::ios::beg);
+        stream.read(reinterpret_cast<char*>(&first_entry), sizeof(first_entry));
+
+        if (first_entry.has_compression <= 1 && first_entry.compressed_size <= first_entry.uncompressed_size)
+        {
+          entry_type = typeid(daikatana_pak_file_entry).hash_code();
+          file_count = file_buffer_size / sizeof(daikatana_pak_file_entry);
+        }
+        else
+        {
+          file_count = file_buffer_size / sizeof(pak_file_entry);
+        }
+      }
       else if ((file_buffer_size % sizeof(pak_file_entry)) == 0)
       {
         file_count = file_buffer_size / sizeof(pak_file_entry);
@@ -238,7 +258,8 @@ namespace siege::resource::pak
 
               if constexpr (sizeof(entry) == sizeof(dat_file_entry))
               {
-                compression_type = siege::platform::compression_type::lz77_huffman;
+                // Uncompressed Anachronox entries have no compressed size.
+                compression_type = entry.compressed_size == 0 ? siege::platform::compression_type::none : siege::platform::compression_type::lz77_huffman;
               }
 
               results.emplace_back(pak_resource_reader::file_info{
@@ -381,4 +402,428 @@ namespace siege::resource::pak
         std::ostreambuf_iterator(output));
     }
   }
+  std::vector<std::byte> code_rle_compress(std::span<const std::byte> input)
+  {
+    // Produces the same op codes which extract_file_contents understands:
+    // 0-63 copies the next (op + 1) bytes, 64-127 repeats zero (op - 62) times,
+    // 128-191 repeats the next byte (op - 126) times, 192-254 copies (op - 190) bytes
+    // from (next byte + 2) bytes back in the output and 255 ends the stream.
+    constexpr static auto max_literal_size = 64u;
+    constexpr static auto max_run_size = 65u;
+    constexpr static auto max_copy_size = 64u;
+    constexpr static auto min_copy_distance = 2u;
+    constexpr static auto max_copy_distance = 257u;
+
+    std::vector<std::byte> result;
+    result.reserve(input.size() + input.size() / max_literal_size + 2);
+
+    std::array<std::int64_t, 4096> last_seen;
+    last_seen.fill(-1);
+
+    auto hash_at = [&](std::size_t position) {
+      return ((std::size_t(input[position]) << 8) ^ (std::size_t(input[position + 1]) << 4) ^ std::size_t(input[position + 2])) & (last_seen.size() - 1);
+    };
+
+    std::size_t literal_start = 0;
+    std::size_t position = 0;
+
+    auto flush_literals = [&](std::size_t end) {
+      while (literal_start < end)
+      {
+        auto count = std::min<std::size_t>(max_literal_size, end - literal_start);
+        result.emplace_back(std::byte(count - 1));
+        result.insert(result.end(), input.begin() + literal_start, input.begin() + literal_start + count);
+        literal_start += count;
+      }
+    };
+
+    auto remember = [&](std::size_t start, std::size_t end) {
+      for (; start < end && start + 2 < input.size(); ++start)
+      {
+        last_seen[hash_at(start)] = std::int64_t(start);
+      }
+    };
+
+    while (position < input.size())
+    {
+      auto value = input[position];
+      std::size_t run = 1;
+
+      while (position + run < input.size() && run < max_run_size && input[position + run] == value)
+      {
+        run++;
+      }
+
+      if (run >= 3 || (run == 2 && value == std::byte{ 0 }))
+      {
+        flush_literals(position);
+
+        if (value == std::byte{ 0 })
+        {
+          result.emplace_back(std::byte(run + 62));
+        }
+        else
+        {
+          result.emplace_back(std::byte(run + 126));
+          result.emplace_back(value);
+        }
+
+        remember(position, position + run);
+        position += run;
+        literal_start = position;
+        continue;
+      }
+
+      if (position + 2 < input.size())
+      {
+        auto candidate = last_seen[hash_at(position)];
+
+        if (candidate >= 0)
+        {
+          auto distance = position - std::size_t(candidate);
+
+          if (distance >= min_copy_distance && distance <= max_copy_distance)
+          {
+            std::size_t length = 0;
+            auto max_length = std::min<std::size_t>({ max_copy_size, distance, input.size() - position });
+
+            while (length < max_length && input[candidate + length] == input[position + length])
+            {
+              length++;
+            }
+
+            if (length >= 3)
+            {
+              flush_literals(position);
+              result.emplace_back(std::byte(length + 190));
+              result.emplace_back(std::byte(distance - 2));
+
+              remember(position, position + length);
+              position += length;
+              literal_start = position;
+              continue;
+            }
+          }
+        }
+      }
+
+      remember(position, position + 1);
+      position++;
+    }
+
+    flush_literals(position);
+    result.emplace_back(std::byte(255));
+
+    return result;
+  }
+
+  struct prepared_entry
+  {
+    std::string path;
+    std::string sort_key;
+    std::vector<std::byte> data;
+    std::size_t size;
+    bool is_compressed;
+    std::size_t offset;
+    std::size_t stored_size;
+  };
+
+  namespace
+  {
+
+    std::optional<std::vector<std::byte>> zlib_compress(std::span<const std::byte> input)
+    {
+      std::vector<std::byte> result(compressBound(uLong(input.size())));
+      auto result_size = uLongf(result.size());
+
+      if (compress2((Bytef*)result.data(), &result_size, (const Bytef*)input.data(), uLong(input.size()), Z_BEST_COMPRESSION) != Z_OK)
+      {
+        return std::nullopt;
+      }
+
+      result.resize(result_size);
+      return result;
+    }
+
+    void write_padding(std::ostream& output, std::size_t count)
+    {
+      constexpr static std::array<std::byte, 64> zeros{};
+
+      while (count > 0)
+      {
+        auto amount = std::min(count, zeros.size());
+        platform::write(output, zeros.data(), amount);
+        count -= amount;
+      }
+    }
+
+    void validate_settings(const pak_write_settings& settings)
+    {
+      using compression_type = siege::platform::compression_type;
+
+      if (settings.compression_type == compression_type::none)
+      {
+        return;
+      }
+
+      if (settings.version == pak_version::daikatana && settings.compression_type != compression_type::code_rle)
+      {
+        throw std::invalid_argument("Daikatana PAK files only support code_rle compression.");
+      }
+
+      if (settings.version == pak_version::anachronox && settings.compression_type != compression_type::lz77_huffman)
+      {
+        throw std::invalid_argument("Anachronox DAT files only support lz77_huffman (zlib) compression.");
+      }
+
+      if (settings.version == pak_version::quake)
+      {
+        throw std::invalid_argument("Quake PAK files do not support compression.");
+      }
+    }
+
+    std::size_t get_header_size(const pak_write_settings& settings)
+    {
+      return settings.version == pak_version::anachronox ? 16 : 12;
+    }
+
+    std::size_t get_entry_size(const pak_write_settings& settings)
+    {
+      return settings.version == pak_version::quake ? sizeof(pak_file_entry) : settings.version == pak_version::daikatana ? sizeof(daikatana_pak_file_entry)
+                                                                                                                         : sizeof(dat_file_entry);
+    }
+
+    // Reads every file and, where it makes them smaller, compresses them in parallel.
+    std::vector<prepared_entry> prepare_entries(std::vector<pak_file_info>& files, const pak_write_settings& settings)
+    {
+      using compression_type = siege::platform::compression_type;
+
+      const auto max_path_size = settings.version == pak_version::anachronox ? sizeof(dat_file_entry::path) : sizeof(pak_file_entry::path);
+
+      std::vector<prepared_entry> entries(files.size());
+
+      for (auto i = 0u; i < files.size(); ++i)
+      {
+        entries[i].path = files[i].filename;
+        std::replace(entries[i].path.begin(), entries[i].path.end(), '\\', '/');
+
+        if (entries[i].path.size() >= max_path_size)
+        {
+          throw std::invalid_argument("The path " + entries[i].path + " is too long for the PAK directory.");
+        }
+
+        // Checked here rather than while reading, since exceptions cannot leave the parallel transform below.
+        if (files[i].size > std::numeric_limits<std::uint32_t>::max())
+        {
+          throw std::invalid_argument("The file " + entries[i].path + " is larger than 4GB.");
+        }
+
+        entries[i].sort_key = platform::to_lower(entries[i].path);
+      }
+
+      std::transform(std::execution::par, files.begin(), files.end(), entries.begin(), entries.begin(), [&](pak_file_info& file, prepared_entry entry) {
+        entry.size = file.size;
+        entry.data.resize(file.size);
+        platform::read(*file.stream, entry.data.data(), entry.data.size());
+
+        if (settings.compression_type != compression_type::none && !entry.data.empty())
+        {
+          auto compressed = settings.compression_type == compression_type::code_rle ? code_rle_compress(entry.data) : zlib_compress(entry.data);
+
+          if (compressed && compressed->size() < entry.data.size())
+          {
+            entry.data = std::move(*compressed);
+            entry.is_compressed = true;
+          }
+        }
+
+        entry.stored_size = entry.data.size();
+        return entry;
+      });
+
+      return entries;
+    }
+
+    // Every offset and size in a PAK is 32-bit, and the directory is the last thing in it.
+    void check_archive_size(std::size_t directory_offset, std::size_t directory_size)
+    {
+      if (directory_offset + directory_size > std::numeric_limits<std::uint32_t>::max())
+      {
+        throw std::invalid_argument("The PAK contents are larger than 4GB.");
+      }
+    }
+
+    void write_header(std::ostream& output, const pak_write_settings& settings, std::size_t directory_offset, std::size_t directory_size)
+    {
+      check_archive_size(directory_offset, directory_size);
+
+      platform::write(output, settings.version == pak_version::anachronox ? anox_tag.data() : quake_tag.data(), quake_tag.size());
+      endian::little_uint32_t value = std::uint32_t(directory_offset);
+      platform::write(output, reinterpret_cast<const char*>(&value), sizeof(value));
+      value = std::uint32_t(directory_size);
+      platform::write(output, reinterpret_cast<const char*>(&value), sizeof(value));
+
+      if (settings.version == pak_version::anachronox)
+      {
+        constexpr static auto anox_version = 9;
+        value = anox_version;
+        platform::write(output, reinterpret_cast<const char*>(&value), sizeof(value));
+      }
+    }
+
+    template<typename EntryType>
+    EntryType make_entry(const prepared_entry& entry)
+    {
+      EntryType result{};
+      std::copy(entry.path.begin(), entry.path.end(), result.path.begin());
+      result.offset = std::uint32_t(entry.offset);
+      result.uncompressed_size = std::uint32_t(entry.size);
+
+      if constexpr (std::is_same_v<EntryType, daikatana_pak_file_entry>)
+      {
+        result.compressed_size = std::uint32_t(entry.stored_size);
+        result.has_compression = entry.is_compressed ? 1 : 0;
+      }
+
+      if constexpr (std::is_same_v<EntryType, dat_file_entry>)
+      {
+        result.compressed_size = entry.is_compressed ? std::uint32_t(entry.stored_size) : 0u;
+      }
+
+      return result;
+    }
+
+    template<typename EntryType>
+    void write_directory(std::ostream& output, const std::vector<prepared_entry>& entries)
+    {
+      std::vector<EntryType> directory;
+      directory.reserve(entries.size());
+
+      std::transform(entries.begin(), entries.end(), std::back_inserter(directory), make_entry<EntryType>);
+      platform::write(output, reinterpret_cast<const char*>(directory.data()), directory.size() * sizeof(EntryType));
+    }
+
+    void write_directory(std::ostream& output, const pak_write_settings& settings, const std::vector<prepared_entry>& entries)
+    {
+      if (settings.version == pak_version::quake)
+      {
+        write_directory<pak_file_entry>(output, entries);
+      }
+      else if (settings.version == pak_version::daikatana)
+      {
+        write_directory<daikatana_pak_file_entry>(output, entries);
+      }
+      else
+      {
+        write_directory<dat_file_entry>(output, entries);
+      }
+    }
+
+    void sort_entries(std::vector<prepared_entry>& entries)
+    {
+      std::stable_sort(entries.begin(), entries.end(), [](const auto& a, const auto& b) {
+        return a.sort_key < b.sort_key;
+      });
+    }
+  }// namespace
+
+  void create_pak_file(std::ostream& output, std::vector<pak_file_info>& files, const pak_write_settings& settings)
+  {
+    validate_settings(settings);
+
+    const auto alignment = std::max<std::size_t>(settings.alignment, 1);
+
+    auto entries = prepare_entries(files, settings);
+    sort_entries(entries);
+
+    const auto header_size = get_header_size(settings);
+
+    // Lay everything out up front, so the output can be written in one pass without seeking.
+    // Offsets are relative to the start of the archive, wherever it begins in the output.
+    std::size_t position = header_size;
+
+    for (auto& entry : entries)
+    {
+      position += platform::get_padding_size(position, alignment);
+      entry.offset = position;
+      position += entry.data.size();
+    }
+
+    auto directory_padding = platform::get_padding_size(position, alignment);
+
+    write_header(output, settings, position + directory_padding, entries.size() * get_entry_size(settings));
+
+    position = header_size;
+
+    for (auto& entry : entries)
+    {
+      write_padding(output, entry.offset - position);
+      platform::write(output, entry.data.data(), entry.data.size());
+      position = entry.offset + entry.data.size();
+    }
+
+    write_padding(output, directory_padding);
+    write_directory(output, settings, entries);
+  }
+
+  pak_writer::pak_writer(std::ostream& output, const pak_write_settings& settings)
+    : output(output), settings(settings), start(0), position(0)
+  {
+    if (output.tellp() == std::ostream::pos_type(-1))
+    {
+      throw std::invalid_argument("PAK files can only be written a batch at a time to a seekable stream.");
+    }
+
+    start = std::size_t(output.tellp());
+    validate_settings(settings);
+    this->settings.alignment = std::max<std::size_t>(settings.alignment, 1);
+
+    // The real header is written by finish, once the directory offset is known.
+    write_header(output, this->settings, 0, 0);
+    position = get_header_size(this->settings);
+  }
+
+  pak_writer::~pak_writer() = default;
+
+  void pak_writer::add(std::vector<pak_file_info>& files)
+  {
+    auto prepared = prepare_entries(files, settings);
+
+    for (auto& entry : prepared)
+    {
+      auto padding = platform::get_padding_size(position, settings.alignment);
+
+      // Nothing of an entry is written when its offset would not fit in the directory.
+      check_archive_size(position + padding, entry.data.size());
+      write_padding(output, padding);
+      position += padding;
+
+      entry.offset = position;
+      platform::write(output, entry.data.data(), entry.data.size());
+      position += entry.data.size();
+
+      // Only the directory entry is kept, the data is already in the output.
+      entry.data = std::vector<std::byte>{};
+      entries.emplace_back(std::move(entry));
+    }
+  }
+
+  void pak_writer::finish()
+  {
+    sort_entries(entries);
+
+    auto directory_padding = platform::get_padding_size(position, settings.alignment);
+    auto directory_offset = position + directory_padding;
+    auto directory_size = entries.size() * get_entry_size(settings);
+
+    // Checked before the directory is written, rather than by write_header once it is already in the output.
+    check_archive_size(directory_offset, directory_size);
+    write_padding(output, directory_padding);
+    write_directory(output, settings, entries);
+
+    auto end = output.tellp();
+    output.seekp(std::streamoff(start), std::ios::beg);
+    write_header(output, settings, directory_offset, directory_size);
+    output.seekp(end);
+  }
 }// namespace siege::resource::pak
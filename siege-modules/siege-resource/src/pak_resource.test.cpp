@@ -0,0 +1,230 @@
+#include <catch2/catch_test_macros.hpp>
+#include <sstream>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <siege/resource/pak_resource.hpp>
+#include <siege/platform/stream.hpp>
+#include <siege/platform/shared.hpp>
+
+namespace pak = siege::resource::pak;
+
+namespace
+{
+  pak::pak_file_info make_file(std::string filename, std::string content)
+  {
+    auto size = content.size();
+    return pak::pak_file_info{ std::move(filename), size, std::make_unique<std::stringstream>(std::move(content)) };
+  }
+
+  std::string extract(std::stringstream& archive, const pak::pak_resource_reader& reader, const siege::platform::file_info& info)
+  {
+    std::any cache;
+    std::stringstream output;
+    reader.extract_file_contents(cache, archive, info, output);
+    return output.str();
+  }
+}// namespace
+
+TEST_CASE("With several files, creates a PAK file with a sorted directory", "[pak.quake]")
+{
+  std::stringstream mem_buffer;
+
+  std::vector<pak::pak_file_info> files;
+  files.emplace_back(make_file("sound/beep.wav", "Beep, beep, beep"));
+  files.emplace_back(make_file("Maps/e1m1.bsp", "Hello Darkness, my old friend..."));
+  files.emplace_back(make_file("maps/e1m2.bsp", "Hey, hey, hey"));
+
+  pak::create_pak_file(mem_buffer, files, { .alignment = 16 });
+
+  REQUIRE(pak::pak_resource_reader::is_supported(mem_buffer) == true);
+
+  pak::pak_resource_reader reader;
+  std::any cache;
+  auto root_listing = reader.get_content_listing(cache, mem_buffer, { "test.pak", "test.pak" });
+  auto maps_listing = reader.get_content_listing(cache, mem_buffer, { "test.pak", std::filesystem::path("test.pak") / "Maps" });
+
+  REQUIRE(root_listing.size() == 3);
+  REQUIRE(maps_listing.size() == 1);
+
+  auto& info = std::get<siege::platform::file_info>(maps_listing.at(0));
+  REQUIRE(info.filename == "e1m1.bsp");
+  REQUIRE(info.offset == 16);
+  REQUIRE(extract(mem_buffer, reader, info) == "Hello Darkness, my old friend...");
+
+  mem_buffer.seekg(48, std::ios::beg);
+  std::array<char, 13> content{};
+  siege::platform::read(mem_buffer, content.data(), content.size());
+  REQUIRE(std::string_view(content.data(), content.size()) == "Hey, hey, hey");
+}
+
+TEST_CASE("With code_rle compression, creates a Daikatana PAK file which can be extracted", "[pak.daikatana]")
+{
+  std::stringstream mem_buffer;
+
+  std::string repeated = std::string(100, '\0') + std::string(70, 'a') + "abcdefabcdefabcdef-the end";
+
+  std::vector<pak::pak_file_info> files;
+  files.emplace_back(make_file("data/repeated.dat", repeated));
+  files.emplace_back(make_file("data/short.txt", "abc"));
+
+  pak::create_pak_file(mem_buffer, files, { .version = pak::pak_version::daikatana, .compression_type = siege::platform::compression_type::code_rle });
+
+  pak::pak_resource_reader reader;
+  std::any cache;
+  auto listing = reader.get_content_listing(cache, mem_buffer, { "test.pak", std::filesystem::path("test.pak") / "data" });
+
+  REQUIRE(listing.size() == 2);
+
+  auto& compressed = std::get<siege::platform::file_info>(listing.at(0));
+  REQUIRE(compressed.filename == "repeated.dat");
+  REQUIRE(compressed.compression_type == siege::platform::compression_type::code_rle);
+  REQUIRE(compressed.compressed_size.value() < repeated.size());
+  REQUIRE(extract(mem_buffer, reader, compressed) == repeated);
+
+  auto& stored = std::get<siege::platform::file_info>(listing.at(1));
+  REQUIRE(stored.compression_type == siege::platform::compression_type::none);
+  REQUIRE(extract(mem_buffer, reader, stored) == "abc");
+}
+
+TEST_CASE("With zlib compression, creates an Anachronox DAT file where only smaller entries are compressed", "[pak.anachronox]")
+{
+  std::stringstream mem_buffer;
+
+  std::string repeated;
+
+  for (auto i = 0; i < 64; ++i)
+  {
+    repeated += "The quick brown fox jumps over the lazy dog. ";
+  }
+
+  std::vector<pak::pak_file_info> files;
+  files.emplace_back(make_file("text/repeated.txt", repeated));
+  files.emplace_back(make_file("text/short.txt", "abc"));
+
+  pak::create_pak_file(mem_buffer, files, { .version = pak::pak_version::anachronox, .compression_type = siege::platform::compression_type::lz77_huffman });
+
+  REQUIRE(pak::pak_resource_reader::is_supported(mem_buffer) == true);
+
+  pak::pak_resource_reader reader;
+  std::any cache;
+  auto listing = reader.get_content_listing(cache, mem_buffer, { "test.dat", std::filesystem::path("test.dat") / "text" });
+
+  REQUIRE(listing.size() == 2);
+
+  auto& compressed = std::get<siege::platform::file_info>(listing.at(0));
+  REQUIRE(compressed.filename == "repeated.txt");
+  REQUIRE(compressed.compression_type == siege::platform::compression_type::lz77_huffman);
+  REQUIRE(compressed.compressed_size.value() < repeated.size());
+  REQUIRE(extract(mem_buffer, reader, compressed) == repeated);
+
+  // Stored entries have a compressed size of 0 rather than the same size as the data.
+  auto& stored = std::get<siege::platform::file_info>(listing.at(1));
+  REQUIRE(stored.filename == "short.txt");
+  REQUIRE(stored.compressed_size.value() == 0);
+  REQUIRE(stored.compression_type == siege::platform::compression_type::none);
+  REQUIRE(extract(mem_buffer, reader, stored) == "abc");
+}
+
+TEST_CASE("When files are added a few at a time, pak_writer writes the same PAK file as create_pak_file", "[pak.anachronox]")
+{
+  auto make_files = [] {
+    // Already sorted, as pak_writer writes data in the order it is added, whereas create_pak_file sorts it first.
+    std::vector<pak::pak_file_info> files;
+    files.emplace_back(make_file("maps/e1m1.bsp", std::string(256, 'a')));
+    files.emplace_back(make_file("maps/e1m2.bsp", "Hey, hey, hey"));
+    files.emplace_back(make_file("sound/beep.wav", "Beep, beep, beep"));
+    return files;
+  };
+
+  pak::pak_write_settings settings{ .version = pak::pak_version::anachronox, .compression_type = siege::platform::compression_type::lz77_huffman };
+
+  std::stringstream expected;
+  auto all_files = make_files();
+  pak::create_pak_file(expected, all_files, settings);
+
+  std::stringstream mem_buffer;
+  auto files = make_files();
+  {
+    pak::pak_writer writer(mem_buffer, settings);
+    std::vector<pak::pak_file_info> batch;
+    batch.emplace_back(std::move(files[0]));
+    writer.add(batch);
+    batch.clear();
+    batch.emplace_back(std::move(files[1]));
+    batch.emplace_back(std::move(files[2]));
+    writer.add(batch);
+    writer.finish();
+  }
+
+  REQUIRE(mem_buffer.str() == expected.str());
+}
+
+TEST_CASE("When the output already has data in it, offsets are relative to the start of the PAK file", "[pak.quake]")
+{
+  std::stringstream mem_buffer;
+  mem_buffer << "some data before the archive";
+
+  std::vector<pak::pak_file_info> files;
+  files.emplace_back(make_file("readme.txt", "Hello"));
+
+  pak::create_pak_file(mem_buffer, files);
+
+  std::stringstream archive(mem_buffer.str().substr(std::string_view("some data before the archive").size()));
+
+  pak::pak_resource_reader reader;
+  std::any cache;
+  auto listing = reader.get_content_listing(cache, archive, { "test.pak", "test.pak" });
+
+  REQUIRE(listing.size() == 1);
+
+  auto& info = std::get<siege::platform::file_info>(listing.at(0));
+  REQUIRE(info.offset == 12);
+  REQUIRE(extract(archive, reader, info) == "Hello");
+}
+
+TEST_CASE("Files too large for a PAK directory are rejected before anything is read or written", "[pak.quake]")
+{
+  std::stringstream mem_buffer;
+
+  std::vector<pak::pak_file_info> files;
+  files.emplace_back(pak::pak_file_info{ "huge.bin", std::size_t(std::numeric_limits<std::uint32_t>::max()) + 1, std::make_unique<std::stringstream>() });
+
+  REQUIRE_THROWS_AS(pak::create_pak_file(mem_buffer, files), std::invalid_argument);
+  REQUIRE(mem_buffer.str().empty());
+
+  pak::pak_writer writer(mem_buffer, {});
+  auto header = mem_buffer.str();
+  REQUIRE_THROWS_AS(writer.add(files), std::invalid_argument);
+  REQUIRE(mem_buffer.str() == header);
+}
+
+TEST_CASE("Stored PAK entries are read in batches", "[pak.quake]")
+{
+  auto path = std::filesystem::temp_directory_path() / "siege-batch-test.pak";
+
+  {
+    std::vector<pak::pak_file_info> files;
+    files.emplace_back(make_file("a.txt", "Hello Darkness, my old friend..."));
+    files.emplace_back(make_file("b.txt", "Hey, hey, hey"));
+
+    std::ofstream output(path, std::ios::binary);
+    pak::create_pak_file(output, files);
+  }
+
+  pak::pak_resource_reader reader;
+  std::ifstream archive(path, std::ios::binary);
+  auto files = siege::platform::get_all_content_of_type<siege::platform::file_info>(path, archive, reader);
+  REQUIRE(files.size() == 2);
+
+  std::map<std::string, std::string> contents;
+  siege::platform::read_file_contents_batch(path, reader, files, [&](const auto& info, auto data) {
+    contents[info.filename.string()] = std::string(reinterpret_cast<const char*>(data.data()), data.size());
+  });
+
+  REQUIRE(contents["a.txt"] == "Hello Darkness, my old friend...");
+  REQUIRE(contents["b.txt"] == "Hey, hey, hey");
+
+  archive.close();
+  std::filesystem::remove(path);
+}
@@ -2,7 +2,10 @@
 #include <functional>
 #include <filesystem>
 #include <climits>
+#include <set>
+#include <execution>
 #include <siege/platform/shared.hpp>
+#include <siege/platform/stream.hpp>
 #include <siege/resource/resource_explorer.hpp>
 
 // Check to make sure our chars are 8 bits wide and additional sanity checks.
@@ -42,112 +45,120 @@ namespace siege::resource
     return extensions;
   }
 
-  std::vector<siege::platform::file_info> resource_explorer::find_files(const std::filesystem::path& new_search_path, const std::vector<std::string_view>& extensions) const
+  void resource_explorer::collect_files(const std::variant<siege::platform::folder_info, siege::platform::file_info>& item,
+    const std::vector<std::string_view>& extensions,
+    std::vector<siege::platform::file_info>& results) const
   {
-    std::stringstream key;
-    key << new_search_path;
-    std::for_each(extensions.begin(), extensions.end(), [&](auto& ext) { key << ext; });
-
-    auto cache_result = info_cache.find(key.str());
-
-    if (cache_result != info_cache.end())
-    {
-      return cache_result->second;
-    }
-
-    std::vector<siege::platform::file_info> results;
+    std::visit([&](const auto& folder) {
+      using T = std::decay_t<decltype(folder)>;
 
-    auto files_folders = get_content_listing(new_search_path);
+      if constexpr (std::is_same_v<T, siege::platform::folder_info>)
+      {
+        const auto& real_folder = static_cast<const siege::platform::folder_info&>(folder);
 
-    std::function<void(decltype(files_folders)::const_reference)> get_files_folders = [&](const auto& file_folder) {
-      std::visit([&](const auto& folder) {
-        using T = std::decay_t<decltype(folder)>;
+        const auto ext = platform::to_lower(real_folder.full_path.extension().string());
 
-        if constexpr (std::is_same_v<T, siege::platform::folder_info>)
+        // There are specific archives that must not be queried, unless
+        // they or their supported formats are explicitly queried.
+        if (auto must_be_explicit = archive_explicit_extensions.find(ext);
+            std::filesystem::exists(folder.full_path) &&
+            !std::filesystem::is_directory(real_folder.full_path) && must_be_explicit != archive_explicit_extensions.end())
         {
-          const auto& real_folder = static_cast<const siege::platform::folder_info&>(folder);
-
-          const auto ext = platform::to_lower(real_folder.full_path.extension().string());
+          auto count = std::count(extensions.begin(), extensions.end(), "ALL");
 
-          // There are specific archives that must not be queried, unless
-          // they or their supported formats are explicitly queried.
-          if (auto must_be_explicit = archive_explicit_extensions.find(ext);
-              std::filesystem::exists(folder.full_path) &&
-              !std::filesystem::is_directory(real_folder.full_path) && must_be_explicit != archive_explicit_extensions.end())
+          if (count == 0)
           {
-            auto count = std::count(extensions.begin(), extensions.end(), "ALL");
+            count = std::count(extensions.begin(), extensions.end(), ext);
+          }
 
-            if (count == 0)
+          if (count == 0)
+          {
+            for (auto value : must_be_explicit->second)
             {
-              count = std::count(extensions.begin(), extensions.end(), ext);
+              count += std::count(extensions.begin(), extensions.end(), value);
             }
 
             if (count == 0)
             {
-              for (auto value : must_be_explicit->second)
-              {
-                count += std::count(extensions.begin(), extensions.end(), value);
-              }
-
-              if (count == 0)
-              {
-                return;
-              }
+              return;
             }
           }
+        }
 
-          auto more_files = get_content_listing(folder.full_path);
-
-          if (std::filesystem::exists(folder.full_path) && !std::filesystem::is_directory(folder.full_path))
+        if (std::filesystem::exists(folder.full_path) && !std::filesystem::is_directory(folder.full_path))
+        {
+          for (auto& extension : extensions)
           {
-            for (auto& extension : extensions)
+            if (platform::to_lower(folder.full_path.filename().extension().string()) == extension)
             {
-              if (platform::to_lower(folder.full_path.filename().extension().string()) == extension)
-              {
-                siege::platform::file_info info{};
-                info.filename = folder.full_path.filename();
-                info.folder_path = folder.full_path.parent_path();
-                results.emplace_back(info);
-                break;
-              }
+              siege::platform::file_info info{};
+              info.filename = folder.full_path.filename();
+              info.folder_path = folder.full_path.parent_path();
+              results.emplace_back(info);
+              break;
             }
           }
+        }
 
-          for (auto& item : more_files)
+        // Each batch is collected as soon as it is listed, so the listing of a large folder is never held in full.
+        get_content_listing(folder.full_path, [&](auto batch) {
+          for (auto& item : batch)
           {
-            get_files_folders(item);
+            collect_files(item, extensions, results);
           }
-        }
+        });
+      }
 
-        if constexpr (std::is_same_v<T, siege::platform::file_info>)
+      if constexpr (std::is_same_v<T, siege::platform::file_info>)
+      {
+        if (extensions.size() == 1 && extensions.front() == "ALL")
         {
-          if (extensions.size() == 1 && extensions.front() == "ALL")
-          {
-            results.emplace_back(folder);
-          }
-          else
+          results.emplace_back(folder);
+        }
+        else
+        {
+          for (auto& extension : extensions)
           {
-            for (auto& extension : extensions)
+            auto ext = platform::to_lower(folder.filename.extension().string());
+            if (ext == extension)
             {
-              auto ext = platform::to_lower(folder.filename.extension().string());
-              if (ext == extension)
-              {
-                results.emplace_back(folder);
-                break;
-              }
+              results.emplace_back(folder);
+              break;
             }
           }
         }
-      },
-        file_folder);
-    };
+      }
+    },
+      item);
+  }
+
+  std::vector<siege::platform::file_info> resource_explorer::find_files(const std::filesystem::path& new_search_path, const std::vector<std::string_view>& extensions) const
+  {
+    std::stringstream key;
+    key << new_search_path;
+    std::for_each(extensions.begin(), extensions.end(), [&](auto& ext) { key << ext; });
 
-    for (const auto& item : files_folders)
     {
-      get_files_folders(item);
+      std::lock_guard<std::mutex> guard(*info_cache_mutex);
+      auto cache_result = info_cache.find(key.str());
+
+      if (cache_result != info_cache.end())
+      {
+        return cache_result->second.files;
+      }
     }
 
-    info_cache.emplace(key.str(), results);
+    std::vector<siege::platform::file_info> results;
+
+    get_content_listing(new_search_path, [&](auto batch) {
+      for (const auto& item : batch)
+      {
+        collect_files(item, extensions, results);
+      }
+    });
+
+    std::lock_guard<std::mutex> guard(*info_cache_mutex);
+    info_cache.emplace(key.str(), cached_files{ new_search_path, std::vector<std::string>(extensions.begin(), extensions.end()), results });
 
     return results;
   }
@@ -270,9 +281,18 @@ namespace siege::resource
     auto ext = platform::to_lower(file_path.filename().extension().string());
     auto archive_type = archive_types.equal_range(ext);
 
+    if (archive_type.first == archive_type.second)
+    {
+      return std::nullopt;
+    }
+
+    // One stream is shared by every candidate reader, since opening files is far more expensive than seeking.
+    auto file_stream = std::ifstream{ file_path, std::ios::binary };
+
     for (auto it = archive_type.first; it != archive_type.second; ++it)
     {
-      auto file_stream = std::ifstream{ file_path, std::ios::binary };
+      file_stream.clear();
+      file_stream.seekg(0, std::ios::beg);
 
       if (it->second->stream_is_supported(file_stream))
       {
@@ -283,14 +303,8 @@ namespace siege::resource
     return std::nullopt;
   }
 
-  void resource_explorer::extract_file_contents(std::istream& archive_file,
-    std::filesystem::path destination,
-    const siege::platform::file_info& info,
-    std::optional<std::reference_wrapper<platform::batch_storage>> storage) const
+  std::filesystem::path resource_explorer::get_extract_destination(std::filesystem::path destination, const std::filesystem::path& archive_path, const siege::platform::file_info& info) const
   {
-    std::any cache;
-    auto archive_path = get_archive_path(info.folder_path);
-
     if (destination.filename() != info.filename)
     {
       destination = destination / std::filesystem::relative(archive_path, get_search_path()).parent_path() / archive_path.stem() / std::filesystem::relative(info.folder_path, archive_path).replace_extension("");
@@ -303,6 +317,19 @@ namespace siege::resource
       destination = destination / info.filename;
     }
 
+    return destination;
+  }
+
+  void resource_explorer::extract_file_contents(std::istream& archive_file,
+    std::filesystem::path destination,
+    const siege::platform::file_info& info,
+    std::optional<std::reference_wrapper<platform::batch_storage>> storage) const
+  {
+    std::any cache;
+    auto archive_path = get_archive_path(info.folder_path);
+
+    destination = get_extract_destination(std::move(destination), archive_path, info);
+
     std::ofstream new_file(destination, std::ios::binary);
 
     auto type = get_archive_type(archive_path);
@@ -313,55 +340,281 @@ namespace siege::resource
     }
   }
 
+  void resource_explorer::extract_file_contents(const std::filesystem::path& archive_path,
+    const std::filesystem::path& destination,
+    std::span<const siege::platform::file_info> files) const
+  {
+    auto type = get_archive_type(archive_path);
+
+    if (!type.has_value())
+    {
+      return;
+    }
+
+    platform::read_file_contents_batch(archive_path, type->get(), files, [&](const auto& info, auto contents) {
+      std::ofstream new_file(get_extract_destination(destination, archive_path, info), std::ios::binary);
+      platform::write(new_file, contents.data(), contents.size());
+    });
+  }
+
   std::vector<std::variant<siege::platform::folder_info, siege::platform::file_info>> resource_explorer::get_content_listing(const std::filesystem::path& folder_path) const
   {
-    std::any cache;
     std::vector<std::variant<siege::platform::folder_info, siege::platform::file_info>> files;
 
+    get_content_listing(folder_path, [&](auto batch) {
+      files.insert(files.end(), std::make_move_iterator(batch.begin()), std::make_move_iterator(batch.end()));
+    });
+
+    return files;
+  }
+
+  void resource_explorer::get_content_listing(const std::filesystem::path& folder_path,
+    const std::function<void(std::span<std::variant<siege::platform::folder_info, siege::platform::file_info>>)>& on_content,
+    std::size_t batch_size) const
+  {
+    std::any cache;
+
     if (auto archive_type = get_archive_type(get_archive_path(folder_path)); archive_type.has_value())
     {
       auto file_stream = std::ifstream{ get_archive_path(folder_path), std::ios::binary };
 
-      return archive_type.value().get().get_content_listing(cache, file_stream, { get_archive_path(folder_path), folder_path });
+      auto files = archive_type.value().get().get_content_listing(cache, file_stream, { get_archive_path(folder_path), folder_path });
+      on_content(files);
+      return;
     }
 
-    if (!std::filesystem::is_directory(folder_path))
+    std::error_code error;
+    auto iterator = std::filesystem::directory_iterator(folder_path, std::filesystem::directory_options::skip_permission_denied, error);
+
+    if (error)
     {
-      return files;
+      return;
     }
 
-    for (auto& item : std::filesystem::directory_iterator(folder_path))
-    try
+    batch_size = std::max<std::size_t>(batch_size, 1);
+
+    std::vector<std::filesystem::directory_entry> entries;
+    std::vector<std::optional<std::variant<siege::platform::folder_info, siege::platform::file_info>>> infos;
+    std::vector<std::variant<siege::platform::folder_info, siege::platform::file_info>> files;
+    entries.reserve(batch_size);
+
+    // Entries are classified a batch at a time, so that the first batch can be shown
+    // while the rest of the folder is still being read.
+    auto flush = [&]() {
+      infos.resize(entries.size());
+      std::transform(std::execution::par, entries.begin(), entries.end(), infos.begin(), [this](const auto& entry) {
+        return get_content_info(entry);
+      });
+
+      files.clear();
+
+      for (auto& info : infos)
+      {
+        if (info.has_value())
+        {
+          files.emplace_back(std::move(*info));
+        }
+      }
+
+      entries.clear();
+
+      if (!files.empty())
+      {
+        on_content(files);
+      }
+    };
+
+    for (auto end = std::filesystem::directory_iterator(); iterator != end; iterator.increment(error))
     {
-      if (item.is_directory())
+      if (error)
       {
-        siege::platform::folder_info info{};
-        info.name = item.path().filename().string();
-        info.full_path = item.path();
-        files.emplace_back(info);
+        break;
       }
-      else if (auto archive_type = get_archive_type(item.path()); archive_type.has_value())
+
+      entries.emplace_back(*iterator);
+
+      if (entries.size() >= batch_size)
       {
-        siege::platform::folder_info info{};
-        info.name = item.path().filename().string();
-        info.full_path = item.path();
-        files.emplace_back(info);
+        flush();
       }
-      else
+    }
+
+    flush();
+  }
+
+  std::optional<std::variant<siege::platform::folder_info, siege::platform::file_info>> resource_explorer::get_content_info(const std::filesystem::directory_entry& entry) const
+  try
+  {
+    auto& path = entry.path();
+    std::error_code error;
+
+    // Whether an entry is a folder comes from enumeration, without a stat on most file systems.
+    // The size of a file is not part of it on POSIX, so file_size still costs one stat per file there.
+    if (entry.is_directory(error))
+    {
+      siege::platform::folder_info info{};
+      info.name = path.filename().string();
+      info.full_path = path;
+      return info;
+    }
+    else if (auto archive_type = get_archive_type(path); archive_type.has_value())
+    {
+      siege::platform::folder_info info{};
+      info.name = path.filename().string();
+      info.full_path = path;
+      return info;
+    }
+    else
+    {
+      siege::platform::file_info info{};
+
+      info.filename = path.filename().string();
+      info.folder_path = path.parent_path();
+      info.size = std::size_t(entry.file_size());
+      return info;
+    }
+  }
+  catch (...)
+  {
+    return std::nullopt;
+  }
+
+  void resource_explorer::apply_changes(std::span<const path_change> changes) const
+  {
+    auto is_within = [](const std::filesystem::path& path, const std::filesystem::path& parent) {
+      auto parent_end = std::mismatch(parent.begin(), parent.end(), path.begin(), path.end()).first;
+      return parent_end == parent.end() || (std::next(parent_end) == parent.end() && parent_end->empty());
+    };
+
+    // The same path often changes several times in a row (created then written), so only do the work once.
+    std::set<std::filesystem::path> changed_paths;
+
+    for (auto& change : changes)
+    {
+      changed_paths.emplace(change.path.lexically_normal());
+    }
+
+    // Paths inside of a changed folder are covered when the folder itself is rescanned.
+    // The set is sorted, so a folder always comes before what is inside of it.
+    for (auto iter = changed_paths.begin(); iter != changed_paths.end();)
+    {
+      auto parent = std::find_if(changed_paths.begin(), iter, [&](const auto& other) { return is_within(*iter, other); });
+      iter = parent == iter ? std::next(iter) : changed_paths.erase(iter);
+    }
+
+    struct cache_update
+    {
+      std::string key;
+      std::filesystem::path search_path;
+      std::vector<std::string> extensions;
+      std::vector<std::filesystem::path> stale_paths;
+      std::vector<siege::platform::file_info> new_files;
+    };
+
+    std::vector<cache_update> updates;
+
+    {
+      std::lock_guard<std::mutex> guard(*info_cache_mutex);
+      updates.reserve(info_cache.size());
+
+      for (auto& [key, cache] : info_cache)
       {
-        siege::platform::file_info info{};
+        updates.emplace_back(cache_update{ key, cache.search_path.lexically_normal(), cache.extensions });
+      }
+    }
+
+    // Rescanning can mean listing whole folders and archives, so it is done without the lock,
+    // which leaves find_files free to answer from the cache in the meantime.
+    for (auto& update : updates)
+    {
+      std::vector<std::string_view> extensions(update.extensions.begin(), update.extensions.end());
+
+      for (auto& changed_path : changed_paths)
+      {
+        if (!is_within(changed_path, update.search_path))
+        {
+          continue;
+        }
+
+        update.stale_paths.emplace_back(changed_path);
 
-        info.filename = item.path().filename().string();
-        info.folder_path = item.path().parent_path();
-        info.size = std::size_t(std::filesystem::file_size(item.path()));
-        files.emplace_back(info);
+        if (changed_path == update.search_path)
+        {
+          get_content_listing(update.search_path, [&](auto batch) {
+            for (const auto& item : batch)
+            {
+              collect_files(item, extensions, update.new_files);
+            }
+          });
+          continue;
+        }
+
+        std::error_code error;
+        std::filesystem::directory_entry entry(changed_path, error);
+
+        if (auto info = get_content_info(entry); info.has_value())
+        {
+          collect_files(*info, extensions, update.new_files);
+        }
       }
     }
-    catch(...)
+
+    std::lock_guard<std::mutex> guard(*info_cache_mutex);
+
+    for (auto& update : updates)
     {
-      continue;
+      auto cache = info_cache.find(update.key);
+
+      if (cache == info_cache.end() || update.stale_paths.empty())
+      {
+        continue;
+      }
+
+      // Anything inside of a changed folder or archive, as well as the archive or file itself, is stale.
+      std::erase_if(cache->second.files, [&](const auto& info) {
+        auto folder_path = info.folder_path.lexically_normal();
+        return std::any_of(update.stale_paths.begin(), update.stale_paths.end(), [&](const auto& changed_path) {
+          return is_within(folder_path, changed_path) || (folder_path / info.filename) == changed_path;
+        });
+      });
+
+      cache->second.files.insert(cache->second.files.end(), std::make_move_iterator(update.new_files.begin()), std::make_move_iterator(update.new_files.end()));
     }
+  }
 
-    return files;
+  void resource_explorer::start_watching(bool force_polling)
+  {
+    if (watch_thread.joinable())
+    {
+      return;
+    }
+
+    watch_thread = std::jthread([this, force_polling, root = get_search_path()](std::stop_token token) {
+      resource_watcher watcher(root, force_polling);
+
+      while (!token.stop_requested())
+      {
+        auto changes = watcher.get_changes(watcher.is_polling() ? std::chrono::milliseconds(2000) : std::chrono::milliseconds(250), token);
+
+        if (!changes.empty())
+        {
+          apply_changes(changes);
+        }
+      }
+    });
+  }
+
+  void resource_explorer::stop_watching()
+  {
+    if (watch_thread.joinable())
+    {
+      watch_thread.request_stop();
+      watch_thread.join();
+    }
+  }
+
+  bool resource_explorer::is_watching() const
+  {
+    return watch_thread.joinable();
   }
 }// namespace siege::resource
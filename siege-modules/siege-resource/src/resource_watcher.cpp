@@ -0,0 +1,255 @@
+#include <array>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <siege/resource/resource_watcher.hpp>
+
+#if __linux__
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+namespace siege::resource
+{
+  namespace fs = std::filesystem;
+
+  resource_watcher::resource_watcher(std::filesystem::path root, bool force_polling) : root(std::move(root))
+  {
+#if __linux__
+    if (!force_polling)
+    {
+      notify_handle = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    }
+
+    if (notify_handle != -1)
+    {
+      add_watches(this->root);
+      return;
+    }
+#endif
+    snapshot = take_snapshot();
+  }
+
+  resource_watcher::~resource_watcher()
+  {
+#if __linux__
+    if (notify_handle != -1)
+    {
+      ::close(notify_handle);
+    }
+#endif
+  }
+
+  bool resource_watcher::is_polling() const
+  {
+    return notify_handle == -1;
+  }
+
+  std::vector<path_change> resource_watcher::get_changes(std::chrono::milliseconds timeout, std::stop_token token)
+  {
+    if (is_polling())
+    {
+      return get_polled_changes(timeout, std::move(token));
+    }
+
+    return get_notified_changes(timeout, std::move(token));
+  }
+
+  void resource_watcher::add_watches(const std::filesystem::path& folder)
+  {
+#if __linux__
+    constexpr static auto events = IN_CREATE | IN_CLOSE_WRITE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_ONLYDIR;
+
+    auto add_watch = [&](const fs::path& path) {
+      if (auto handle = inotify_add_watch(notify_handle, path.c_str(), events); handle != -1)
+      {
+        watched_folders[handle] = path;
+      }
+    };
+
+    add_watch(folder);
+
+    std::error_code code;
+    for (auto iter = fs::recursive_directory_iterator(folder, fs::directory_options::skip_permission_denied, code); iter != fs::recursive_directory_iterator(); iter.increment(code))
+    {
+      if (code)
+      {
+        break;
+      }
+
+      if (iter->is_directory(code) && !iter->is_symlink(code))
+      {
+        add_watch(iter->path());
+      }
+    }
+#endif
+  }
+
+  std::vector<path_change> resource_watcher::get_notified_changes(std::chrono::milliseconds timeout, std::stop_token token)
+  {
+    std::vector<path_change> results;
+#if __linux__
+    // A stop request wakes the poll up through an event of its own, rather than waiting out the timeout.
+    auto stop_handle = ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    std::array<pollfd, 2> descriptors{ { { .fd = notify_handle, .events = POLLIN }, { .fd = stop_handle, .events = POLLIN } } };
+    int ready = 0;
+
+    {
+      // The callback is gone by the time the handle is closed, so a late stop request cannot write to it.
+      std::stop_callback on_stop(token, [&] {
+        if (stop_handle != -1)
+        {
+          ::eventfd_write(stop_handle, 1);
+        }
+      });
+
+      ready = ::poll(descriptors.data(), stop_handle == -1 ? 1 : 2, int(timeout.count()));
+    }
+
+    if (stop_handle != -1)
+    {
+      ::close(stop_handle);
+    }
+
+    if (ready <= 0 || token.stop_requested() || !(descriptors[0].revents & POLLIN))
+    {
+      return results;
+    }
+
+    alignas(inotify_event) std::array<char, 16 * 1024> buffer;
+
+    while (true)
+    {
+      auto size = ::read(notify_handle, buffer.data(), buffer.size());
+
+      if (size <= 0)
+      {
+        break;
+      }
+
+      for (auto position = 0; position < size;)
+      {
+        inotify_event event;
+        std::memcpy(&event, buffer.data() + position, sizeof(event));
+        const char* name = buffer.data() + position + sizeof(inotify_event);
+        position += sizeof(inotify_event) + event.len;
+
+        if (event.mask & IN_Q_OVERFLOW)
+        {
+          results.clear();
+          results.emplace_back(path_change{ root, path_change_type::modified });
+          return results;
+        }
+
+        if (event.mask & IN_IGNORED)
+        {
+          watched_folders.erase(event.wd);
+          continue;
+        }
+
+        auto folder = watched_folders.find(event.wd);
+
+        if (folder == watched_folders.end() || event.len == 0)
+        {
+          continue;
+        }
+
+        auto path = folder->second / name;
+
+        if (event.mask & (IN_CREATE | IN_MOVED_TO))
+        {
+          if (event.mask & IN_ISDIR)
+          {
+            add_watches(path);
+          }
+
+          results.emplace_back(path_change{ std::move(path), path_change_type::created });
+        }
+        else if (event.mask & IN_CLOSE_WRITE)
+        {
+          results.emplace_back(path_change{ std::move(path), path_change_type::modified });
+        }
+        else if (event.mask & (IN_DELETE | IN_MOVED_FROM))
+        {
+          results.emplace_back(path_change{ std::move(path), path_change_type::removed });
+        }
+      }
+    }
+#endif
+    return results;
+  }
+
+  resource_watcher::snapshot_type resource_watcher::take_snapshot() const
+  {
+    snapshot_type result;
+
+    std::error_code code;
+    for (auto iter = fs::recursive_directory_iterator(root, fs::directory_options::skip_permission_denied, code); iter != fs::recursive_directory_iterator(); iter.increment(code))
+    {
+      if (code)
+      {
+        break;
+      }
+
+      if (iter->is_directory(code))
+      {
+        result.emplace(iter->path(), std::make_pair(fs::file_time_type{}, 0));
+        continue;
+      }
+
+      auto write_time = iter->last_write_time(code);
+      auto size = iter->file_size(code);
+      result.emplace(iter->path(), std::make_pair(write_time, code ? 0 : size));
+    }
+
+    return result;
+  }
+
+  std::vector<path_change> resource_watcher::get_polled_changes(std::chrono::milliseconds timeout, std::stop_token token)
+  {
+    // Nothing else notifies this, so the wait only ends early when a stop is requested.
+    std::mutex mutex;
+    std::condition_variable_any stopped;
+    std::unique_lock lock(mutex);
+
+    if (stopped.wait_for(lock, token, timeout, [] { return false; }) || token.stop_requested())
+    {
+      return {};
+    }
+
+    auto new_snapshot = take_snapshot();
+    std::vector<path_change> results;
+
+    auto old_iter = snapshot.begin();
+    auto new_iter = new_snapshot.begin();
+
+    // Both snapshots are sorted, so they can be compared in one pass.
+    while (old_iter != snapshot.end() || new_iter != new_snapshot.end())
+    {
+      if (new_iter == new_snapshot.end() || (old_iter != snapshot.end() && old_iter->first < new_iter->first))
+      {
+        results.emplace_back(path_change{ old_iter->first, path_change_type::removed });
+        ++old_iter;
+      }
+      else if (old_iter == snapshot.end() || new_iter->first < old_iter->first)
+      {
+        results.emplace_back(path_change{ new_iter->first, path_change_type::created });
+        ++new_iter;
+      }
+      else
+      {
+        if (old_iter->second != new_iter->second)
+        {
+          results.emplace_back(path_change{ new_iter->first, path_change_type::modified });
+        }
+        ++old_iter;
+        ++new_iter;
+      }
+    }
+
+    snapshot = std::move(new_snapshot);
+    return results;
+  }
+}// namespace siege::resource
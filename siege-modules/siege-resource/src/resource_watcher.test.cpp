@@ -0,0 +1,221 @@
+#include <catch2/catch_test_macros.hpp>
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <stop_token>
+#include <string>
+#include <thread>
+#include <siege/resource/resource_watcher.hpp>
+#include <siege/resource/resource_explorer.hpp>
+
+namespace fs = std::filesystem;
+using namespace std::chrono_literals;
+using siege::resource::path_change;
+using siege::resource::path_change_type;
+using siege::resource::resource_watcher;
+
+namespace
+{
+  struct temp_folder
+  {
+    fs::path path = fs::temp_directory_path() / ("siege-watcher-test-" + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count()));
+
+    temp_folder()
+    {
+      fs::create_directories(path);
+    }
+
+    ~temp_folder()
+    {
+      std::error_code unused;
+      fs::remove_all(path, unused);
+    }
+  };
+
+  void write_file(const fs::path& path, std::string_view content, std::ios::openmode mode = std::ios::trunc)
+  {
+    std::ofstream output(path, std::ios::binary | mode);
+    output << content;
+  }
+
+  // Changes can arrive over more than one call, so keep asking until the expected one shows up.
+  bool wait_for_change(resource_watcher& watcher, const fs::path& path, path_change_type type)
+  {
+    for (auto attempt = 0; attempt < 10; ++attempt)
+    {
+      auto changes = watcher.get_changes(100ms);
+
+      if (std::any_of(changes.begin(), changes.end(), [&](const auto& change) { return change.path == path && change.type == type; }))
+      {
+        return true;
+      }
+    }
+
+    return false;
+  }
+}// namespace
+
+TEST_CASE("Created, modified and removed files are reported", "[resource_watcher]")
+{
+  for (auto force_polling : { false, true })
+  {
+    temp_folder root;
+    resource_watcher watcher(root.path, force_polling);
+
+#if __linux__
+    REQUIRE(watcher.is_polling() == force_polling);
+#endif
+
+    auto path = root.path / "test.txt";
+
+    write_file(path, "Hello");
+    REQUIRE(wait_for_change(watcher, path, path_change_type::created));
+
+    write_file(path, ", world", std::ios::app);
+    REQUIRE(wait_for_change(watcher, path, path_change_type::modified));
+
+    fs::remove(path);
+    REQUIRE(wait_for_change(watcher, path, path_change_type::removed));
+
+    REQUIRE(watcher.get_changes(10ms).empty());
+  }
+}
+
+TEST_CASE("Files inside of new folders are reported", "[resource_watcher]")
+{
+  temp_folder root;
+  resource_watcher watcher(root.path);
+
+  fs::create_directory(root.path / "maps");
+  REQUIRE(wait_for_change(watcher, root.path / "maps", path_change_type::created));
+
+  write_file(root.path / "maps" / "e1m1.bsp", "map");
+  REQUIRE(wait_for_change(watcher, root.path / "maps" / "e1m1.bsp", path_change_type::created));
+}
+
+#if __linux__
+TEST_CASE("When inotify drops events, the whole root is reported as modified", "[resource_watcher]")
+{
+  std::size_t max_queued_events = 16384;
+  std::ifstream("/proc/sys/fs/inotify/max_queued_events") >> max_queued_events;
+
+  if (max_queued_events > 65536)
+  {
+    SKIP("The inotify queue is too large to overflow in a test");
+  }
+
+  temp_folder root;
+  resource_watcher watcher(root.path);
+  REQUIRE(watcher.is_polling() == false);
+
+  // Each new file is at least a create and a close event, so this is more than the queue can hold.
+  for (auto i = 0u; i < max_queued_events; ++i)
+  {
+    write_file(root.path / (std::to_string(i) + ".txt"), "");
+  }
+
+  auto changes = watcher.get_changes(1000ms);
+  REQUIRE(changes.size() == 1);
+  REQUIRE(changes[0].path == root.path);
+  REQUIRE(changes[0].type == path_change_type::modified);
+}
+#endif
+
+TEST_CASE("A stop request ends the wait for changes straight away", "[resource_watcher]")
+{
+  for (auto force_polling : { false, true })
+  {
+    temp_folder root;
+    resource_watcher watcher(root.path, force_polling);
+
+    std::stop_source source;
+    auto start = std::chrono::steady_clock::now();
+    std::jthread stopper([&] {
+      std::this_thread::sleep_for(50ms);
+      source.request_stop();
+    });
+
+    REQUIRE(watcher.get_changes(10s, source.get_token()).empty());
+    REQUIRE(std::chrono::steady_clock::now() - start < 5s);
+  }
+}
+
+TEST_CASE("apply_changes adds new files to and removes deleted files from the find_files results", "[resource_explorer]")
+{
+  temp_folder root;
+  write_file(root.path / "first.txt", "first");
+  fs::create_directory(root.path / "more");
+
+  siege::resource::resource_explorer explorer;
+  REQUIRE(explorer.find_files(root.path, { ".txt" }).size() == 1);
+
+  write_file(root.path / "second.txt", "second");
+  write_file(root.path / "more" / "third.txt", "third");
+  fs::remove(root.path / "first.txt");
+
+  // Until the changes are applied, the cached results are returned.
+  REQUIRE(explorer.find_files(root.path, { ".txt" }).size() == 1);
+
+  std::vector<path_change> changes{
+    { root.path / "second.txt", path_change_type::created },
+    { root.path / "more", path_change_type::modified },
+    { root.path / "more" / "third.txt", path_change_type::created },
+    { root.path / "first.txt", path_change_type::removed },
+  };
+  explorer.apply_changes(changes);
+
+  auto files = explorer.find_files(root.path, { ".txt" });
+  std::vector<std::string> names;
+  std::transform(files.begin(), files.end(), std::back_inserter(names), [](const auto& info) { return info.filename.string(); });
+  std::sort(names.begin(), names.end());
+
+  REQUIRE(names == std::vector<std::string>{ "second.txt", "third.txt" });
+}
+
+TEST_CASE("Folders are listed in batches, with every entry listed once", "[resource_explorer]")
+{
+  temp_folder root;
+  fs::create_directory(root.path / "maps");
+
+  for (auto i = 0; i < 10; ++i)
+  {
+    write_file(root.path / (std::to_string(i) + ".txt"), std::string(i, 'a'));
+  }
+
+  siege::resource::resource_explorer explorer;
+
+  std::vector<std::size_t> batch_sizes;
+  std::vector<std::string> names;
+  std::size_t total_size = 0;
+
+  explorer.get_content_listing(root.path, [&](auto batch) {
+    batch_sizes.emplace_back(batch.size());
+
+    for (auto& item : batch)
+    {
+      std::visit([&](const auto& info) {
+        using info_type = std::decay_t<decltype(info)>;
+
+        if constexpr (std::is_same_v<info_type, siege::platform::file_info>)
+        {
+          names.emplace_back(info.filename.string());
+          total_size += info.size;
+        }
+        else
+        {
+          names.emplace_back(info.name);
+        }
+      },
+        item);
+    }
+  }, 4);
+
+  std::sort(names.begin(), names.end());
+
+  REQUIRE(batch_sizes == std::vector<std::size_t>{ 4, 4, 3 });
+  REQUIRE(names.size() == 11);
+  REQUIRE(std::adjacent_find(names.begin(), names.end()) == names.end());
+  REQUIRE(names.back() == "maps");
+  REQUIRE(total_size == 45);
+  REQUIRE(explorer.get_content_listing(root.path).size() == 11);
+}
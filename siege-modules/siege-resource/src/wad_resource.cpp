@@ -1,6 +1,7 @@
 #include <fstream>
 #include <filesystem>
 #include <vector>
+#include <limits>
 #include <list>
 #include <string>
 #include <unordered_map>
@@ -9,6 +10,7 @@
 #include <cstdlib>
 #include <optional>
 #include <sstream>
+#include <stdexcept>
 #include <algorithm>
 #include <iostream>
 #include <map>
@@ -407,4 +409,98 @@ namespace siege::resource::wad
       info.size,
       std::ostreambuf_iterator(output));
   }
+  void create_pod_file(std::ostream& output, std::vector<pod_file_info>& files, std::size_t alignment)
+  {
+    constexpr static auto header_size = sizeof(pod_tag) + sizeof(endian::little_uint32_t) * 4;
+    constexpr static std::array<char, 64> zeros{};
+
+    alignment = std::max<std::size_t>(alignment, 1);
+
+    auto write_padding = [&](std::size_t count) {
+      while (count > 0)
+      {
+        auto amount = std::min(count, zeros.size());
+        platform::write(output, zeros.data(), amount);
+        count -= amount;
+      }
+    };
+
+    std::vector<pod_file_entry> entries(files.size());
+    std::string string_table;
+    string_table.reserve(files.size() * 16);
+
+    auto entries_size = files.size() * sizeof(pod_file_entry);
+    // Offsets are relative to the start of the archive, wherever it begins in the output.
+    std::size_t position = header_size;
+
+    for (auto i = 0u; i < files.size(); ++i)
+    {
+      // Markers have no data, so there is nothing to align for them.
+      if (files[i].size > 0)
+      {
+        position += platform::get_padding_size(position, alignment);
+      }
+
+      entries[i].offset = std::uint32_t(position);
+      entries[i].size = std::uint32_t(files[i].size);
+      entries[i].string_offset = std::uint32_t(entries_size + string_table.size());
+      entries[i].type = files[i].type;
+      position += files[i].size;
+
+      string_table.append(files[i].filename);
+      string_table.push_back('\0');
+    }
+
+    auto directory_padding = platform::get_padding_size(position, alignment);
+
+    // Every offset and size in a POD is 32-bit, and the directory is the last thing in it.
+    if (position + directory_padding + entries_size + string_table.size() > std::numeric_limits<std::uint32_t>::max())
+    {
+      throw std::invalid_argument("The POD contents are larger than 4GB.");
+    }
+
+    platform::write(output, pod_tag.data(), pod_tag.size());
+    endian::little_uint32_t value = 0;
+    platform::write(output, reinterpret_cast<const char*>(&value), sizeof(value));
+    value = std::uint32_t(files.size());
+    platform::write(output, reinterpret_cast<const char*>(&value), sizeof(value));
+    value = std::uint32_t(position + directory_padding);
+    platform::write(output, reinterpret_cast<const char*>(&value), sizeof(value));
+    value = std::uint32_t(entries_size + string_table.size());
+    platform::write(output, reinterpret_cast<const char*>(&value), sizeof(value));
+
+    position = header_size;
+    std::vector<char> buffer(64 * 1024);
+
+    for (auto i = 0u; i < files.size(); ++i)
+    {
+      if (files[i].size == 0)
+      {
+        continue;
+      }
+
+      write_padding(entries[i].offset - position);
+
+      // The directory already says how large the file is, so a stream which ends early is an error rather than a shorter file.
+      for (auto remaining = files[i].size; remaining > 0;)
+      {
+        files[i].stream->read(buffer.data(), std::streamsize(std::min(remaining, buffer.size())));
+        auto count = std::size_t(files[i].stream->gcount());
+
+        if (count == 0)
+        {
+          throw std::runtime_error("The file " + files[i].filename + " has fewer bytes than its size.");
+        }
+
+        platform::write(output, buffer.data(), count);
+        remaining -= count;
+      }
+
+      position = entries[i].offset + files[i].size;
+    }
+
+    write_padding(directory_padding);
+    platform::write(output, reinterpret_cast<const char*>(entries.data()), entries_size);
+    platform::write(output, string_table.data(), string_table.size());
+  }
 }// namespace siege::resource::wad
@@ -0,0 +1,102 @@
+#include <catch2/catch_test_macros.hpp>
+#include <limits>
+#include <sstream>
+#include <siege/resource/wad_resource.hpp>
+#include <siege/platform/stream.hpp>
+#include <siege/platform/shared.hpp>
+
+namespace wad = siege::resource::wad;
+
+namespace
+{
+  wad::pod_file_info make_file(std::string filename, std::uint32_t type, std::string content)
+  {
+    auto size = content.size();
+    return wad::pod_file_info{ std::move(filename), type, size, std::make_unique<std::stringstream>(std::move(content)) };
+  }
+
+  std::string extract(std::stringstream& archive, const wad::wad_resource_reader& reader, const siege::platform::file_info& info)
+  {
+    std::any cache;
+    std::stringstream output;
+    reader.extract_file_contents(cache, archive, info, output);
+    return output.str();
+  }
+}// namespace
+
+TEST_CASE("With a group and loose files, creates a POD file which keeps the directory order", "[pod]")
+{
+  std::stringstream mem_buffer;
+
+  std::vector<wad::pod_file_info> files;
+  files.emplace_back(make_file("notes", 0x1, "Hello Darkness, my old friend..."));
+  files.emplace_back(make_file("startsound", 0x32, ""));
+  files.emplace_back(make_file("beep", 0x1, "Beep, beep, beep"));
+  files.emplace_back(make_file("endsound", 0x32, ""));
+  files.emplace_back(make_file("after", 0x1, "abc"));
+
+  wad::create_pod_file(mem_buffer, files, 16);
+
+  REQUIRE(wad::wad_resource_reader::is_supported(mem_buffer) == true);
+
+  wad::wad_resource_reader reader;
+  std::any cache;
+  auto listing = reader.get_content_listing(cache, mem_buffer, { "test.pod", "test.pod" });
+
+  // The group markers are not listed, but the entries between them take the group as their extension.
+  REQUIRE(listing.size() == 3);
+
+  auto& notes = std::get<siege::platform::file_info>(listing.at(0));
+  REQUIRE(notes.filename == "notes");
+  REQUIRE(notes.offset == 32);
+  REQUIRE(extract(mem_buffer, reader, notes) == "Hello Darkness, my old friend...");
+
+  auto& beep = std::get<siege::platform::file_info>(listing.at(1));
+  REQUIRE(beep.filename == "beep.wav");
+  REQUIRE(beep.offset == 64);
+  REQUIRE(extract(mem_buffer, reader, beep) == "Beep, beep, beep");
+
+  auto& after = std::get<siege::platform::file_info>(listing.at(2));
+  REQUIRE(after.filename == "after");
+  REQUIRE(after.offset == 80);
+  REQUIRE(extract(mem_buffer, reader, after) == "abc");
+}
+
+TEST_CASE("When the output already has data in it, offsets are relative to the start of the POD file", "[pod]")
+{
+  std::stringstream mem_buffer;
+  mem_buffer << "some data before the archive";
+
+  std::vector<wad::pod_file_info> files;
+  files.emplace_back(make_file("readme", 0x1, "Hello"));
+
+  wad::create_pod_file(mem_buffer, files);
+
+  std::stringstream archive(mem_buffer.str().substr(std::string_view("some data before the archive").size()));
+
+  wad::wad_resource_reader reader;
+  std::any cache;
+  auto listing = reader.get_content_listing(cache, archive, { "test.pod", "test.pod" });
+
+  REQUIRE(listing.size() == 1);
+
+  auto& info = std::get<siege::platform::file_info>(listing.at(0));
+  REQUIRE(info.offset == 24);
+  REQUIRE(extract(archive, reader, info) == "Hello");
+}
+
+TEST_CASE("POD files which would not fit in 32-bit offsets, or whose streams end early, are errors", "[pod]")
+{
+  std::vector<wad::pod_file_info> files;
+  files.emplace_back(wad::pod_file_info{ "huge", 0x1, std::size_t(std::numeric_limits<std::uint32_t>::max()), std::make_unique<std::stringstream>() });
+
+  std::stringstream too_large;
+  REQUIRE_THROWS_AS(wad::create_pod_file(too_large, files), std::invalid_argument);
+  REQUIRE(too_large.str().empty());
+
+  files.clear();
+  files.emplace_back(wad::pod_file_info{ "short", 0x1, 10, std::make_unique<std::stringstream>("abc") });
+
+  std::stringstream too_short;
+  REQUIRE_THROWS_AS(wad::create_pod_file(too_short, files), std::runtime_error);
+}
@@ -0,0 +1,196 @@
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <execution>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <spanstream>
+#include <sstream>
+#include <string_view>
+#include <vector>
+#include <siege/content/bmp/bitmap_frames.hpp>
+#include <siege/content/bmp/png.hpp>
+#include <siege/content/dts/gltf_export.hpp>
+#include <siege/content/dts/renderable_shape_factory.hpp>
+#include <siege/content/dts/tmd_renderable_shape.hpp>
+#include <siege/content/pal/palette_resolver.hpp>
+#include <siege/platform/shared.hpp>
+#include <siege/resource/file_gathering.hpp>
+
+namespace fs = std::filesystem;
+
+namespace dio
+{
+  namespace bmp = siege::content::bmp;
+  namespace pal = siege::content::pal;
+  namespace dts = siege::content::dts;
+  namespace gltf = siege::content::gltf;
+  namespace tmd = siege::content::tmd;
+  namespace resource = siege::resource;
+}// namespace dio
+
+// argument examples
+
+// <gameFolderPath>
+// <archive.vol> --output <destination>
+// <shape.dts> --no-textures
+
+struct parsed_args
+{
+  std::vector<fs::path> inputs;
+  fs::path output_folder = fs::current_path();
+  bool include_textures = true;
+};
+
+std::optional<parsed_args> parse_args(int argc, const char** argv)
+{
+  parsed_args result{};
+
+  for (auto i = 1; i < argc; ++i)
+  {
+    std::string_view arg = argv[i];
+
+    if (arg == "--output" && i + 1 < argc)
+    {
+      result.output_folder = argv[++i];
+    }
+    else if (arg == "--no-textures")
+    {
+      result.include_textures = false;
+    }
+    else if (arg.starts_with("--"))
+    {
+      return std::nullopt;
+    }
+    else
+    {
+      result.inputs.emplace_back(arg);
+    }
+  }
+
+  if (result.inputs.empty())
+  {
+    return std::nullopt;
+  }
+
+  return result;
+}
+
+std::vector<std::byte> to_png(std::span<const dio::pal::colour> colours, siege::platform::bitmap::const_pixel_view pixels)
+{
+  std::ostringstream output(std::ios::binary);
+  dio::bmp::write_png_data(output, colours, pixels);
+
+  auto png_text = std::move(output).str();
+  std::vector<std::byte> result(png_text.size());
+  std::memcpy(result.data(), png_text.data(), png_text.size());
+  return result;
+}
+
+int main(int argc, const char** argv)
+{
+  auto args = parse_args(argc, argv);
+
+  if (!args)
+  {
+    std::cerr << "Usage: dts-to-gltf [--output <folder>] [--no-textures] <input>...\n";
+    return EXIT_FAILURE;
+  }
+
+  auto explorer = dio::resource::make_resource_explorer();
+  dio::resource::shared_reader reader(explorer);
+
+  dio::pal::palette_registry registry(dio::pal::get_default_palette_index_folder() / "palette-index.bin");
+  dio::pal::palette_mapping mapping(dio::pal::get_default_palette_index_folder() / "palette-mapping.bin");
+  dio::pal::palette_resolver palettes(registry, mapping);
+  dio::bmp::texture_cache<std::vector<std::byte>> textures([&](const auto& info) { return reader.read(info); }, palettes, [](dio::bmp::decoded_frame frame) {
+    return to_png(frame.colours, frame.pixels);
+  });
+
+  auto items = dio::resource::gather_files(explorer, args->inputs, { ".dts", ".mdl", ".md2", ".mdx", ".dkm", ".tmd", ".bnd", ".bwd" }, [](const fs::path& input) {
+    std::cerr << "Could not find " << input << '\n';
+  });
+
+  if (args->include_textures)
+  {
+    // Palettes inside of archives are found through the same explorer, one archive at a time.
+    dio::resource::embedded_files embedded_palettes(explorer, reader, std::vector<std::string_view>(dio::pal::palette_archive_extensions.begin(), dio::pal::palette_archive_extensions.end()));
+    dio::pal::scan_input_palettes(registry, args->inputs, [&](fs::path path) { return embedded_palettes.find(path); }, [&](fs::path path) { return embedded_palettes.read(path); });
+
+    textures.add_files(dio::resource::find_beside(explorer, items, std::vector<std::string_view>(dio::bmp::texture_extensions.begin(), dio::bmp::texture_extensions.end())));
+  }
+
+  dio::dts::texture_resolver resolve_texture;
+
+  if (args->include_textures)
+  {
+    resolve_texture = [&](std::string_view filename) -> std::optional<std::vector<std::byte>> {
+      auto png = textures.get(filename);
+      return png ? std::make_optional(*png) : std::nullopt;
+    };
+  }
+
+  // BWD models refer to the meshes and textures of their PRJ archive by file ID, so each of those archives is listed before anything else is read.
+  auto archive_files = dio::resource::get_files_by_id(explorer, reader, items, ".bwd");
+
+  std::atomic_size_t failures = 0;
+  std::mutex log_mutex;
+
+  // Each shape is read, converted and written on its own, so whole games are converted in parallel.
+  std::for_each(std::execution::par, items.begin(), items.end(), [&](const dio::resource::gathered_file& item) {
+    try
+    {
+      auto contents = reader.read(item.info);
+      std::ispanstream stream{ std::span<const char>(contents) };
+
+      dio::dts::related_files related;
+
+      if (auto archive = archive_files.find(item.info.archive_path); archive != archive_files.end())
+      {
+        related.get_filename = [&files = archive->second](std::uint16_t file_id) { return files.get_filename(file_id); };
+        related.read = [&files = archive->second](std::uint16_t file_id) { return files.read(file_id); };
+      }
+
+      auto shape = dio::dts::make_shape(stream, related);
+      auto shape_texture = resolve_texture;
+
+      // PlayStation models bring their own TIM images with them, which are used before anything in the archive.
+      if (auto* tmd_shape = dynamic_cast<dio::tmd::tmd_renderable_shape*>(shape.get()); tmd_shape && args->include_textures)
+      {
+        shape_texture = [&, tmd_shape](std::string_view filename) -> std::optional<std::vector<std::byte>> {
+          auto image = tmd_shape->get_texture(filename);
+
+          if (!image || image->pixels.empty())
+          {
+            return resolve_texture(filename);
+          }
+
+          return to_png(image->colours, image->pixels);
+        };
+      }
+
+      dio::gltf::glb_writer writer;
+      dio::dts::add_shape(writer, *shape, shape_texture);
+
+      auto output_path = dio::resource::get_output_path(args->output_folder, item, fs::path(item.info.filename).replace_extension(".glb"));
+      fs::create_directories(output_path.parent_path());
+
+      std::ofstream output(output_path, std::ios::binary | std::ios::trunc);
+      writer.write(output);
+
+      std::lock_guard<std::mutex> guard(log_mutex);
+      std::cout << "Converted " << item.info.folder_path / item.info.filename << '\n';
+    }
+    catch (const std::exception& error)
+    {
+      failures++;
+      std::lock_guard<std::mutex> guard(log_mutex);
+      std::cerr << "Could not convert " << item.info.folder_path / item.info.filename << ": " << error.what() << '\n';
+    }
+  });
+
+  return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -1,12 +1,10 @@
 #include <iostream>
-#include <iomanip>
 #include <iterator>
 #include <execution>
 #include <algorithm>
 #include <bitset>
 #include <fstream>
-#include <siege/content/json_boost.hpp>
-#include <siege/content/dts/complex_serializer.hpp>
+#include <siege/content/json_stream.hpp>
 #include <siege/platform/shared.hpp>
 #include <siege/content/dts/darkstar.hpp>
 #include <siege/content/dts/3space.hpp>
@@ -27,14 +25,25 @@ overloaded(Ts...) -> overloaded<Ts...>;
 
 int main(int argc, const char** argv)
 {
+  std::vector<std::string> args(argv + 1, argv + argc);
+
+  // --compact leaves out the whitespace and writes vertices and keyframes as flat arrays of numbers.
+  auto style = siege::content::json_style::pretty;
+
+  if (auto compact = std::find(args.begin(), args.end(), "--compact"); compact != args.end())
+  {
+    style = siege::content::json_style::compact;
+    args.erase(compact);
+  }
+
   const auto files = siege::platform::find_files(
-    std::vector<std::string>(argv + 1, argv + argc),
+    args,
     ".dts",
     ".DTS",
     ".dml",
     ".DML");
 
-  std::for_each(std::execution::par_unseq, files.begin(), files.end(), [](auto&& file_name) {
+  std::for_each(std::execution::par_unseq, files.begin(), files.end(), [style](auto&& file_name) {
     try
     {
       {
@@ -50,17 +59,11 @@ int main(int argc, const char** argv)
         auto shape = dts3::read_shape(input);
 
         std::visit([&](const auto& item) {
-          nlohmann::ordered_json item_as_json = item;
-
-          //TODO make this have a flag
-          // and reduce the amount of formatting to only what makes sense
-          // and what is easy to parse again
-          //format_json(item_as_json);
-
           auto new_file_name = file_name.string() + ".json";
           {
-            std::ofstream item_as_file(new_file_name, std::ios::trunc);
-            item_as_file << std::setw(4) << item_as_json;
+            std::ofstream item_as_file(new_file_name, std::ios::binary | std::ios::trunc);
+            siege::content::json_stream_writer writer(item_as_file, style);
+            siege::content::write_json(writer, item);
           }
 
           std::stringstream msg;
@@ -73,12 +76,12 @@ int main(int argc, const char** argv)
       {
         namespace dts = dts2::v1;
         auto shapes = dts2::v1::read_shapes(input);
-        nlohmann::ordered_json item_as_json = shapes;
 
         auto new_file_name = file_name.string() + ".json";
         {
-          std::ofstream item_as_file(new_file_name, std::ios::trunc);
-          item_as_file << std::setw(4) << item_as_json;
+          std::ofstream item_as_file(new_file_name, std::ios::binary | std::ios::trunc);
+          siege::content::json_stream_writer writer(item_as_file, style);
+          siege::content::write_json(writer, shapes);
         }
 
         //TODO figure out how these DTS file work
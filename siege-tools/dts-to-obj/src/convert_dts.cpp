@@ -1,3 +1,4 @@
+#include <fstream>
 #include <iostream>
 #include <iterator>
 #include <execution>
@@ -10,6 +11,7 @@
 #include <siege/platform/shared.hpp>
 #include <siege/content/dts/darkstar.hpp>
 #include <siege/content/dts/dts_renderable_shape.hpp>
+#include <siege/content/dts/renderable_shape_factory.hpp>
 #include <siege/content/obj_renderer.hpp>
 
 namespace fs = std::filesystem;
@@ -32,7 +34,19 @@ int main(int argc, const char** argv)
     ".dts",
     ".DTS",
     ".dml",
-    ".DML");
+    ".DML",
+    ".mdl",
+    ".MDL",
+    ".md2",
+    ".MD2",
+    ".mdx",
+    ".MDX",
+    ".dkm",
+    ".DKM",
+    ".tmd",
+    ".TMD",
+    ".bnd",
+    ".BND");
 
   std::for_each(std::execution::par_unseq, files.begin(), files.end(), [](auto&& file_name) {
     try
@@ -45,30 +59,60 @@ int main(int argc, const char** argv)
 
       std::ifstream input(file_name, std::ios::binary);
 
+      auto write_materials = [&](const std::vector<siege::content::material>& materials) {
+        std::ofstream output(file_name.string() + ".mtl", std::ios::binary | std::ios::trunc);
+        siege::content::write_mtl(output, materials);
+      };
+
+      auto write_shape = [&](const siege::content::renderable_shape& instance) {
+        auto materials = instance.get_materials();
+        std::vector<std::string> material_names;
+        material_names.reserve(materials.size());
+
+        for (auto i = 0u; i < materials.size(); ++i)
+        {
+          material_names.emplace_back(siege::content::get_material_name(i, materials[i]));
+        }
+
+        if (!materials.empty())
+        {
+          write_materials(materials);
+        }
+
+        auto detail_levels = instance.get_detail_levels();
+
+        for (auto i = 0u; i < detail_levels.size(); ++i)
+        {
+          std::vector<std::size_t> details{ i };
+          auto batches = instance.get_mesh_batches(details, instance.get_sequences(details));
+
+          std::ofstream output(file_name.string() + "." + detail_levels[i] + ".obj", std::ios::binary | std::ios::trunc);
+          siege::content::obj_writer writer{ output };
+
+          if (!materials.empty())
+          {
+            writer.write_material_library(file_name.filename().string() + ".mtl");
+          }
+
+          writer.write_batches(batches, material_names);
+        }
+      };
+
+      // Anything else, such as the Quake, Kingpin, Daikatana and PlayStation models, is read through the factory.
+      if (!dts::is_darkstar_dts(input) && !dts::is_darkstar_dml(input))
+      {
+        write_shape(*siege::content::dts::make_shape(input));
+        return;
+      }
+
       auto shape = dts::read_shape(input);
 
       std::visit(overloaded{
-                   [&](const dts::shape_variant& core_shape)
-                   {
-                     std::visit([&](const auto& main_shape) {
-                       for (auto i = 0u; i < main_shape.details.size(); ++i)
-                       {
-                         const auto& detail_level = main_shape.details[i];
-                         const auto root_node = main_shape.nodes[detail_level.root_node_index];
-                         const std::string root_node_name = main_shape.names[root_node.name_index].data();
-                         std::ofstream output(file_name.string() + "." + root_node_name + ".obj", std::ios::trunc);
-                         auto renderer = siege::content::obj_renderer{output};
-
-                         siege::content::dts::darkstar::dts_renderable_shape instance{core_shape};
-                         std::vector<std::size_t> details{i};
-                         auto sequences = instance.get_sequences(details);
-                         instance.render_shape(renderer, details, sequences);
-                       }
-                     },
-                       core_shape);
+                   [&](const dts::shape_variant& core_shape) {
+                     write_shape(dts::dts_renderable_shape{ core_shape });
                    },
-                   [&](const dts::material_list_variant&) {
-                     //TODO generate a MTL file
+                   [&](const dts::material_list_variant& material_list) {
+                     write_materials(dts::get_materials(material_list));
                    } },
         shape);
     }
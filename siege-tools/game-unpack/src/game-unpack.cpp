@@ -21,6 +21,7 @@
 #include <siege/resource/iso_resource.hpp>
 #include <siege/resource/cab_resource.hpp>
 #include <siege/resource/resource_explorer.hpp>
+#include <siege/platform/stream.hpp>
 
 namespace fs = std::filesystem;
 
@@ -779,16 +780,19 @@ int main(int argc, char** argv)
                        std::ifstream archive{ src_path, std::ios::binary };
                        auto all_files = siege::platform::get_all_content_of_type<siege::platform::file_info>(src_path, archive, archive_type.value().get());
 
-                       std::any storage;
-
-                       for (auto& file : all_files)
+                       try
                        {
-                         auto new_path = fs::current_path() / file.archive_path.stem() / fs::relative(file.folder_path, file.archive_path);
-                         fs::create_directories(new_path);
-
-                         std::ofstream output { new_path / file.filename, std::ios::binary };
+                         siege::platform::read_file_contents_batch(src_path, archive_type.value().get(), all_files, [](const auto& file, auto contents) {
+                           auto new_path = fs::current_path() / file.archive_path.stem() / fs::relative(file.folder_path, file.archive_path);
+                           fs::create_directories(new_path);
 
-                        archive_type.value().get().extract_file_contents(storage, archive, file, output);
+                           std::ofstream output { new_path / file.filename, std::ios::binary };
+                           siege::platform::write(output, contents.data(), contents.size());
+                         });
+                       }
+                       catch(const std::exception& ex)
+                       {
+                         std::cerr << "Error: " << ex.what() << '\n';
                        }
                      }
                    },
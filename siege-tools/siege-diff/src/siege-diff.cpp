@@ -0,0 +1,61 @@
+#include <fstream>
+#include <filesystem>
+#include <iostream>
+#include <siege/resource/archive_patch.hpp>
+
+namespace fs = std::filesystem;
+
+constexpr std::string_view to_string(siege::resource::entry_change_type type)
+{
+  switch (type)
+  {
+  case siege::resource::entry_change_type::added:
+    return "added";
+  case siege::resource::entry_change_type::removed:
+    return "removed";
+  case siege::resource::entry_change_type::modified:
+    return "modified";
+  default:
+    return "unchanged";
+  }
+}
+
+int main(int argc, const char** argv)
+{
+  if (argc < 3)
+  {
+    std::cerr << "Usage: siege-diff <old archive> <new archive> [patch file]\n";
+    return EXIT_FAILURE;
+  }
+
+  fs::path old_archive(argv[1]);
+  fs::path new_archive(argv[2]);
+  fs::path patch_path = argc > 3 ? fs::path(argv[3]) : fs::path(new_archive.string() + ".patch");
+
+  try
+  {
+    std::ofstream output(patch_path, std::ios::binary | std::ios::trunc);
+    auto changes = siege::resource::create_archive_patch(old_archive, new_archive, output);
+
+    std::size_t patch_size = 0;
+
+    for (auto& change : changes)
+    {
+      patch_size += change.payload_size;
+
+      if (change.type != siege::resource::entry_change_type::unchanged)
+      {
+        std::cout << to_string(change.type) << ' ' << change.path << " (" << change.payload_size << " bytes)\n";
+      }
+    }
+
+    std::cout << "Wrote " << patch_path.string() << " with " << changes.size() << " entries and " << patch_size << " bytes of changes\n";
+  }
+  catch (const std::exception& ex)
+  {
+    std::cerr << "Could not create a patch from " << old_archive.string() << " to " << new_archive.string() << ": " << ex.what() << '\n';
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
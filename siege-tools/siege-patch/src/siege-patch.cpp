@@ -0,0 +1,60 @@
+#include <fstream>
+#include <filesystem>
+#include <iostream>
+#include <algorithm>
+#include <siege/resource/archive_patch.hpp>
+
+namespace fs = std::filesystem;
+
+int main(int argc, const char** argv)
+{
+  if (argc < 3)
+  {
+    std::cerr << "Usage: siege-patch <old archive> <patch file> [new archive]\n";
+    return EXIT_FAILURE;
+  }
+
+  fs::path old_archive(argv[1]);
+  fs::path patch_path(argv[2]);
+  fs::path new_archive = argc > 3 ? fs::path(argv[3]) : old_archive;
+
+  // Patching in place writes to a temporary file first, so that the old archive can still be read from.
+  auto output_path = new_archive == old_archive ? fs::path(new_archive.string() + ".tmp") : new_archive;
+
+  try
+  {
+    std::ifstream patch(patch_path, std::ios::binary);
+
+    if (!patch)
+    {
+      throw std::invalid_argument("Could not open " + patch_path.string());
+    }
+
+    auto changes = siege::resource::apply_archive_patch(old_archive, patch, output_path);
+
+    if (output_path != new_archive)
+    {
+      fs::rename(output_path, new_archive);
+    }
+
+    auto changed = std::count_if(changes.begin(), changes.end(), [](auto& change) {
+      return change.type != siege::resource::entry_change_type::unchanged;
+    });
+
+    std::cout << "Patched " << new_archive.string() << " with " << changed << " changed entries\n";
+  }
+  catch (const std::exception& ex)
+  {
+    std::error_code unused;
+
+    if (output_path != new_archive)
+    {
+      fs::remove(output_path, unused);
+    }
+
+    std::cerr << "Could not patch " << old_archive.string() << " with " << patch_path.string() << ": " << ex.what() << '\n';
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
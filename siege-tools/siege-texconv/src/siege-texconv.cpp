@@ -0,0 +1,402 @@
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <execution>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <iostream>
+#include <mutex>
+#include <spanstream>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include <siege/content/bmp/bitmap.hpp>
+#include <siege/content/bmp/bitmap_frames.hpp>
+#include <siege/content/bmp/png.hpp>
+#include <siege/content/pal/palette_resolver.hpp>
+#include <siege/content/pal/quantizer.hpp>
+#include <siege/platform/bitmap.hpp>
+#include <siege/resource/file_gathering.hpp>
+
+namespace fs = std::filesystem;
+
+namespace dio
+{
+  namespace bmp = siege::content::bmp;
+  namespace pal = siege::content::pal;
+  namespace resource = siege::resource;
+}// namespace dio
+
+using namespace siege::platform::bitmap;
+
+constexpr static auto bitmap_extensions = std::array<std::string_view, 12>{ { ".bmp", ".pba", ".tim", ".dbm", ".dba", ".db0", ".db1", ".db2", ".hba", ".hb0", ".hb1", ".hb2" } };
+
+struct parsed_args
+{
+  std::vector<fs::path> inputs;
+  fs::path output_folder = fs::current_path();
+  bool to_pbmp = false;
+  bool detect_palettes = false;
+  std::optional<fs::path> palette_path;
+  std::uint32_t palette_position = 0;
+  std::optional<std::uint32_t> palette_index;
+  dio::pal::quantize_settings quantize_settings;
+  // How many files are read into memory at once. Each batch is converted while the next one is being read.
+  std::size_t batch_size = std::max(1u, std::thread::hardware_concurrency()) * 8;
+};
+
+// argument examples
+
+// <gameFolderPath>
+// <archive.vol> --output <destination>
+// <gameFolderPath> --detect-palettes --output <destination>
+// --to-pbmp <pngFolder> --palette <palette.ppl> --palette-index 2 --output <destination>
+// --to-pbmp <pngFolder> --palette <palette.pal> --dither ordered --transparent-index 0
+
+std::optional<std::uint32_t> parse_number(std::string_view value)
+{
+  std::uint32_t result{};
+  auto [end, error] = std::from_chars(value.data(), value.data() + value.size(), result);
+
+  if (error != std::errc{} || end != value.data() + value.size())
+  {
+    return std::nullopt;
+  }
+
+  return result;
+}
+
+std::optional<parsed_args> parse_args(int argc, const char** argv)
+{
+  parsed_args result{};
+
+  for (auto i = 1; i < argc; ++i)
+  {
+    std::string_view arg = argv[i];
+    auto has_value = i + 1 < argc;
+
+    if (arg == "--to-png")
+    {
+      result.to_pbmp = false;
+    }
+    else if (arg == "--to-pbmp")
+    {
+      result.to_pbmp = true;
+    }
+    else if (arg == "--detect-palettes")
+    {
+      result.detect_palettes = true;
+    }
+    else if (arg == "--output" && has_value)
+    {
+      result.output_folder = argv[++i];
+    }
+    else if (arg == "--dither" && has_value)
+    {
+      std::string_view method = argv[++i];
+
+      if (method == "none")
+      {
+        result.quantize_settings.dither = dio::pal::dither_method::none;
+      }
+      else if (method == "floyd-steinberg")
+      {
+        result.quantize_settings.dither = dio::pal::dither_method::floyd_steinberg;
+      }
+      else if (method == "ordered")
+      {
+        result.quantize_settings.dither = dio::pal::dither_method::ordered;
+      }
+      else
+      {
+        std::cerr << "Unknown dither method " << method << '\n';
+        return std::nullopt;
+      }
+    }
+    else if (arg == "--palette" && has_value)
+    {
+      result.palette_path = argv[++i];
+    }
+    else if ((arg == "--palette-position" || arg == "--palette-index" || arg == "--transparent-index" || arg == "--batch-size") && has_value)
+    {
+      auto value = parse_number(argv[++i]);
+
+      if (!value)
+      {
+        std::cerr << "Expected a number after " << arg << '\n';
+        return std::nullopt;
+      }
+
+      if (arg == "--palette-position")
+      {
+        result.palette_position = *value;
+      }
+      else if (arg == "--palette-index")
+      {
+        result.palette_index = *value;
+      }
+      else if (arg == "--transparent-index")
+      {
+        result.quantize_settings.transparent_index = std::uint8_t(std::min<std::uint32_t>(*value, 255));
+      }
+      else
+      {
+        result.batch_size = std::max<std::size_t>(1, *value);
+      }
+    }
+    else if (arg.starts_with("--"))
+    {
+      std::cerr << "Unknown option " << arg << '\n';
+      return std::nullopt;
+    }
+    else
+    {
+      result.inputs.emplace_back(arg);
+    }
+  }
+
+  if (result.inputs.empty())
+  {
+    return std::nullopt;
+  }
+
+  return result;
+}
+
+struct conversion_item : dio::resource::gathered_file
+{
+  std::vector<char> contents;
+};
+
+std::vector<conversion_item> find_inputs(const dio::resource::resource_explorer& explorer, std::span<const fs::path> inputs, const std::vector<std::string_view>& extensions)
+{
+  std::vector<conversion_item> results;
+
+  for (auto& file : dio::resource::gather_files(explorer, inputs, extensions, [](const fs::path& input) { std::cerr << "Could not find " << input << '\n'; }))
+  {
+    results.emplace_back(conversion_item{ std::move(file) });
+  }
+
+  return results;
+}
+
+void convert_to_png(const conversion_item& item, const fs::path& output_folder, const dio::pal::palette_resolver& palettes)
+{
+  dio::bmp::decode_bitmap_frames(item.contents, item.info.folder_path / item.info.filename, palettes, [&](std::size_t index, std::size_t, dio::bmp::decoded_frame frame) {
+    if (frame.pixels.empty())
+    {
+      return;
+    }
+
+    auto output_path = dio::resource::get_output_path(output_folder, item, dio::bmp::get_png_filename(item.info.filename, index));
+    fs::create_directories(output_path.parent_path());
+
+    std::ofstream output(output_path, std::ios::binary | std::ios::trunc);
+    dio::bmp::write_png_data(output, frame.colours, frame.pixels);
+  });
+}
+
+void convert_to_pbmp(const conversion_item& item,
+  const fs::path& output_folder,
+  const std::optional<dio::pal::palette_entry>& palette,
+  std::optional<std::uint32_t> palette_index,
+  const dio::pal::quantize_settings& settings)
+{
+  std::ispanstream stream(std::span<const char>(item.contents));
+  auto image = dio::bmp::get_png_data(stream);
+
+  const_pixel_view view = image.pixels;
+  std::vector<std::byte> indexes;
+  std::vector<dio::pal::colour> colours;
+
+  if (is_indexed(view.format))
+  {
+    indexes.assign(view.data.begin(), view.data.end());
+    colours = image.colours;
+
+    if (palette)
+    {
+      indexes = dio::bmp::remap_bitmap(indexes, image.colours, palette->colours);
+      colours = palette->colours;
+    }
+  }
+  else if (palette)
+  {
+    auto quantized = dio::pal::quantize(view, palette->colours, settings);
+    indexes.assign(quantized.bytes().begin(), quantized.bytes().end());
+    colours = palette->colours;
+  }
+  else
+  {
+    throw std::invalid_argument("True colour images need a palette, which can be given with --palette.");
+  }
+
+  colours.resize(256);
+
+  auto output_path = dio::resource::get_output_path(output_folder, item, item.info.filename.stem().string() + ".bmp");
+  fs::create_directories(output_path.parent_path());
+
+  std::ofstream output(output_path, std::ios::binary | std::ios::trunc);
+  dio::bmp::write_pbmp_data(output, std::int32_t(view.width), std::int32_t(view.height), colours, indexes, palette_index);
+}
+
+// Each batch is read on this thread, since archive readers are not safe to share, and then converted in parallel
+// while the next batch is being read. At most two batches of files are in memory at once.
+template<typename ConvertFunc>
+std::size_t convert_in_batches(const dio::resource::shared_reader& reader, std::vector<conversion_item>& items, std::size_t batch_size, ConvertFunc convert)
+{
+  std::atomic_size_t failures = 0;
+  std::mutex log_mutex;
+  std::future<void> pending;
+
+  for (auto first = 0u; first < items.size(); first += batch_size)
+  {
+    auto batch = std::span(items).subspan(first, std::min(batch_size, items.size() - first));
+
+    for (auto& item : batch)
+    {
+      try
+      {
+        item.contents = reader.read(item.info);
+      }
+      catch (const std::exception& error)
+      {
+        failures++;
+        std::lock_guard<std::mutex> guard(log_mutex);
+        std::cerr << "Could not read " << item.info.folder_path / item.info.filename << ": " << error.what() << '\n';
+      }
+    }
+
+    if (pending.valid())
+    {
+      pending.get();
+    }
+
+    pending = std::async(std::launch::async, [&, batch, first]() {
+      std::for_each(std::execution::par, batch.begin(), batch.end(), [&](conversion_item& item) {
+        try
+        {
+          if (!item.contents.empty())
+          {
+            convert(item);
+          }
+        }
+        catch (const std::exception& error)
+        {
+          failures++;
+          std::lock_guard<std::mutex> guard(log_mutex);
+          std::cerr << "Could not convert " << item.info.folder_path / item.info.filename << ": " << error.what() << '\n';
+        }
+
+        item.contents = std::vector<char>{};
+      });
+
+      std::lock_guard<std::mutex> guard(log_mutex);
+      std::cout << "Converted " << std::min(first + batch.size(), items.size()) << " of " << items.size() << " files\n";
+    });
+  }
+
+  if (pending.valid())
+  {
+    pending.get();
+  }
+
+  return failures;
+}
+
+int main(int argc, const char** argv)
+{
+  auto args = parse_args(argc, argv);
+
+  if (!args)
+  {
+    std::cerr << "Usage: siege-texconv [--to-png | --to-pbmp] [--output <folder>] [--palette <file>] [--palette-position <n>] [--palette-index <n>] [--dither none|floyd-steinberg|ordered] [--transparent-index <n>] [--detect-palettes] [--batch-size <n>] <input>...\n";
+    return EXIT_FAILURE;
+  }
+
+  auto explorer = dio::resource::make_resource_explorer();
+  dio::resource::shared_reader reader(explorer);
+
+  std::optional<dio::pal::palette_entry> forced_palette;
+
+  if (args->palette_path)
+  {
+    std::ifstream palette_stream(*args->palette_path, std::ios::binary);
+    auto entries = dio::pal::get_palette_entries(*args->palette_path, palette_stream);
+
+    if (args->palette_position >= entries.size())
+    {
+      std::cerr << "Could not find palette " << args->palette_position << " in " << *args->palette_path << '\n';
+      return EXIT_FAILURE;
+    }
+
+    forced_palette = std::move(entries[args->palette_position]);
+
+    // Phoenix palettes carry the index which bitmaps refer to them by.
+    palette_stream.clear();
+    palette_stream.seekg(0);
+
+    if (!args->palette_index && dio::pal::is_phoenix_pal(palette_stream))
+    {
+      args->palette_index = forced_palette->index;
+    }
+  }
+
+  if (args->to_pbmp)
+  {
+    auto items = find_inputs(explorer, args->inputs, { ".png" });
+
+    // Many images are already converted at once, so each one only gets a thread of its own.
+    if (items.size() > 1 && args->quantize_settings.max_threads == 0)
+    {
+      args->quantize_settings.max_threads = 1;
+    }
+
+    auto failures = convert_in_batches(reader, items, args->batch_size, [&](const conversion_item& item) {
+      convert_to_pbmp(item, args->output_folder, forced_palette, args->palette_index, args->quantize_settings);
+    });
+
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+  }
+
+  dio::pal::palette_registry registry(dio::pal::get_default_palette_index_folder() / "palette-index.bin");
+  dio::pal::palette_mapping mapping(dio::pal::get_default_palette_index_folder() / "palette-mapping.bin");
+
+  auto items = find_inputs(explorer, args->inputs, std::vector<std::string_view>(bitmap_extensions.begin(), bitmap_extensions.end()));
+
+  if (!forced_palette)
+  {
+    // Palettes inside of archives are found through the same explorer, one archive at a time.
+    dio::resource::embedded_files embedded_palettes(explorer, reader, std::vector<std::string_view>(dio::pal::palette_archive_extensions.begin(), dio::pal::palette_archive_extensions.end()));
+    dio::pal::scan_input_palettes(registry, args->inputs, [&](fs::path path) { return embedded_palettes.find(path); }, [&](fs::path path) { return embedded_palettes.read(path); });
+
+    if (args->detect_palettes)
+    {
+      // Detection reads files straight from disk, so bitmaps inside of archives keep using the registry.
+      std::vector<fs::path> bitmaps;
+
+      for (auto& item : items)
+      {
+        if (fs::is_directory(item.info.folder_path))
+        {
+          bitmaps.emplace_back(item.info.folder_path / item.info.filename);
+        }
+      }
+
+      auto assignments = dio::pal::detect_palettes(registry, bitmaps, { .score_by_histogram = true });
+      mapping.assign(assignments);
+      mapping.save();
+
+      std::cout << "Assigned palettes to " << assignments.size() << " of " << bitmaps.size() << " bitmaps\n";
+    }
+  }
+
+  dio::pal::palette_resolver palettes(registry, mapping, std::move(forced_palette));
+
+  auto failures = convert_in_batches(reader, items, args->batch_size, [&](const conversion_item& item) {
+    convert_to_png(item, args->output_folder, palettes);
+  });
+
+  return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -8,6 +8,7 @@
 #include <siege/resource/darkstar_resource.hpp>
 #include <siege/resource/three_space_resource.hpp>
 #include <siege/resource/trophy_bass_resource.hpp>
+#include <siege/platform/stream.hpp>
 
 auto replace_extension(std::string output_folder)
 {
@@ -70,36 +71,22 @@ int main(int, const char** argv)
     return EXIT_FAILURE;
   }
 
-  std::any cache;
-  auto files = archive->get_content_listing(cache, volume_stream, { volume_file, volume_file });
+  auto files = siege::platform::get_all_content_of_type<siege::platform::file_info>(volume_file, volume_stream, *archive);
 
   std::string output_folder = replace_extension(volume_file);
 
-  std::function<void(decltype(files)&)> extract_files = [&](const auto& files){
-    for (const auto& some_file : files)
-    {
-      std::visit([&](const auto& info) {
-        using info_type = std::decay_t<decltype(info)>;
-
-        if constexpr (std::is_same_v<info_type, siege::platform::file_info>)
-        {
-          auto final_folder = output_folder / std::filesystem::relative(replace_extension(info.folder_path.string()), output_folder);
-          std::filesystem::create_directories(final_folder);
-          auto filename = final_folder / info.filename;
-          auto new_stream = std::ofstream{ filename, std::ios::binary };
-          archive->extract_file_contents(cache, volume_stream, info, new_stream);
-        }
-
-        if constexpr (std::is_same_v<info_type, siege::platform::folder_info>)
-        {
-          // TODO think about whether get_content_listing should preserve the original position of the stream or not.
-          std::ifstream temp_stream{ volume_file, std::ios::binary };
-          auto files = archive->get_content_listing(cache, temp_stream, { volume_file, info.full_path });
-          extract_files(files);
-        }
-      }, some_file);
-    }
-  };
-
-  extract_files(files);
+  try
+  {
+    siege::platform::read_file_contents_batch(volume_file, *archive, files, [&](const auto& info, auto contents) {
+      auto final_folder = output_folder / std::filesystem::relative(replace_extension(info.folder_path.string()), output_folder);
+      std::filesystem::create_directories(final_folder);
+      auto new_stream = std::ofstream{ final_folder / info.filename, std::ios::binary };
+      siege::platform::write(new_stream, contents.data(), contents.size());
+    });
+  }
+  catch (const std::exception& ex)
+  {
+    std::cerr << "Could not extract " << volume_file << ": " << ex.what() << '\n';
+    return EXIT_FAILURE;
+  }
 }